@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <inttypes.h>
 #include <stdio.h>
 
 #include "render/buffers.h"
@@ -26,6 +27,7 @@
 #include "util/util_args.h"
 #include "util/util_foreach.h"
 #include "util/util_function.h"
+#include "util/util_guarded_allocator.h"
 #include "util/util_logging.h"
 #include "util/util_path.h"
 #include "util/util_progress.h"
@@ -46,11 +48,15 @@ struct Options {
 	Session *session;
 	Scene *scene;
 	string filepath;
+	vector<string> filepaths;
 	int width, height;
 	SceneParams scene_params;
 	SessionParams session_params;
 	bool quiet;
 	bool show_help, interactive, pause;
+	bool benchmark;
+	int benchmark_iterations;
+	string benchmark_output;
 } options;
 
 static void session_print(const string& str)
@@ -93,6 +99,8 @@ static BufferParams& session_buffer_params()
 	buffer_params.height = options.height;
 	buffer_params.full_width = options.width;
 	buffer_params.full_height = options.height;
+	/* buffer layout must match the film passes */
+	buffer_params.use_adaptive_sampling = options.scene && options.scene->film->use_adaptive_sampling;
 
 	return buffer_params;
 }
@@ -121,7 +129,6 @@ static void scene_init()
 static void session_init()
 {
 	options.session = new Session(options.session_params);
-	options.session->reset(session_buffer_params(), options.session_params.samples);
 
 	if(options.session_params.background && !options.quiet)
 		options.session->progress.set_update_callback(function_bind(&session_print_status));
@@ -134,12 +141,19 @@ static void session_init()
 	scene_init();
 	options.session->scene = options.scene;
 
+	options.session->reset(session_buffer_params(), options.session_params.samples);
 	options.session->start();
 }
 
 static void session_exit()
 {
 	if(options.session) {
+		if(options.session->scene && !options.quiet) {
+			string texture_cache_stats = options.session->scene->image_manager->texture_cache_stats();
+			if(!texture_cache_stats.empty()) {
+				printf("%s\n", texture_cache_stats.c_str());
+			}
+		}
 		delete options.session;
 		options.session = NULL;
 	}
@@ -150,6 +164,158 @@ static void session_exit()
 	}
 }
 
+/* Benchmark
+ *
+ * Renders every scene file a number of times in background and writes
+ * timings and memory statistics of each run as JSON. Times of tiles are
+ * summed over all render threads, other times are wall clock. */
+
+struct BenchmarkRun {
+	double scene_sync_time;
+	double device_update_time;
+	double bvh_build_time;
+	double image_load_time;
+	double render_time;
+	double path_trace_time;
+	double denoise_time;
+	double samples_per_second;
+	double camera_rays_per_second;
+	size_t device_mem_peak;
+	size_t host_mem_peak;
+};
+
+static BenchmarkRun benchmark_render_file(const string& filepath)
+{
+	BenchmarkRun run;
+
+	options.filepath = filepath;
+	options.width = 0;
+	options.height = 0;
+
+	/* peak of this run only, not of the previous ones */
+	util_guarded_reset_mem_peak();
+
+	options.session = new Session(options.session_params);
+
+	scoped_timer sync_timer;
+	scene_init();
+	run.scene_sync_time = sync_timer.get_time();
+
+	options.session->scene = options.scene;
+	options.session->reset(session_buffer_params(), options.session_params.samples);
+	options.session->start();
+	options.session->wait();
+
+	Progress& progress = options.session->progress;
+	const SceneUpdateTimes& update_times = options.scene->update_times;
+	double total_time;
+
+	progress.get_time(total_time, run.render_time);
+	progress.get_tile_times(run.path_trace_time, run.denoise_time);
+	run.device_update_time = update_times.total;
+	run.bvh_build_time = update_times.bvh;
+	run.image_load_time = update_times.images;
+
+	/* every pixel sample starts with one camera ray, secondary rays are not
+	 * counted by the kernel */
+	const double render_time = max(run.render_time, 1e-6);
+	run.samples_per_second = options.session_params.samples / render_time;
+	run.camera_rays_per_second = progress.get_pixel_samples() / render_time;
+
+	run.device_mem_peak = options.session->stats.mem_peak;
+	run.host_mem_peak = util_guarded_get_mem_peak();
+
+	delete options.session;
+	options.session = NULL;
+
+	return run;
+}
+
+static string benchmark_json_string(const string& str)
+{
+	string result = "\"";
+	foreach(char c, str) {
+		if(c == '"' || c == '\\') {
+			result += '\\';
+			result += c;
+		}
+		else if((unsigned char)c < 0x20) {
+			result += string_printf("\\u%04x", (int)c);
+		}
+		else {
+			result += c;
+		}
+	}
+	return result + "\"";
+}
+
+static string benchmark_json_run(const BenchmarkRun& run)
+{
+	return string_printf(
+	        "{\"scene_sync\": %f, \"device_update\": %f, "
+	        "\"bvh_build\": %f, \"image_load\": %f, "
+	        "\"render\": %f, \"path_trace\": %f, \"denoise\": %f, "
+	        "\"samples_per_second\": %f, \"camera_rays_per_second\": %f, "
+	        "\"device_mem_peak\": %" PRIu64 ", \"host_mem_peak\": %" PRIu64 "}",
+	        run.scene_sync_time, run.device_update_time,
+	        run.bvh_build_time, run.image_load_time,
+	        run.render_time, run.path_trace_time, run.denoise_time,
+	        run.samples_per_second, run.camera_rays_per_second,
+	        (uint64_t)run.device_mem_peak, (uint64_t)run.host_mem_peak);
+}
+
+static bool benchmark_run()
+{
+	string json = "{\n";
+	json += "  \"version\": " + benchmark_json_string(CYCLES_VERSION_STRING) + ",\n";
+	json += "  \"device\": " + benchmark_json_string(options.session_params.device.description) + ",\n";
+	json += string_printf("  \"threads\": %d,\n", options.session_params.threads);
+	json += string_printf("  \"samples\": %d,\n", options.session_params.samples);
+	json += string_printf("  \"iterations\": %d,\n", options.benchmark_iterations);
+	json += "  \"scenes\": [";
+
+	for(size_t i = 0; i < options.filepaths.size(); i++) {
+		const string& filepath = options.filepaths[i];
+
+		json += (i == 0)? "\n": ",\n";
+		json += "    {\"file\": " + benchmark_json_string(filepath) + ", \"runs\": [";
+
+		for(int iteration = 0; iteration < options.benchmark_iterations; iteration++) {
+			if(!options.quiet) {
+				printf("Benchmark %s, run %d of %d\n",
+				       path_filename(filepath).c_str(),
+				       iteration + 1,
+				       options.benchmark_iterations);
+			}
+
+			BenchmarkRun run = benchmark_render_file(filepath);
+
+			json += (iteration == 0)? "\n": ",\n";
+			json += "      " + benchmark_json_run(run);
+		}
+
+		json += "\n    ]}";
+	}
+
+	json += "\n  ]\n}\n";
+
+	if(options.benchmark_output == "") {
+		printf("%s", json.c_str());
+		return true;
+	}
+
+	FILE *f = path_fopen(options.benchmark_output, "wb");
+	if(!f) {
+		fprintf(stderr, "Failed to write benchmark results to %s\n",
+		        options.benchmark_output.c_str());
+		return false;
+	}
+	fwrite(json.c_str(), 1, json.size(), f);
+	fclose(f);
+
+	return true;
+}
+
 #ifdef WITH_CYCLES_STANDALONE_GUI
 static void display_info(Progress& progress)
 {
@@ -314,8 +480,11 @@ static void keyboard(unsigned char key)
 
 static int files_parse(int argc, const char *argv[])
 {
-	if(argc > 0)
-		options.filepath = argv[0];
+	if(argc > 0) {
+		if(options.filepath == "")
+			options.filepath = argv[0];
+		options.filepaths.push_back(argv[0]);
+	}
 
 	return 0;
 }
@@ -327,6 +496,9 @@ static void options_parse(int argc, const char **argv)
 	options.filepath = "";
 	options.session = NULL;
 	options.quiet = false;
+	options.benchmark = false;
+	options.benchmark_iterations = 3;
+	options.benchmark_output = "";
 
 	/* device names */
 	string device_names = "";
@@ -355,7 +527,7 @@ static void options_parse(int argc, const char **argv)
 	bool help = false, debug = false, version = false;
 	int verbosity = 1;
 
-	ap.options ("Usage: cycles [options] file.xml",
+	ap.options ("Usage: cycles [options] file.xml [file.xml ...]",
 		"%*", files_parse, "",
 		"--device %s", &devicename, ("Devices to use: " + device_names).c_str(),
 #ifdef WITH_OSL
@@ -371,6 +543,9 @@ static void options_parse(int argc, const char **argv)
 		"--tile-width %d", &options.session_params.tile_size.x, "Tile width in pixels",
 		"--tile-height %d", &options.session_params.tile_size.y, "Tile height in pixels",
 		"--list-devices", &list, "List information about all available devices",
+		"--benchmark", &options.benchmark, "Render all files in background and print timings as JSON",
+		"--benchmark-iterations %d", &options.benchmark_iterations, "Number of times to render each file in benchmark mode",
+		"--benchmark-output %s", &options.benchmark_output, "File path to write benchmark JSON to, instead of stdout",
 #ifdef WITH_CYCLES_LOGGING
 		"--debug", &debug, "Enable debug logging",
 		"--verbose %d", &verbosity, "Set verbosity of the logger",
@@ -421,6 +596,12 @@ static void options_parse(int argc, const char **argv)
 	options.session_params.background = true;
 #endif
 
+	/* Benchmark renders without interface and progress output */
+	if(options.benchmark) {
+		options.session_params.background = true;
+		options.quiet = options.quiet || options.benchmark_output == "";
+	}
+
 	/* Use progressive rendering */
 	options.session_params.progressive = true;
 
@@ -456,6 +637,10 @@ static void options_parse(int argc, const char **argv)
 		fprintf(stderr, "Invalid number of samples: %d\n", options.session_params.samples);
 		exit(EXIT_FAILURE);
 	}
+	else if(options.benchmark && options.benchmark_iterations < 1) {
+		fprintf(stderr, "Invalid number of benchmark iterations: %d\n", options.benchmark_iterations);
+		exit(EXIT_FAILURE);
+	}
 	else if(options.filepath == "") {
 		fprintf(stderr, "No file path specified\n");
 		exit(EXIT_FAILURE);
@@ -475,6 +660,10 @@ int main(int argc, const char **argv)
 	path_init();
 	options_parse(argc, argv);
 
+	if(options.benchmark) {
+		return benchmark_run()? 0: 1;
+	}
+
 #ifdef WITH_CYCLES_STANDALONE_GUI
 	if(options.session_params.background) {
 #endif
@@ -291,6 +291,27 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
                 default=0.01,
                 )
 
+        cls.use_adaptive_sampling = BoolProperty(
+                name="Adaptive Sampling",
+                description="Stop sampling pixels once their noise level is below the threshold, "
+                            "only for final renders on the CPU",
+                default=False,
+                )
+        cls.adaptive_threshold = FloatProperty(
+                name="Adaptive Threshold",
+                description="Noise level below which a pixel is considered converged, "
+                            "lower values give less noise but take more samples",
+                min=0.0001, max=1.0,
+                default=0.01,
+                precision=4,
+                )
+        cls.adaptive_min_samples = IntProperty(
+                name="Adaptive Min Samples",
+                description="Number of samples every pixel takes before its convergence is checked",
+                min=4, max=4096,
+                default=16,
+                )
+
         cls.caustics_reflective = BoolProperty(
                 name="Reflective Caustics",
                 description="Use reflective caustics, resulting in a brighter image (more noise but added realism)",
@@ -616,6 +637,15 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
             items=enum_texture_limit
             )
 
+        cls.texture_cache_size = IntProperty(
+            name="Texture Cache Size",
+            description="Memory budget in megabytes of the texture cache of CPU rendering, "
+                        "image tiles are read on demand instead of loading full images, 0 disables the cache",
+            min=0, max=1024 * 1024,
+            default=0,
+            subtype='UNSIGNED',
+            )
+
         cls.ao_bounces = IntProperty(
             name="AO Bounces",
             default=0,
@@ -643,7 +673,9 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         cls.debug_use_cpu_sse3 = BoolProperty(name="SSE3", default=True)
         cls.debug_use_cpu_sse2 = BoolProperty(name="SSE2", default=True)
         cls.debug_use_qbvh = BoolProperty(name="QBVH", default=True)
+        cls.debug_use_bvh8 = BoolProperty(name="BVH8", default=True)
         cls.debug_use_cpu_split_kernel = BoolProperty(name="Split Kernel", default=False)
+        cls.debug_use_cpu_packet_traversal = BoolProperty(name="Packet Traversal", default=False)
 
         cls.debug_use_cuda_adaptive_compile = BoolProperty(name="Adaptive Compile", default=False)
         cls.debug_use_cuda_split_kernel = BoolProperty(name="Split Kernel", default=False)
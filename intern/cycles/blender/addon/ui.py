@@ -205,6 +205,13 @@ class CYCLES_RENDER_PT_sampling(CyclesButtonsPanel, Panel):
 
         layout.row().prop(cscene, "sampling_pattern", text="Pattern")
 
+        row = layout.row(align=True)
+        row.prop(cscene, "use_adaptive_sampling", text="Adaptive")
+        sub = row.row(align=True)
+        sub.active = cscene.use_adaptive_sampling
+        sub.prop(cscene, "adaptive_threshold", text="Threshold")
+        sub.prop(cscene, "adaptive_min_samples", text="Min Samples")
+
         for rl in scene.render.layers:
             if rl.samples > 0:
                 layout.separator()
@@ -416,7 +423,8 @@ class CYCLES_RENDER_PT_performance(CyclesButtonsPanel, Panel):
 
         col.label(text="Final Render:")
         col.prop(rd, "use_save_buffers")
-        col.prop(rd, "use_persistent_data", text="Persistent Images")
+        col.prop(rd, "use_persistent_data", text="Persistent Data")
+        col.prop(cscene, "texture_cache_size")
 
         col.separator()
 
@@ -1595,7 +1603,9 @@ class CYCLES_RENDER_PT_debug(CyclesButtonsPanel, Panel):
         row.prop(cscene, "debug_use_cpu_avx", toggle=True)
         row.prop(cscene, "debug_use_cpu_avx2", toggle=True)
         col.prop(cscene, "debug_use_qbvh")
+        col.prop(cscene, "debug_use_bvh8")
         col.prop(cscene, "debug_use_cpu_split_kernel")
+        col.prop(cscene, "debug_use_cpu_packet_traversal")
 
         col.separator()
 
@@ -1131,6 +1131,22 @@ Mesh *BlenderSync::sync_mesh(BL::Object& b_ob,
 			rebuild = true;
 	}
 
+	/* with persistent data all meshes are synced again for every frame,
+	 * skip the device update when nothing changed since the previous frame.
+	 * subdivision, displacement and motion are computed in the device update
+	 * and always have to be redone. */
+	if(scene->params.persistent_data) {
+		const bool modified = mesh->is_modified();
+
+		if(!modified && !rebuild &&
+		   mesh->subdivision_type == Mesh::SUBDIVISION_NONE &&
+		   !mesh->has_true_displacement() &&
+		   scene->need_motion() == Scene::MOTION_NONE)
+		{
+			return mesh;
+		}
+	}
+
 	mesh->tag_update(scene, rebuild);
 
 	return mesh;
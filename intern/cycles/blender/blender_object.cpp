@@ -208,8 +208,9 @@ void BlenderSync::sync_light(BL::Object& b_parent,
 	light->use_transmission = (visibility & PATH_RAY_TRANSMIT) != 0;
 	light->use_scatter = (visibility & PATH_RAY_VOLUME_SCATTER) != 0;
 
-	/* tag */
-	light->tag_update(scene);
+	/* tag, with persistent data only when changed since the previous frame */
+	if(!scene->params.persistent_data || light->is_modified())
+		light->tag_update(scene);
 }
 
 void BlenderSync::sync_background_light(bool use_portal)
@@ -69,7 +69,9 @@ bool debug_flags_sync_from_scene(BL::Scene b_scene)
 	flags.cpu.sse3 = get_boolean(cscene, "debug_use_cpu_sse3");
 	flags.cpu.sse2 = get_boolean(cscene, "debug_use_cpu_sse2");
 	flags.cpu.qbvh = get_boolean(cscene, "debug_use_qbvh");
+	flags.cpu.bvh8 = get_boolean(cscene, "debug_use_bvh8");
 	flags.cpu.split_kernel = get_boolean(cscene, "debug_use_cpu_split_kernel");
+	flags.cpu.packet_traversal = get_boolean(cscene, "debug_use_cpu_packet_traversal");
 	/* Synchronize CUDA flags. */
 	flags.cuda.adaptive_compile = get_boolean(cscene, "debug_use_cuda_adaptive_compile");
 	flags.cuda.split_kernel = get_boolean(cscene, "debug_use_cuda_split_kernel");
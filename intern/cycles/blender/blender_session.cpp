@@ -193,6 +193,11 @@ void BlenderSession::reset_session(BL::BlendData& b_data_, BL::Scene& b_scene_)
 		 * them rather than trying to distinguish which settings need to be updated
 		 */
 
+		if(sync) {
+			delete sync;
+			sync = NULL;
+		}
+
 		delete session;
 
 		create_session();
@@ -201,7 +206,6 @@ void BlenderSession::reset_session(BL::BlendData& b_data_, BL::Scene& b_scene_)
 	}
 
 	session->progress.reset();
-	scene->reset();
 
 	session->tile_manager.set_tile_order(session_params.tile_order);
 
@@ -210,8 +214,15 @@ void BlenderSession::reset_session(BL::BlendData& b_data_, BL::Scene& b_scene_)
 	 */
 	session->stats.mem_peak = session->stats.mem_used;
 
-	/* sync object should be re-created */
-	sync = new BlenderSync(b_engine, b_data, b_scene, scene, !background, session->progress);
+	/* scene data and sync object are kept from the previous frame, only
+	 * changes are synced and updated on the device */
+	if(sync) {
+		sync->sync_recalc_persistent(b_data, b_scene);
+	}
+	else {
+		scene->reset();
+		sync = new BlenderSync(b_engine, b_data, b_scene, scene, !background, session->progress);
+	}
 
 	/* for final render we will do full data sync per render layer, only
 	 * do some basic syncing here, no objects or materials for speed */
@@ -375,6 +386,7 @@ void BlenderSession::render()
 	/* get buffer parameters */
 	SessionParams session_params = BlenderSync::get_session_params(b_engine, b_userpref, b_scene, background);
 	BufferParams buffer_params = BlenderSync::get_buffer_params(b_render, b_v3d, b_rv3d, scene->camera, width, height);
+	PointerRNA cscene = RNA_pointer_get(&b_scene.ptr, "cycles");
 
 	/* render each layer */
 	BL::RenderSettings r = b_scene.render();
@@ -421,6 +433,12 @@ void BlenderSession::render()
 		if(!get_boolean(crl, "denoising_subsurface_indirect"))   scene->film->denoising_flags |= DENOISING_CLEAN_SUBSURFACE_IND;
 		scene->film->denoising_clean_pass = (scene->film->denoising_flags & DENOISING_CLEAN_ALL_PASSES);
 		buffer_params.denoising_clean_pass = scene->film->denoising_clean_pass;
+		/* convergence is only checked by the CPU path tracer, and progressive
+		 * refine needs all pixels to take the same number of samples */
+		scene->film->use_adaptive_sampling = get_boolean(cscene, "use_adaptive_sampling") &&
+		                                     session_params.device.type == DEVICE_CPU &&
+		                                     !session_params.progressive_refine;
+		buffer_params.use_adaptive_sampling = scene->film->use_adaptive_sampling;
 		session->params.denoising_radius = get_int(crl, "denoising_radius");
 		session->params.denoising_strength = get_float(crl, "denoising_strength");
 		session->params.denoising_feature_strength = get_float(crl, "denoising_feature_strength");
@@ -439,6 +457,7 @@ void BlenderSession::render()
 			b_engine.active_view_set(b_rview_name.c_str());
 
 			/* update scene */
+			scoped_timer sync_timer;
 			BL::Object b_camera_override(b_engine.camera_override());
 			sync->sync_camera(b_render, b_camera_override, width, height, b_rview_name.c_str());
 			sync->sync_data(b_render,
@@ -447,6 +466,9 @@ void BlenderSession::render()
 			                width, height,
 			                &python_thread_state,
 			                b_rlay_name.c_str());
+			VLOG(1) << "Synchronization of frame " << b_scene.frame_current()
+			        << ", render layer " << b_rlay_name
+			        << " took " << sync_timer.get_time() << " seconds.";
 
 			/* Make sure all views have different noise patterns. - hardcoded value just to make it random */
 			if(view_index != 0) {
@@ -499,18 +521,26 @@ void BlenderSession::render()
 	VLOG(1) << "Total render time: " << total_time;
 	VLOG(1) << "Render time (without synchronization): " << render_time;
 
+	/* 1 << 1 means RPT_INFO, see report of errors in update_status_progress(). */
+	string texture_cache_stats = scene->image_manager->texture_cache_stats();
+	if(!texture_cache_stats.empty()) {
+		b_engine.report(1 << 1, texture_cache_stats.c_str());
+	}
+
 	/* clear callback */
 	session->write_render_tile_cb = function_null;
 	session->update_render_tile_cb = function_null;
 
-	/* free all memory used (host and device), so we wouldn't leave render
+	/* with persistent data the scene is kept for the next frame, otherwise
+	 * free all memory used (host and device), so we wouldn't leave render
 	 * engine with extra memory allocated
 	 */
+	if(!scene->params.persistent_data) {
+		session->device_free();
 
-	session->device_free();
-
-	delete sync;
-	sync = NULL;
+		delete sync;
+		sync = NULL;
+	}
 }
 
 static void populate_bake_data(BakeData *data, const
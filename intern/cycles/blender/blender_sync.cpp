@@ -188,6 +188,107 @@ bool BlenderSync::sync_recalc()
 	return recalc;
 }
 
+static bool id_is_animated(BL::ID& b_id)
+{
+	PointerRNA animdata = RNA_pointer_get(&b_id.ptr, "animation_data");
+	return animdata.data != NULL;
+}
+
+static bool image_is_animated(BL::Image& b_image, BL::ImageUser& b_image_user)
+{
+	return b_image &&
+	       (b_image.source() == BL::Image::source_SEQUENCE ||
+	        b_image.source() == BL::Image::source_MOVIE ||
+	        b_image_user.use_auto_refresh());
+}
+
+/* Image textures bake the frame into the file name when synced, so node
+ * trees using image sequences or movies change with every frame. */
+static bool node_tree_has_animated_images(BL::NodeTree& b_ntree)
+{
+	BL::NodeTree::nodes_iterator b_node;
+	for(b_ntree.nodes.begin(b_node); b_node != b_ntree.nodes.end(); ++b_node) {
+		if(b_node->is_a(&RNA_ShaderNodeTexImage)) {
+			BL::ShaderNodeTexImage b_image_node(*b_node);
+			BL::Image b_image(b_image_node.image());
+			BL::ImageUser b_image_user(b_image_node.image_user());
+			if(image_is_animated(b_image, b_image_user))
+				return true;
+		}
+		else if(b_node->is_a(&RNA_ShaderNodeTexEnvironment)) {
+			BL::ShaderNodeTexEnvironment b_env_node(*b_node);
+			BL::Image b_image(b_env_node.image());
+			BL::ImageUser b_image_user(b_env_node.image_user());
+			if(image_is_animated(b_image, b_image_user))
+				return true;
+		}
+		else if(b_node->is_a(&RNA_ShaderNodeGroup) || b_node->is_a(&RNA_NodeCustomGroup)) {
+			BL::NodeTree b_group_ntree(PointerRNA_NULL);
+			if(b_node->is_a(&RNA_ShaderNodeGroup))
+				b_group_ntree = ((BL::NodeGroup)(*b_node)).node_tree();
+			else
+				b_group_ntree = ((BL::NodeCustomGroup)(*b_node)).node_tree();
+			if(b_group_ntree && node_tree_has_animated_images(b_group_ntree))
+				return true;
+		}
+	}
+	return false;
+}
+
+static bool id_or_node_tree_is_animated(BL::ID b_id, BL::NodeTree b_ntree)
+{
+	return id_is_animated(b_id) ||
+	       (b_ntree && (id_is_animated(b_ntree) ||
+	                    node_tree_has_animated_images(b_ntree)));
+}
+
+void BlenderSync::sync_recalc_persistent(BL::BlendData& b_data_, BL::Scene& b_scene_)
+{
+	/* with persistent data the scene is kept between frames of an animation
+	 * render. the dependency graph recalc flags are already cleared after the
+	 * frame change, so geometry and lights are synced again and compared to
+	 * the previous frame, shaders only when they are animated or use image
+	 * sequences, movies or auto refresh images. */
+	b_data = b_data_;
+	b_scene = b_scene_;
+
+	BL::BlendData::materials_iterator b_mat;
+	for(b_data.materials.begin(b_mat); b_mat != b_data.materials.end(); ++b_mat) {
+		Shader *shader = shader_map.find(*b_mat);
+		if(id_or_node_tree_is_animated(*b_mat, b_mat->node_tree()) ||
+		   (shader != NULL && shader->has_object_dependency))
+		{
+			shader_map.set_recalc(*b_mat);
+		}
+	}
+
+	BL::BlendData::lamps_iterator b_lamp;
+	for(b_data.lamps.begin(b_lamp); b_lamp != b_data.lamps.end(); ++b_lamp) {
+		if(id_or_node_tree_is_animated(*b_lamp, b_lamp->node_tree()))
+			shader_map.set_recalc(*b_lamp);
+	}
+
+	BL::World b_world = b_scene.world();
+	if(b_world && id_or_node_tree_is_animated(b_world, b_world.node_tree()))
+		world_recalc = true;
+	else if(b_world && scene->default_background->has_object_dependency)
+		world_recalc = true;
+
+	BL::BlendData::objects_iterator b_ob;
+	for(b_data.objects.begin(b_ob); b_ob != b_data.objects.end(); ++b_ob) {
+		if(object_is_mesh(*b_ob)) {
+			BL::ID key = BKE_object_is_modified(*b_ob)? *b_ob: b_ob->data();
+			mesh_map.set_recalc(key);
+		}
+		else if(object_is_light(*b_ob)) {
+			light_map.set_recalc(*b_ob);
+		}
+
+		if(b_ob->particle_systems.length())
+			particle_system_map.set_recalc(*b_ob);
+	}
+}
+
 void BlenderSync::sync_data(BL::RenderSettings& b_render,
                             BL::SpaceView3D& b_v3d,
                             BL::Object& b_override,
@@ -289,6 +390,9 @@ void BlenderSync::sync_integrator()
 	integrator->sample_all_lights_indirect = get_boolean(cscene, "sample_all_lights_indirect");
 	integrator->light_sampling_threshold = get_float(cscene, "light_sampling_threshold");
 
+	integrator->adaptive_threshold = get_float(cscene, "adaptive_threshold");
+	integrator->adaptive_min_samples = get_int(cscene, "adaptive_min_samples");
+
 	int diffuse_samples = get_int(cscene, "diffuse_samples");
 	int glossy_samples = get_int(cscene, "glossy_samples");
 	int transmission_samples = get_int(cscene, "transmission_samples");
@@ -627,15 +731,20 @@ SceneParams BlenderSync::get_scene_params(BL::Scene& b_scene,
 	else
 		params.bvh_type = SceneParams::BVH_DYNAMIC;
 
-	params.use_bvh_spatial_split = RNA_boolean_get(&cscene, "debug_use_spatial_splits");
-	params.use_bvh_unaligned_nodes = RNA_boolean_get(&cscene, "debug_use_hair_bvh");
-	params.num_bvh_time_steps = RNA_int_get(&cscene, "debug_bvh_time_steps");
-
 	if(background && params.shadingsystem != SHADINGSYSTEM_OSL)
 		params.persistent_data = r.use_persistent_data();
 	else
 		params.persistent_data = false;
 
+	/* with persistent data objects keep their own BVH between frames, so only
+	 * the top level BVH has to be rebuilt when objects move */
+	if(params.persistent_data)
+		params.bvh_type = SceneParams::BVH_DYNAMIC;
+
+	params.use_bvh_spatial_split = RNA_boolean_get(&cscene, "debug_use_spatial_splits");
+	params.use_bvh_unaligned_nodes = RNA_boolean_get(&cscene, "debug_use_hair_bvh");
+	params.num_bvh_time_steps = RNA_int_get(&cscene, "debug_bvh_time_steps");
+
 	int texture_limit;
 	if(background) {
 		texture_limit = RNA_enum_get(&cscene, "texture_limit_render");
@@ -650,7 +759,10 @@ SceneParams BlenderSync::get_scene_params(BL::Scene& b_scene,
 		params.texture_limit = 0;
 	}
 
+	params.texture_cache_size = RNA_int_get(&cscene, "texture_cache_size");
+
 	params.use_qbvh = DebugFlags().cpu.qbvh;
+	params.use_bvh8 = DebugFlags().cpu.bvh8;
 
 	return params;
 }
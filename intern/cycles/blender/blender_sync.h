@@ -59,6 +59,7 @@ public:
 
 	/* sync */
 	bool sync_recalc();
+	void sync_recalc_persistent(BL::BlendData& b_data, BL::Scene& b_scene);
 	void sync_data(BL::RenderSettings& b_render,
 	               BL::SpaceView3D& b_v3d,
 	               BL::Object& b_override,
@@ -22,6 +22,7 @@
 
 #include "bvh/bvh2.h"
 #include "bvh/bvh4.h"
+#include "bvh/bvh8.h"
 #include "bvh/bvh_build.h"
 #include "bvh/bvh_node.h"
 
@@ -47,11 +48,16 @@ int BVHStackEntry::encodeIdx() const
 BVH::BVH(const BVHParams& params_, const vector<Object*>& objects_)
 : params(params_), objects(objects_)
 {
+	build_sah_cost = 0.0f;
+	sah_cost = 0.0f;
+	refit_leaf_area = 0.0f;
 }
 
 BVH *BVH::create(const BVHParams& params, const vector<Object*>& objects)
 {
-	if(params.use_qbvh)
+	if(params.use_bvh8)
+		return new BVH8(params, objects);
+	else if(params.use_qbvh)
 		return new BVH4(params, objects);
 	else
 		return new BVH2(params, objects);
@@ -91,6 +97,12 @@ void BVH::build(Progress& progress)
 	progress.set_substatus("Packing BVH nodes");
 	pack_nodes(root);
 
+	/* reference cost for refit, only object BVHs are refitted */
+	if(!params.top_level) {
+		build_sah_cost = leaf_sah_cost(root);
+		sah_cost = build_sah_cost;
+	}
+
 	/* free build nodes */
 	root->deleteSubtree();
 }
@@ -105,9 +117,58 @@ void BVH::refit(Progress& progress)
 	if(progress.get_cancel()) return;
 
 	progress.set_substatus("Refitting BVH nodes");
+	refit_leaf_area = 0.0f;
 	refit_nodes();
 }
 
+/* Leaf SAH Cost
+ *
+ * Leaf bounds are recomputed from the primitives the same way refit does, so
+ * spatial split clipping does not make a fresh build look cheaper than an
+ * identical refit. */
+
+float BVH::leaf_sah_cost(const BVHNode *root)
+{
+	float leaf_area = 0.0f;
+	BoundBox root_bbox = BoundBox::empty;
+
+	vector<const BVHNode*> stack;
+	stack.push_back(root);
+
+	while(!stack.empty()) {
+		const BVHNode *node = stack.back();
+		stack.pop_back();
+
+		if(node->is_leaf()) {
+			const LeafNode *leaf = reinterpret_cast<const LeafNode*>(node);
+			BoundBox bbox = BoundBox::empty;
+			uint visibility = 0;
+
+			refit_primitives(leaf->lo, leaf->hi, bbox, visibility);
+			leaf_area += leaf->num_triangles() * bbox.safe_area();
+			root_bbox.grow(bbox);
+		}
+		else {
+			for(int i = 0; i < node->num_children(); i++)
+				stack.push_back(node->get_child(i));
+		}
+	}
+
+	const float root_area = root_bbox.safe_area();
+	return (root_area > 0.0f)? leaf_area / root_area: 0.0f;
+}
+
+void BVH::refit_leaf_sah_add(int start, int end, const BoundBox& bbox)
+{
+	refit_leaf_area += (end - start) * bbox.safe_area();
+}
+
+void BVH::refit_leaf_sah_finish(const BoundBox& root_bbox)
+{
+	const float root_area = root_bbox.safe_area();
+	sah_cost = (root_area > 0.0f)? refit_leaf_area / root_area: 0.0f;
+}
+
 void BVH::refit_primitives(int start, int end, BoundBox& bbox, uint& visibility)
 {
 	/* Refit range of primitives. */
@@ -249,6 +310,7 @@ void BVH::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
 	 * top level BVH, adjusting indexes and offsets where appropriate.
 	 */
 	const bool use_qbvh = params.use_qbvh;
+	const bool use_bvh8 = params.use_bvh8;
 
 	/* Adjust primitive index to point to the triangle in the global array, for
 	 * meshes with transform applied and already in the top level BVH.
@@ -425,14 +487,26 @@ void BVH::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
 			for(size_t i = 0, j = 0; i < bvh_nodes_size; j++) {
 				size_t nsize, nsize_bbox;
 				if(bvh_nodes[i].x & PATH_RAY_NODE_UNALIGNED) {
-					nsize = use_qbvh
-					            ? BVH_UNALIGNED_QNODE_SIZE
-					            : BVH_UNALIGNED_NODE_SIZE;
-					nsize_bbox = (use_qbvh)? 13: 0;
+					if(use_bvh8) {
+						nsize = BVH_UNALIGNED_ONODE_SIZE;
+						nsize_bbox = 26;
+					}
+					else {
+						nsize = use_qbvh
+						            ? BVH_UNALIGNED_QNODE_SIZE
+						            : BVH_UNALIGNED_NODE_SIZE;
+						nsize_bbox = (use_qbvh)? 13: 0;
+					}
 				}
 				else {
-					nsize = (use_qbvh)? BVH_QNODE_SIZE: BVH_NODE_SIZE;
-					nsize_bbox = (use_qbvh)? 7: 0;
+					if(use_bvh8) {
+						nsize = BVH_ONODE_SIZE;
+						nsize_bbox = 14;
+					}
+					else {
+						nsize = (use_qbvh)? BVH_QNODE_SIZE: BVH_NODE_SIZE;
+						nsize_bbox = (use_qbvh)? 7: 0;
+					}
 				}
 
 				memcpy(pack_nodes + pack_nodes_offset,
@@ -445,19 +519,33 @@ void BVH::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
 				data.z += (data.z < 0)? -noffset_leaf: noffset;
 				data.w += (data.w < 0)? -noffset_leaf: noffset;
 
-				if(use_qbvh) {
+				if(use_qbvh || use_bvh8) {
 					data.x += (data.x < 0)? -noffset_leaf: noffset;
 					data.y += (data.y < 0)? -noffset_leaf: noffset;
 				}
 
 				pack_nodes[pack_nodes_offset + nsize_bbox] = data;
 
+				/* Octo BVH stores children indices in two int4. */
+				size_t nsize_children = 1;
+				if(use_bvh8) {
+					data = bvh_nodes[i + nsize_bbox + 1];
+
+					data.x += (data.x < 0)? -noffset_leaf: noffset;
+					data.y += (data.y < 0)? -noffset_leaf: noffset;
+					data.z += (data.z < 0)? -noffset_leaf: noffset;
+					data.w += (data.w < 0)? -noffset_leaf: noffset;
+
+					pack_nodes[pack_nodes_offset + nsize_bbox + 1] = data;
+					nsize_children = 2;
+				}
+
 				/* Usually this copies nothing, but we better
 				 * be prepared for possible node size extension.
 				 */
-				memcpy(&pack_nodes[pack_nodes_offset + nsize_bbox+1],
-				       &bvh_nodes[i + nsize_bbox+1],
-				       sizeof(int4) * (nsize - (nsize_bbox+1)));
+				memcpy(&pack_nodes[pack_nodes_offset + nsize_bbox + nsize_children],
+				       &bvh_nodes[i + nsize_bbox + nsize_children],
+				       sizeof(int4) * (nsize - (nsize_bbox + nsize_children)));
 
 				pack_nodes_offset += nsize;
 				i += nsize;
@@ -82,6 +82,13 @@ public:
 	BVHParams params;
 	vector<Object*> objects;
 
+	/* Surface area heuristic cost of the leaf primitives relative to the root
+	 * bounds, as measured after the last full build and after the last refit.
+	 * Refit keeps the tree layout, so when geometry deforms a lot the refit
+	 * cost grows and the tree is better rebuilt from scratch. */
+	float build_sah_cost;
+	float sah_cost;
+
 	static BVH *create(const BVHParams& params, const vector<Object*>& objects);
 	virtual ~BVH() {}
 
@@ -94,6 +101,14 @@ protected:
 	/* Refit range of primitives. */
 	void refit_primitives(int start, int end, BoundBox& bbox, uint& visibility);
 
+	/* Leaf SAH cost, computed from build nodes or accumulated during refit. */
+	float leaf_sah_cost(const BVHNode *root);
+	void refit_leaf_sah_add(int start, int end, const BoundBox& bbox);
+	void refit_leaf_sah_finish(const BoundBox& root_bbox);
+
+	/* Sum of primitive count times surface area of refitted leaves. */
+	float refit_leaf_area;
+
 	/* triangles and strands */
 	void pack_primitives();
 	void pack_triangle(int idx, float4 storage[3]);
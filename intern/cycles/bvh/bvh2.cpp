@@ -242,6 +242,7 @@ void BVH2::refit_nodes()
 	BoundBox bbox = BoundBox::empty;
 	uint visibility = 0;
 	refit_node(0, (pack.root_index == -1)? true: false, bbox, visibility);
+	refit_leaf_sah_finish(bbox);
 }
 
 void BVH2::refit_node(int idx, bool leaf, BoundBox& bbox, uint& visibility)
@@ -254,6 +255,7 @@ void BVH2::refit_node(int idx, bool leaf, BoundBox& bbox, uint& visibility)
 		const int c1 = data[0].y;
 
 		BVH::refit_primitives(c0, c1, bbox, visibility);
+		refit_leaf_sah_add(c0, c1, bbox);
 
 		/* TODO(sergey): De-duplicate with pack_leaf(). */
 		float4 leaf_data[BVH_NODE_LEAF_SIZE];
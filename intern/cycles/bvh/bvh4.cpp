@@ -370,6 +370,7 @@ void BVH4::refit_nodes()
 	BoundBox bbox = BoundBox::empty;
 	uint visibility = 0;
 	refit_node(0, (pack.root_index == -1)? true: false, bbox, visibility);
+	refit_leaf_sah_finish(bbox);
 }
 
 void BVH4::refit_node(int idx, bool leaf, BoundBox& bbox, uint& visibility)
@@ -380,6 +381,7 @@ void BVH4::refit_node(int idx, bool leaf, BoundBox& bbox, uint& visibility)
 		int4 c = data[0];
 
 		BVH::refit_primitives(c.x, c.y, bbox, visibility);
+		refit_leaf_sah_add(c.x, c.y, bbox);
 
 		/* TODO(sergey): This is actually a copy of pack_leaf(),
 		 * but this chunk of code only knows actual data and has
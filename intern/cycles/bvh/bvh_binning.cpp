@@ -23,6 +23,8 @@
 
 #include "util/util_algorithm.h"
 #include "util/util_boundbox.h"
+#include "util/util_simd.h"
+#include "util/util_task.h"
 #include "util/util_types.h"
 
 CCL_NAMESPACE_BEGIN
@@ -39,6 +41,34 @@ template<size_t src> __forceinline float extract(const int4& b)
 template<size_t dst> __forceinline const float4 insert(const float4& a, const float b)
 { float4 r = a; r[dst] = b; return r; }
 
+/* Bounding box growing, done with SSE when available since it's the inner
+ * loop of binning. Arguments order matches BoundBox::grow() so NaN values of
+ * the grown box are ignored the same way. */
+
+__forceinline void grow_bounds(BoundBox& box, const BoundBox& other)
+{
+#ifdef __KERNEL_SSE2__
+	_mm_store_ps(&box.min.x, _mm_min_ps(_mm_load_ps(&other.min.x), _mm_load_ps(&box.min.x)));
+	_mm_store_ps(&box.max.x, _mm_max_ps(_mm_load_ps(&other.max.x), _mm_load_ps(&box.max.x)));
+#else
+	/* Not BoundBox::grow(), which grows by both corners of the other box and
+	 * would turn an empty box into an infinite one. */
+	box.min = min(other.min, box.min);
+	box.max = max(other.max, box.max);
+#endif
+}
+
+__forceinline void grow_bounds(BoundBox& box, const float3& pt)
+{
+#ifdef __KERNEL_SSE2__
+	const __m128 p = _mm_load_ps(&pt.x);
+	_mm_store_ps(&box.min.x, _mm_min_ps(p, _mm_load_ps(&box.min.x)));
+	_mm_store_ps(&box.max.x, _mm_max_ps(p, _mm_load_ps(&box.max.x)));
+#else
+	box.grow(pt);
+#endif
+}
+
 __forceinline int get_best_dimension(const float4& bestSAH)
 {
 	// return (int)__bsf(movemask(reduce_min(bestSAH) == bestSAH));
@@ -82,57 +112,20 @@ BVHObjectBinning::BVHObjectBinning(const BVHRange& job,
 	num_bins = min(size_t(MAX_BINS), size_t(4.0f + 0.05f*size()));
 	scale = rcp(cent_bounds_.size()) * make_float3((float)num_bins);
 
-	/* initialize binning counter and bounds */
-	BoundBox bin_bounds[MAX_BINS][4];	/* bounds for every bin in every dimension */
-	int4 bin_count[MAX_BINS];			/* number of primitives mapped to bin */
+	/* map geometry to bins */
+	Bins bins;
 
-	for(size_t i = 0; i < num_bins; i++) {
-		bin_count[i] = make_int4(0);
-		bin_bounds[i][0] = bin_bounds[i][1] = bin_bounds[i][2] = BoundBox::empty;
+	if(size() >= PARALLEL_BINNING_THRESHOLD && TaskScheduler::num_threads() > 1) {
+		bin_primitives_parallel(prims, &bins);
 	}
-
-	/* map geometry to bins, unrolled once */
-	{
-		ssize_t i;
-
-		for(i = 0; i < ssize_t(size()) - 1; i += 2) {
-			prefetch_L2(&prims[start() + i + 8]);
-
-			/* map even and odd primitive to bin */
-			const BVHReference& prim0 = prims[start() + i + 0];
-			const BVHReference& prim1 = prims[start() + i + 1];
-
-			BoundBox bounds0 = get_prim_bounds(prim0);
-			BoundBox bounds1 = get_prim_bounds(prim1);
-
-			int4 bin0 = get_bin(bounds0);
-			int4 bin1 = get_bin(bounds1);
-
-			/* increase bounds for bins for even primitive */
-			int b00 = (int)extract<0>(bin0); bin_count[b00][0]++; bin_bounds[b00][0].grow(bounds0);
-			int b01 = (int)extract<1>(bin0); bin_count[b01][1]++; bin_bounds[b01][1].grow(bounds0);
-			int b02 = (int)extract<2>(bin0); bin_count[b02][2]++; bin_bounds[b02][2].grow(bounds0);
-
-			/* increase bounds of bins for odd primitive */
-			int b10 = (int)extract<0>(bin1); bin_count[b10][0]++; bin_bounds[b10][0].grow(bounds1);
-			int b11 = (int)extract<1>(bin1); bin_count[b11][1]++; bin_bounds[b11][1].grow(bounds1);
-			int b12 = (int)extract<2>(bin1); bin_count[b12][2]++; bin_bounds[b12][2].grow(bounds1);
-		}
-
-		/* for uneven number of primitives */
-		if(i < ssize_t(size())) {
-			/* map primitive to bin */
-			const BVHReference& prim0 = prims[start() + i];
-			BoundBox bounds0 = get_prim_bounds(prim0);
-			int4 bin0 = get_bin(bounds0);
-
-			/* increase bounds of bins */
-			int b00 = (int)extract<0>(bin0); bin_count[b00][0]++; bin_bounds[b00][0].grow(bounds0);
-			int b01 = (int)extract<1>(bin0); bin_count[b01][1]++; bin_bounds[b01][1].grow(bounds0);
-			int b02 = (int)extract<2>(bin0); bin_count[b02][2]++; bin_bounds[b02][2].grow(bounds0);
-		}
+	else {
+		bins.reset(num_bins);
+		bin_primitives(prims, start(), start() + size(), &bins);
 	}
 
+	const BoundBox (*bin_bounds)[4] = bins.bounds;
+	const int4 *bin_count = bins.count;
+
 	/* sweep from right to left and compute parallel prefix of merged bounds */
 	float4 r_area[MAX_BINS];	/* area of bounds of primitives on the right */
 	float4 r_count[MAX_BINS];	/* number of primitives on the right */
@@ -188,6 +181,104 @@ BVHObjectBinning::BVHObjectBinning(const BVHRange& job,
 	leafSAH = bounds_.half_area() * blocks(size());
 }
 
+void BVHObjectBinning::Bins::reset(size_t num_bins)
+{
+	for(size_t i = 0; i < num_bins; i++) {
+		count[i] = make_int4(0);
+		bounds[i][0] = bounds[i][1] = bounds[i][2] = BoundBox::empty;
+	}
+}
+
+void BVHObjectBinning::Bins::merge(const Bins& other, size_t num_bins)
+{
+	for(size_t i = 0; i < num_bins; i++) {
+		count[i] = count[i] + other.count[i];
+		grow_bounds(bounds[i][0], other.bounds[i][0]);
+		grow_bounds(bounds[i][1], other.bounds[i][1]);
+		grow_bounds(bounds[i][2], other.bounds[i][2]);
+	}
+}
+
+void BVHObjectBinning::bin_primitives(const BVHReference *prims,
+                                      size_t begin,
+                                      size_t end,
+                                      Bins *bins) const
+{
+	BoundBox (*bin_bounds)[4] = bins->bounds;
+	int4 *bin_count = bins->count;
+
+	/* unrolled once */
+	ssize_t i;
+
+	for(i = begin; i < ssize_t(end) - 1; i += 2) {
+		prefetch_L2(&prims[i + 8]);
+
+		/* map even and odd primitive to bin */
+		const BVHReference& prim0 = prims[i + 0];
+		const BVHReference& prim1 = prims[i + 1];
+
+		BoundBox bounds0 = get_prim_bounds(prim0);
+		BoundBox bounds1 = get_prim_bounds(prim1);
+
+		int4 bin0 = get_bin(bounds0);
+		int4 bin1 = get_bin(bounds1);
+
+		/* increase bounds for bins for even primitive */
+		int b00 = (int)extract<0>(bin0); bin_count[b00][0]++; grow_bounds(bin_bounds[b00][0], bounds0);
+		int b01 = (int)extract<1>(bin0); bin_count[b01][1]++; grow_bounds(bin_bounds[b01][1], bounds0);
+		int b02 = (int)extract<2>(bin0); bin_count[b02][2]++; grow_bounds(bin_bounds[b02][2], bounds0);
+
+		/* increase bounds of bins for odd primitive */
+		int b10 = (int)extract<0>(bin1); bin_count[b10][0]++; grow_bounds(bin_bounds[b10][0], bounds1);
+		int b11 = (int)extract<1>(bin1); bin_count[b11][1]++; grow_bounds(bin_bounds[b11][1], bounds1);
+		int b12 = (int)extract<2>(bin1); bin_count[b12][2]++; grow_bounds(bin_bounds[b12][2], bounds1);
+	}
+
+	/* for uneven number of primitives */
+	if(i < ssize_t(end)) {
+		/* map primitive to bin */
+		const BVHReference& prim0 = prims[i];
+		BoundBox bounds0 = get_prim_bounds(prim0);
+		int4 bin0 = get_bin(bounds0);
+
+		/* increase bounds of bins */
+		int b00 = (int)extract<0>(bin0); bin_count[b00][0]++; grow_bounds(bin_bounds[b00][0], bounds0);
+		int b01 = (int)extract<1>(bin0); bin_count[b01][1]++; grow_bounds(bin_bounds[b01][1], bounds0);
+		int b02 = (int)extract<2>(bin0); bin_count[b02][2]++; grow_bounds(bin_bounds[b02][2], bounds0);
+	}
+}
+
+void BVHObjectBinning::bin_primitives_parallel(const BVHReference *prims,
+                                               Bins *bins) const
+{
+	const size_t num_blocks = divide_up(size(), (size_t)PARALLEL_BINNING_BLOCK_SIZE);
+	vector<Bins> block_bins(num_blocks);
+
+	/* Every block gets its own bins, so no locking is needed. This is called
+	 * from the build tasks as well, waiting here runs our own tasks only. */
+	TaskPool pool;
+
+	for(size_t block = 0; block < num_blocks; block++) {
+		const size_t block_begin = start() + block * PARALLEL_BINNING_BLOCK_SIZE;
+		const size_t block_end = min(block_begin + PARALLEL_BINNING_BLOCK_SIZE, (size_t)end());
+
+		block_bins[block].reset(num_bins);
+		pool.push(function_bind(&BVHObjectBinning::bin_primitives,
+		                        this,
+		                        prims,
+		                        block_begin,
+		                        block_end,
+		                        &block_bins[block]));
+	}
+
+	pool.wait_work();
+
+	*bins = block_bins[0];
+	for(size_t block = 1; block < num_blocks; block++) {
+		bins->merge(block_bins[block], num_bins);
+	}
+}
+
 void BVHObjectBinning::split(BVHReference* prims,
                              BVHObjectBinning& left_o,
                              BVHObjectBinning& right_o) const
@@ -211,13 +302,13 @@ void BVHObjectBinning::split(BVHReference* prims,
 		float3 center = prim.bounds().center2();
 
 		if(get_bin(unaligned_center)[dim] < pos) {
-			lgeom_bounds.grow(prim.bounds());
-			lcent_bounds.grow(center);
+			grow_bounds(lgeom_bounds, prim.bounds());
+			grow_bounds(lcent_bounds, center);
 			l++;
 		}
 		else {
-			rgeom_bounds.grow(prim.bounds());
-			rcent_bounds.grow(center);
+			grow_bounds(rgeom_bounds, prim.bounds());
+			grow_bounds(rcent_bounds, center);
 			swap(prims[start()+l],prims[start()+r]);
 			r--;
 		}
@@ -27,12 +27,15 @@ CCL_NAMESPACE_BEGIN
 
 class BVHBuild;
 
-/* Single threaded object binner. Finds the split with the best SAH heuristic
- * by testing for each dimension multiple partitionings for regular spaced
- * partition locations. A partitioning for a partition location is computed,
- * by putting primitives whose centroid is on the left and right of the split
- * location to different sets. The SAH is evaluated by computing the number of
- * blocks occupied by the primitives in the partitions. */
+/* Object binner. Finds the split with the best SAH heuristic by testing for
+ * each dimension multiple partitionings for regular spaced partition
+ * locations. A partitioning for a partition location is computed, by putting
+ * primitives whose centroid is on the left and right of the split location to
+ * different sets. The SAH is evaluated by computing the number of blocks
+ * occupied by the primitives in the partitions.
+ *
+ * Large ranges, such as the top levels of the tree, are binned in parallel
+ * blocks which are merged afterwards. */
 
 class BVHObjectBinning : public BVHRange
 {
@@ -69,6 +72,27 @@ protected:
 	enum { MAX_BINS = 32 };
 	enum { LOG_BLOCK_SIZE = 2 };
 
+	/* Ranges with at least this many primitives are binned in parallel,
+	 * in blocks of PARALLEL_BINNING_BLOCK_SIZE primitives. */
+	enum { PARALLEL_BINNING_THRESHOLD = 65536 };
+	enum { PARALLEL_BINNING_BLOCK_SIZE = 16384 };
+
+	/* Bin counters and bounds, for all bins and all dimensions. */
+	struct Bins {
+		BoundBox bounds[MAX_BINS][4];
+		int4 count[MAX_BINS];
+
+		void reset(size_t num_bins);
+		void merge(const Bins& other, size_t num_bins);
+	};
+
+	/* Map primitives of the range [begin, end) to bins. */
+	void bin_primitives(const BVHReference *prims,
+	                    size_t begin,
+	                    size_t end,
+	                    Bins *bins) const;
+	void bin_primitives_parallel(const BVHReference *prims, Bins *bins) const;
+
 	/* computes the bin numbers for each dimension for a box. */
 	__forceinline int4 get_bin(const BoundBox& box) const
 	{
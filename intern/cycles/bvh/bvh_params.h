@@ -53,6 +53,9 @@ public:
 	/* QBVH */
 	bool use_qbvh;
 
+	/* Octo BVH, takes precedence over QBVH. */
+	bool use_bvh8;
+
 	/* Mask of primitives to be included into the BVH. */
 	int primitive_mask;
 
@@ -99,6 +102,7 @@ public:
 
 		top_level = false;
 		use_qbvh = false;
+		use_bvh8 = false;
 		use_unaligned_nodes = false;
 
 		primitive_mask = PRIMITIVE_ALL;
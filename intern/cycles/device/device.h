@@ -57,6 +57,7 @@ public:
 	bool has_bindless_textures; /* flag for GPU and Multi device */
 	bool has_volume_decoupled;
 	bool has_qbvh;
+	bool has_bvh8;
 	bool has_osl;
 	bool use_split_kernel; /* Denotes if the device is going to run cycles using split-kernel */
 	int cpu_threads;
@@ -73,6 +74,7 @@ public:
 		has_bindless_textures = false;
 		has_volume_decoupled = false;
 		has_qbvh = false;
+		has_bvh8 = false;
 		has_osl = false;
 		use_split_kernel = false;
 	}
@@ -290,6 +292,9 @@ public:
 	/* open shading language, only for CPU device */
 	virtual void *osl_memory() { return NULL; }
 
+	/* texture cache for images read on demand, only for CPU device */
+	virtual void *texture_cache_memory() { return NULL; }
+
 	/* load/compile kernels, must be called before adding tasks */ 
 	virtual bool load_kernels(
 	        const DeviceRequestedFeatures& /*requested_features*/)
@@ -34,6 +34,7 @@
 #include "kernel/kernel_types.h"
 #include "kernel/split/kernel_split_data.h"
 #include "kernel/kernel_globals.h"
+#include "kernel/kernels/cpu/kernel_texture_cache.h"
 
 #include "kernel/filter/filter.h"
 
@@ -170,11 +171,17 @@ public:
 	OSLGlobals osl_globals;
 #endif
 
+	TextureCacheGlobals texture_cache_globals;
+
 	bool use_split_kernel;
+	bool use_packet_traversal;
 
 	DeviceRequestedFeatures requested_features;
 
 	KernelFunctions<void(*)(KernelGlobals *, float *, int, int, int, int, int)>             path_trace_kernel;
+	KernelFunctions<void(*)(KernelGlobals *, float *, int, int, int, int, int, int)>        path_trace_packet_kernel;
+	KernelFunctions<bool(*)(KernelGlobals *, float *, int, int, int, int, int, int)>        adaptive_filter_kernel;
+	KernelFunctions<void(*)(KernelGlobals *, float *, int, int, int, int, int, int, int)>   adaptive_adjust_samples_kernel;
 	KernelFunctions<void(*)(KernelGlobals *, uchar4 *, float *, float, int, int, int, int)> convert_to_half_float_kernel;
 	KernelFunctions<void(*)(KernelGlobals *, uchar4 *, float *, float, int, int, int, int)> convert_to_byte_kernel;
 	KernelFunctions<void(*)(KernelGlobals *, uint4 *, float4 *, int, int, int, int, int)>   shader_kernel;
@@ -212,6 +219,9 @@ public:
 	  texture_info(this, "__texture_info", MEM_TEXTURE),
 #define REGISTER_KERNEL(name) name ## _kernel(KERNEL_FUNCTIONS(name))
 	  REGISTER_KERNEL(path_trace),
+	  REGISTER_KERNEL(path_trace_packet),
+	  REGISTER_KERNEL(adaptive_filter),
+	  REGISTER_KERNEL(adaptive_adjust_samples),
 	  REGISTER_KERNEL(convert_to_half_float),
 	  REGISTER_KERNEL(convert_to_byte),
 	  REGISTER_KERNEL(shader),
@@ -237,7 +247,10 @@ public:
 #ifdef WITH_OSL
 		kernel_globals.osl = &osl_globals;
 #endif
+		kernel_globals.texture_cache = NULL;
+		kernel_globals.texture_cache_tdata = NULL;
 		use_split_kernel = DebugFlags().cpu.split_kernel;
+		use_packet_traversal = DebugFlags().cpu.packet_traversal;
 		if(use_split_kernel) {
 			VLOG(1) << "Will be using split kernel.";
 		}
@@ -435,6 +448,11 @@ public:
 #endif
 	}
 
+	void *texture_cache_memory()
+	{
+		return &texture_cache_globals;
+	}
+
 	void thread_run(DeviceTask *task)
 	{
 		if(task->type == DeviceTask::RENDER) {
@@ -689,22 +707,62 @@ public:
 		int start_sample = tile.start_sample;
 		int end_sample = tile.start_sample + tile.num_samples;
 
+		/* Adaptive sampling, converged pixels are skipped by the kernel and
+		 * the tile is finished early once all of its pixels converged. */
+		const KernelIntegrator& kintegrator = kg->__data.integrator;
+		const bool use_adaptive_sampling = kg->__data.film.pass_adaptive_aux_buffer != 0;
+
 		for(int sample = start_sample; sample < end_sample; sample++) {
 			if(task.get_cancel() || task_pool.canceled()) {
 				if(task.need_finish_queue == false)
 					break;
 			}
 
-			for(int y = tile.y; y < tile.y + tile.h; y++) {
-				for(int x = tile.x; x < tile.x + tile.w; x++) {
-					path_trace_kernel()(kg, render_buffer,
-					                    sample, x, y, tile.offset, tile.stride);
+			if(use_packet_traversal) {
+				for(int y = tile.y; y < tile.y + tile.h; y++) {
+					for(int x = tile.x; x < tile.x + tile.w; x += PATH_PACKET_SIZE) {
+						int num_pixels = min(PATH_PACKET_SIZE, tile.x + tile.w - x);
+						path_trace_packet_kernel()(kg, render_buffer,
+						                           sample, x, y, num_pixels,
+						                           tile.offset, tile.stride);
+					}
+				}
+			}
+			else {
+				for(int y = tile.y; y < tile.y + tile.h; y++) {
+					for(int x = tile.x; x < tile.x + tile.w; x++) {
+						path_trace_kernel()(kg, render_buffer,
+						                    sample, x, y, tile.offset, tile.stride);
+					}
 				}
 			}
 
 			tile.sample = sample + 1;
 
 			task.update_progress(&tile, tile.w*tile.h);
+
+			const int num_samples = tile.sample - start_sample;
+			if(use_adaptive_sampling &&
+			   num_samples >= kintegrator.adaptive_min_samples &&
+			   num_samples % kintegrator.adaptive_step == 0)
+			{
+				bool any = adaptive_filter_kernel()(kg, render_buffer,
+				                                    tile.x, tile.y, tile.w, tile.h,
+				                                    tile.offset, tile.stride);
+				if(!any) {
+					/* Count skipped samples as done for progress. */
+					int skipped_samples = end_sample - tile.sample;
+					tile.sample = end_sample;
+					task.update_progress(&tile, tile.w*tile.h*skipped_samples);
+					break;
+				}
+			}
+		}
+
+		if(use_adaptive_sampling) {
+			adaptive_adjust_samples_kernel()(kg, render_buffer, tile.sample,
+			                                 tile.x, tile.y, tile.w, tile.h,
+			                                 tile.offset, tile.stride);
 		}
 	}
 
@@ -820,6 +878,8 @@ public:
 #ifdef WITH_OSL
 		OSLShader::thread_init(&kg, &kernel_globals, &osl_globals);
 #endif
+		kernel_texture_cache_thread_init(&kg, &texture_cache_globals);
+
 		for(int sample = 0; sample < task.num_samples; sample++) {
 			for(int x = task.shader_x; x < task.shader_x + task.shader_w; x++)
 				shader_kernel()(&kg,
@@ -841,6 +901,7 @@ public:
 #ifdef WITH_OSL
 		OSLShader::thread_free(&kg);
 #endif
+		kernel_texture_cache_thread_free(&kg);
 	}
 
 	int get_split_task_count(DeviceTask& task)
@@ -892,6 +953,7 @@ protected:
 #ifdef WITH_OSL
 		OSLShader::thread_init(&kg, &kernel_globals, &osl_globals);
 #endif
+		kernel_texture_cache_thread_init(&kg, &texture_cache_globals);
 		return kg;
 	}
 
@@ -914,6 +976,7 @@ protected:
 #ifdef WITH_OSL
 		OSLShader::thread_free(kg);
 #endif
+		kernel_texture_cache_thread_free(kg);
 	}
 
 	virtual bool load_kernels(DeviceRequestedFeatures& requested_features_) {
@@ -1045,6 +1108,12 @@ void device_cpu_info(vector<DeviceInfo>& devices)
 	info.num = 0;
 	info.advanced_shading = true;
 	info.has_qbvh = system_cpu_support_sse2();
+	/* BVH8 traversal only exists in the AVX2 kernel. */
+#ifdef WITH_CYCLES_OPTIMIZED_KERNEL_AVX2
+	info.has_bvh8 = system_cpu_support_avx2();
+#else
+	info.has_bvh8 = false;
+#endif
 	info.has_volume_decoupled = true;
 	info.has_osl = true;
 
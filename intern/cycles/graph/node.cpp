@@ -18,6 +18,7 @@
 #include "graph/node_type.h"
 
 #include "util/util_foreach.h"
+#include "util/util_md5.h"
 #include "util/util_param.h"
 #include "util/util_transform.h"
 
@@ -403,5 +404,57 @@ bool Node::equals(const Node& other) const
 	return true;
 }
 
+/* hash */
+
+template<typename T>
+static void hash_array(const Node *node, const SocketType& socket, MD5Hash& md5)
+{
+	const array<T>& a = get_socket_value<array<T> >(node, socket);
+	const int size = (int)a.size();
+	md5.append((const uint8_t*)&size, sizeof(size));
+	md5.append((const uint8_t*)a.data(), sizeof(T)*size);
+}
+
+void Node::hash(MD5Hash& md5)
+{
+	foreach(const SocketType& socket, type->inputs) {
+		if(socket.is_array()) {
+			switch(socket.type) {
+				case SocketType::BOOLEAN_ARRAY: hash_array<bool>(this, socket, md5); break;
+				case SocketType::FLOAT_ARRAY: hash_array<float>(this, socket, md5); break;
+				case SocketType::INT_ARRAY: hash_array<int>(this, socket, md5); break;
+				case SocketType::COLOR_ARRAY: hash_array<float3>(this, socket, md5); break;
+				case SocketType::VECTOR_ARRAY: hash_array<float3>(this, socket, md5); break;
+				case SocketType::POINT_ARRAY: hash_array<float3>(this, socket, md5); break;
+				case SocketType::NORMAL_ARRAY: hash_array<float3>(this, socket, md5); break;
+				case SocketType::POINT2_ARRAY: hash_array<float2>(this, socket, md5); break;
+				case SocketType::STRING_ARRAY: hash_array<ustring>(this, socket, md5); break;
+				case SocketType::TRANSFORM_ARRAY: hash_array<Transform>(this, socket, md5); break;
+				case SocketType::NODE_ARRAY: hash_array<void*>(this, socket, md5); break;
+				default: assert(0); break;
+			}
+		}
+		else {
+			/* strings are unique pointers and nodes are compared by pointer,
+			 * so the raw value can be hashed for all other types */
+			const uint8_t *value = ((const uint8_t*)this) + socket.struct_offset;
+			md5.append(value, (int)socket.size());
+		}
+	}
+}
+
+bool Node::is_modified()
+{
+	MD5Hash md5;
+	hash(md5);
+	string new_hash = md5.get_hex();
+
+	if(new_hash == modified_hash)
+		return false;
+
+	modified_hash = new_hash;
+	return true;
+}
+
 CCL_NAMESPACE_END
 
@@ -20,10 +20,12 @@
 
 #include "util/util_map.h"
 #include "util/util_param.h"
+#include "util/util_string.h"
 #include "util/util_vector.h"
 
 CCL_NAMESPACE_BEGIN
 
+class MD5Hash;
 struct Node;
 struct NodeType;
 struct Transform;
@@ -88,8 +90,19 @@ struct Node
 	/* equals */
 	bool equals(const Node& other) const;
 
+	/* hash of all socket values, nodes can add data which is not a socket */
+	virtual void hash(MD5Hash& md5);
+
+	/* check if the node changed since the previous call, by comparing hashes.
+	 * used to skip device updates of data which is synchronized again but
+	 * did not change, for example between frames with persistent data */
+	bool is_modified();
+
 	ustring name;
 	const NodeType *type;
+
+protected:
+	string modified_hash;
 };
 
 CCL_NAMESPACE_END
@@ -34,6 +34,16 @@ CCL_NAMESPACE_BEGIN
 #  include "kernel/bvh/qbvh_nodes.h"
 #endif
 
+/* Common OBVH functions. */
+#ifdef __OBVH__
+#  include "kernel/bvh/obvh_nodes.h"
+#endif
+
+/* Packet traversal of coherent rays. */
+#ifdef __QBVH_PACKET__
+#  include "kernel/bvh/qbvh_packet.h"
+#endif
+
 /* Regular BVH traversal */
 
 #include "kernel/bvh/bvh_nodes.h"
@@ -201,6 +211,32 @@ ccl_device_intersect bool scene_intersect(KernelGlobals *kg,
 #endif /* __KERNEL_CPU__ */
 }
 
+#ifdef __QBVH_PACKET__
+/* Packet traversal handles triangles in a flat QBVH only, other scenes have
+ * to trace their rays one by one with scene_intersect().
+ */
+ccl_device_inline bool scene_intersect_packet_supported(KernelGlobals *kg)
+{
+	return kernel_data.bvh.use_qbvh &&
+	       !kernel_data.bvh.have_instancing &&
+	       !kernel_data.bvh.have_motion &&
+	       !kernel_data.bvh.have_curves;
+}
+
+/* Closest hit of up to PATH_PACKET_SIZE coherent rays, returns mask of the
+ * rays which hit anything.
+ */
+ccl_device_intersect int scene_intersect_packet(KernelGlobals *kg,
+                                                const Ray *rays,
+                                                const int num_rays,
+                                                const uint visibility,
+                                                Intersection *isects)
+{
+	kernel_assert(scene_intersect_packet_supported(kg));
+	return qbvh_intersect_packet(kg, rays, isects, num_rays, visibility);
+}
+#endif  /* __QBVH_PACKET__ */
+
 #ifdef __SUBSURFACE__
 /* Note: ray is passed by value to work around a possible CUDA compiler bug. */
 ccl_device_intersect void scene_intersect_subsurface(KernelGlobals *kg,
@@ -21,6 +21,10 @@
 #  include "kernel/bvh/qbvh_subsurface.h"
 #endif
 
+#ifdef __OBVH__
+#  include "kernel/bvh/obvh_subsurface.h"
+#endif
+
 #if BVH_FEATURE(BVH_HAIR)
 #  define NODE_INTERSECT bvh_node_intersect
 #else
@@ -240,6 +244,17 @@ ccl_device_inline void BVH_FUNCTION_NAME(KernelGlobals *kg,
                                          uint *lcg_state,
                                          int max_hits)
 {
+#ifdef __OBVH__
+	if(kernel_data.bvh.use_bvh8) {
+		return BVH_FUNCTION_FULL_NAME(OBVH)(kg,
+		                                    ray,
+		                                    ss_isect,
+		                                    subsurface_object,
+		                                    lcg_state,
+		                                    max_hits);
+	}
+	else
+#endif
 #ifdef __QBVH__
 	if(kernel_data.bvh.use_qbvh) {
 		return BVH_FUNCTION_FULL_NAME(QBVH)(kg,
@@ -253,6 +268,7 @@ ccl_device_inline void BVH_FUNCTION_NAME(KernelGlobals *kg,
 #endif
 	{
 		kernel_assert(kernel_data.bvh.use_qbvh == false);
+		kernel_assert(kernel_data.bvh.use_bvh8 == false);
 		return BVH_FUNCTION_FULL_NAME(BVH)(kg,
 		                                   ray,
 		                                   ss_isect,
@@ -21,6 +21,10 @@
 #  include "kernel/bvh/qbvh_traversal.h"
 #endif
 
+#ifdef __OBVH__
+#  include "kernel/bvh/obvh_traversal.h"
+#endif
+
 #if BVH_FEATURE(BVH_HAIR)
 #  define NODE_INTERSECT bvh_node_intersect
 #  define NODE_INTERSECT_ROBUST bvh_node_intersect_robust
@@ -426,6 +430,21 @@ ccl_device_inline bool BVH_FUNCTION_NAME(KernelGlobals *kg,
 #endif
                                          )
 {
+#ifdef __OBVH__
+	if(kernel_data.bvh.use_bvh8) {
+		return BVH_FUNCTION_FULL_NAME(OBVH)(kg,
+		                                    ray,
+		                                    isect,
+		                                    visibility
+#if BVH_FEATURE(BVH_HAIR_MINIMUM_WIDTH)
+		                                    , lcg_state,
+		                                    difl,
+		                                    extmax
+#endif
+		                                    );
+	}
+	else
+#endif
 #ifdef __QBVH__
 	if(kernel_data.bvh.use_qbvh) {
 		return BVH_FUNCTION_FULL_NAME(QBVH)(kg,
@@ -443,6 +462,7 @@ ccl_device_inline bool BVH_FUNCTION_NAME(KernelGlobals *kg,
 #endif
 	{
 		kernel_assert(kernel_data.bvh.use_qbvh == false);
+		kernel_assert(kernel_data.bvh.use_bvh8 == false);
 		return BVH_FUNCTION_FULL_NAME(BVH)(kg,
 		                                   ray,
 		                                   isect,
@@ -21,6 +21,10 @@
 #  include "kernel/bvh/qbvh_volume.h"
 #endif
 
+#ifdef __OBVH__
+#  include "kernel/bvh/obvh_volume.h"
+#endif
+
 #if BVH_FEATURE(BVH_HAIR)
 #  define NODE_INTERSECT bvh_node_intersect
 #else
@@ -309,6 +313,15 @@ ccl_device_inline bool BVH_FUNCTION_NAME(KernelGlobals *kg,
                                          Intersection *isect,
                                          const uint visibility)
 {
+#ifdef __OBVH__
+	if(kernel_data.bvh.use_bvh8) {
+		return BVH_FUNCTION_FULL_NAME(OBVH)(kg,
+		                                    ray,
+		                                    isect,
+		                                    visibility);
+	}
+	else
+#endif
 #ifdef __QBVH__
 	if(kernel_data.bvh.use_qbvh) {
 		return BVH_FUNCTION_FULL_NAME(QBVH)(kg,
@@ -320,6 +333,7 @@ ccl_device_inline bool BVH_FUNCTION_NAME(KernelGlobals *kg,
 #endif
 	{
 		kernel_assert(kernel_data.bvh.use_qbvh == false);
+		kernel_assert(kernel_data.bvh.use_bvh8 == false);
 		return BVH_FUNCTION_FULL_NAME(BVH)(kg,
 		                                   ray,
 		                                   isect,
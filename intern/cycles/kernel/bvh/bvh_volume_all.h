@@ -21,6 +21,10 @@
 #  include "kernel/bvh/qbvh_volume_all.h"
 #endif
 
+#ifdef __OBVH__
+#  include "kernel/bvh/obvh_volume_all.h"
+#endif
+
 #if BVH_FEATURE(BVH_HAIR)
 #  define NODE_INTERSECT bvh_node_intersect
 #else
@@ -381,6 +385,16 @@ ccl_device_inline uint BVH_FUNCTION_NAME(KernelGlobals *kg,
                                          const uint max_hits,
                                          const uint visibility)
 {
+#ifdef __OBVH__
+	if(kernel_data.bvh.use_bvh8) {
+		return BVH_FUNCTION_FULL_NAME(OBVH)(kg,
+		                                    ray,
+		                                    isect_array,
+		                                    max_hits,
+		                                    visibility);
+	}
+	else
+#endif
 #ifdef __QBVH__
 	if(kernel_data.bvh.use_qbvh) {
 		return BVH_FUNCTION_FULL_NAME(QBVH)(kg,
@@ -393,6 +407,7 @@ ccl_device_inline uint BVH_FUNCTION_NAME(KernelGlobals *kg,
 #endif
 	{
 		kernel_assert(kernel_data.bvh.use_qbvh == false);
+		kernel_assert(kernel_data.bvh.use_bvh8 == false);
 		return BVH_FUNCTION_FULL_NAME(BVH)(kg,
 		                                   ray,
 		                                   isect_array,
@@ -0,0 +1,380 @@
+/*
+ * Copyright 2011-2017, Blender Foundation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Octo BVH nodes, same layout as the QBVH ones but with two float4 per row
+ * so that all eight children are intersected with a single AVX instruction.
+ * Only used by the AVX2 kernel.
+ */
+
+struct OBVHStackItem {
+	int addr;
+	float dist;
+};
+
+ccl_device_inline void obvh_near_far_idx_calc(const float3& idir,
+                                              int *ccl_restrict near_x,
+                                              int *ccl_restrict near_y,
+                                              int *ccl_restrict near_z,
+                                              int *ccl_restrict far_x,
+                                              int *ccl_restrict far_y,
+                                              int *ccl_restrict far_z)
+
+{
+	/* Offsets of the bounding box rows, every row takes two float4. */
+	*near_x = 0; *far_x = 2;
+	*near_y = 4; *far_y = 6;
+	*near_z = 8; *far_z = 10;
+
+	const size_t mask = movemask(ssef(idir.m128));
+
+	const int mask_x = (mask & 1) << 1;
+	const int mask_y = mask & 2;
+	const int mask_z = (mask & 4) >> 1;
+
+	*near_x += mask_x; *far_x -= mask_x;
+	*near_y += mask_y; *far_y -= mask_y;
+	*near_z += mask_z; *far_z -= mask_z;
+}
+
+/* Sort stack items so the closest one ends up on top of the stack. */
+ccl_device_inline void obvh_stack_sort(OBVHStackItem *ccl_restrict items,
+                                       const int num_items)
+{
+	for(int i = 1; i < num_items; i++) {
+		const OBVHStackItem item = items[i];
+		int j = i - 1;
+		while(j >= 0 && items[j].dist < item.dist) {
+			items[j + 1] = items[j];
+			j--;
+		}
+		items[j + 1] = item;
+	}
+}
+
+ccl_device_inline OBVHStackItem obvh_stack_item(const avxf& cnodes,
+                                                const avxf& dist,
+                                                const int index)
+{
+	OBVHStackItem item;
+	item.addr = cnodes.i[index];
+	item.dist = dist.f[index];
+	return item;
+}
+
+/* Pick the child to continue traversal with from the mask of hit children,
+ * pushing all the other hit children onto the traversal stack.
+ */
+ccl_device_inline OBVHStackItem obvh_traverse_children(
+        int child_mask,
+        const avxf& cnodes,
+        const avxf& dist,
+        OBVHStackItem *ccl_restrict traversal_stack,
+        int *ccl_restrict stack_ptr)
+{
+	/* One child is hit, continue with that child. */
+	int r = __bscf(child_mask);
+	const OBVHStackItem c0 = obvh_stack_item(cnodes, dist, r);
+	if(child_mask == 0) {
+		return c0;
+	}
+
+	/* Two children are hit, push far child, and continue with closer child. */
+	r = __bscf(child_mask);
+	const OBVHStackItem c1 = obvh_stack_item(cnodes, dist, r);
+	if(child_mask == 0) {
+		++*stack_ptr;
+		kernel_assert(*stack_ptr < BVH_OSTACK_SIZE);
+		if(c1.dist < c0.dist) {
+			traversal_stack[*stack_ptr] = c0;
+			return c1;
+		}
+		else {
+			traversal_stack[*stack_ptr] = c1;
+			return c0;
+		}
+	}
+
+	/* Here starts the slow path for 3 or more hit children. We push all
+	 * nodes onto the stack to sort them there, and continue with the
+	 * closest one.
+	 */
+	int num_items = 2;
+	traversal_stack[++*stack_ptr] = c1;
+	traversal_stack[++*stack_ptr] = c0;
+	while(child_mask != 0) {
+		r = __bscf(child_mask);
+		traversal_stack[++*stack_ptr] = obvh_stack_item(cnodes, dist, r);
+		num_items++;
+	}
+	kernel_assert(*stack_ptr < BVH_OSTACK_SIZE);
+
+	obvh_stack_sort(&traversal_stack[*stack_ptr - num_items + 1], num_items);
+
+	return traversal_stack[(*stack_ptr)--];
+}
+
+/* Axis-aligned nodes intersection */
+
+ccl_device_inline int obvh_aligned_node_intersect(KernelGlobals *ccl_restrict kg,
+                                                  const avxf& isect_near,
+                                                  const avxf& isect_far,
+                                                  const avx3f& org_idir,
+                                                  const avx3f& idir,
+                                                  const int near_x,
+                                                  const int near_y,
+                                                  const int near_z,
+                                                  const int far_x,
+                                                  const int far_y,
+                                                  const int far_z,
+                                                  const int node_addr,
+                                                  avxf *ccl_restrict dist)
+{
+	const int offset = node_addr + 2;
+	const avxf tnear_x = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+near_x), idir.x, org_idir.x);
+	const avxf tnear_y = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+near_y), idir.y, org_idir.y);
+	const avxf tnear_z = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+near_z), idir.z, org_idir.z);
+	const avxf tfar_x = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+far_x), idir.x, org_idir.x);
+	const avxf tfar_y = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+far_y), idir.y, org_idir.y);
+	const avxf tfar_z = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+far_z), idir.z, org_idir.z);
+
+	const avxf tnear = max(max(tnear_x, tnear_y), max(tnear_z, isect_near));
+	const avxf tfar = min(min(tfar_x, tfar_y), min(tfar_z, isect_far));
+	const avxf vmask = tnear <= tfar;
+	*dist = tnear;
+	return movemask(vmask);
+}
+
+ccl_device_inline int obvh_aligned_node_intersect_robust(
+        KernelGlobals *ccl_restrict kg,
+        const avxf& isect_near,
+        const avxf& isect_far,
+        const avx3f& P_idir,
+        const avx3f& idir,
+        const int near_x,
+        const int near_y,
+        const int near_z,
+        const int far_x,
+        const int far_y,
+        const int far_z,
+        const int node_addr,
+        const float difl,
+        avxf *ccl_restrict dist)
+{
+	const int offset = node_addr + 2;
+	const avxf tnear_x = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+near_x), idir.x, P_idir.x);
+	const avxf tnear_y = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+near_y), idir.y, P_idir.y);
+	const avxf tnear_z = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+near_z), idir.z, P_idir.z);
+	const avxf tfar_x = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+far_x), idir.x, P_idir.x);
+	const avxf tfar_y = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+far_y), idir.y, P_idir.y);
+	const avxf tfar_z = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+far_z), idir.z, P_idir.z);
+
+	const float round_down = 1.0f - difl;
+	const float round_up = 1.0f + difl;
+	const avxf tnear = max(max(tnear_x, tnear_y), max(tnear_z, isect_near));
+	const avxf tfar = min(min(tfar_x, tfar_y), min(tfar_z, isect_far));
+	const avxf vmask = round_down*tnear <= round_up*tfar;
+	*dist = tnear;
+	return movemask(vmask);
+}
+
+/* Unaligned nodes intersection */
+
+ccl_device_inline void obvh_unaligned_node_slabs(KernelGlobals *ccl_restrict kg,
+                                                 const avx3f& org,
+                                                 const avx3f& dir,
+                                                 const int node_addr,
+                                                 avx3f *ccl_restrict tnear,
+                                                 avx3f *ccl_restrict tfar)
+{
+	const int offset = node_addr + 2;
+	const avxf tfm_x_x = kernel_tex_fetch_avxf(__bvh_nodes, offset);
+	const avxf tfm_x_y = kernel_tex_fetch_avxf(__bvh_nodes, offset+2);
+	const avxf tfm_x_z = kernel_tex_fetch_avxf(__bvh_nodes, offset+4);
+
+	const avxf tfm_y_x = kernel_tex_fetch_avxf(__bvh_nodes, offset+6);
+	const avxf tfm_y_y = kernel_tex_fetch_avxf(__bvh_nodes, offset+8);
+	const avxf tfm_y_z = kernel_tex_fetch_avxf(__bvh_nodes, offset+10);
+
+	const avxf tfm_z_x = kernel_tex_fetch_avxf(__bvh_nodes, offset+12);
+	const avxf tfm_z_y = kernel_tex_fetch_avxf(__bvh_nodes, offset+14);
+	const avxf tfm_z_z = kernel_tex_fetch_avxf(__bvh_nodes, offset+16);
+
+	const avxf tfm_t_x = kernel_tex_fetch_avxf(__bvh_nodes, offset+18);
+	const avxf tfm_t_y = kernel_tex_fetch_avxf(__bvh_nodes, offset+20);
+	const avxf tfm_t_z = kernel_tex_fetch_avxf(__bvh_nodes, offset+22);
+
+	const avxf aligned_dir_x = dir.x*tfm_x_x + dir.y*tfm_x_y + dir.z*tfm_x_z,
+	           aligned_dir_y = dir.x*tfm_y_x + dir.y*tfm_y_y + dir.z*tfm_y_z,
+	           aligned_dir_z = dir.x*tfm_z_x + dir.y*tfm_z_y + dir.z*tfm_z_z;
+
+	const avxf aligned_P_x = org.x*tfm_x_x + org.y*tfm_x_y + org.z*tfm_x_z + tfm_t_x,
+	           aligned_P_y = org.x*tfm_y_x + org.y*tfm_y_y + org.z*tfm_y_z + tfm_t_y,
+	           aligned_P_z = org.x*tfm_z_x + org.y*tfm_z_y + org.z*tfm_z_z + tfm_t_z;
+
+	const avxf neg_one(-1.0f);
+	const avxf nrdir_x = neg_one / aligned_dir_x,
+	           nrdir_y = neg_one / aligned_dir_y,
+	           nrdir_z = neg_one / aligned_dir_z;
+
+	const avxf tlower_x = aligned_P_x * nrdir_x,
+	           tlower_y = aligned_P_y * nrdir_y,
+	           tlower_z = aligned_P_z * nrdir_z;
+
+	const avxf tupper_x = tlower_x - nrdir_x,
+	           tupper_y = tlower_y - nrdir_y,
+	           tupper_z = tlower_z - nrdir_z;
+
+	tnear->x = min(tlower_x, tupper_x);
+	tnear->y = min(tlower_y, tupper_y);
+	tnear->z = min(tlower_z, tupper_z);
+	tfar->x = max(tlower_x, tupper_x);
+	tfar->y = max(tlower_y, tupper_y);
+	tfar->z = max(tlower_z, tupper_z);
+}
+
+ccl_device_inline int obvh_unaligned_node_intersect(
+        KernelGlobals *ccl_restrict kg,
+        const avxf& isect_near,
+        const avxf& isect_far,
+        const avx3f& org,
+        const avx3f& dir,
+        const int node_addr,
+        avxf *ccl_restrict dist)
+{
+	avx3f tnear_xyz, tfar_xyz;
+	obvh_unaligned_node_slabs(kg, org, dir, node_addr, &tnear_xyz, &tfar_xyz);
+
+	/* Empty child slots are filled with NaN, min/max return the second
+	 * operand when either is NaN so the ray interval goes first to keep NaN
+	 * lanes from ever being counted as a hit.
+	 */
+	const avxf tnear = max(max(isect_near, tnear_xyz.x), max(tnear_xyz.y, tnear_xyz.z));
+	const avxf tfar = min(min(isect_far, tfar_xyz.x), min(tfar_xyz.y, tfar_xyz.z));
+	const avxf vmask = tnear <= tfar;
+	*dist = tnear;
+	return movemask(vmask);
+}
+
+ccl_device_inline int obvh_unaligned_node_intersect_robust(
+        KernelGlobals *ccl_restrict kg,
+        const avxf& isect_near,
+        const avxf& isect_far,
+        const avx3f& P,
+        const avx3f& dir,
+        const int node_addr,
+        const float difl,
+        avxf *ccl_restrict dist)
+{
+	avx3f tnear_xyz, tfar_xyz;
+	obvh_unaligned_node_slabs(kg, P, dir, node_addr, &tnear_xyz, &tfar_xyz);
+
+	const float round_down = 1.0f - difl;
+	const float round_up = 1.0f + difl;
+	const avxf tnear = max(max(isect_near, tnear_xyz.x), max(tnear_xyz.y, tnear_xyz.z));
+	const avxf tfar = min(min(isect_far, tfar_xyz.x), min(tfar_xyz.y, tfar_xyz.z));
+	const avxf vmask = round_down*tnear <= round_up*tfar;
+	*dist = tnear;
+	return movemask(vmask);
+}
+
+/* Intersectors wrappers.
+ *
+ * They'll check node type and call appropriate intersection code.
+ */
+
+ccl_device_inline int obvh_node_intersect(
+        KernelGlobals *ccl_restrict kg,
+        const avxf& isect_near,
+        const avxf& isect_far,
+        const avx3f& org_idir,
+        const avx3f& org,
+        const avx3f& dir,
+        const avx3f& idir,
+        const int near_x,
+        const int near_y,
+        const int near_z,
+        const int far_x,
+        const int far_y,
+        const int far_z,
+        const int node_addr,
+        avxf *ccl_restrict dist)
+{
+	const int offset = node_addr;
+	const float4 node = kernel_tex_fetch(__bvh_nodes, offset);
+	if(__float_as_uint(node.x) & PATH_RAY_NODE_UNALIGNED) {
+		return obvh_unaligned_node_intersect(kg,
+		                                     isect_near,
+		                                     isect_far,
+		                                     org,
+		                                     dir,
+		                                     node_addr,
+		                                     dist);
+	}
+	else {
+		return obvh_aligned_node_intersect(kg,
+		                                   isect_near,
+		                                   isect_far,
+		                                   org_idir,
+		                                   idir,
+		                                   near_x, near_y, near_z,
+		                                   far_x, far_y, far_z,
+		                                   node_addr,
+		                                   dist);
+	}
+}
+
+ccl_device_inline int obvh_node_intersect_robust(
+        KernelGlobals *ccl_restrict kg,
+        const avxf& isect_near,
+        const avxf& isect_far,
+        const avx3f& P_idir,
+        const avx3f& P,
+        const avx3f& dir,
+        const avx3f& idir,
+        const int near_x,
+        const int near_y,
+        const int near_z,
+        const int far_x,
+        const int far_y,
+        const int far_z,
+        const int node_addr,
+        const float difl,
+        avxf *ccl_restrict dist)
+{
+	const int offset = node_addr;
+	const float4 node = kernel_tex_fetch(__bvh_nodes, offset);
+	if(__float_as_uint(node.x) & PATH_RAY_NODE_UNALIGNED) {
+		return obvh_unaligned_node_intersect_robust(kg,
+		                                            isect_near,
+		                                            isect_far,
+		                                            P,
+		                                            dir,
+		                                            node_addr,
+		                                            difl,
+		                                            dist);
+	}
+	else {
+		return obvh_aligned_node_intersect_robust(kg,
+		                                          isect_near,
+		                                          isect_far,
+		                                          P_idir,
+		                                          idir,
+		                                          near_x, near_y, near_z,
+		                                          far_x, far_y, far_z,
+		                                          node_addr,
+		                                          difl,
+		                                          dist);
+	}
+}
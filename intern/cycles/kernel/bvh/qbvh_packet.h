@@ -0,0 +1,244 @@
+/*
+ * Copyright 2011-2017 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Packet traversal of coherent rays through the QBVH.
+ *
+ * Up to PATH_PACKET_SIZE rays share every node fetch: bounds of the four
+ * children are loaded once and tested against each ray of the packet, and a
+ * child is visited as soon as any ray hits it. Distances of the rays to a node
+ * are kept in the SIMD lanes of the stack items, so rays which already found
+ * a closer hit drop out of the subtree without being tested.
+ *
+ * Only triangles in a single flat BVH are supported, scenes with instancing,
+ * motion blur or curves are traced ray by ray, see scene_intersect_packet().
+ */
+
+struct QBVHPacketStackItem {
+	/* Distance to the node per ray, FLT_MAX for rays which missed it. */
+	ssef dist;
+	int addr;
+};
+
+ccl_device_inline int qbvh_packet_node_intersect(const ssef *bounds,
+                                                 const ssef& isect_near,
+                                                 const ssef& isect_far,
+                                                 const sse3f& org,
+                                                 const sse3f& idir,
+                                                 const int near_x,
+                                                 const int near_y,
+                                                 const int near_z,
+                                                 const int far_x,
+                                                 const int far_y,
+                                                 const int far_z,
+                                                 ssef *ccl_restrict dist)
+{
+	const ssef tnear_x = (bounds[near_x] - org.x) * idir.x;
+	const ssef tnear_y = (bounds[near_y] - org.y) * idir.y;
+	const ssef tnear_z = (bounds[near_z] - org.z) * idir.z;
+	const ssef tfar_x = (bounds[far_x] - org.x) * idir.x;
+	const ssef tfar_y = (bounds[far_y] - org.y) * idir.y;
+	const ssef tfar_z = (bounds[far_z] - org.z) * idir.z;
+
+	const ssef tnear = max(max(tnear_x, tnear_y), max(tnear_z, isect_near));
+	const ssef tfar = min(min(tfar_x, tfar_y), min(tfar_z, isect_far));
+	*dist = tnear;
+	return (int)movemask(tnear <= tfar);
+}
+
+/* Returns mask of the rays which hit anything. */
+ccl_device int qbvh_intersect_packet(KernelGlobals *kg,
+                                     const Ray *rays,
+                                     Intersection *isects,
+                                     const int num_rays,
+                                     const uint visibility)
+{
+	kernel_assert(num_rays <= PATH_PACKET_SIZE);
+
+	/* Traversal stack in thread-local memory. */
+	QBVHPacketStackItem traversal_stack[BVH_QSTACK_SIZE];
+	traversal_stack[0].addr = ENTRYPOINT_SENTINEL;
+	traversal_stack[0].dist = ssef(-FLT_MAX);
+
+	/* Ray parameters, one entry per ray of the packet. */
+	float3 P[PATH_PACKET_SIZE], dir[PATH_PACKET_SIZE];
+	sse3f org4[PATH_PACKET_SIZE], idir4[PATH_PACKET_SIZE];
+	int near_x[PATH_PACKET_SIZE], near_y[PATH_PACKET_SIZE], near_z[PATH_PACKET_SIZE];
+	int far_x[PATH_PACKET_SIZE], far_y[PATH_PACKET_SIZE], far_z[PATH_PACKET_SIZE];
+
+	/* Closest hit distance per ray. Lanes of unused rays are negative, so they
+	 * never pass the node distance test.
+	 */
+	ssef ray_t(-FLT_MAX);
+
+	for(int i = 0; i < num_rays; i++) {
+		Intersection *isect = &isects[i];
+		isect->t = rays[i].t;
+		isect->u = 0.0f;
+		isect->v = 0.0f;
+		isect->prim = PRIM_NONE;
+		isect->object = OBJECT_NONE;
+		BVH_DEBUG_INIT();
+
+		P[i] = rays[i].P;
+		dir[i] = bvh_clamp_direction(rays[i].D);
+		float3 idir = bvh_inverse_direction(dir[i]);
+		org4[i] = sse3f(ssef(P[i].x), ssef(P[i].y), ssef(P[i].z));
+		idir4[i] = sse3f(ssef(idir.x), ssef(idir.y), ssef(idir.z));
+		qbvh_near_far_idx_calc(idir,
+		                       &near_x[i], &near_y[i], &near_z[i],
+		                       &far_x[i], &far_y[i], &far_z[i]);
+
+		if(isfinite(P[i].x)) {
+			((float*)&ray_t)[i] = rays[i].t;
+		}
+	}
+
+	/* Traversal variables in registers. */
+	int stack_ptr = 0;
+	int node_addr = kernel_data.bvh.root;
+	ssef node_dist(0.0f);
+	const ssef tnear(0.0f);
+
+	/* Traversal loop. */
+	do {
+		/* Traverse internal nodes. */
+		while(node_addr >= 0 && node_addr != ENTRYPOINT_SENTINEL) {
+			float4 inodes = kernel_tex_fetch(__bvh_nodes, node_addr+0);
+			int ray_mask = (int)movemask(node_dist <= ray_t);
+
+			if(ray_mask == 0
+#ifdef __VISIBILITY_FLAG__
+			   || (__float_as_uint(inodes.x) & visibility) == 0
+#endif
+			 )
+			{
+				/* Pop. */
+				node_addr = traversal_stack[stack_ptr].addr;
+				node_dist = traversal_stack[stack_ptr].dist;
+				--stack_ptr;
+				continue;
+			}
+
+			/* Fetch child bounds once for the whole packet. */
+			ssef bounds[6];
+			for(int i = 0; i < 6; i++) {
+				bounds[i] = kernel_tex_fetch_ssef(__bvh_nodes, node_addr+1+i);
+			}
+
+			/* Distance of every ray to every child, transposed so lanes are rays. */
+			ssef child_dist[4] = {ssef(FLT_MAX), ssef(FLT_MAX), ssef(FLT_MAX), ssef(FLT_MAX)};
+			int child_mask = 0;
+
+			while(ray_mask != 0) {
+				int r = __bscf(ray_mask);
+				ssef dist;
+				int mask = qbvh_packet_node_intersect(bounds,
+				                                      tnear,
+				                                      ssef(((float*)&ray_t)[r]),
+				                                      org4[r],
+				                                      idir4[r],
+				                                      near_x[r], near_y[r], near_z[r],
+				                                      far_x[r], far_y[r], far_z[r],
+				                                      &dist);
+#ifdef __KERNEL_DEBUG__
+				++isects[r].num_traversed_nodes;
+#endif
+				child_mask |= mask;
+				while(mask != 0) {
+					int c = __bscf(mask);
+					((float*)&child_dist[c])[r] = ((float*)&dist)[c];
+				}
+			}
+
+			if(child_mask != 0) {
+				float4 cnodes = kernel_tex_fetch(__bvh_nodes, node_addr+7);
+
+				/* Push all children hit by any ray, and sort them so the child
+				 * closest to the packet ends up on top of the stack.
+				 */
+				const int first = stack_ptr + 1;
+				while(child_mask != 0) {
+					int c = __bscf(child_mask);
+					QBVHPacketStackItem item;
+					item.addr = __float_as_int(cnodes[c]);
+					item.dist = child_dist[c];
+					const float item_dist = reduce_min(item.dist);
+					kernel_assert(stack_ptr + 1 < BVH_QSTACK_SIZE);
+
+					int i = stack_ptr;
+					for(; i >= first && reduce_min(traversal_stack[i].dist) < item_dist; i--) {
+						traversal_stack[i + 1] = traversal_stack[i];
+					}
+					traversal_stack[i + 1] = item;
+					++stack_ptr;
+				}
+			}
+
+			node_addr = traversal_stack[stack_ptr].addr;
+			node_dist = traversal_stack[stack_ptr].dist;
+			--stack_ptr;
+		}
+
+		/* If node is leaf, fetch triangle list. */
+		if(node_addr < 0) {
+			float4 leaf = kernel_tex_fetch(__bvh_leaf_nodes, (-node_addr-1));
+			int ray_mask = (int)movemask(node_dist <= ray_t);
+
+			/* Pop. */
+			node_addr = traversal_stack[stack_ptr].addr;
+			node_dist = traversal_stack[stack_ptr].dist;
+			--stack_ptr;
+
+#ifdef __VISIBILITY_FLAG__
+			if((__float_as_uint(leaf.z) & visibility) == 0) {
+				continue;
+			}
+#endif
+
+			const int prim_addr_start = __float_as_int(leaf.x);
+			const int prim_addr_end = __float_as_int(leaf.y);
+			kernel_assert(prim_addr_start >= 0);
+			kernel_assert((__float_as_int(leaf.w) & PRIMITIVE_ALL) == PRIMITIVE_TRIANGLE);
+
+			/* Primitive intersection. */
+			while(ray_mask != 0) {
+				int r = __bscf(ray_mask);
+				Intersection *isect = &isects[r];
+				for(int prim_addr = prim_addr_start; prim_addr < prim_addr_end; prim_addr++) {
+					BVH_DEBUG_NEXT_INTERSECTION();
+					if(triangle_intersect(kg,
+					                      isect,
+					                      P[r],
+					                      dir[r],
+					                      visibility,
+					                      OBJECT_NONE,
+					                      prim_addr))
+					{
+						((float*)&ray_t)[r] = isect->t;
+					}
+				}
+			}
+		}
+	} while(node_addr != ENTRYPOINT_SENTINEL);
+
+	int hit_mask = 0;
+	for(int i = 0; i < num_rays; i++) {
+		if(isects[i].prim != PRIM_NONE) {
+			hit_mask |= (1 << i);
+		}
+	}
+	return hit_mask;
+}
@@ -16,6 +16,28 @@
 
 CCL_NAMESPACE_BEGIN
 
+/* The SIMD versions process 8 (AVX) or 4 (SSE) pixels of a row at once with
+ * unaligned loads, the remaining pixels of a row use the scalar code, so any
+ * tile width works. */
+
+ccl_device_inline float kernel_filter_nlm_difference_pixel(int ofs, int dofs,
+                                                           const float *ccl_restrict weight_image,
+                                                           const float *ccl_restrict variance_image,
+                                                           int numChannels,
+                                                           int channel_offset,
+                                                           float a,
+                                                           float k_2)
+{
+	float diff = 0.0f;
+	for(int c = 0; c < numChannels; c++) {
+		float cdiff = weight_image[c*channel_offset + ofs] - weight_image[c*channel_offset + dofs];
+		float pvar = variance_image[c*channel_offset + ofs];
+		float qvar = variance_image[c*channel_offset + dofs];
+		diff += (cdiff*cdiff - a*(pvar + min(pvar, qvar))) / (1e-8f + k_2*(pvar+qvar));
+	}
+	return diff;
+}
+
 ccl_device_inline void kernel_filter_nlm_calc_difference(int dx, int dy,
                                                          const float *ccl_restrict weight_image,
                                                          const float *ccl_restrict variance_image,
@@ -26,20 +48,32 @@ ccl_device_inline void kernel_filter_nlm_calc_difference(int dx, int dy,
                                                          float a,
                                                          float k_2)
 {
+	const int numChannels = channel_offset? 3 : 1;
+	const float channel_fac = 1.0f/numChannels;
+	const int shift = dy*w + dx;
+
 	for(int y = rect.y; y < rect.w; y++) {
-		for(int x = rect.x; x < rect.z; x++) {
-			float diff = 0.0f;
-			int numChannels = channel_offset? 3 : 1;
+		int x = rect.x;
+#ifdef __KERNEL_AVX__
+		for(; x + 8 <= rect.z; x += 8) {
+			avxf diff(0.0f);
 			for(int c = 0; c < numChannels; c++) {
-				float cdiff = weight_image[c*channel_offset + y*w+x] - weight_image[c*channel_offset + (y+dy)*w+(x+dx)];
-				float pvar = variance_image[c*channel_offset + y*w+x];
-				float qvar = variance_image[c*channel_offset + (y+dy)*w+(x+dx)];
-				diff += (cdiff*cdiff - a*(pvar + min(pvar, qvar))) / (1e-8f + k_2*(pvar+qvar));
-			}
-			if(numChannels > 1) {
-				diff *= 1.0f/numChannels;
+				const int ofs = c*channel_offset + y*w+x;
+				avxf cdiff = loadu8f(weight_image + ofs) - loadu8f(weight_image + ofs + shift);
+				avxf pvar = loadu8f(variance_image + ofs);
+				avxf qvar = loadu8f(variance_image + ofs + shift);
+				diff = diff + msub(cdiff, cdiff, a*(pvar + min(pvar, qvar))) / madd(avxf(k_2), pvar+qvar, avxf(1e-8f));
 			}
-			difference_image[y*w+x] = diff;
+			storeu8f(difference_image + y*w+x, diff*channel_fac);
+		}
+#endif
+		for(; x < rect.z; x++) {
+			difference_image[y*w+x] = channel_fac * kernel_filter_nlm_difference_pixel(y*w+x, y*w+x + shift,
+			                                                                            weight_image,
+			                                                                            variance_image,
+			                                                                            numChannels,
+			                                                                            channel_offset,
+			                                                                            a, k_2);
 		}
 	}
 }
@@ -50,23 +84,42 @@ ccl_device_inline void kernel_filter_nlm_blur(const float *ccl_restrict differen
                                               int w,
                                               int f)
 {
-	int aligned_lowx = rect.x / 4;
-	int aligned_highx = (rect.z + 3) / 4;
 	for(int y = rect.y; y < rect.w; y++) {
 		const int low = max(rect.y, y-f);
 		const int high = min(rect.w, y+f+1);
-		for(int x = rect.x; x < rect.z; x++) {
+		const float fac = 1.0f/(high - low);
+
+		int x = rect.x;
+#ifdef __KERNEL_AVX__
+		/* Sum the column window in registers. */
+		for(; x + 8 <= rect.z; x += 8) {
+			avxf sum(0.0f);
+			for(int y1 = low; y1 < high; y1++) {
+				sum = sum + loadu8f(difference_image + y1*w+x);
+			}
+			storeu8f(out_image + y*w+x, sum*fac);
+		}
+#endif
+#ifdef __KERNEL_SSE__
+		for(; x + 4 <= rect.z; x += 4) {
+			ssef sum(0.0f);
+			for(int y1 = low; y1 < high; y1++) {
+				sum = sum + loadu4f(difference_image + y1*w+x);
+			}
+			storeu4f(out_image + y*w+x, sum*fac);
+		}
+#endif
+		const int remaining_x = x;
+		for(x = remaining_x; x < rect.z; x++) {
 			out_image[y*w+x] = 0.0f;
 		}
 		for(int y1 = low; y1 < high; y1++) {
-			float4* out_image4 = (float4*)(out_image + y*w);
-			float4* difference_image4 = (float4*)(difference_image + y1*w);
-			for(int x = aligned_lowx; x < aligned_highx; x++) {
-				out_image4[x] += difference_image4[x];
+			for(x = remaining_x; x < rect.z; x++) {
+				out_image[y*w+x] += difference_image[y1*w+x];
 			}
 		}
-		for(int x = rect.x; x < rect.z; x++) {
-			out_image[y*w+x] *= 1.0f/(high - low);
+		for(x = remaining_x; x < rect.z; x++) {
+			out_image[y*w+x] *= fac;
 		}
 	}
 }
@@ -100,6 +153,27 @@ ccl_device_inline void kernel_filter_nlm_calc_weight(const float *ccl_restrict d
 	}
 }
 
+ccl_device_inline void kernel_filter_nlm_update_output_pixel(int x, int y,
+                                                             int dx, int dy,
+                                                             const float *ccl_restrict difference_image,
+                                                             const float *ccl_restrict image,
+                                                             float *out_image,
+                                                             float *accum_image,
+                                                             int4 rect,
+                                                             int w,
+                                                             int f)
+{
+	const int low = max(rect.x, x-f);
+	const int high = min(rect.z, x+f+1);
+	float sum = 0.0f;
+	for(int x1 = low; x1 < high; x1++) {
+		sum += difference_image[y*w+x1];
+	}
+	float weight = sum * (1.0f/(high - low));
+	accum_image[y*w+x] += weight;
+	out_image[y*w+x] += weight*image[(y+dy)*w+(x+dx)];
+}
+
 ccl_device_inline void kernel_filter_nlm_update_output(int dx, int dy,
                                                        const float *ccl_restrict difference_image,
                                                        const float *ccl_restrict image,
@@ -110,16 +184,34 @@ ccl_device_inline void kernel_filter_nlm_update_output(int dx, int dy,
                                                        int f)
 {
 	for(int y = rect.y; y < rect.w; y++) {
-		for(int x = rect.x; x < rect.z; x++) {
-			const int low = max(rect.x, x-f);
-			const int high = min(rect.z, x+f+1);
-			float sum = 0.0f;
-			for(int x1 = low; x1 < high; x1++) {
-				sum += difference_image[y*w+x1];
+		int x = rect.x;
+#ifdef __KERNEL_AVX__
+		/* Pixels whose window is clipped by the rect border use the scalar code. */
+		for(; x < min(rect.x + f, rect.z); x++) {
+			kernel_filter_nlm_update_output_pixel(x, y, dx, dy,
+			                                      difference_image, image,
+			                                      out_image, accum_image,
+			                                      rect, w, f);
+		}
+		const float fac = 1.0f/(2*f + 1);
+		for(; x + 8 + f <= rect.z; x += 8) {
+			avxf sum(0.0f);
+			for(int x1 = x-f; x1 <= x+f; x1++) {
+				sum = sum + loadu8f(difference_image + y*w+x1);
 			}
-			float weight = sum * (1.0f/(high - low));
-			accum_image[y*w+x] += weight;
-			out_image[y*w+x] += weight*image[(y+dy)*w+(x+dx)];
+			avxf weight = sum * fac;
+			const int ofs = y*w+x;
+			storeu8f(accum_image + ofs, loadu8f(accum_image + ofs) + weight);
+			storeu8f(out_image + ofs, madd(weight,
+			                               loadu8f(image + (y+dy)*w+(x+dx)),
+			                               loadu8f(out_image + ofs)));
+		}
+#endif
+		for(; x < rect.z; x++) {
+			kernel_filter_nlm_update_output_pixel(x, y, dx, dy,
+			                                      difference_image, image,
+			                                      out_image, accum_image,
+			                                      rect, w, f);
 		}
 	}
 }
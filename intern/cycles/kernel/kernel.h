@@ -30,6 +30,7 @@ CCL_NAMESPACE_BEGIN
 
 struct KernelGlobals;
 struct KernelData;
+struct TextureCacheGlobals;
 
 KernelGlobals *kernel_globals_create();
 void kernel_globals_free(KernelGlobals *kg);
@@ -43,6 +44,14 @@ void kernel_tex_copy(KernelGlobals *kg,
                      device_ptr mem,
                      size_t size);
 
+void kernel_texture_cache_thread_init(KernelGlobals *kg,
+                                      TextureCacheGlobals *texture_cache);
+void kernel_texture_cache_thread_free(KernelGlobals *kg);
+bool kernel_texture_cache_lookup(KernelGlobals *kg,
+                                 int id,
+                                 float x, float y,
+                                 float4 *result);
+
 #define KERNEL_ARCH cpu
 #include "kernel/kernels/cpu/kernel_cpu.h"
 
@@ -0,0 +1,210 @@
+/*
+ * Copyright 2011-2017 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+CCL_NAMESPACE_BEGIN
+
+/* Adaptive Sampling
+ *
+ * Pixels stop taking samples once they are converged. Besides the combined
+ * pass, an auxiliary pass accumulates only every second sample with double
+ * weight. Both are estimates of the same pixel value, and their difference
+ * is used as the remaining error of the pixel.
+ *
+ * The auxiliary pass stores the half sample color in xyz, written along with
+ * the other passes in kernel_write_result, w is non-zero once the pixel
+ * converged. A second pass counts the samples taken per pixel, so
+ * converged pixels can be scaled up to the full number of samples at the end.
+ */
+
+ccl_device_inline ccl_global float *kernel_adaptive_pixel(KernelGlobals *kg,
+                                                          ccl_global float *buffer,
+                                                          int x, int y,
+                                                          int offset, int stride)
+{
+	return buffer + (offset + x + y*stride)*kernel_data.film.pass_stride;
+}
+
+ccl_device_inline bool kernel_adaptive_is_converged(KernelGlobals *kg,
+                                                    ccl_global float *buffer)
+{
+	return buffer[kernel_data.film.pass_adaptive_aux_buffer + 3] != 0.0f;
+}
+
+/* Called before taking a sample, returns true when the pixel is converged
+ * and the sample is to be skipped, otherwise the sample is counted. */
+ccl_device_inline bool kernel_adaptive_sample_skip(KernelGlobals *kg,
+                                                   ccl_global float *buffer)
+{
+	if(!kernel_data.film.pass_adaptive_aux_buffer) {
+		return false;
+	}
+
+	if(kernel_adaptive_is_converged(kg, buffer)) {
+		return true;
+	}
+
+	kernel_write_pass_float(buffer + kernel_data.film.pass_sample_count, 1.0f);
+	return false;
+}
+
+/* Mark the pixel as converged when the difference between the full and half
+ * sample estimates is below the threshold. The error is relative to the
+ * square root of the intensity, so noise in dark regions, which is more
+ * visible, needs more samples to converge. */
+ccl_device void kernel_adaptive_stopping(KernelGlobals *kg, ccl_global float *buffer)
+{
+	ccl_global float *aux = buffer + kernel_data.film.pass_adaptive_aux_buffer;
+
+	if(aux[3] != 0.0f) {
+		return;
+	}
+
+	const float num_samples = buffer[kernel_data.film.pass_sample_count];
+	if(num_samples == 0.0f) {
+		return;
+	}
+
+	const float inv_num_samples = 1.0f/num_samples;
+	const float3 I = make_float3(buffer[0], buffer[1], buffer[2])*inv_num_samples;
+	const float3 A = make_float3(aux[0], aux[1], aux[2])*inv_num_samples;
+
+	const float error = (fabsf(I.x - A.x) + fabsf(I.y - A.y) + fabsf(I.z - A.z)) /
+	                    sqrtf(max(I.x + I.y + I.z, 1e-4f));
+
+	if(error < kernel_data.integrator.adaptive_threshold) {
+		aux[3] = 1.0f;
+	}
+}
+
+/* Pixels next to a pixel which is not converged keep sampling as well, to
+ * avoid sharp transitions in noise level. This is a box filter of the
+ * converged flag, done in two passes. Returns true if any pixel of the row or
+ * column still needs samples. */
+ccl_device bool kernel_adaptive_filter_x(KernelGlobals *kg,
+                                         ccl_global float *buffer,
+                                         int y, int x, int w,
+                                         int offset, int stride)
+{
+	const int aux_flag = kernel_data.film.pass_adaptive_aux_buffer + 3;
+	bool any = false;
+	bool prev = false;
+
+	for(int i = x; i < x + w; i++) {
+		ccl_global float *pixel = kernel_adaptive_pixel(kg, buffer, i, y, offset, stride);
+
+		if(pixel[aux_flag] == 0.0f) {
+			any = true;
+			if(i > x && !prev) {
+				kernel_adaptive_pixel(kg, buffer, i - 1, y, offset, stride)[aux_flag] = 0.0f;
+			}
+			prev = true;
+		}
+		else {
+			if(prev) {
+				pixel[aux_flag] = 0.0f;
+			}
+			prev = false;
+		}
+	}
+
+	return any;
+}
+
+ccl_device bool kernel_adaptive_filter_y(KernelGlobals *kg,
+                                         ccl_global float *buffer,
+                                         int x, int y, int h,
+                                         int offset, int stride)
+{
+	const int aux_flag = kernel_data.film.pass_adaptive_aux_buffer + 3;
+	bool any = false;
+	bool prev = false;
+
+	for(int i = y; i < y + h; i++) {
+		ccl_global float *pixel = kernel_adaptive_pixel(kg, buffer, x, i, offset, stride);
+
+		if(pixel[aux_flag] == 0.0f) {
+			any = true;
+			if(i > y && !prev) {
+				kernel_adaptive_pixel(kg, buffer, x, i - 1, offset, stride)[aux_flag] = 0.0f;
+			}
+			prev = true;
+		}
+		else {
+			if(prev) {
+				pixel[aux_flag] = 0.0f;
+			}
+			prev = false;
+		}
+	}
+
+	return any;
+}
+
+/* Passes which are written only once or are not averaged over samples must
+ * keep their value, as must the variance passes of the denoising data. */
+ccl_device_inline bool kernel_adaptive_pass_skip_scale(KernelGlobals *kg, int offset)
+{
+	const int flag = kernel_data.film.pass_flag;
+
+	if(offset == kernel_data.film.pass_sample_count ||
+	   offset == kernel_data.film.pass_adaptive_aux_buffer + 3)
+	{
+		return true;
+	}
+	if(((flag & PASS_DEPTH) && offset == kernel_data.film.pass_depth) ||
+	   ((flag & PASS_OBJECT_ID) && offset == kernel_data.film.pass_object_id) ||
+	   ((flag & PASS_MATERIAL_ID) && offset == kernel_data.film.pass_material_id))
+	{
+		return true;
+	}
+
+	const int denoising = kernel_data.film.pass_denoising_data;
+	if(denoising) {
+		const int i = offset - denoising;
+		if((i >= DENOISING_PASS_NORMAL_VAR && i < DENOISING_PASS_NORMAL_VAR + 3) ||
+		   (i >= DENOISING_PASS_ALBEDO_VAR && i < DENOISING_PASS_ALBEDO_VAR + 3) ||
+		   (i == DENOISING_PASS_DEPTH_VAR) ||
+		   (i >= DENOISING_PASS_COLOR_VAR && i < DENOISING_PASS_COLOR_VAR + 3))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/* Scale passes of a pixel which converged early as if it had taken all
+ * samples, film conversion divides all pixels by the same sample count. */
+ccl_device void kernel_adaptive_adjust_samples(KernelGlobals *kg,
+                                               ccl_global float *buffer,
+                                               int num_samples)
+{
+	const float pixel_samples = buffer[kernel_data.film.pass_sample_count];
+
+	if(pixel_samples == 0.0f || pixel_samples >= (float)num_samples) {
+		return;
+	}
+
+	const float scale = (float)num_samples/pixel_samples;
+
+	for(int i = 0; i < kernel_data.film.pass_stride; i++) {
+		if(!kernel_adaptive_pass_skip_scale(kg, i)) {
+			buffer[i] *= scale;
+		}
+	}
+}
+
+CCL_NAMESPACE_END
@@ -44,6 +44,8 @@ struct OSLShadingSystem;
 
 struct Intersection;
 struct VolumeStep;
+struct TextureCacheGlobals;
+struct TextureCacheThreadData;
 
 typedef struct KernelGlobals {
 #  define KERNEL_TEX(type, name) texture<type> name;
@@ -60,6 +62,10 @@ typedef struct KernelGlobals {
 	OSLThreadData *osl_tdata;
 #  endif
 
+	/* Texture cache for images which are not in memory, NULL when unused. */
+	TextureCacheGlobals *texture_cache;
+	TextureCacheThreadData *texture_cache_tdata;
+
 	/* **** Run-time data ****  */
 
 	/* Heap-allocated storage for transparent shadows intersections. */
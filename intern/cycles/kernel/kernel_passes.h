@@ -327,6 +327,19 @@ ccl_device_inline void kernel_write_light_passes(KernelGlobals *kg, ccl_global f
 #endif
 }
 
+/* Every second sample with double weight, for adaptive sampling to estimate
+ * the remaining noise, see kernel_adaptive_sampling.h */
+ccl_device_inline void kernel_write_adaptive_aux(KernelGlobals *kg,
+                                                 ccl_global float *buffer,
+                                                 int sample,
+                                                 float3 L_sum)
+{
+	if(kernel_data.film.pass_adaptive_aux_buffer && (sample & 1)) {
+		kernel_write_pass_float4(buffer + kernel_data.film.pass_adaptive_aux_buffer,
+		                         make_float4(L_sum.x*2.0f, L_sum.y*2.0f, L_sum.z*2.0f, 0.0f));
+	}
+}
+
 ccl_device_inline void kernel_write_result(KernelGlobals *kg,
                                            ccl_global float *buffer,
                                            int sample,
@@ -338,6 +351,7 @@ ccl_device_inline void kernel_write_result(KernelGlobals *kg,
 	kernel_write_pass_float4(buffer, make_float4(L_sum.x, L_sum.y, L_sum.z, alpha));
 
 	kernel_write_light_passes(kg, buffer, L);
+	kernel_write_adaptive_aux(kg, buffer, sample, L_sum);
 
 #ifdef __DENOISING_FEATURES__
 	if(kernel_data.film.pass_denoising_data) {
@@ -31,6 +31,7 @@
 #include "kernel/kernel_shader.h"
 #include "kernel/kernel_light.h"
 #include "kernel/kernel_passes.h"
+#include "kernel/kernel_adaptive_sampling.h"
 
 #ifdef __SUBSURFACE__
 #  include "kernel/kernel_subsurface.h"
@@ -50,6 +51,22 @@
 
 CCL_NAMESPACE_BEGIN
 
+/* Accumulate BVH statistics of a traced ray for the debug passes. */
+ccl_device_forceinline void kernel_path_scene_intersect_debug(
+	ccl_addr_space PathState *state,
+	const Intersection *isect,
+	PathRadiance *L)
+{
+#ifdef __KERNEL_DEBUG__
+	if(state->flag & PATH_RAY_CAMERA) {
+		L->debug_data.num_bvh_traversed_nodes += isect->num_traversed_nodes;
+		L->debug_data.num_bvh_traversed_instances += isect->num_traversed_instances;
+		L->debug_data.num_bvh_intersections += isect->num_intersections;
+	}
+	L->debug_data.num_ray_bounces++;
+#endif  /* __KERNEL_DEBUG__ */
+}
+
 ccl_device_forceinline bool kernel_path_scene_intersect(
 	KernelGlobals *kg,
 	ccl_addr_space PathState *state,
@@ -84,14 +101,7 @@ ccl_device_forceinline bool kernel_path_scene_intersect(
 	bool hit = scene_intersect(kg, *ray, visibility, isect, NULL, 0.0f, 0.0f);
 #endif  /* __HAIR__ */
 
-#ifdef __KERNEL_DEBUG__
-	if(state->flag & PATH_RAY_CAMERA) {
-		L->debug_data.num_bvh_traversed_nodes += isect->num_traversed_nodes;
-		L->debug_data.num_bvh_traversed_instances += isect->num_traversed_instances;
-		L->debug_data.num_bvh_intersections += isect->num_intersections;
-	}
-	L->debug_data.num_ray_bounces++;
-#endif  /* __KERNEL_DEBUG__ */
+	kernel_path_scene_intersect_debug(state, isect, L);
 
 	return hit;
 }
@@ -542,7 +552,8 @@ ccl_device_forceinline void kernel_path_integrate(
 	Ray *ray,
 	PathRadiance *L,
 	ccl_global float *buffer,
-	ShaderData *emission_sd)
+	ShaderData *emission_sd,
+	const Intersection *camera_isect)
 {
 	/* Shader data memory used for both volumes and surfaces, saves stack space. */
 	ShaderData sd;
@@ -556,9 +567,19 @@ ccl_device_forceinline void kernel_path_integrate(
 
 	/* path iteration */
 	for(;;) {
-		/* Find intersection with objects in scene. */
+		/* Find intersection with objects in scene, unless the camera ray
+		 * was already traced as part of a packet. */
 		Intersection isect;
-		bool hit = kernel_path_scene_intersect(kg, state, ray, &isect, L);
+		bool hit;
+		if(camera_isect != NULL) {
+			isect = *camera_isect;
+			hit = (isect.prim != PRIM_NONE);
+			camera_isect = NULL;
+			kernel_path_scene_intersect_debug(state, &isect, L);
+		}
+		else {
+			hit = kernel_path_scene_intersect(kg, state, ray, &isect, L);
+		}
 
 		/* Find intersection with lamps and compute emission for MIS. */
 		kernel_path_lamp_emission(kg, state, ray, throughput, &isect, emission_sd, L);
@@ -690,6 +711,10 @@ ccl_device void kernel_path_trace(KernelGlobals *kg,
 
 	buffer += index*pass_stride;
 
+	if(kernel_adaptive_sample_skip(kg, buffer)) {
+		return;
+	}
+
 	/* Initialize random numbers and sample ray. */
 	uint rng_hash;
 	Ray ray;
@@ -717,11 +742,96 @@ ccl_device void kernel_path_trace(KernelGlobals *kg,
 	                      &ray,
 	                      &L,
 	                      buffer,
-	                      &emission_sd);
+	                      &emission_sd,
+	                      NULL);
 
 	kernel_write_result(kg, buffer, sample, &L);
 }
 
+#ifdef __QBVH_PACKET__
+/* Path trace num_pixels consecutive pixels of a row, intersecting their
+ * camera rays as one packet before integrating each path on its own.
+ */
+ccl_device void kernel_path_trace_packet(KernelGlobals *kg,
+	ccl_global float *buffer,
+	int sample, int x, int y, int num_pixels, int offset, int stride)
+{
+	kernel_assert(num_pixels <= PATH_PACKET_SIZE);
+
+	if(!scene_intersect_packet_supported(kg)) {
+		for(int i = 0; i < num_pixels; i++) {
+			kernel_path_trace(kg, buffer, sample, x + i, y, offset, stride);
+		}
+		return;
+	}
+
+	int pass_stride = kernel_data.film.pass_stride;
+
+	/* Initialize random numbers and sample rays. */
+	uint rng_hash[PATH_PACKET_SIZE];
+	Ray rays[PATH_PACKET_SIZE];
+	int ray_x[PATH_PACKET_SIZE];
+	int num_rays = 0;
+
+	for(int i = 0; i < num_pixels; i++) {
+		int index = offset + x + i + y*stride;
+		if(kernel_adaptive_sample_skip(kg, buffer + index*pass_stride)) {
+			continue;
+		}
+
+		kernel_path_trace_setup(kg, sample, x + i, y, &rng_hash[num_rays], &rays[num_rays]);
+
+		if(rays[num_rays].t != 0.0f) {
+			ray_x[num_rays] = x + i;
+			num_rays++;
+		}
+	}
+
+	if(num_rays == 0) {
+		return;
+	}
+
+	/* Camera rays of a row all have the same visibility. */
+	ShaderData emission_sd;
+	PathState state;
+	path_state_init(kg, &emission_sd, &state, rng_hash[0], sample, &rays[0]);
+
+	Intersection isects[PATH_PACKET_SIZE];
+	scene_intersect_packet(kg,
+	                       rays,
+	                       num_rays,
+	                       path_state_ray_visibility(kg, &state),
+	                       isects);
+
+	for(int i = 0; i < num_rays; i++) {
+		int index = offset + ray_x[i] + y*stride;
+		ccl_global float *pixel_buffer = buffer + index*pass_stride;
+
+		/* Initialize state. */
+		float3 throughput = make_float3(1.0f, 1.0f, 1.0f);
+
+		PathRadiance L;
+		path_radiance_init(&L, kernel_data.film.use_light_pass);
+
+		if(i != 0) {
+			path_state_init(kg, &emission_sd, &state, rng_hash[i], sample, &rays[i]);
+		}
+
+		/* Integrate. */
+		kernel_path_integrate(kg,
+		                      &state,
+		                      throughput,
+		                      &rays[i],
+		                      &L,
+		                      pixel_buffer,
+		                      &emission_sd,
+		                      &isects[i]);
+
+		kernel_write_result(kg, pixel_buffer, sample, &L);
+	}
+}
+#endif  /* __QBVH_PACKET__ */
+
 #endif  /* __SPLIT_KERNEL__ */
 
 CCL_NAMESPACE_END
@@ -580,6 +580,10 @@ ccl_device void kernel_branched_path_trace(KernelGlobals *kg,
 
 	buffer += index*pass_stride;
 
+	if(kernel_adaptive_sample_skip(kg, buffer)) {
+		return;
+	}
+
 	/* initialize random numbers and ray */
 	uint rng_hash;
 	Ray ray;
@@ -58,6 +58,9 @@ CCL_NAMESPACE_BEGIN
 
 #define WORK_POOL_SIZE_GPU 64
 #define WORK_POOL_SIZE_CPU 1
+
+/* Number of camera rays traced together by packet traversal. */
+#define PATH_PACKET_SIZE 4
 #ifdef __KERNEL_GPU__
 #  define WORK_POOL_SIZE WORK_POOL_SIZE_GPU
 #else
@@ -80,6 +83,10 @@ CCL_NAMESPACE_BEGIN
 #ifdef __KERNEL_CPU__
 #  ifdef __KERNEL_SSE2__
 #    define __QBVH__
+#    define __QBVH_PACKET__
+#  endif
+#  ifdef __KERNEL_AVX2__
+#    define __OBVH__
 #  endif
 #  define __KERNEL_SHADING__
 #  define __KERNEL_ADV_SHADING__
@@ -1193,7 +1200,10 @@ typedef struct KernelFilm {
 	int pass_denoising_data;
 	int pass_denoising_clean;
 	int denoising_flags;
-	int pad;
+	int pass_adaptive_aux_buffer;
+
+	int pass_sample_count;
+	int pad1, pad2, pad3;
 
 #ifdef __KERNEL_DEBUG__
 	int pass_bvh_traversed_nodes;
@@ -1289,6 +1299,12 @@ typedef struct KernelIntegrator {
 	float light_inv_rr_threshold;
 
 	int start_sample;
+
+	/* adaptive sampling */
+	float adaptive_threshold;
+	int adaptive_min_samples;
+	int adaptive_step;
+	int pad_adaptive;
 } KernelIntegrator;
 static_assert_align(KernelIntegrator, 16);
 
@@ -1301,7 +1317,7 @@ typedef struct KernelBVH {
 	int have_instancing;
 	int use_qbvh;
 	int use_bvh_steps;
-	int pad1;
+	int use_bvh8;
 } KernelBVH;
 static_assert_align(KernelBVH, 16);
 
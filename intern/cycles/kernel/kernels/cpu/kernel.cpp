@@ -59,6 +59,7 @@
 #include "kernel/kernel.h"
 #define KERNEL_ARCH cpu
 #include "kernel/kernels/cpu/kernel_cpu_impl.h"
+#include "kernel/kernels/cpu/kernel_texture_cache.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -92,4 +93,69 @@ void kernel_tex_copy(KernelGlobals *kg,
 	}
 }
 
+/* Texture Cache */
+
+void kernel_texture_cache_thread_init(KernelGlobals *kg,
+                                      TextureCacheGlobals *texture_cache)
+{
+	if(texture_cache->ts == NULL) {
+		kg->texture_cache = NULL;
+		kg->texture_cache_tdata = NULL;
+		return;
+	}
+
+	TextureCacheThreadData *tdata = new TextureCacheThreadData();
+	tdata->thread_info = texture_cache->ts->get_perthread_info();
+
+	kg->texture_cache = texture_cache;
+	kg->texture_cache_tdata = tdata;
+}
+
+void kernel_texture_cache_thread_free(KernelGlobals *kg)
+{
+	delete kg->texture_cache_tdata;
+
+	kg->texture_cache = NULL;
+	kg->texture_cache_tdata = NULL;
+}
+
+bool kernel_texture_cache_lookup(KernelGlobals *kg,
+                                 int id,
+                                 float x, float y,
+                                 float4 *result)
+{
+	TextureCacheGlobals *texture_cache = kg->texture_cache;
+	if((size_t)id >= texture_cache->images.size() ||
+	   texture_cache->images[id].handle == NULL)
+	{
+		return false;
+	}
+
+	const TextureCacheImage& image = texture_cache->images[id];
+	OIIO::TextureOpt options = image.options;
+	float rgba[4];
+
+	/* Images in memory are stored bottom-up, flip to match. Without
+	 * differentials the finest mipmap level is used. */
+	if(!texture_cache->ts->texture(image.handle,
+	                               kg->texture_cache_tdata->thread_info,
+	                               options,
+	                               x, 1.0f - y,
+	                               0.0f, 0.0f, 0.0f, 0.0f,
+	                               4, rgba))
+	{
+		/* Clear the error so it doesn't accumulate, and return the same
+		 * color as for images which failed to load. */
+		(void)texture_cache->ts->geterror();
+		*result = make_float4(TEX_IMAGE_MISSING_R,
+		                      TEX_IMAGE_MISSING_G,
+		                      TEX_IMAGE_MISSING_B,
+		                      TEX_IMAGE_MISSING_A);
+		return true;
+	}
+
+	*result = make_float4(rgba[0], rgba[1], rgba[2], rgba[3]);
+	return true;
+}
+
 CCL_NAMESPACE_END
@@ -23,6 +23,29 @@ void KERNEL_FUNCTION_FULL_NAME(path_trace)(KernelGlobals *kg,
                                            int offset,
                                            int stride);
 
+void KERNEL_FUNCTION_FULL_NAME(path_trace_packet)(KernelGlobals *kg,
+                                                  float *buffer,
+                                                  int sample,
+                                                  int x, int y,
+                                                  int num_pixels,
+                                                  int offset,
+                                                  int stride);
+
+bool KERNEL_FUNCTION_FULL_NAME(adaptive_filter)(KernelGlobals *kg,
+                                                float *buffer,
+                                                int x, int y,
+                                                int w, int h,
+                                                int offset,
+                                                int stride);
+
+void KERNEL_FUNCTION_FULL_NAME(adaptive_adjust_samples)(KernelGlobals *kg,
+                                                        float *buffer,
+                                                        int num_samples,
+                                                        int x, int y,
+                                                        int w, int h,
+                                                        int offset,
+                                                        int stride);
+
 void KERNEL_FUNCTION_FULL_NAME(convert_to_byte)(KernelGlobals *kg,
                                                 uchar4 *rgba,
                                                 float *buffer,
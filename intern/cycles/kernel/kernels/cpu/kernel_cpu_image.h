@@ -449,6 +449,13 @@ template<typename T> struct TextureInterpolator  {
 
 ccl_device float4 kernel_tex_image_interp(KernelGlobals *kg, int id, float x, float y)
 {
+	float4 r;
+	if(UNLIKELY(kg->texture_cache != NULL) &&
+	   kernel_texture_cache_lookup(kg, id, x, y, &r))
+	{
+		return r;
+	}
+
 	const TextureInfo& info = kernel_tex_fetch(__texture_info, id);
 
 	switch(kernel_tex_type(id)) {
@@ -100,6 +100,83 @@ void KERNEL_FUNCTION_FULL_NAME(path_trace)(KernelGlobals *kg,
 #endif /* KERNEL_STUB */
 }
 
+void KERNEL_FUNCTION_FULL_NAME(path_trace_packet)(KernelGlobals *kg,
+                                                  float *buffer,
+                                                  int sample,
+                                                  int x, int y,
+                                                  int num_pixels,
+                                                  int offset,
+                                                  int stride)
+{
+#ifdef KERNEL_STUB
+	STUB_ASSERT(KERNEL_ARCH, path_trace_packet);
+#else
+#  ifdef __QBVH_PACKET__
+#    ifdef __BRANCHED_PATH__
+	if(!kernel_data.integrator.branched)
+#    endif
+	{
+		kernel_path_trace_packet(kg, buffer, sample, x, y, num_pixels, offset, stride);
+		return;
+	}
+#  endif
+	for(int i = 0; i < num_pixels; i++) {
+		KERNEL_FUNCTION_FULL_NAME(path_trace)(kg, buffer, sample, x + i, y, offset, stride);
+	}
+#endif /* KERNEL_STUB */
+}
+
+/* Adaptive Sampling */
+
+bool KERNEL_FUNCTION_FULL_NAME(adaptive_filter)(KernelGlobals *kg,
+                                                float *buffer,
+                                                int x, int y,
+                                                int w, int h,
+                                                int offset,
+                                                int stride)
+{
+#ifdef KERNEL_STUB
+	STUB_ASSERT(KERNEL_ARCH, adaptive_filter);
+	return false;
+#else
+	for(int j = y; j < y + h; j++) {
+		for(int i = x; i < x + w; i++) {
+			kernel_adaptive_stopping(kg, kernel_adaptive_pixel(kg, buffer, i, j, offset, stride));
+		}
+	}
+
+	bool any = false;
+	for(int j = y; j < y + h; j++) {
+		any |= kernel_adaptive_filter_x(kg, buffer, j, x, w, offset, stride);
+	}
+	for(int i = x; i < x + w; i++) {
+		any |= kernel_adaptive_filter_y(kg, buffer, i, y, h, offset, stride);
+	}
+	return any;
+#endif /* KERNEL_STUB */
+}
+
+void KERNEL_FUNCTION_FULL_NAME(adaptive_adjust_samples)(KernelGlobals *kg,
+                                                        float *buffer,
+                                                        int num_samples,
+                                                        int x, int y,
+                                                        int w, int h,
+                                                        int offset,
+                                                        int stride)
+{
+#ifdef KERNEL_STUB
+	STUB_ASSERT(KERNEL_ARCH, adaptive_adjust_samples);
+#else
+	for(int j = y; j < y + h; j++) {
+		for(int i = x; i < x + w; i++) {
+			kernel_adaptive_adjust_samples(kg,
+			                               kernel_adaptive_pixel(kg, buffer, i, j, offset, stride),
+			                               num_samples);
+		}
+	}
+#endif /* KERNEL_STUB */
+}
+
 /* Film */
 
 void KERNEL_FUNCTION_FULL_NAME(convert_to_byte)(KernelGlobals *kg,
@@ -0,0 +1,64 @@
+/*
+ * Copyright 2011-2017 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __KERNEL_TEXTURE_CACHE_H__
+#define __KERNEL_TEXTURE_CACHE_H__
+
+#include <OpenImageIO/texture.h>
+
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Texture cache of the CPU device.
+ *
+ * File images are not loaded into memory at full resolution, but read on
+ * demand through an OpenImageIO TextureSystem. It keeps tiles of the image
+ * and of its automatically generated mipmaps in an LRU cache which stays
+ * within a memory budget. The ImageManager owns the texture system and
+ * registers images here, kernel threads access it with their own handle.
+ */
+
+struct TextureCacheImage {
+	TextureCacheImage()
+	: handle(NULL)
+	{
+	}
+
+	/* NULL when the image is in device memory instead. */
+	OIIO::TextureSystem::TextureHandle *handle;
+	OIIO::TextureOpt options;
+};
+
+struct TextureCacheGlobals {
+	TextureCacheGlobals()
+	: ts(NULL)
+	{
+	}
+
+	OIIO::TextureSystem *ts;
+
+	/* Indexed by flat image slot. */
+	vector<TextureCacheImage> images;
+};
+
+struct TextureCacheThreadData {
+	OIIO::TextureSystem::Perthread *thread_info;
+};
+
+CCL_NAMESPACE_END
+
+#endif  /* __KERNEL_TEXTURE_CACHE_H__ */
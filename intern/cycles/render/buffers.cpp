@@ -44,6 +44,7 @@ BufferParams::BufferParams()
 
 	denoising_data_pass = false;
 	denoising_clean_pass = false;
+	use_adaptive_sampling = false;
 
 	Pass::add(PASS_COMBINED, passes);
 }
@@ -62,6 +63,7 @@ bool BufferParams::modified(const BufferParams& params)
 		&& height == params.height
 		&& full_width == params.full_width
 		&& full_height == params.full_height
+		&& use_adaptive_sampling == params.use_adaptive_sampling
 		&& Pass::equals(passes, params.passes));
 }
 
@@ -77,6 +79,11 @@ int BufferParams::get_passes_size()
 		if(denoising_clean_pass) size += DENOISING_PASS_SIZE_CLEAN;
 	}
 
+	/* auxiliary half sample buffer and sample count, see Film::device_update */
+	if(use_adaptive_sampling) {
+		size += 5;
+	}
+
 	return align_up(size, 4);
 }
 
@@ -107,6 +114,8 @@ RenderTile::RenderTile()
 	offset = 0;
 	stride = 0;
 
+	start_time = 0.0;
+
 	buffer = 0;
 
 	buffers = NULL;
@@ -54,6 +54,8 @@ public:
 	bool denoising_data_pass;
 	/* If only some light path types should be denoised, an additional pass is needed. */
 	bool denoising_clean_pass;
+	/* Adaptive sampling needs an auxiliary half sample pass and a sample count pass. */
+	bool use_adaptive_sampling;
 
 	/* functions */
 	BufferParams();
@@ -136,6 +138,9 @@ public:
 	int stride;
 	int tile_index;
 
+	/* time at which the tile was acquired, for timing statistics */
+	double start_time;
+
 	device_ptr buffer;
 
 	RenderBuffers *buffers;
@@ -283,6 +283,8 @@ NODE_DEFINE(Film)
 	SOCKET_BOOLEAN(denoising_clean_pass, "Generate Denoising Clean Pass", false);
 	SOCKET_INT(denoising_flags, "Denoising Flags", 0);
 
+	SOCKET_BOOLEAN(use_adaptive_sampling, "Use Adaptive Sampling", false);
+
 	return type;
 }
 
@@ -455,6 +457,15 @@ void Film::device_update(Device *device, DeviceScene *dscene, Scene *scene)
 		}
 	}
 
+	kfilm->pass_adaptive_aux_buffer = 0;
+	kfilm->pass_sample_count = 0;
+	if(use_adaptive_sampling) {
+		kfilm->pass_adaptive_aux_buffer = kfilm->pass_stride;
+		kfilm->pass_stride += 4;
+		kfilm->pass_sample_count = kfilm->pass_stride;
+		kfilm->pass_stride += 1;
+	}
+
 	kfilm->pass_stride = align_up(kfilm->pass_stride, 4);
 	kfilm->pass_alpha_threshold = pass_alpha_threshold;
 
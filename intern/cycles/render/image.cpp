@@ -15,6 +15,7 @@
  */
 
 #include "device/device.h"
+#include "kernel/kernels/cpu/kernel_texture_cache.h"
 #include "render/image.h"
 #include "render/scene.h"
 
@@ -44,6 +45,7 @@ ImageManager::ImageManager(const DeviceInfo& info)
 {
 	need_update = true;
 	osl_texture_system = NULL;
+	texture_cache = NULL;
 	animation_frame = 0;
 
 	/* In case of multiple devices used we need to know type of an actual
@@ -734,6 +736,12 @@ void ImageManager::device_load_image(Device *device,
 		img->mem = NULL;
 	}
 
+	/* Read tiles on demand through the texture cache instead. */
+	if(texture_cache_load_image(img, flat_slot)) {
+		img->need_load = false;
+		return;
+	}
+
 	/* Create new texture. */
 	if(type == IMAGE_DATA_TYPE_FLOAT4) {
 		device_vector<float4> *tex_img
@@ -889,6 +897,8 @@ void ImageManager::device_free_image(Device *, ImageDataType type, int slot)
 #endif
 		}
 
+		texture_cache_free_image(img, type_index_to_flattened_slot(slot, type));
+
 		if(img->mem) {
 			thread_scoped_lock device_lock(device_mutex);
 			delete img->mem;
@@ -908,6 +918,8 @@ void ImageManager::device_update(Device *device,
 		return;
 	}
 
+	texture_cache_init(device, scene);
+
 	TaskPool pool;
 	for(int type = 0; type < IMAGE_DATA_NUM_TYPES; type++) {
 		for(size_t slot = 0; slot < images[type].size(); slot++) {
@@ -977,6 +989,154 @@ void ImageManager::device_free(Device *device)
 		}
 		images[type].clear();
 	}
+
+	texture_cache_free();
+}
+
+void ImageManager::texture_cache_init(Device *device, Scene *scene)
+{
+	const int cache_size = scene->params.texture_cache_size;
+
+	/* OSL reads images through its own texture system already. */
+	if(texture_cache || cache_size <= 0 || osl_texture_system) {
+		return;
+	}
+
+	texture_cache = (TextureCacheGlobals*)device->texture_cache_memory();
+	if(!texture_cache) {
+		VLOG(1) << "Texture cache is not supported by the device, "
+		        << "loading images into memory.";
+		return;
+	}
+
+	TextureSystem *ts = TextureSystem::create(false);
+	ts->attribute("automip", 1);
+	ts->attribute("autotile", 64);
+	ts->attribute("gray_to_rgb", 1);
+	ts->attribute("max_memory_MB", (float)cache_size);
+
+	texture_cache->ts = ts;
+
+	VLOG(1) << "Using texture cache of " << cache_size << " MB.";
+}
+
+bool ImageManager::texture_cache_load_image(Image *img, int flat_slot)
+{
+	/* Builtin images have no file to read tiles from, and alpha of cached
+	 * images is always associated. */
+	if(!texture_cache || img->builtin_data || !img->use_alpha) {
+		return false;
+	}
+
+	TextureSystem *ts = texture_cache->ts;
+	ustring filename(img->filename);
+	ts->invalidate(filename);
+
+	/* Volumes and files which fail to open are loaded as usual, so missing
+	 * images show up the same way with or without the cache. */
+	ustring texture_type;
+	if(!ts->get_texture_info(filename, 0, ustring("texturetype"), TypeDesc::STRING, &texture_type) ||
+	   texture_type != "Plain Texture")
+	{
+		(void)ts->geterror();
+		return false;
+	}
+
+	TextureCacheImage image;
+	image.handle = ts->get_texture_handle(filename);
+	image.options.fill = 1.0f;
+
+	switch(img->interpolation) {
+		case INTERPOLATION_CLOSEST:
+			image.options.interpmode = TextureOpt::InterpClosest;
+			break;
+		case INTERPOLATION_LINEAR:
+			image.options.interpmode = TextureOpt::InterpBilinear;
+			break;
+		default:
+			image.options.interpmode = TextureOpt::InterpBicubic;
+			break;
+	}
+
+	switch(img->extension) {
+		case EXTENSION_EXTEND:
+			image.options.swrap = image.options.twrap = TextureOpt::WrapClamp;
+			break;
+		case EXTENSION_CLIP:
+			image.options.swrap = image.options.twrap = TextureOpt::WrapBlack;
+			break;
+		case EXTENSION_REPEAT:
+		default:
+			image.options.swrap = image.options.twrap = TextureOpt::WrapPeriodic;
+			break;
+	}
+
+	thread_scoped_lock device_lock(device_mutex);
+	if(texture_cache->images.size() <= (size_t)flat_slot) {
+		texture_cache->images.resize(flat_slot + 1);
+	}
+	texture_cache->images[flat_slot] = image;
+
+	return true;
+}
+
+void ImageManager::texture_cache_free_image(Image *img, int flat_slot)
+{
+	if(!texture_cache) {
+		return;
+	}
+
+	/* Images are loaded from pool tasks, which may resize the vector. */
+	thread_scoped_lock device_lock(device_mutex);
+	if(texture_cache->images.size() <= (size_t)flat_slot ||
+	   texture_cache->images[flat_slot].handle == NULL)
+	{
+		return;
+	}
+
+	texture_cache->images[flat_slot] = TextureCacheImage();
+	texture_cache->ts->invalidate(ustring(img->filename));
+}
+
+string ImageManager::texture_cache_stats() const
+{
+	if(!texture_cache || !texture_cache->ts) {
+		return "";
+	}
+
+	TextureSystem *ts = texture_cache->ts;
+	long long lookups = 0, memory_used = 0;
+	int misses = 0, tiles_created = 0;
+	ts->getattribute("stat:find_tile_calls", TypeDesc::INT64, &lookups);
+	ts->getattribute("stat:find_tile_cache_misses", TypeDesc::INT, &misses);
+	ts->getattribute("stat:tiles_created", TypeDesc::INT, &tiles_created);
+	ts->getattribute("stat:cache_memory_used", TypeDesc::INT64, &memory_used);
+
+	const double hit_rate = (lookups > 0) ? 100.0 * (lookups - misses) / lookups : 0.0;
+	return string_printf("Texture cache: %s tile lookups, %s misses (%.2f%% hits), "
+	                     "%s tiles loaded, %s in use",
+	                     string_human_readable_number((size_t)lookups).c_str(),
+	                     string_human_readable_number((size_t)misses).c_str(),
+	                     hit_rate,
+	                     string_human_readable_number((size_t)tiles_created).c_str(),
+	                     string_human_readable_size((size_t)memory_used).c_str());
+}
+
+void ImageManager::texture_cache_free()
+{
+	if(!texture_cache) {
+		return;
+	}
+
+	if(texture_cache->ts) {
+		VLOG(1) << "Texture cache statistics:\n"
+		        << texture_cache->ts->getstats();
+		TextureSystem::destroy(texture_cache->ts);
+	}
+
+	texture_cache->ts = NULL;
+	texture_cache->images.clear();
+	texture_cache = NULL;
 }
 
 CCL_NAMESPACE_END
@@ -30,6 +30,7 @@ CCL_NAMESPACE_BEGIN
 class Device;
 class Progress;
 class Scene;
+struct TextureCacheGlobals;
 
 class ImageManager {
 public:
@@ -116,6 +117,9 @@ public:
 		int users;
 	};
 
+	/* Hits and misses of the texture cache, empty when it's not used. */
+	string texture_cache_stats() const;
+
 private:
 	int tex_num_images[IMAGE_DATA_NUM_TYPES];
 	int max_num_images;
@@ -127,6 +131,7 @@ private:
 
 	vector<Image*> images[IMAGE_DATA_NUM_TYPES];
 	void *osl_texture_system;
+	TextureCacheGlobals *texture_cache;
 
 	bool file_load_image_generic(Image *img,
 	                             ImageInput **in,
@@ -156,6 +161,11 @@ private:
 	void device_free_image(Device *device,
 	                       ImageDataType type,
 	                       int slot);
+
+	void texture_cache_init(Device *device, Scene *scene);
+	bool texture_cache_load_image(Image *img, int flat_slot);
+	void texture_cache_free_image(Image *img, int flat_slot);
+	void texture_cache_free();
 };
 
 CCL_NAMESPACE_END
@@ -68,6 +68,9 @@ NODE_DEFINE(Integrator)
 	SOCKET_BOOLEAN(sample_all_lights_indirect, "Sample All Lights Indirect", true);
 	SOCKET_FLOAT(light_sampling_threshold, "Light Sampling Threshold", 0.05f);
 
+	SOCKET_FLOAT(adaptive_threshold, "Adaptive Threshold", 0.01f);
+	SOCKET_INT(adaptive_min_samples, "Adaptive Min Samples", 16);
+
 	static NodeEnum method_enum;
 	method_enum.insert("path", PATH);
 	method_enum.insert("branched_path", BRANCHED_PATH);
@@ -175,6 +178,13 @@ void Integrator::device_update(Device *device, DeviceScene *dscene, Scene *scene
 		kintegrator->light_inv_rr_threshold = 0.0f;
 	}
 
+	/* convergence is checked every few samples, the minimum number of
+	 * samples is rounded up so the first check happens at that sample */
+	kintegrator->adaptive_threshold = adaptive_threshold;
+	kintegrator->adaptive_step = 4;
+	kintegrator->adaptive_min_samples = max((int)align_up(adaptive_min_samples, kintegrator->adaptive_step),
+	                                        kintegrator->adaptive_step);
+
 	/* sobol directions table */
 	int max_samples = 1;
 
@@ -69,6 +69,9 @@ public:
 	bool sample_all_lights_indirect;
 	float light_sampling_threshold;
 
+	float adaptive_threshold;
+	int adaptive_min_samples;
+
 	enum Method {
 		BRANCHED_PATH = 0,
 		PATH = 1,
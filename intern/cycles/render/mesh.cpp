@@ -35,8 +35,10 @@
 
 #include "util/util_foreach.h"
 #include "util/util_logging.h"
+#include "util/util_md5.h"
 #include "util/util_progress.h"
 #include "util/util_set.h"
+#include "util/util_time.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -1046,21 +1048,46 @@ void Mesh::compute_bvh(Device *device,
 		vector<Object*> objects;
 		objects.push_back(&object);
 
-		if(bvh && !need_update_rebuild) {
+		BVHParams bparams;
+		bparams.use_spatial_split = params->use_bvh_spatial_split;
+		bparams.use_bvh8 = params->use_bvh8 && device->info.has_bvh8;
+		bparams.use_qbvh = params->use_qbvh && device->info.has_qbvh && !bparams.use_bvh8;
+		bparams.use_unaligned_nodes = dscene->data.bvh.have_curves &&
+		                              params->use_bvh_unaligned_nodes;
+		bparams.num_motion_triangle_steps = params->num_bvh_time_steps;
+		bparams.num_motion_curve_steps = params->num_bvh_time_steps;
+
+		/* Refit keeps the node layout, so it is only possible when topology
+		 * and the tree type did not change since the last build. */
+		bool use_refit = bvh && !need_update_rebuild &&
+		                 bvh->params.use_spatial_split == bparams.use_spatial_split &&
+		                 bvh->params.use_qbvh == bparams.use_qbvh &&
+		                 bvh->params.use_bvh8 == bparams.use_bvh8 &&
+		                 bvh->params.use_unaligned_nodes == bparams.use_unaligned_nodes &&
+		                 bvh->params.num_motion_triangle_steps == bparams.num_motion_triangle_steps &&
+		                 bvh->params.num_motion_curve_steps == bparams.num_motion_curve_steps;
+
+		if(use_refit) {
 			progress->set_status(msg, "Refitting BVH");
 			bvh->objects = objects;
 			bvh->refit(*progress);
+
+			/* Deformation can make the refitted tree much slower to traverse
+			 * than a new one, rebuild when SAH cost degraded too much. */
+			const float threshold = params->bvh_refit_rebuild_threshold;
+			if(threshold > 0.0f && !progress->get_cancel() &&
+			   bvh->sah_cost > bvh->build_sah_cost * threshold)
+			{
+				VLOG(1) << "Rebuilding BVH of mesh " << name
+				        << ", refit SAH cost " << bvh->sah_cost
+				        << " exceeds build cost " << bvh->build_sah_cost
+				        << " by more than " << threshold << "x.";
+				use_refit = false;
+			}
 		}
-		else {
-			progress->set_status(msg, "Building BVH");
 
-			BVHParams bparams;
-			bparams.use_spatial_split = params->use_bvh_spatial_split;
-			bparams.use_qbvh = params->use_qbvh && device->info.has_qbvh;
-			bparams.use_unaligned_nodes = dscene->data.bvh.have_curves &&
-			                              params->use_bvh_unaligned_nodes;
-			bparams.num_motion_triangle_steps = params->num_bvh_time_steps;
-			bparams.num_motion_curve_steps = params->num_bvh_time_steps;
+		if(!use_refit) {
+			progress->set_status(msg, "Building BVH");
 
 			delete bvh;
 			bvh = BVH::create(bparams, objects);
@@ -1090,6 +1117,43 @@ void Mesh::tag_update(Scene *scene, bool rebuild)
 	scene->object_manager->need_update = true;
 }
 
+static void mesh_hash_attributes(const AttributeSet& attributes, MD5Hash& md5)
+{
+	foreach(const Attribute& attr, attributes.attributes) {
+		md5.append((const uint8_t*)&attr.name, sizeof(attr.name));
+		md5.append((const uint8_t*)&attr.std, sizeof(attr.std));
+		md5.append((const uint8_t*)&attr.element, sizeof(attr.element));
+		md5.append((const uint8_t*)attr.data(), (int)attr.buffer.size());
+	}
+}
+
+void Mesh::hash(MD5Hash& md5)
+{
+	Node::hash(md5);
+
+	md5.append((const uint8_t*)&subdivision_type, sizeof(subdivision_type));
+	md5.append((const uint8_t*)&geometry_flags, sizeof(geometry_flags));
+
+	foreach(Shader *shader, used_shaders) {
+		md5.append((const uint8_t*)&shader, sizeof(shader));
+	}
+
+	/* subd faces are hashed by member, the struct has padding */
+	for(size_t i = 0; i < subd_faces.size(); i++) {
+		const SubdFace& face = subd_faces[i];
+		md5.append((const uint8_t*)&face.start_corner, sizeof(int));
+		md5.append((const uint8_t*)&face.num_corners, sizeof(int));
+		md5.append((const uint8_t*)&face.shader, sizeof(int));
+		md5.append((const uint8_t*)&face.smooth, sizeof(bool));
+	}
+	md5.append((const uint8_t*)subd_face_corners.data(), sizeof(int)*subd_face_corners.size());
+	md5.append((const uint8_t*)subd_creases.data(), sizeof(SubdEdgeCrease)*subd_creases.size());
+
+	mesh_hash_attributes(attributes, md5);
+	mesh_hash_attributes(curve_attributes, md5);
+	mesh_hash_attributes(subd_attributes, md5);
+}
+
 bool Mesh::has_motion_blur() const
 {
 	return (use_motion_blur &&
@@ -1816,14 +1880,16 @@ void MeshManager::device_update_bvh(Device *device, DeviceScene *dscene, Scene *
 
 	BVHParams bparams;
 	bparams.top_level = true;
-	bparams.use_qbvh = scene->params.use_qbvh && device->info.has_qbvh;
+	bparams.use_bvh8 = scene->params.use_bvh8 && device->info.has_bvh8;
+	bparams.use_qbvh = scene->params.use_qbvh && device->info.has_qbvh && !bparams.use_bvh8;
 	bparams.use_spatial_split = scene->params.use_bvh_spatial_split;
 	bparams.use_unaligned_nodes = dscene->data.bvh.have_curves &&
 	                              scene->params.use_bvh_unaligned_nodes;
 	bparams.num_motion_triangle_steps = scene->params.num_bvh_time_steps;
 	bparams.num_motion_curve_steps = scene->params.num_bvh_time_steps;
 
-	VLOG(1) << (bparams.use_qbvh ? "Using QBVH optimization structure"
+	VLOG(1) << (bparams.use_bvh8 ? "Using BVH8 optimization structure" :
+	            bparams.use_qbvh ? "Using QBVH optimization structure"
 	                             : "Using regular BVH optimization structure");
 
 	BVH *bvh = BVH::create(bparams, scene->objects);
@@ -1882,6 +1948,7 @@ void MeshManager::device_update_bvh(Device *device, DeviceScene *dscene, Scene *
 
 	dscene->data.bvh.root = pack.root_index;
 	dscene->data.bvh.use_qbvh = bparams.use_qbvh;
+	dscene->data.bvh.use_bvh8 = bparams.use_bvh8;
 	dscene->data.bvh.use_bvh_steps = (scene->params.num_bvh_time_steps != 0);
 
 	delete bvh;
@@ -2071,6 +2138,7 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 	}
 
 	/* Update bvh. */
+	scoped_timer bvh_timer;
 	size_t num_bvh = 0;
 	foreach(Mesh *mesh, scene->meshes) {
 		if(mesh->need_update && mesh->need_build_bvh()) {
@@ -2122,6 +2190,7 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 	if(progress.get_cancel()) return;
 
 	device_update_bvh(device, dscene, scene, progress);
+	scene->update_times.bvh += bvh_timer.get_time();
 	if(progress.get_cancel()) return;
 
 	device_update_mesh(device, dscene, scene, false, progress);
@@ -298,6 +298,9 @@ public:
 
 	void tag_update(Scene *scene, bool rebuild);
 
+	/* Includes attributes and subdivision data besides sockets. */
+	void hash(MD5Hash& md5);
+
 	bool has_motion_blur() const;
 	bool has_true_displacement() const;
 
@@ -37,6 +37,7 @@
 #include "util/util_guarded_allocator.h"
 #include "util/util_logging.h"
 #include "util/util_progress.h"
+#include "util/util_time.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -223,7 +224,9 @@ void Scene::device_update(Device *device_, Progress& progress)
 	if(progress.get_cancel() || device->have_error()) return;
 
 	progress.set_status("Updating Images");
+	scoped_timer image_timer;
 	image_manager->device_update(device, this, progress);
+	update_times.images += image_timer.get_time();
 
 	if(progress.get_cancel() || device->have_error()) return;
 
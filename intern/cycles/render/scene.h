@@ -118,6 +118,27 @@ public:
 	DeviceScene(Device *device);
 };
 
+/* Scene Update Times
+ *
+ * Wall clock time spent updating the scene on the device, accumulated over
+ * all updates. Used for benchmark statistics. */
+
+class SceneUpdateTimes {
+public:
+	SceneUpdateTimes() { reset(); }
+
+	void reset()
+	{
+		total = 0.0;
+		bvh = 0.0;
+		images = 0.0;
+	}
+
+	double total;
+	double bvh;
+	double images;
+};
+
 /* Scene Parameters */
 
 class SceneParams {
@@ -133,8 +154,15 @@ public:
 	bool use_bvh_unaligned_nodes;
 	int num_bvh_time_steps;
 	bool use_qbvh;
+	bool use_bvh8;
+	/* Rebuild an object BVH instead of refitting it when the refitted SAH
+	 * cost exceeds the cost at build time by this factor, 0 to always refit. */
+	float bvh_refit_rebuild_threshold;
 	bool persistent_data;
 	int texture_limit;
+	/* Memory budget in megabytes of the CPU texture cache, 0 to load images
+	 * into memory at full resolution. */
+	int texture_cache_size;
 
 	SceneParams()
 	{
@@ -144,8 +172,11 @@ public:
 		use_bvh_unaligned_nodes = true;
 		num_bvh_time_steps = 0;
 		use_qbvh = true;
+		use_bvh8 = true;
+		bvh_refit_rebuild_threshold = 1.5f;
 		persistent_data = false;
 		texture_limit = 0;
+		texture_cache_size = 0;
 	}
 
 	bool modified(const SceneParams& params)
@@ -155,8 +186,11 @@ public:
 		&& use_bvh_unaligned_nodes == params.use_bvh_unaligned_nodes
 		&& num_bvh_time_steps == params.num_bvh_time_steps
 		&& use_qbvh == params.use_qbvh
+		&& use_bvh8 == params.use_bvh8
+		&& bvh_refit_rebuild_threshold == params.bvh_refit_rebuild_threshold
 		&& persistent_data == params.persistent_data
-		&& texture_limit == params.texture_limit); }
+		&& texture_limit == params.texture_limit
+		&& texture_cache_size == params.texture_cache_size); }
 };
 
 /* Scene */
@@ -200,6 +234,9 @@ public:
 	/* parameters */
 	SceneParams params;
 
+	/* statistics */
+	SceneUpdateTimes update_times;
+
 	/* mutex must be locked manually by callers */
 	thread_mutex mutex;
 
@@ -373,6 +373,7 @@ bool Session::acquire_tile(Device *tile_device, RenderTile& rtile)
 	rtile.resolution = tile_manager.state.resolution_divider;
 	rtile.tile_index = tile->index;
 	rtile.task = (tile->state == Tile::DENOISE)? RenderTile::DENOISE: RenderTile::PATH_TRACE;
+	rtile.start_time = time_dt();
 
 	tile_lock.unlock();
 
@@ -436,7 +437,8 @@ void Session::release_tile(RenderTile& rtile)
 {
 	thread_scoped_lock tile_lock(tile_mutex);
 
-	progress.add_finished_tile(rtile.task == RenderTile::DENOISE);
+	progress.add_finished_tile(rtile.task == RenderTile::DENOISE,
+	                           time_dt() - rtile.start_time);
 
 	bool delete_tile;
 
@@ -859,7 +861,10 @@ void Session::update_scene()
 		load_kernels(false);
 
 		progress.set_status("Updating Scene");
+		scoped_timer timer;
 		MEM_GUARDED_CALL(&progress, scene->device_update, device, progress);
+		scene->update_times.total += timer.get_time();
+		VLOG(1) << "Scene device update took " << timer.get_time() << " seconds.";
 	}
 }
 
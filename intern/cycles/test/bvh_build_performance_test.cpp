@@ -0,0 +1,118 @@
+/*
+ * Copyright 2011-2017 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "testing/testing.h"
+
+#include "bvh/bvh.h"
+#include "bvh/bvh_params.h"
+
+#include "render/mesh.h"
+#include "render/object.h"
+
+#include "util/util_progress.h"
+#include "util/util_task.h"
+#include "util/util_time.h"
+
+DEFINE_int32(bvh_grid_size, 1024, "Grid resolution of the mesh, which has twice its square triangles");
+DEFINE_int32(bvh_build_runs, 3, "Number of builds per layout, the fastest one is reported");
+
+CCL_NAMESPACE_BEGIN
+
+namespace {
+
+/* Slightly displaced grid, so the tree isn't built for a flat plane. */
+Mesh *create_grid_mesh(int size)
+{
+	Mesh *mesh = new Mesh();
+
+	mesh->reserve_mesh((size + 1) * (size + 1), 2 * size * size);
+
+	for(int y = 0; y <= size; y++) {
+		for(int x = 0; x <= size; x++) {
+			const float u = (float)x / size;
+			const float v = (float)y / size;
+			mesh->add_vertex(make_float3(u, v, 0.05f * sinf(u * 40.0f) * cosf(v * 40.0f)));
+		}
+	}
+
+	for(int y = 0; y < size; y++) {
+		for(int x = 0; x < size; x++) {
+			const int v0 = y * (size + 1) + x;
+			const int v1 = v0 + 1;
+			const int v2 = v0 + (size + 1);
+			const int v3 = v2 + 1;
+			mesh->add_triangle(v0, v1, v3, 0, false);
+			mesh->add_triangle(v0, v3, v2, 0, false);
+		}
+	}
+
+	return mesh;
+}
+
+double bvh_build_time(Object *object, bool use_qbvh, bool use_spatial_split)
+{
+	BVHParams params;
+	params.use_qbvh = use_qbvh;
+	params.use_spatial_split = use_spatial_split;
+
+	vector<Object*> objects;
+	objects.push_back(object);
+
+	double best_time = 0.0;
+
+	for(int run = 0; run < FLAGS_bvh_build_runs; run++) {
+		Progress progress;
+		BVH *bvh = BVH::create(params, objects);
+
+		const double time_start = time_dt();
+		bvh->build(progress);
+		const double time = time_dt() - time_start;
+
+		EXPECT_GT(bvh->pack.nodes.size(), (size_t)0);
+		delete bvh;
+
+		if(run == 0 || time < best_time) {
+			best_time = time;
+		}
+	}
+
+	return best_time;
+}
+
+}  // namespace
+
+TEST(bvh_build_performance, grid) {
+	TaskScheduler::init(0);
+
+	Mesh *mesh = create_grid_mesh(FLAGS_bvh_grid_size);
+	Object *object = new Object();
+	object->mesh = mesh;
+
+	printf("BVH build of %d triangles with %d threads:\n",
+	       (int)mesh->num_triangles(),
+	       TaskScheduler::num_threads());
+	printf("  BVH2 binned:  %.3f s\n", bvh_build_time(object, false, false));
+	printf("  BVH4 binned:  %.3f s\n", bvh_build_time(object, true, false));
+	printf("  BVH2 spatial: %.3f s\n", bvh_build_time(object, false, true));
+	printf("  BVH4 spatial: %.3f s\n", bvh_build_time(object, true, true));
+
+	delete object;
+	delete mesh;
+
+	TaskScheduler::exit();
+}
+
+CCL_NAMESPACE_END
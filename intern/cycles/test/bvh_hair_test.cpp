@@ -0,0 +1,197 @@
+/*
+ * Copyright 2011-2017 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "testing/testing.h"
+
+#include "device/device.h"
+
+#include "render/background.h"
+#include "render/buffers.h"
+#include "render/camera.h"
+#include "render/integrator.h"
+#include "render/mesh.h"
+#include "render/object.h"
+#include "render/scene.h"
+#include "render/session.h"
+
+#include "util/util_foreach.h"
+#include "util/util_function.h"
+#include "util/util_hash.h"
+#include "util/util_progress.h"
+
+CCL_NAMESPACE_BEGIN
+
+namespace {
+
+const int resolution = 64;
+
+enum BVHLayout {
+	BVH_LAYOUT_BVH2,
+	BVH_LAYOUT_BVH4,
+	BVH_LAYOUT_BVH8,
+};
+
+float random_01(uint i)
+{
+	return (float)hash_int(i) / (float)0xFFFFFFFF;
+}
+
+/* Strands with random tilt in front of the camera. Curves are put into
+ * unaligned nodes, and with this few of them most nodes have empty child
+ * slots.
+ */
+void scene_add_hair(Scene *scene, int num_curves)
+{
+	const int num_keys = 4;
+
+	Mesh *mesh = new Mesh();
+	mesh->used_shaders.push_back(scene->default_surface);
+	mesh->reserve_curves(num_curves, num_curves * num_keys);
+
+	for(int i = 0; i < num_curves; i++) {
+		const float x = random_01(i * 3) * 2.0f - 1.0f;
+		const float y = random_01(i * 3 + 1) * 2.0f - 1.0f;
+		const float tilt = (random_01(i * 3 + 2) - 0.5f) * 0.5f;
+
+		mesh->add_curve(mesh->curve_keys.size(), 0);
+		for(int k = 0; k < num_keys; k++) {
+			const float t = (float)k / (num_keys - 1);
+			mesh->add_curve_key(make_float3(x + tilt * t, y + 0.5f * t, 2.0f + 0.2f * t),
+			                     0.02f * (1.0f - 0.5f * t));
+		}
+	}
+
+	Object *object = new Object();
+	object->mesh = mesh;
+
+	scene->meshes.push_back(mesh);
+	scene->objects.push_back(object);
+}
+
+void write_render_tile(RenderTile& rtile, vector<float> *pixels)
+{
+	RenderBuffers *buffers = rtile.buffers;
+	if(!buffers->copy_from_device()) {
+		return;
+	}
+
+	vector<float> tile_pixels(rtile.w * rtile.h * 4);
+	if(!buffers->get_pass_rect(PASS_COMBINED, 1.0f, rtile.sample, 4, &tile_pixels[0])) {
+		return;
+	}
+
+	for(int y = 0; y < rtile.h; y++) {
+		memcpy(&(*pixels)[((rtile.y + y) * resolution + rtile.x) * 4],
+		       &tile_pixels[y * rtile.w * 4],
+		       sizeof(float) * rtile.w * 4);
+	}
+}
+
+/* Render the hair with the given layout, only camera rays are traced so the
+ * alpha is the coverage of the curves. Returns false when the layout is not
+ * supported by the device.
+ */
+bool render_hair(const DeviceInfo& device_info, BVHLayout layout, vector<float> *pixels)
+{
+	if(layout == BVH_LAYOUT_BVH8 && !device_info.has_bvh8) {
+		return false;
+	}
+
+	SessionParams session_params;
+	session_params.device = device_info;
+	session_params.background = true;
+	session_params.samples = 4;
+
+	SceneParams scene_params;
+	scene_params.bvh_type = SceneParams::BVH_STATIC;
+	scene_params.use_qbvh = (layout == BVH_LAYOUT_BVH4);
+	scene_params.use_bvh8 = (layout == BVH_LAYOUT_BVH8);
+	scene_params.use_bvh_unaligned_nodes = true;
+
+	Session *session = new Session(session_params);
+	Scene *scene = new Scene(scene_params, session->device);
+
+	scene_add_hair(scene, 100);
+
+	scene->integrator->max_bounce = 0;
+	scene->integrator->tag_update(scene);
+	scene->background->transparent = true;
+	scene->background->tag_update(scene);
+
+	scene->camera->width = resolution;
+	scene->camera->height = resolution;
+	scene->camera->compute_auto_viewplane();
+	scene->camera->need_update = true;
+
+	BufferParams buffer_params;
+	buffer_params.width = resolution;
+	buffer_params.height = resolution;
+	buffer_params.full_width = resolution;
+	buffer_params.full_height = resolution;
+
+	pixels->clear();
+	pixels->resize(resolution * resolution * 4, -1.0f);
+	session->write_render_tile_cb = function_bind(&write_render_tile, _1, pixels);
+
+	session->scene = scene;
+	session->reset(buffer_params, session_params.samples);
+	session->start();
+	session->wait();
+	delete session;
+
+	return true;
+}
+
+DeviceInfo cpu_device_info()
+{
+	vector<DeviceInfo>& devices = Device::available_devices();
+	foreach(DeviceInfo& info, devices) {
+		if(info.type == DEVICE_CPU) {
+			return info;
+		}
+	}
+	return DeviceInfo();
+}
+
+}  // namespace
+
+/* Curves have to be found the same way no matter which layout is used. */
+TEST(bvh_hair, layouts_match) {
+	DeviceInfo device_info = cpu_device_info();
+	ASSERT_EQ(device_info.type, DEVICE_CPU);
+
+	vector<float> reference, pixels;
+	ASSERT_TRUE(render_hair(device_info, BVH_LAYOUT_BVH2, &reference));
+
+	float coverage = 0.0f;
+	for(size_t i = 3; i < reference.size(); i += 4) {
+		coverage += reference[i];
+	}
+	/* Make sure some of the hair is actually visible. */
+	EXPECT_GT(coverage, 0.0f);
+
+	const BVHLayout layouts[] = {BVH_LAYOUT_BVH4, BVH_LAYOUT_BVH8};
+	for(int l = 0; l < 2; l++) {
+		if(!render_hair(device_info, layouts[l], &pixels)) {
+			continue;
+		}
+		for(size_t i = 3; i < pixels.size(); i += 4) {
+			EXPECT_NEAR(reference[i], pixels[i], 1e-4f) << "layout " << l << ", pixel " << i / 4;
+		}
+	}
+}
+
+CCL_NAMESPACE_END
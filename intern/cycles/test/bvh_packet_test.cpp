@@ -0,0 +1,204 @@
+/*
+ * Copyright 2011-2017 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "testing/testing.h"
+
+#include "device/device.h"
+
+#include "render/background.h"
+#include "render/buffers.h"
+#include "render/camera.h"
+#include "render/film.h"
+#include "render/integrator.h"
+#include "render/mesh.h"
+#include "render/object.h"
+#include "render/scene.h"
+#include "render/session.h"
+
+#include "util/util_debug.h"
+#include "util/util_foreach.h"
+#include "util/util_function.h"
+#include "util/util_progress.h"
+
+CCL_NAMESPACE_BEGIN
+
+namespace {
+
+const int resolution = 64;
+
+/* Displaced grid covering part of the view, so the packets contain rays which
+ * hit, rays which miss and rays which hit different triangles.
+ */
+void scene_add_grid(Scene *scene, int size)
+{
+	Mesh *mesh = new Mesh();
+	mesh->used_shaders.push_back(scene->default_surface);
+	mesh->reserve_mesh((size + 1) * (size + 1), 2 * size * size);
+
+	for(int y = 0; y <= size; y++) {
+		for(int x = 0; x <= size; x++) {
+			const float u = (float)x / size;
+			const float v = (float)y / size;
+			mesh->add_vertex(make_float3(u * 2.0f - 0.5f,
+			                             v * 2.0f - 0.7f,
+			                             2.0f + 0.3f * sinf(u * 20.0f) * cosf(v * 20.0f)));
+		}
+	}
+
+	for(int y = 0; y < size; y++) {
+		for(int x = 0; x < size; x++) {
+			const int v0 = y * (size + 1) + x;
+			const int v1 = v0 + 1;
+			const int v2 = v0 + (size + 1);
+			const int v3 = v2 + 1;
+			mesh->add_triangle(v0, v1, v3, 0, false);
+			mesh->add_triangle(v0, v3, v2, 0, false);
+		}
+	}
+
+	Object *object = new Object();
+	object->mesh = mesh;
+
+	scene->meshes.push_back(mesh);
+	scene->objects.push_back(object);
+}
+
+struct RenderResult {
+	vector<float> alpha;
+	vector<float> depth;
+};
+
+void write_render_tile(RenderTile& rtile, RenderResult *result)
+{
+	RenderBuffers *buffers = rtile.buffers;
+	if(!buffers->copy_from_device()) {
+		return;
+	}
+
+	vector<float> combined(rtile.w * rtile.h * 4);
+	vector<float> depth(rtile.w * rtile.h);
+	if(!buffers->get_pass_rect(PASS_COMBINED, 1.0f, rtile.sample, 4, &combined[0]) ||
+	   !buffers->get_pass_rect(PASS_DEPTH, 1.0f, rtile.sample, 1, &depth[0]))
+	{
+		return;
+	}
+
+	for(int y = 0; y < rtile.h; y++) {
+		for(int x = 0; x < rtile.w; x++) {
+			const int index = (rtile.y + y) * resolution + rtile.x + x;
+			result->alpha[index] = combined[(y * rtile.w + x) * 4 + 3];
+			result->depth[index] = depth[y * rtile.w + x];
+		}
+	}
+}
+
+/* Render camera rays only, so coverage and depth of every pixel tell which
+ * triangle its camera ray hit, if any.
+ */
+void render_camera_rays(const DeviceInfo& device_info, bool use_packet_traversal, RenderResult *result)
+{
+	SessionParams session_params;
+	session_params.device = device_info;
+	session_params.background = true;
+	session_params.samples = 4;
+
+	SceneParams scene_params;
+	scene_params.bvh_type = SceneParams::BVH_STATIC;
+	scene_params.use_qbvh = true;
+
+	/* Read by the device when it is created. */
+	DebugFlags().cpu.packet_traversal = use_packet_traversal;
+
+	Session *session = new Session(session_params);
+	Scene *scene = new Scene(scene_params, session->device);
+
+	scene_add_grid(scene, 32);
+
+	scene->integrator->max_bounce = 0;
+	scene->integrator->tag_update(scene);
+	scene->background->transparent = true;
+	scene->background->tag_update(scene);
+
+	array<Pass> passes;
+	Pass::add(PASS_COMBINED, passes);
+	Pass::add(PASS_DEPTH, passes);
+	scene->film->tag_passes_update(scene, passes);
+	scene->film->tag_update(scene);
+
+	scene->camera->width = resolution;
+	scene->camera->height = resolution;
+	scene->camera->compute_auto_viewplane();
+	scene->camera->need_update = true;
+
+	BufferParams buffer_params;
+	buffer_params.width = resolution;
+	buffer_params.height = resolution;
+	buffer_params.full_width = resolution;
+	buffer_params.full_height = resolution;
+	buffer_params.passes = passes;
+
+	result->alpha.clear();
+	result->alpha.resize(resolution * resolution, -1.0f);
+	result->depth.clear();
+	result->depth.resize(resolution * resolution, -1.0f);
+	session->write_render_tile_cb = function_bind(&write_render_tile, _1, result);
+
+	session->scene = scene;
+	session->reset(buffer_params, session_params.samples);
+	session->start();
+	session->wait();
+	delete session;
+
+	DebugFlags().cpu.packet_traversal = false;
+}
+
+DeviceInfo cpu_device_info()
+{
+	vector<DeviceInfo>& devices = Device::available_devices();
+	foreach(DeviceInfo& info, devices) {
+		if(info.type == DEVICE_CPU) {
+			return info;
+		}
+	}
+	return DeviceInfo();
+}
+
+}  // namespace
+
+/* Packets have to find the same hits as rays traced one by one. */
+TEST(bvh_packet, hits_match_single_rays) {
+	DeviceInfo device_info = cpu_device_info();
+	ASSERT_EQ(device_info.type, DEVICE_CPU);
+
+	RenderResult single, packet;
+	render_camera_rays(device_info, false, &single);
+	render_camera_rays(device_info, true, &packet);
+
+	/* Make sure both hits and misses are tested. */
+	int num_hit = 0;
+	for(size_t i = 0; i < single.alpha.size(); i++) {
+		num_hit += (single.alpha[i] > 0.0f);
+	}
+	EXPECT_GT(num_hit, 0);
+	EXPECT_LT(num_hit, resolution * resolution);
+
+	for(size_t i = 0; i < single.alpha.size(); i++) {
+		EXPECT_EQ(single.alpha[i], packet.alpha[i]) << "pixel " << i;
+		EXPECT_EQ(single.depth[i], packet.depth[i]) << "pixel " << i;
+	}
+}
+
+CCL_NAMESPACE_END
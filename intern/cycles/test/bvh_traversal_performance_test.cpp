@@ -0,0 +1,197 @@
+/*
+ * Copyright 2011-2017 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "testing/testing.h"
+
+#include "device/device.h"
+
+#include "render/buffers.h"
+#include "render/camera.h"
+#include "render/integrator.h"
+#include "render/mesh.h"
+#include "render/object.h"
+#include "render/scene.h"
+#include "render/session.h"
+
+#include "util/util_debug.h"
+#include "util/util_foreach.h"
+#include "util/util_progress.h"
+
+DEFINE_int32(bvh_traversal_grid_size, 512, "Grid resolution of the mesh, which has twice its square triangles");
+DEFINE_int32(bvh_traversal_resolution, 256, "Width and height of the rendered image");
+DEFINE_int32(bvh_traversal_samples, 16, "Number of samples per pixel");
+
+CCL_NAMESPACE_BEGIN
+
+namespace {
+
+enum BVHLayout {
+	BVH_LAYOUT_BVH2,
+	BVH_LAYOUT_BVH4,
+	BVH_LAYOUT_BVH8,
+};
+
+/* Displaced grid in front of the camera, so rays travel through the whole
+ * tree and bounce a few times on the surface.
+ */
+void scene_add_grid(Scene *scene, int size)
+{
+	Mesh *mesh = new Mesh();
+	mesh->used_shaders.push_back(scene->default_surface);
+	mesh->reserve_mesh((size + 1) * (size + 1), 2 * size * size);
+
+	for(int y = 0; y <= size; y++) {
+		for(int x = 0; x <= size; x++) {
+			const float u = (float)x / size;
+			const float v = (float)y / size;
+			mesh->add_vertex(make_float3(u * 2.0f - 1.0f,
+			                             v * 2.0f - 1.0f,
+			                             2.0f + 0.1f * sinf(u * 40.0f) * cosf(v * 40.0f)));
+		}
+	}
+
+	for(int y = 0; y < size; y++) {
+		for(int x = 0; x < size; x++) {
+			const int v0 = y * (size + 1) + x;
+			const int v1 = v0 + 1;
+			const int v2 = v0 + (size + 1);
+			const int v3 = v2 + 1;
+			mesh->add_triangle(v0, v1, v3, 0, false);
+			mesh->add_triangle(v0, v3, v2, 0, false);
+		}
+	}
+
+	Object *object = new Object();
+	object->mesh = mesh;
+
+	scene->meshes.push_back(mesh);
+	scene->objects.push_back(object);
+}
+
+/* Render the grid with the given layout, returns samples per second or zero
+ * when the layout is not supported by the device. With camera_rays_only no
+ * bounces are traced, which measures primary ray throughput.
+ */
+double render_samples_per_second(const DeviceInfo& device_info,
+                                 BVHLayout layout,
+                                 bool camera_rays_only = false,
+                                 bool use_packet_traversal = false)
+{
+	if(layout == BVH_LAYOUT_BVH8 && !device_info.has_bvh8) {
+		return 0.0;
+	}
+
+	SessionParams session_params;
+	session_params.device = device_info;
+	session_params.background = true;
+	session_params.samples = FLAGS_bvh_traversal_samples;
+
+	SceneParams scene_params;
+	scene_params.bvh_type = SceneParams::BVH_STATIC;
+	scene_params.use_qbvh = (layout == BVH_LAYOUT_BVH4);
+	scene_params.use_bvh8 = (layout == BVH_LAYOUT_BVH8);
+
+	DebugFlags().cpu.packet_traversal = use_packet_traversal;
+
+	Session *session = new Session(session_params);
+	Scene *scene = new Scene(scene_params, session->device);
+
+	scene_add_grid(scene, FLAGS_bvh_traversal_grid_size);
+
+	if(camera_rays_only) {
+		scene->integrator->max_bounce = 0;
+		scene->integrator->tag_update(scene);
+	}
+
+	const int resolution = FLAGS_bvh_traversal_resolution;
+	scene->camera->width = resolution;
+	scene->camera->height = resolution;
+	scene->camera->compute_auto_viewplane();
+	scene->camera->need_update = true;
+
+	BufferParams buffer_params;
+	buffer_params.width = resolution;
+	buffer_params.height = resolution;
+	buffer_params.full_width = resolution;
+	buffer_params.full_height = resolution;
+
+	session->scene = scene;
+	session->reset(buffer_params, session_params.samples);
+	session->start();
+	session->wait();
+
+	double total_time, render_time;
+	session->progress.get_time(total_time, render_time);
+	delete session;
+
+	DebugFlags().cpu.packet_traversal = false;
+
+	const double num_samples = (double)resolution * resolution * FLAGS_bvh_traversal_samples;
+	return (render_time > 0.0)? num_samples / render_time: 0.0;
+}
+
+DeviceInfo cpu_device_info()
+{
+	vector<DeviceInfo>& devices = Device::available_devices();
+	foreach(DeviceInfo& info, devices) {
+		if(info.type == DEVICE_CPU) {
+			return info;
+		}
+	}
+	return DeviceInfo();
+}
+
+}  // namespace
+
+TEST(bvh_traversal_performance, grid) {
+	DeviceInfo device_info = cpu_device_info();
+	ASSERT_EQ(device_info.type, DEVICE_CPU);
+
+	printf("Rendering %d triangles at %dx%d with %d samples:\n",
+	       2 * FLAGS_bvh_traversal_grid_size * FLAGS_bvh_traversal_grid_size,
+	       FLAGS_bvh_traversal_resolution,
+	       FLAGS_bvh_traversal_resolution,
+	       FLAGS_bvh_traversal_samples);
+
+	const char *names[] = {"BVH2", "BVH4", "BVH8"};
+	const BVHLayout layouts[] = {BVH_LAYOUT_BVH2, BVH_LAYOUT_BVH4, BVH_LAYOUT_BVH8};
+	for(int i = 0; i < 3; i++) {
+		const double samples_per_second = render_samples_per_second(device_info, layouts[i]);
+		if(samples_per_second == 0.0) {
+			printf("  %s: not supported by this CPU\n", names[i]);
+		}
+		else {
+			printf("  %s: %.3f M samples/s\n", names[i], samples_per_second * 1e-6);
+		}
+	}
+}
+
+TEST(bvh_traversal_performance, camera_rays) {
+	DeviceInfo device_info = cpu_device_info();
+	ASSERT_EQ(device_info.type, DEVICE_CPU);
+
+	printf("Camera rays of %d triangles at %dx%d with %d samples:\n",
+	       2 * FLAGS_bvh_traversal_grid_size * FLAGS_bvh_traversal_grid_size,
+	       FLAGS_bvh_traversal_resolution,
+	       FLAGS_bvh_traversal_resolution,
+	       FLAGS_bvh_traversal_samples);
+	printf("  Single rays:  %.3f M rays/s\n",
+	       render_samples_per_second(device_info, BVH_LAYOUT_BVH4, true, false) * 1e-6);
+	printf("  Packet rays:  %.3f M rays/s\n",
+	       render_samples_per_second(device_info, BVH_LAYOUT_BVH4, true, true) * 1e-6);
+}
+
+CCL_NAMESPACE_END
@@ -0,0 +1,266 @@
+/*
+ * Copyright 2011-2017 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "testing/testing.h"
+
+#include <OpenImageIO/imageio.h>
+
+#include "kernel/filter/filter.h"
+
+#include "util/util_hash.h"
+#include "util/util_math.h"
+#include "util/util_optimization.h"
+#include "util/util_system.h"
+#include "util/util_time.h"
+#include "util/util_vector.h"
+
+OIIO_NAMESPACE_USING
+
+DEFINE_string(filter_nlm_image, "", "Saved render result to denoise, a noisy test image is generated when empty");
+DEFINE_int32(filter_nlm_resolution, 256, "Width and height of the generated test image");
+DEFINE_int32(filter_nlm_radius, 8, "Search window radius of the filter");
+DEFINE_int32(filter_nlm_iterations, 3, "Number of times the image is filtered per architecture");
+
+CCL_NAMESPACE_BEGIN
+
+namespace {
+
+/* Only the NLM kernels are timed, the rest of the denoiser is unchanged
+ * between architectures.
+ */
+struct NLMKernels {
+	const char *name;
+	void (*calc_difference)(int, int, float*, float*, float*, int*, int, int, float, float);
+	void (*blur)(float*, float*, int*, int, int);
+	void (*calc_weight)(float*, float*, int*, int, int);
+	void (*update_output)(int, int, float*, float*, float*, float*, int*, int, int);
+	void (*normalize)(float*, float*, int*, int);
+};
+
+#define NLM_KERNELS(arch) { \
+	#arch, \
+	kernel_##arch##_filter_nlm_calc_difference, \
+	kernel_##arch##_filter_nlm_blur, \
+	kernel_##arch##_filter_nlm_calc_weight, \
+	kernel_##arch##_filter_nlm_update_output, \
+	kernel_##arch##_filter_nlm_normalize, \
+}
+
+struct NLMImage {
+	int width, height;
+	/* Row stride, deliberately not padded so odd widths are tested as well. */
+	int w;
+	vector<float> image;
+	vector<float> variance;
+};
+
+/* Variance is estimated from the difference to the 3x3 neighborhood mean,
+ * render buffers saved as images don't contain the variance pass. */
+void image_estimate_variance(NLMImage& img)
+{
+	img.variance.resize(img.image.size());
+	for(int y = 0; y < img.height; y++) {
+		for(int x = 0; x < img.width; x++) {
+			float sum = 0.0f;
+			int num = 0;
+			for(int y1 = max(0, y-1); y1 < min(img.height, y+2); y1++) {
+				for(int x1 = max(0, x-1); x1 < min(img.width, x+2); x1++) {
+					sum += img.image[y1*img.w + x1];
+					num++;
+				}
+			}
+			const float diff = img.image[y*img.w + x] - sum / num;
+			img.variance[y*img.w + x] = max(diff*diff, 1e-4f);
+		}
+	}
+}
+
+bool image_load(const string& filepath, NLMImage& img)
+{
+	ImageInput *in = ImageInput::create(filepath);
+	if(!in) {
+		return false;
+	}
+
+	ImageSpec spec;
+	if(!in->open(filepath, spec)) {
+		delete in;
+		return false;
+	}
+
+	vector<float> pixels(spec.width * spec.height * spec.nchannels);
+	in->read_image(TypeDesc::FLOAT, &pixels[0]);
+	in->close();
+	delete in;
+
+	img.width = img.w = spec.width;
+	img.height = spec.height;
+	img.image.resize(img.width * img.height);
+
+	/* Filter the average of the color channels. */
+	const int num_channels = min(spec.nchannels, 3);
+	for(int i = 0; i < img.width * img.height; i++) {
+		float sum = 0.0f;
+		for(int c = 0; c < num_channels; c++) {
+			sum += pixels[i*spec.nchannels + c];
+		}
+		img.image[i] = sum / num_channels;
+	}
+
+	image_estimate_variance(img);
+	return true;
+}
+
+void image_generate(int resolution, NLMImage& img)
+{
+	/* Odd width to cover the remainder of the SIMD loops. */
+	img.width = img.w = resolution + 3;
+	img.height = resolution;
+	img.image.resize(img.width * img.height);
+
+	for(int y = 0; y < img.height; y++) {
+		for(int x = 0; x < img.width; x++) {
+			const float u = (float)x / img.width;
+			const float v = (float)y / img.height;
+			const float noise = (float)(hash_int_2d(x, y) & 0xffff) / 0xffff - 0.5f;
+			img.image[y*img.w + x] = 0.5f + 0.25f*sinf(u*20.0f)*cosf(v*20.0f) + 0.2f*noise;
+		}
+	}
+
+	image_estimate_variance(img);
+}
+
+/* Same steps as CPUDevice::denoising_non_local_means. */
+void filter_nlm(const NLMKernels& kernels, NLMImage& img, int r, vector<float>& out)
+{
+	const int f = 4;
+	const float a = 1.0f;
+	const float k_2 = 0.5f;
+	const int w = img.w;
+	const int h = img.height;
+
+	vector<float> blur_difference(w*h, 0.0f);
+	vector<float> difference(w*h, 0.0f);
+	vector<float> weight_accum(w*h, 0.0f);
+	out.assign(w*h, 0.0f);
+
+	for(int i = 0; i < (2*r+1)*(2*r+1); i++) {
+		int dy = i / (2*r+1) - r;
+		int dx = i % (2*r+1) - r;
+
+		int local_rect[4] = {max(0, -dx), max(0, -dy), img.width - max(0, dx), h - max(0, dy)};
+		kernels.calc_difference(dx, dy,
+		                        &img.image[0],
+		                        &img.variance[0],
+		                        &difference[0],
+		                        local_rect,
+		                        w, 0,
+		                        a, k_2);
+
+		kernels.blur(&difference[0], &blur_difference[0], local_rect, w, f);
+		kernels.calc_weight(&blur_difference[0], &difference[0], local_rect, w, f);
+		kernels.blur(&difference[0], &blur_difference[0], local_rect, w, f);
+
+		kernels.update_output(dx, dy,
+		                      &blur_difference[0],
+		                      &img.image[0],
+		                      &out[0],
+		                      &weight_accum[0],
+		                      local_rect,
+		                      w, f);
+	}
+
+	int local_rect[4] = {0, 0, img.width, h};
+	kernels.normalize(&out[0], &weight_accum[0], local_rect, w);
+}
+
+vector<NLMKernels> available_kernels()
+{
+	vector<NLMKernels> kernels;
+	NLMKernels kernels_cpu = NLM_KERNELS(cpu);
+	kernels.push_back(kernels_cpu);
+#ifdef WITH_CYCLES_OPTIMIZED_KERNEL_SSE41
+	if(system_cpu_support_sse41()) {
+		NLMKernels kernels_sse41 = NLM_KERNELS(cpu_sse41);
+		kernels.push_back(kernels_sse41);
+	}
+#endif
+#ifdef WITH_CYCLES_OPTIMIZED_KERNEL_AVX
+	if(system_cpu_support_avx()) {
+		NLMKernels kernels_avx = NLM_KERNELS(cpu_avx);
+		kernels.push_back(kernels_avx);
+	}
+#endif
+#ifdef WITH_CYCLES_OPTIMIZED_KERNEL_AVX2
+	if(system_cpu_support_avx2()) {
+		NLMKernels kernels_avx2 = NLM_KERNELS(cpu_avx2);
+		kernels.push_back(kernels_avx2);
+	}
+#endif
+	return kernels;
+}
+
+}  // namespace
+
+TEST(filter_nlm_performance, architectures) {
+	NLMImage img;
+	if(FLAGS_filter_nlm_image.empty()) {
+		image_generate(FLAGS_filter_nlm_resolution, img);
+	}
+	else {
+		ASSERT_TRUE(image_load(FLAGS_filter_nlm_image, img)) << "Failed to read " << FLAGS_filter_nlm_image;
+	}
+
+	const int r = FLAGS_filter_nlm_radius;
+	printf("Filtering %dx%d pixels with radius %d:\n", img.width, img.height, r);
+
+	vector<NLMKernels> kernels = available_kernels();
+	vector<float> reference;
+
+	for(size_t i = 0; i < kernels.size(); i++) {
+		vector<float> out;
+		double best_time = 0.0;
+		for(int iteration = 0; iteration < FLAGS_filter_nlm_iterations; iteration++) {
+			const double start_time = time_dt();
+			filter_nlm(kernels[i], img, r, out);
+			const double filter_time = time_dt() - start_time;
+			if(iteration == 0 || filter_time < best_time) {
+				best_time = filter_time;
+			}
+		}
+
+		printf("  %-10s %.3f s, %.3f M pixels/s\n",
+		       kernels[i].name,
+		       best_time,
+		       (best_time > 0.0)? img.width * img.height / best_time * 1e-6: 0.0);
+
+		/* All architectures must give the same result as the scalar kernels,
+		 * up to rounding differences of fused multiply-add. */
+		if(i == 0) {
+			reference = out;
+			continue;
+		}
+		for(int y = 0; y < img.height; y++) {
+			for(int x = 0; x < img.width; x++) {
+				const float expected = reference[y*img.w + x];
+				ASSERT_NEAR(expected, out[y*img.w + x], 1e-4f * max(fabsf(expected), 1.0f))
+				        << kernels[i].name << " at pixel " << x << ", " << y;
+			}
+		}
+	}
+}
+
+CCL_NAMESPACE_END
@@ -107,6 +107,17 @@ __forceinline const avxf operator^(const avxf& a, const avxf& b) { return _mm256
 
 __forceinline const avxf operator&(const avxf& a, const avxf& b) { return _mm256_and_ps(a.m256,b.m256); }
 
+__forceinline const avxf min(const avxf& a, const avxf& b) { return _mm256_min_ps(a.m256, b.m256); }
+__forceinline const avxf max(const avxf& a, const avxf& b) { return _mm256_max_ps(a.m256, b.m256); }
+
+////////////////////////////////////////////////////////////////////////////////
+/// Comparison Operators
+////////////////////////////////////////////////////////////////////////////////
+
+__forceinline const avxf operator <=(const avxf& a, const avxf& b) { return _mm256_cmp_ps(a.m256, b.m256, _CMP_LE_OS); }
+
+__forceinline int movemask(const avxf& a) { return _mm256_movemask_ps(a.m256); }
+
 ////////////////////////////////////////////////////////////////////////////////
 /// Movement/Shifting/Shuffling Functions
 ////////////////////////////////////////////////////////////////////////////////
@@ -171,6 +182,14 @@ __forceinline const avxf madd (const avxf& a, const avxf& b, const avxf& c) {
 #endif
 }
 
+__forceinline const avxf msub(const avxf& a, const avxf& b, const avxf& c) {
+#ifdef __KERNEL_AVX2__
+	return _mm256_fmsub_ps(a, b, c);
+#else
+	return (a*b)-c;
+#endif
+}
+
 __forceinline const avxf nmadd(const avxf& a, const avxf& b, const avxf& c) {
 #ifdef __KERNEL_AVX2__
 	return _mm256_fnmadd_ps(a, b, c);
@@ -178,6 +197,18 @@ __forceinline const avxf nmadd(const avxf& a, const avxf& b, const avxf& c) {
 	return c-(a*b);
 #endif
 }
+
+////////////////////////////////////////////////////////////////////////////////
+/// Memory load and store operations
+////////////////////////////////////////////////////////////////////////////////
+
+__forceinline avxf loadu8f(const void* const a) {
+	return _mm256_loadu_ps((float*)a);
+}
+
+__forceinline void storeu8f(void* ptr, const avxf& v) {
+	_mm256_storeu_ps((float*)ptr, v);
+}
 #endif
 
 #ifndef _mm256_set_m128
@@ -50,8 +50,14 @@ public:
 		/* Whether QBVH usage is allowed or not. */
 		bool qbvh;
 
+		/* Whether BVH8 usage is allowed or not, takes precedence over QBVH. */
+		bool bvh8;
+
 		/* Whether split kernel is used */
 		bool split_kernel;
+
+		/* Whether camera rays are traced in packets. */
+		bool packet_traversal;
 	};
 
 	/* Descriptor of CUDA feature-set to be used. */
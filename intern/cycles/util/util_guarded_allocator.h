@@ -163,6 +163,8 @@ public:
 /* Get memory usage and peak from the guarded STL allocator. */
 size_t util_guarded_get_mem_used(void);
 size_t util_guarded_get_mem_peak(void);
+/* Start measuring the peak from current usage. */
+void util_guarded_reset_mem_peak(void);
 
 /* Call given function and keep track if it runs out of memory.
  *
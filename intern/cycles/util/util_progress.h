@@ -39,6 +39,8 @@ public:
 		current_tile_sample = 0;
 		rendered_tiles = 0;
 		denoised_tiles = 0;
+		path_trace_time = 0.0;
+		denoise_time = 0.0;
 		start_time = time_dt();
 		render_start_time = time_dt();
 		end_time = 0.0;
@@ -79,6 +81,8 @@ public:
 		current_tile_sample = 0;
 		rendered_tiles = 0;
 		denoised_tiles = 0;
+		path_trace_time = 0.0;
+		denoise_time = 0.0;
 		start_time = time_dt();
 		render_start_time = time_dt();
 		end_time = 0.0;
@@ -222,15 +226,17 @@ public:
 		set_update();
 	}
 
-	void add_finished_tile(bool denoised)
+	void add_finished_tile(bool denoised, double tile_time)
 	{
 		thread_scoped_lock lock(progress_mutex);
 
 		if(denoised) {
 			denoised_tiles++;
+			denoise_time += tile_time;
 		}
 		else {
 			rendered_tiles++;
+			path_trace_time += tile_time;
 		}
 	}
 
@@ -254,6 +260,20 @@ public:
 		return denoised_tiles;
 	}
 
+	uint64_t get_pixel_samples()
+	{
+		thread_scoped_lock lock(progress_mutex);
+		return pixel_samples;
+	}
+
+	/* Time spent on tiles summed over all threads, not wall clock time. */
+	void get_tile_times(double& path_trace_time_, double& denoise_time_)
+	{
+		thread_scoped_lock lock(progress_mutex);
+		path_trace_time_ = path_trace_time;
+		denoise_time_ = denoise_time;
+	}
+
 	/* status messages */
 
 	void set_status(const string& status_, const string& substatus_ = "")
@@ -345,6 +365,8 @@ protected:
 	/* Stores the number of tiles that's already finished.
 	 * Used to determine whether all but the last tile are finished rendering, in which case the current_tile_sample is displayed. */
 	int rendered_tiles, denoised_tiles;
+	/* Time spent path tracing and denoising tiles, summed over all threads. */
+	double path_trace_time, denoise_time;
 
 	double start_time, render_start_time;
 	/* End time written when render is done, so it doesn't keep increasing on redraws. */
@@ -422,12 +422,14 @@ class NODE_PT_quality(bpy.types.Panel):
         col.prop(tree, "render_quality", text="Render")
         col.prop(tree, "edit_quality", text="Edit")
         col.prop(tree, "chunk_size")
+        col.prop(tree, "cache_size")
 
         col = layout.column()
         col.prop(tree, "use_opencl")
         col.prop(tree, "use_groupnode_buffer")
         col.prop(tree, "use_two_pass")
         col.prop(tree, "use_viewer_border")
+        col.prop(tree, "use_full_frame")
 
 
 class NODE_UL_interface_sockets(bpy.types.UIList):
@@ -128,6 +128,7 @@ enum {
 	G_DEBUG_DEPSGRAPH_NO_THREADS = (1 << 11),  /* single threaded depsgraph */
 	G_DEBUG_GPU =        (1 << 12), /* gpu debug */
 	G_DEBUG_IO = (1 << 13),   /* IO Debugging (for Collada, ...)*/
+	G_DEBUG_DEPSGRAPH_PROFILE = (1 << 14),  /* depsgraph evaluation timing */
 };
 
 #define G_DEBUG_ALL  (G_DEBUG | G_DEBUG_FFMPEG | G_DEBUG_PYTHON | G_DEBUG_EVENTS | G_DEBUG_WM | G_DEBUG_JOBS | \
@@ -178,6 +179,8 @@ enum {
 /* On write, restore paths after editing them (G_FILE_RELATIVE_REMAP) */
 #define G_FILE_SAVE_COPY         (1 << 27)
 #define G_FILE_GLSL_NO_ENV_LIGHTING (1 << 28)
+/* Compress in independent blocks (multithreaded, not readable by older versions), used with G_FILE_COMPRESS */
+#define G_FILE_COMPRESS_BLOCKS   (1 << 29)
 
 #define G_FILE_FLAGS_RUNTIME (G_FILE_NO_UI | G_FILE_RELATIVE_REMAP | G_FILE_MESH_COMPAT | G_FILE_SAVE_COPY)
 
@@ -293,6 +293,9 @@ typedef struct bNodeTreeType {
 	void (*local_sync)(struct bNodeTree *localtree, struct bNodeTree *ntree);
 	void (*local_merge)(struct bNodeTree *localtree, struct bNodeTree *ntree);
 
+	/* Default settings of a newly created tree, not called for trees read from files */
+	void (*init)(struct bNodeTree *ntree);
+
 	/* Tree update. Overrides nodetype->updatetreefunc! */
 	void (*update)(struct bNodeTree *ntree);
 	
@@ -48,6 +48,8 @@
 #include "BLI_string.h"
 #include "BLI_utildefines.h"
 
+#include "PIL_time.h"
+
 #include "IMB_imbuf.h"
 #include "IMB_moviecache.h"
 
@@ -191,12 +193,18 @@ void BKE_undo_write(bContext *C, const char *name)
 	}
 	else {
 		MemFile *prevfile = NULL;
+		const double time_start = PIL_check_seconds_timer();
 
 		if (curundo->prev) prevfile = &(curundo->prev->memfile);
 
 		memused = MEM_get_memory_in_use();
 		/* success = */ /* UNUSED */ BLO_write_file_mem(CTX_data_main(C), prevfile, &curundo->memfile, G.fileflags);
 		curundo->undosize = MEM_get_memory_in_use() - memused;
+
+		if (G.debug & G_DEBUG_WM) {
+			printf("%s: '%s' pushed in %.3f ms, %u kB of new data\n", __func__, name,
+			       (PIL_check_seconds_timer() - time_start) * 1000.0, curundo->memfile.size / 1024);
+		}
 	}
 
 	if (U.undomemory != 0) {
@@ -1727,6 +1727,17 @@ void DAG_relations_tag_update(Main *bmain)
 	}
 }
 
+void DAG_id_relations_tag_update(Main *bmain, ID *id)
+{
+	if (DEG_depsgraph_use_legacy()) {
+		DAG_relations_tag_update(bmain);
+	}
+	else {
+		/* New dependency graph. */
+		DEG_id_relations_tag_update(bmain, id);
+	}
+}
+
 /* rebuild dependency graph only for a given scene */
 void DAG_scene_relations_rebuild(Main *bmain, Scene *sce)
 {
@@ -2968,6 +2979,12 @@ void DAG_id_tag_update_ex(Main *bmain, ID *id, short flag)
 		printf("%s: id=%s flag=%d\n", __func__, id->name, flag);
 	}
 
+	/* data is about to change, memfile undo can't re-use what it wrote before */
+	id->tag &= ~LIB_TAG_UNDO_UNCHANGED;
+	if (GS(id->name) == ID_OB && ((Object *)id)->data) {
+		((ID *)((Object *)id)->data)->tag &= ~LIB_TAG_UNDO_UNCHANGED;
+	}
+
 	/* tag ID for update */
 	if (flag) {
 		if (flag & OB_RECALC_OB)
@@ -3622,6 +3639,11 @@ void DAG_relations_tag_update(Main *bmain)
 	DEG_relations_tag_update(bmain);
 }
 
+void DAG_id_relations_tag_update(Main *bmain, ID *id)
+{
+	DEG_id_relations_tag_update(bmain, id);
+}
+
 /* Rebuild dependency graph only for a given scene. */
 void DAG_scene_relations_rebuild(Main *bmain, Scene *scene)
 {
@@ -1208,6 +1208,9 @@ bNodeTree *ntreeAddTree(Main *bmain, const char *name, const char *idname)
 	BLI_strncpy(ntree->idname, idname, sizeof(ntree->idname));
 	ntree_set_typeinfo(ntree, ntreeTypeFind(idname));
 	
+	if (ntree->typeinfo->init)
+		ntree->typeinfo->init(ntree);
+	
 	return ntree;
 }
 
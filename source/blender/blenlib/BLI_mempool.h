@@ -41,8 +41,10 @@ extern "C"
 
 struct BLI_mempool;
 struct BLI_mempool_chunk;
+struct BLI_mempool_threadcache;
 
 typedef struct BLI_mempool BLI_mempool;
+typedef struct BLI_mempool_threadcache BLI_mempool_threadcache;
 
 BLI_mempool *BLI_mempool_create(unsigned int esize, unsigned int totelem,
                                 unsigned int pchunk, unsigned int flag) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
@@ -61,6 +63,13 @@ void      **BLI_mempool_as_tableN(BLI_mempool *pool, const char *allocstr) ATTR_
 void        BLI_mempool_as_array(BLI_mempool *pool, void *data) ATTR_NONNULL(1, 2);
 void       *BLI_mempool_as_arrayN(BLI_mempool *pool, const char *allocstr) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT ATTR_NONNULL(1, 2);
 
+/* thread-aware allocation, every thread uses its own cache */
+BLI_mempool_threadcache *BLI_mempool_threadcache_create(BLI_mempool *pool) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT ATTR_NONNULL(1);
+void        *BLI_mempool_threadcache_alloc(BLI_mempool_threadcache *cache) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT ATTR_NONNULL(1);
+void        *BLI_mempool_threadcache_calloc(BLI_mempool_threadcache *cache) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT ATTR_NONNULL(1);
+void         BLI_mempool_threadcache_free(BLI_mempool_threadcache *cache, void *addr) ATTR_NONNULL(1, 2);
+void         BLI_mempool_threadcache_destroy(BLI_mempool_threadcache *cache) ATTR_NONNULL(1);
+
 #ifndef NDEBUG
 void        BLI_mempool_set_memory_debug(void);
 #endif
@@ -71,6 +80,8 @@ typedef struct BLI_mempool_iter {
 	BLI_mempool *pool;
 	struct BLI_mempool_chunk *curchunk;
 	unsigned int curindex;
+
+	struct BLI_mempool_chunk **curchunk_threaded_shared;
 } BLI_mempool_iter;
 
 /* flag */
@@ -87,6 +98,9 @@ enum {
 void  BLI_mempool_iternew(BLI_mempool *pool, BLI_mempool_iter *iter) ATTR_NONNULL();
 void *BLI_mempool_iterstep(BLI_mempool_iter *iter) ATTR_WARN_UNUSED_RESULT ATTR_NONNULL();
 
+BLI_mempool_iter *BLI_mempool_iter_threadsafe_create(BLI_mempool *pool, const size_t num_iter) ATTR_WARN_UNUSED_RESULT ATTR_NONNULL();
+void              BLI_mempool_iter_threadsafe_free(BLI_mempool_iter *iter_arr) ATTR_NONNULL();
+
 #ifdef __cplusplus
 }
 #endif
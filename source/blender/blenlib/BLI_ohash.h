@@ -0,0 +1,108 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+#ifndef __BLI_OHASH_H__
+#define __BLI_OHASH_H__
+
+/** \file BLI_ohash.h
+ *  \ingroup bli
+ *
+ * Open-addressing (pointer -> pointer) hash table, drop-in alternative
+ * to #GHash for cases where lookup speed matters more than memory usage.
+ * Uses the same hash and compare callbacks as #GHash.
+ */
+
+#include "BLI_sys_types.h" /* for bool */
+#include "BLI_compiler_attrs.h"
+#include "BLI_ghash.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct OHash OHash;
+
+typedef struct OHashIterator {
+	OHash *oh;
+	unsigned int curr_slot;
+} OHashIterator;
+
+enum {
+	OHASH_FLAG_ALLOW_DUPES  = (1 << 0),  /* Only checked for in debug mode */
+	OHASH_FLAG_ALLOW_SHRINK = (1 << 1),  /* Allow to shrink storage on removal. */
+};
+
+OHash *BLI_ohash_new_ex(GHashHashFP hashfp, GHashCmpFP cmpfp, const char *info,
+                        const unsigned int nentries_reserve) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
+OHash *BLI_ohash_new(GHashHashFP hashfp, GHashCmpFP cmpfp, const char *info) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
+void   BLI_ohash_free(OHash *oh, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp);
+void   BLI_ohash_reserve(OHash *oh, const unsigned int nentries_reserve);
+void   BLI_ohash_insert(OHash *oh, void *key, void *val);
+bool   BLI_ohash_reinsert(OHash *oh, void *key, void *val, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp);
+void  *BLI_ohash_lookup(OHash *oh, const void *key) ATTR_WARN_UNUSED_RESULT;
+void  *BLI_ohash_lookup_default(OHash *oh, const void *key, void *val_default) ATTR_WARN_UNUSED_RESULT;
+void **BLI_ohash_lookup_p(OHash *oh, const void *key) ATTR_WARN_UNUSED_RESULT;
+bool   BLI_ohash_ensure_p(OHash *oh, void *key, void ***r_val) ATTR_WARN_UNUSED_RESULT;
+bool   BLI_ohash_remove(OHash *oh, const void *key, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp);
+void   BLI_ohash_clear(OHash *oh, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp);
+void   BLI_ohash_clear_ex(OHash *oh, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp,
+                          const unsigned int nentries_reserve);
+void  *BLI_ohash_popkey(OHash *oh, const void *key, GHashKeyFreeFP keyfreefp) ATTR_WARN_UNUSED_RESULT;
+bool   BLI_ohash_haskey(OHash *oh, const void *key) ATTR_WARN_UNUSED_RESULT;
+unsigned int BLI_ohash_size(OHash *oh) ATTR_WARN_UNUSED_RESULT;
+void   BLI_ohash_flag_set(OHash *oh, unsigned int flag);
+void   BLI_ohash_flag_clear(OHash *oh, unsigned int flag);
+
+/* *** */
+
+void   BLI_ohashIterator_init(OHashIterator *ohi, OHash *oh);
+void   BLI_ohashIterator_step(OHashIterator *ohi);
+void  *BLI_ohashIterator_getKey(OHashIterator *ohi) ATTR_WARN_UNUSED_RESULT;
+void  *BLI_ohashIterator_getValue(OHashIterator *ohi) ATTR_WARN_UNUSED_RESULT;
+void **BLI_ohashIterator_getValue_p(OHashIterator *ohi) ATTR_WARN_UNUSED_RESULT;
+bool   BLI_ohashIterator_done(OHashIterator *ohi) ATTR_WARN_UNUSED_RESULT;
+
+#define OHASH_ITER(oh_iter_, ohash_) \
+	for (BLI_ohashIterator_init(&oh_iter_, ohash_); \
+	     BLI_ohashIterator_done(&oh_iter_) == false; \
+	     BLI_ohashIterator_step(&oh_iter_))
+
+/** \name OHash Creation Wrappers
+ * \{ */
+
+OHash *BLI_ohash_ptr_new_ex(const char *info, const unsigned int nentries_reserve) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
+OHash *BLI_ohash_ptr_new(const char *info) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
+OHash *BLI_ohash_str_new_ex(const char *info, const unsigned int nentries_reserve) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
+OHash *BLI_ohash_str_new(const char *info) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
+OHash *BLI_ohash_int_new_ex(const char *info, const unsigned int nentries_reserve) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
+OHash *BLI_ohash_int_new(const char *info) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
+
+/** \} */
+
+#ifdef OHASH_INTERNAL_API
+/* Average number of probed groups per lookup of existing keys, and load factor. */
+double BLI_ohash_calc_quality_ex(OHash *oh, double *r_load, int *r_max_probe);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __BLI_OHASH_H__ */
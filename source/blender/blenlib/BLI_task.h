@@ -37,8 +37,9 @@ extern "C" {
 
 /* Task Scheduler
  * 
- * Central scheduler that holds running threads ready to execute tasks. A single
- * queue holds the task from all pools.
+ * Central scheduler that holds running threads ready to execute tasks. A global
+ * queue holds the tasks pushed from outside of the worker threads, tasks pushed
+ * from worker threads go to per-worker deques from which idle workers steal.
  *
  * Init/exit must be called before/after any task pools are created/freed, and
  * must be called from the main threads. All other scheduler and pool functions
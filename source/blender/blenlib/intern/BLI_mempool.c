@@ -36,12 +36,18 @@
  * - Freeing chunks.
  * - Iterating over allocated chunks
  *   (optionally when using the #BLI_MEMPOOL_ALLOW_ITER flag).
+ * - Allocating from multiple threads, each through its own
+ *   #BLI_mempool_threadcache.
+ * - Iterating from multiple threads.
  */
 
 #include <string.h>
 #include <stdlib.h>
 
+#include "atomic_ops.h"
+
 #include "BLI_utildefines.h"
+#include "BLI_threads.h"
 
 #include "BLI_mempool.h" /* own include */
 
@@ -135,10 +141,24 @@ struct BLI_mempool {
 
 	BLI_freenode *free;         /* free element list. Interleaved into chunk datas. */
 	uint maxchunks;     /* use to know how many chunks to keep for BLI_mempool_clear */
-	uint totused;       /* number of elements currently in use */
+	uint totused;       /* number of elements currently in use, includes the ones held by thread caches */
 #ifdef USE_TOTALLOC
 	uint totalloc;          /* number of elements allocated in total */
 #endif
+
+	/* protects chunks, free and totused while thread caches are used */
+	SpinLock lock;
+};
+
+/**
+ * Allocation state of a single thread, elements are moved between
+ * #BLI_mempool_threadcache.free and #BLI_mempool.free in batches
+ * so the pool lock is rarely taken.
+ */
+struct BLI_mempool_threadcache {
+	BLI_mempool *pool;
+	BLI_freenode *free;  /* free elements owned by this thread */
+	uint totfree;        /* number of elements in free */
 };
 
 #define MEMPOOL_ELEM_SIZE_MIN (sizeof(void *) * 2)
@@ -205,23 +225,8 @@ static BLI_mempool_chunk *mempool_chunk_alloc(BLI_mempool *pool)
 	return mpchunk;
 }
 
-/**
- * Initialize a chunk and add into \a pool->chunks
- *
- * \param pool  The pool to add the chunk into.
- * \param mpchunk  The new uninitialized chunk (can be malloc'd)
- * \param lasttail  The last element of the previous chunk
- * (used when building free chunks initially)
- * \return The last chunk,
- */
-static BLI_freenode *mempool_chunk_add(BLI_mempool *pool, BLI_mempool_chunk *mpchunk,
-                                       BLI_freenode *lasttail)
+static void mempool_chunk_append(BLI_mempool *pool, BLI_mempool_chunk *mpchunk)
 {
-	const uint esize = pool->esize;
-	BLI_freenode *curnode = CHUNK_DATA(mpchunk);
-	uint j;
-
-	/* append */
 	if (pool->chunk_tail) {
 		pool->chunk_tail->next = mpchunk;
 	}
@@ -233,9 +238,22 @@ static BLI_freenode *mempool_chunk_add(BLI_mempool *pool, BLI_mempool_chunk *mpc
 	mpchunk->next = NULL;
 	pool->chunk_tail = mpchunk;
 
-	if (UNLIKELY(pool->free == NULL)) {
-		pool->free = curnode;
-	}
+#ifdef USE_TOTALLOC
+	pool->totalloc += pool->pchunk;
+#endif
+}
+
+/**
+ * Link all elements of \a mpchunk into a free list,
+ * doesn't modify the pool so it's safe to call without holding the lock.
+ *
+ * \return The last element of the list.
+ */
+static BLI_freenode *mempool_chunk_init_free(const BLI_mempool *pool, BLI_mempool_chunk *mpchunk)
+{
+	const uint esize = pool->esize;
+	BLI_freenode *curnode = CHUNK_DATA(mpchunk);
+	uint j;
 
 	/* loop through the allocated data, building the pointer structures */
 	j = pool->pchunk;
@@ -258,9 +276,30 @@ static BLI_freenode *mempool_chunk_add(BLI_mempool *pool, BLI_mempool_chunk *mpc
 	curnode = NODE_STEP_PREV(curnode);
 	curnode->next = NULL;
 
-#ifdef USE_TOTALLOC
-	pool->totalloc += pool->pchunk;
-#endif
+	return curnode;
+}
+
+/**
+ * Initialize a chunk and add into \a pool->chunks
+ *
+ * \param pool  The pool to add the chunk into.
+ * \param mpchunk  The new uninitialized chunk (can be malloc'd)
+ * \param lasttail  The last element of the previous chunk
+ * (used when building free chunks initially)
+ * \return The last chunk,
+ */
+static BLI_freenode *mempool_chunk_add(BLI_mempool *pool, BLI_mempool_chunk *mpchunk,
+                                       BLI_freenode *lasttail)
+{
+	BLI_freenode *curnode;
+
+	mempool_chunk_append(pool, mpchunk);
+
+	if (UNLIKELY(pool->free == NULL)) {
+		pool->free = CHUNK_DATA(mpchunk);
+	}
+
+	curnode = mempool_chunk_init_free(pool, mpchunk);
 
 	/* final pointer in the previously allocated chunk is wrong */
 	if (lasttail) {
@@ -334,6 +373,7 @@ BLI_mempool *BLI_mempool_create(uint esize, uint totelem,
 	pool->totalloc = 0;
 #endif
 	pool->totused = 0;
+	BLI_spin_init(&pool->lock);
 
 	if (totelem) {
 		/* allocate the actual chunks */
@@ -472,6 +512,168 @@ void BLI_mempool_free(BLI_mempool *pool, void *addr)
 	}
 }
 
+/**
+ * Create a cache for allocating from \a pool in a thread.
+ *
+ * Any number of threads can use their own caches at the same time, while
+ * the pool itself must not be used directly until all the caches are
+ * destroyed.
+ */
+BLI_mempool_threadcache *BLI_mempool_threadcache_create(BLI_mempool *pool)
+{
+	BLI_mempool_threadcache *cache = MEM_mallocN(sizeof(*cache), __func__);
+	cache->pool = pool;
+	cache->free = NULL;
+	cache->totfree = 0;
+	return cache;
+}
+
+/**
+ * Take a batch of elements from the pool.
+ */
+static void mempool_threadcache_refill(BLI_mempool_threadcache *cache)
+{
+	BLI_mempool *pool = cache->pool;
+	BLI_freenode *head, *tail;
+	uint num;
+
+	BLI_assert(cache->free == NULL);
+
+	BLI_spin_lock(&pool->lock);
+	if (pool->free != NULL) {
+		head = tail = pool->free;
+		num = 1;
+		while (num < pool->pchunk && tail->next != NULL) {
+			tail = tail->next;
+			num++;
+		}
+		pool->free = tail->next;
+		tail->next = NULL;
+		pool->totused += num;
+		BLI_spin_unlock(&pool->lock);
+	}
+	else {
+		BLI_mempool_chunk *mpchunk;
+
+		/* only linking the new chunk into the pool needs the lock */
+		BLI_spin_unlock(&pool->lock);
+		mpchunk = mempool_chunk_alloc(pool);
+		mempool_chunk_init_free(pool, mpchunk);
+		head = CHUNK_DATA(mpchunk);
+		num = pool->pchunk;
+
+		BLI_spin_lock(&pool->lock);
+		mempool_chunk_append(pool, mpchunk);
+		pool->totused += num;
+		BLI_spin_unlock(&pool->lock);
+	}
+
+	cache->free = head;
+	cache->totfree = num;
+}
+
+/**
+ * Give the first \a num elements of the cache back to the pool.
+ */
+static void mempool_threadcache_drain(BLI_mempool_threadcache *cache, uint num)
+{
+	BLI_mempool *pool = cache->pool;
+	BLI_freenode *head = cache->free, *tail = head;
+	uint i;
+
+	BLI_assert(num != 0 && num <= cache->totfree);
+
+	for (i = 1; i < num; i++) {
+		tail = tail->next;
+	}
+	cache->free = tail->next;
+	cache->totfree -= num;
+
+	BLI_spin_lock(&pool->lock);
+	tail->next = pool->free;
+	pool->free = head;
+	pool->totused -= num;
+	BLI_spin_unlock(&pool->lock);
+}
+
+void *BLI_mempool_threadcache_alloc(BLI_mempool_threadcache *cache)
+{
+	BLI_freenode *free_pop;
+
+	if (UNLIKELY(cache->free == NULL)) {
+		mempool_threadcache_refill(cache);
+	}
+
+	free_pop = cache->free;
+
+	if (cache->pool->flag & BLI_MEMPOOL_ALLOW_ITER) {
+		free_pop->freeword = USEDWORD;
+	}
+
+	cache->free = free_pop->next;
+	cache->totfree--;
+
+#ifdef WITH_MEM_VALGRIND
+	VALGRIND_MEMPOOL_ALLOC(cache->pool, free_pop, cache->pool->esize);
+#endif
+
+	return (void *)free_pop;
+}
+
+void *BLI_mempool_threadcache_calloc(BLI_mempool_threadcache *cache)
+{
+	void *retval = BLI_mempool_threadcache_alloc(cache);
+	memset(retval, 0, (size_t)cache->pool->esize);
+	return retval;
+}
+
+/**
+ * Free an element which was allocated from the same pool, by any thread.
+ */
+void BLI_mempool_threadcache_free(BLI_mempool_threadcache *cache, void *addr)
+{
+	BLI_mempool *pool = cache->pool;
+	BLI_freenode *newhead = addr;
+
+#ifndef NDEBUG
+	if (UNLIKELY(mempool_debug_memset)) {
+		memset(addr, 255, pool->esize);
+	}
+#endif
+
+	if (pool->flag & BLI_MEMPOOL_ALLOW_ITER) {
+#ifndef NDEBUG
+		/* this will detect double free's */
+		BLI_assert(newhead->freeword != FREEWORD);
+#endif
+		newhead->freeword = FREEWORD;
+	}
+
+	newhead->next = cache->free;
+	cache->free = newhead;
+	cache->totfree++;
+
+#ifdef WITH_MEM_VALGRIND
+	VALGRIND_MEMPOOL_FREE(pool, addr);
+#endif
+
+	/* keep one batch for the following allocations, give the rest back */
+	if (UNLIKELY(cache->totfree >= pool->pchunk * 2)) {
+		mempool_threadcache_drain(cache, pool->pchunk);
+	}
+}
+
+/**
+ * Give all cached elements back to the pool and free the cache.
+ */
+void BLI_mempool_threadcache_destroy(BLI_mempool_threadcache *cache)
+{
+	if (cache->totfree != 0) {
+		mempool_threadcache_drain(cache, cache->totfree);
+	}
+	MEM_freeN(cache);
+}
+
 int BLI_mempool_count(BLI_mempool *pool)
 {
 	return (int)pool->totused;
@@ -562,6 +764,73 @@ void BLI_mempool_iternew(BLI_mempool *pool, BLI_mempool_iter *iter)
 	iter->pool = pool;
 	iter->curchunk = pool->chunks;
 	iter->curindex = 0;
+
+	iter->curchunk_threaded_shared = NULL;
+}
+
+/**
+ * Initialize an array of mempool iterators, \a BLI_MEMPOOL_ALLOW_ITER flag must be set.
+ *
+ * This is used in threaded code, to generate as much iterators as needed (each task should have its own),
+ * such that each iterator goes over its own single chunk, and only getting the next chunk to iterate over has to be
+ * protected against concurrency (which can be done in a lockless way).
+ *
+ * The pool must not be modified until all the iterators are done
+ * (thread caches must be destroyed before creating the iterators).
+ *
+ * \note Each iterator starts at its own chunk, and the following chunks are
+ * taken by whichever iterator gets to them first.
+ */
+BLI_mempool_iter *BLI_mempool_iter_threadsafe_create(BLI_mempool *pool, const size_t num_iter)
+{
+	BLI_mempool_iter *iter_arr = MEM_mallocN(sizeof(*iter_arr) * num_iter, __func__);
+	BLI_mempool_chunk **curchunk_threaded_shared = MEM_mallocN(sizeof(void *), __func__);
+	size_t i;
+
+	BLI_mempool_iternew(pool, iter_arr);
+
+	*curchunk_threaded_shared = iter_arr->curchunk;
+	iter_arr->curchunk_threaded_shared = curchunk_threaded_shared;
+
+	for (i = 1; i < num_iter; i++) {
+		iter_arr[i] = iter_arr[0];
+		*curchunk_threaded_shared = iter_arr[i].curchunk = (
+		        (*curchunk_threaded_shared) ? (*curchunk_threaded_shared)->next : NULL);
+	}
+
+	/* point to the first chunk which isn't given to any iterator */
+	*curchunk_threaded_shared = (*curchunk_threaded_shared) ? (*curchunk_threaded_shared)->next : NULL;
+
+	return iter_arr;
+}
+
+void BLI_mempool_iter_threadsafe_free(BLI_mempool_iter *iter_arr)
+{
+	BLI_assert(iter_arr->curchunk_threaded_shared != NULL);
+
+	MEM_freeN(iter_arr->curchunk_threaded_shared);
+	MEM_freeN(iter_arr);
+}
+
+/**
+ * Advance \a iter to the next chunk.
+ */
+BLI_INLINE void mempool_iter_chunk_next(BLI_mempool_iter *iter)
+{
+	if (iter->curchunk_threaded_shared) {
+		/* claim the next chunk which isn't taken by any other iterator yet */
+		for (iter->curchunk = *iter->curchunk_threaded_shared;
+		     (iter->curchunk != NULL) &&
+		     (atomic_cas_ptr((void **)iter->curchunk_threaded_shared,
+		                     iter->curchunk, iter->curchunk->next) != iter->curchunk);
+		     iter->curchunk = *iter->curchunk_threaded_shared)
+		{
+			/* pass */
+		}
+	}
+	else {
+		iter->curchunk = iter->curchunk->next;
+	}
 }
 
 #if 0
@@ -578,7 +847,7 @@ static void *bli_mempool_iternext(BLI_mempool_iter *iter)
 	iter->curindex++;
 
 	if (iter->curindex == iter->pool->pchunk) {
-		iter->curchunk = iter->curchunk->next;
+		mempool_iter_chunk_next(iter);
 		iter->curindex = 0;
 	}
 
@@ -620,7 +889,7 @@ void *BLI_mempool_iterstep(BLI_mempool_iter *iter)
 		}
 		else {
 			iter->curindex = 0;
-			iter->curchunk = iter->curchunk->next;
+			mempool_iter_chunk_next(iter);
 			if (iter->curchunk == NULL) {
 				return (ret->freeword == FREEWORD) ? NULL : ret;
 			}
@@ -706,6 +975,8 @@ void BLI_mempool_destroy(BLI_mempool *pool)
 {
 	mempool_chunk_free_all(pool->chunks);
 
+	BLI_spin_end(&pool->lock);
+
 #ifdef WITH_MEM_VALGRIND
 	VALGRIND_DESTROY_MEMPOOL(pool);
 #endif
@@ -0,0 +1,788 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/blenlib/intern/BLI_ohash.c
+ *  \ingroup bli
+ *
+ * An open-addressing (pointer -> pointer) hash table.
+ *
+ * Keys and values are stored inline in a flat slots array, so there are no
+ * per-entry allocations and no pointer chasing on lookup. Every slot has an
+ * additional control byte, which is either a marker of an empty or deleted
+ * slot, or 7 bits of the key hash for used slots. Control bytes are grouped
+ * by 16, and the whole group is matched against the hash at once (using SSE2
+ * when available), so the key comparison callback is only called for slots
+ * which are very likely to contain the key.
+ *
+ * Groups are probed using triangular numbers, which visits all the groups
+ * since their number is always a power of two.
+ *
+ * \note Removal leaves a 'deleted' marker in the slot unless its group still
+ * has some empty slots (in which case no probe sequence ever went through this
+ * group), markers are dropped when the table is resized.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#  include <intrin.h>
+#endif
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_sys_types.h"  /* for intptr_t support */
+#include "BLI_utildefines.h"
+
+#define OHASH_INTERNAL_API
+#include "BLI_ohash.h"
+#include "BLI_strict_flags.h"
+
+/* Number of control bytes matched at once. */
+#define OHASH_GROUP_SIZE 16
+
+#define OHASH_SLOTS_MIN OHASH_GROUP_SIZE
+#define OHASH_SLOTS_BIT_MAX 28  /* About 268M of slots... */
+
+/* Control bytes values, used slots store 7 bits of the hash (always positive). */
+#define OHASH_CTRL_EMPTY   ((signed char)-128)
+#define OHASH_CTRL_DELETED ((signed char)-2)
+
+/**
+ * Open-addressing with group matching behaves well up to very high load,
+ * deleted slots are counted as used ones here.
+ * Min load #OHASH_LIMIT_SHRINK is a quarter of max load, to avoid resizing to quickly.
+ */
+#define OHASH_LIMIT_GROW(_nslots)   (((_nslots) * 7) /  8)
+#define OHASH_LIMIT_SHRINK(_nslots) (((_nslots) * 7) / 32)
+
+typedef struct OHashSlot {
+	void *key;
+	void *val;
+} OHashSlot;
+
+struct OHash {
+	GHashHashFP hashfp;
+	GHashCmpFP cmpfp;
+
+	/* Aligned to the group size, one byte per slot. */
+	signed char *ctrl;
+	OHashSlot *slots;
+	unsigned int nslots;
+	unsigned int group_mask;
+	unsigned int limit_grow, limit_shrink;
+
+	unsigned int nentries;
+	unsigned int ndeleted;
+	unsigned int flag;
+};
+
+
+/* -------------------------------------------------------------------- */
+/* OHash API */
+
+/** \name Internal Utility API
+ * \{ */
+
+/**
+ * Hash functions used with GHash are often weak (pointer hash only rotates
+ * bits e.g.), we need all bits to be good since they are split between group
+ * index and control byte, so mix them (MurmurHash3 finalizer).
+ */
+BLI_INLINE unsigned int ohash_keyhash(OHash *oh, const void *key)
+{
+	unsigned int hash = oh->hashfp(key);
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6bu;
+	hash ^= hash >> 13;
+	hash *= 0xc2b2ae35u;
+	hash ^= hash >> 16;
+	return hash;
+}
+
+BLI_INLINE signed char ohash_hash_ctrl(const unsigned int hash)
+{
+	return (signed char)(hash & 0x7f);
+}
+
+BLI_INLINE unsigned int ohash_hash_group(OHash *oh, const unsigned int hash)
+{
+	return (hash >> 7) & oh->group_mask;
+}
+
+BLI_INLINE unsigned int ohash_bitscan_forward(const unsigned int mask)
+{
+	BLI_assert(mask != 0);
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return (unsigned int)index;
+#else
+	return (unsigned int)__builtin_ctz(mask);
+#endif
+}
+
+/* Bitmask of slots in the group which control byte is equal to \a ctrl_value. */
+BLI_INLINE unsigned int ohash_group_match(const signed char *ctrl, const signed char ctrl_value)
+{
+#ifdef __SSE2__
+	const __m128i group = _mm_load_si128((const __m128i *)ctrl);
+	return (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)ctrl_value)));
+#else
+	unsigned int mask = 0, i;
+	for (i = 0; i < OHASH_GROUP_SIZE; i++) {
+		if (ctrl[i] == ctrl_value) {
+			mask |= (1u << i);
+		}
+	}
+	return mask;
+#endif
+}
+
+/* Bitmask of empty or deleted slots in the group. */
+BLI_INLINE unsigned int ohash_group_match_free(const signed char *ctrl)
+{
+#ifdef __SSE2__
+	/* Both empty and deleted markers are the only negative values. */
+	return (unsigned int)_mm_movemask_epi8(_mm_load_si128((const __m128i *)ctrl));
+#else
+	unsigned int mask = 0, i;
+	for (i = 0; i < OHASH_GROUP_SIZE; i++) {
+		if (ctrl[i] < 0) {
+			mask |= (1u << i);
+		}
+	}
+	return mask;
+#endif
+}
+
+BLI_INLINE unsigned int ohash_group_match_empty(const signed char *ctrl)
+{
+	return ohash_group_match(ctrl, OHASH_CTRL_EMPTY);
+}
+
+BLI_INLINE bool ohash_slot_is_used(OHash *oh, const unsigned int slot)
+{
+	return oh->ctrl[slot] >= 0;
+}
+
+/**
+ * Number of slots to use for the given number of entries.
+ */
+static unsigned int ohash_nslots_for_entries(const unsigned int nentries)
+{
+	unsigned int nslots = OHASH_SLOTS_MIN;
+	while ((nslots < (1u << OHASH_SLOTS_BIT_MAX)) && (OHASH_LIMIT_GROW(nslots) <= nentries)) {
+		nslots <<= 1;
+	}
+	return nslots;
+}
+
+static void ohash_storage_alloc(OHash *oh, const unsigned int nslots)
+{
+	BLI_assert(nslots >= OHASH_SLOTS_MIN && (nslots & (nslots - 1)) == 0);
+
+	oh->nslots = nslots;
+	oh->group_mask = (nslots / OHASH_GROUP_SIZE) - 1;
+	oh->limit_grow = OHASH_LIMIT_GROW(nslots);
+	oh->limit_shrink = (nslots > OHASH_SLOTS_MIN) ? OHASH_LIMIT_SHRINK(nslots) : 0;
+
+	oh->ctrl = MEM_mallocN_aligned(sizeof(*oh->ctrl) * nslots, OHASH_GROUP_SIZE, "OHash ctrl");
+	oh->slots = MEM_mallocN(sizeof(*oh->slots) * nslots, "OHash slots");
+	memset(oh->ctrl, OHASH_CTRL_EMPTY, sizeof(*oh->ctrl) * nslots);
+
+	oh->ndeleted = 0;
+}
+
+/**
+ * Find first free slot in the probe sequence of the given hash.
+ */
+BLI_INLINE unsigned int ohash_find_free_slot(OHash *oh, const unsigned int hash)
+{
+	unsigned int group = ohash_hash_group(oh, hash);
+	unsigned int probe;
+
+	for (probe = 1; ; probe++) {
+		const unsigned int mask = ohash_group_match_free(&oh->ctrl[group * OHASH_GROUP_SIZE]);
+		if (mask) {
+			return group * OHASH_GROUP_SIZE + ohash_bitscan_forward(mask);
+		}
+		group = (group + probe) & oh->group_mask;
+	}
+}
+
+BLI_INLINE void ohash_slot_set(
+        OHash *oh, const unsigned int slot, const unsigned int hash, void *key, void *val)
+{
+	oh->ctrl[slot] = ohash_hash_ctrl(hash);
+	oh->slots[slot].key = key;
+	oh->slots[slot].val = val;
+}
+
+/**
+ * Re-allocate the storage and re-insert all used slots, dropping deleted markers.
+ */
+static void ohash_resize(OHash *oh, const unsigned int nslots)
+{
+	signed char *ctrl_old = oh->ctrl;
+	OHashSlot *slots_old = oh->slots;
+	const unsigned int nslots_old = oh->nslots;
+	unsigned int i;
+
+	ohash_storage_alloc(oh, nslots);
+
+	for (i = 0; i < nslots_old; i++) {
+		if (ctrl_old[i] >= 0) {
+			const unsigned int hash = ohash_keyhash(oh, slots_old[i].key);
+			ohash_slot_set(oh, ohash_find_free_slot(oh, hash), hash, slots_old[i].key, slots_old[i].val);
+		}
+	}
+
+	MEM_freeN(ctrl_old);
+	MEM_freeN(slots_old);
+}
+
+/**
+ * Make room for one more entry, called when there is no empty slot to spare.
+ */
+static void ohash_expand(OHash *oh)
+{
+	unsigned int nslots = ohash_nslots_for_entries(oh->nentries + 1);
+	/* When there are few deleted slots only, re-hashing into the same size
+	 * would need to be done again soon. */
+	if (nslots <= oh->nslots && oh->nentries >= oh->limit_grow / 2) {
+		nslots = oh->nslots << 1;
+	}
+	/* Many deleted slots can make the computed size smaller. */
+	if (!(oh->flag & OHASH_FLAG_ALLOW_SHRINK)) {
+		nslots = MAX2(nslots, oh->nslots);
+	}
+	ohash_resize(oh, nslots);
+}
+
+static void ohash_shrink(OHash *oh)
+{
+	if ((oh->flag & OHASH_FLAG_ALLOW_SHRINK) && (oh->nentries < oh->limit_shrink)) {
+		ohash_resize(oh, ohash_nslots_for_entries(oh->nentries));
+	}
+}
+
+/**
+ * Internal lookup function, returns the slot index or -1 when key is not found.
+ */
+BLI_INLINE int ohash_lookup_slot(OHash *oh, const void *key, const unsigned int hash)
+{
+	const signed char ctrl_value = ohash_hash_ctrl(hash);
+	unsigned int group = ohash_hash_group(oh, hash);
+	unsigned int probe;
+
+	for (probe = 1; ; probe++) {
+		const signed char *ctrl = &oh->ctrl[group * OHASH_GROUP_SIZE];
+		unsigned int mask = ohash_group_match(ctrl, ctrl_value);
+		while (mask) {
+			const unsigned int slot = group * OHASH_GROUP_SIZE + ohash_bitscan_forward(mask);
+			if (UNLIKELY(oh->cmpfp(key, oh->slots[slot].key) == false)) {
+				return (int)slot;
+			}
+			mask &= mask - 1;
+		}
+		/* Probe sequence never continues past a group with empty slots. */
+		if (ohash_group_match_empty(ctrl)) {
+			return -1;
+		}
+		group = (group + probe) & oh->group_mask;
+	}
+}
+
+BLI_INLINE OHashSlot *ohash_lookup_entry(OHash *oh, const void *key)
+{
+	const int slot = ohash_lookup_slot(oh, key, ohash_keyhash(oh, key));
+	return (slot != -1) ? &oh->slots[slot] : NULL;
+}
+
+/**
+ * Insert the key which is known to not be in the hash yet.
+ */
+BLI_INLINE OHashSlot *ohash_insert_ex(OHash *oh, void *key, void *val, const unsigned int hash)
+{
+	unsigned int slot;
+
+	BLI_assert((oh->flag & OHASH_FLAG_ALLOW_DUPES) || (BLI_ohash_haskey(oh, key) == 0));
+
+	slot = ohash_find_free_slot(oh, hash);
+	if (oh->ctrl[slot] == OHASH_CTRL_DELETED) {
+		oh->ndeleted--;
+	}
+	else if (UNLIKELY(oh->nentries + oh->ndeleted >= oh->limit_grow)) {
+		ohash_expand(oh);
+		slot = ohash_find_free_slot(oh, hash);
+	}
+
+	ohash_slot_set(oh, slot, hash, key, val);
+	oh->nentries++;
+
+	return &oh->slots[slot];
+}
+
+static void ohash_remove_slot(OHash *oh, const unsigned int slot)
+{
+	const unsigned int group = slot / OHASH_GROUP_SIZE;
+	if (ohash_group_match_empty(&oh->ctrl[group * OHASH_GROUP_SIZE])) {
+		oh->ctrl[slot] = OHASH_CTRL_EMPTY;
+	}
+	else {
+		oh->ctrl[slot] = OHASH_CTRL_DELETED;
+		oh->ndeleted++;
+	}
+	oh->nentries--;
+}
+
+static void ohash_free_cb(OHash *oh, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp)
+{
+	unsigned int i;
+
+	BLI_assert(keyfreefp || valfreefp);
+
+	for (i = 0; i < oh->nslots; i++) {
+		if (ohash_slot_is_used(oh, i)) {
+			if (keyfreefp) keyfreefp(oh->slots[i].key);
+			if (valfreefp) valfreefp(oh->slots[i].val);
+		}
+	}
+}
+
+/** \} */
+
+
+/** \name Public API
+ * \{ */
+
+/**
+ * Creates a new, empty OHash.
+ *
+ * \param hashfp  Hash callback.
+ * \param cmpfp  Comparison callback.
+ * \param info  Identifier string for the OHash.
+ * \param nentries_reserve  Optionally reserve the number of members that the hash will hold.
+ * Use this to avoid resizing buckets if the size is known or can be closely approximated.
+ * \return  An empty OHash.
+ */
+OHash *BLI_ohash_new_ex(GHashHashFP hashfp, GHashCmpFP cmpfp, const char *info,
+                        const unsigned int nentries_reserve)
+{
+	OHash *oh = MEM_mallocN(sizeof(*oh), info);
+
+	oh->hashfp = hashfp;
+	oh->cmpfp = cmpfp;
+	oh->nentries = 0;
+	oh->flag = 0;
+
+	ohash_storage_alloc(oh, ohash_nslots_for_entries(nentries_reserve));
+
+	return oh;
+}
+
+/**
+ * Wraps #BLI_ohash_new_ex with zero entries reserved.
+ */
+OHash *BLI_ohash_new(GHashHashFP hashfp, GHashCmpFP cmpfp, const char *info)
+{
+	return BLI_ohash_new_ex(hashfp, cmpfp, info, 0);
+}
+
+/**
+ * Frees the OHash and its members.
+ *
+ * \param oh  The OHash to free.
+ * \param keyfreefp  Optional callback to free the key.
+ * \param valfreefp  Optional callback to free the value.
+ */
+void BLI_ohash_free(OHash *oh, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp)
+{
+	if (keyfreefp || valfreefp)
+		ohash_free_cb(oh, keyfreefp, valfreefp);
+
+	MEM_freeN(oh->ctrl);
+	MEM_freeN(oh->slots);
+	MEM_freeN(oh);
+}
+
+/**
+ * Reserve given amount of entries (resize \a oh accordingly if needed).
+ */
+void BLI_ohash_reserve(OHash *oh, const unsigned int nentries_reserve)
+{
+	const unsigned int nslots = ohash_nslots_for_entries(MAX2(nentries_reserve, oh->nentries));
+	if (nslots > oh->nslots) {
+		ohash_resize(oh, nslots);
+	}
+}
+
+/**
+ * Insert a key/value pair into the \a oh.
+ *
+ * \note Duplicates are not checked,
+ * the caller is expected to ensure elements are unique unless
+ * OHASH_FLAG_ALLOW_DUPES flag is set.
+ */
+void BLI_ohash_insert(OHash *oh, void *key, void *val)
+{
+	ohash_insert_ex(oh, key, val, ohash_keyhash(oh, key));
+}
+
+/**
+ * Inserts a new value to a key that may already be in ohash.
+ *
+ * Avoids #BLI_ohash_remove, #BLI_ohash_insert calls (double lookups)
+ *
+ * \returns true if a new key has been added.
+ */
+bool BLI_ohash_reinsert(OHash *oh, void *key, void *val, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp)
+{
+	const unsigned int hash = ohash_keyhash(oh, key);
+	const int slot = ohash_lookup_slot(oh, key, hash);
+
+	if (slot != -1) {
+		OHashSlot *e = &oh->slots[slot];
+		if (keyfreefp) keyfreefp(e->key);
+		if (valfreefp) valfreefp(e->val);
+		e->key = key;
+		e->val = val;
+		return false;
+	}
+	ohash_insert_ex(oh, key, val, hash);
+	return true;
+}
+
+/**
+ * Lookup the value of \a key in \a oh.
+ *
+ * \param key  The key to lookup.
+ * \returns the value for \a key or NULL.
+ *
+ * \note When NULL is a valid value, use #BLI_ohash_lookup_p to differentiate a missing key
+ * from a key with a NULL value. (Avoids calling #BLI_ohash_haskey before #BLI_ohash_lookup)
+ */
+void *BLI_ohash_lookup(OHash *oh, const void *key)
+{
+	OHashSlot *e = ohash_lookup_entry(oh, key);
+	return e ? e->val : NULL;
+}
+
+/**
+ * A version of #BLI_ohash_lookup which accepts a fallback argument.
+ */
+void *BLI_ohash_lookup_default(OHash *oh, const void *key, void *val_default)
+{
+	OHashSlot *e = ohash_lookup_entry(oh, key);
+	return e ? e->val : val_default;
+}
+
+/**
+ * Lookup a pointer to the value of \a key in \a oh.
+ *
+ * \param key  The key to lookup.
+ * \returns the pointer to value for \a key or NULL.
+ *
+ * \note This has 2 main benefits over #BLI_ohash_lookup.
+ * - A NULL return always means that \a key isn't in \a oh.
+ * - The value can be modified in-place without further function calls (faster).
+ */
+void **BLI_ohash_lookup_p(OHash *oh, const void *key)
+{
+	OHashSlot *e = ohash_lookup_entry(oh, key);
+	return e ? &e->val : NULL;
+}
+
+/**
+ * Ensure \a key is exists in \a oh.
+ *
+ * This handles the common situation where the caller needs ensure a key is added to \a oh,
+ * constructing a new value in the case the key isn't found.
+ * Otherwise use the existing value.
+ *
+ * \returns true when the value has already been initialized.
+ */
+bool BLI_ohash_ensure_p(OHash *oh, void *key, void ***r_val)
+{
+	const unsigned int hash = ohash_keyhash(oh, key);
+	const int slot = ohash_lookup_slot(oh, key, hash);
+
+	if (slot != -1) {
+		*r_val = &oh->slots[slot].val;
+		return true;
+	}
+	*r_val = &ohash_insert_ex(oh, key, NULL, hash)->val;
+	return false;
+}
+
+/**
+ * Remove \a key from \a oh, or return false if the key wasn't found.
+ *
+ * \param key  The key to remove.
+ * \param keyfreefp  Optional callback to free the key.
+ * \param valfreefp  Optional callback to free the value.
+ * \return true if \a key was removed from \a oh.
+ */
+bool BLI_ohash_remove(OHash *oh, const void *key, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp)
+{
+	const int slot = ohash_lookup_slot(oh, key, ohash_keyhash(oh, key));
+	if (slot != -1) {
+		OHashSlot *e = &oh->slots[slot];
+		if (keyfreefp) keyfreefp(e->key);
+		if (valfreefp) valfreefp(e->val);
+		ohash_remove_slot(oh, (unsigned int)slot);
+		ohash_shrink(oh);
+		return true;
+	}
+	return false;
+}
+
+/**
+ * Remove \a key from \a oh, returning the value or NULL if the key wasn't found.
+ *
+ * \param key  The key to remove.
+ * \param keyfreefp  Optional callback to free the key.
+ * \return the value of \a key int \a oh or NULL.
+ */
+void *BLI_ohash_popkey(OHash *oh, const void *key, GHashKeyFreeFP keyfreefp)
+{
+	const int slot = ohash_lookup_slot(oh, key, ohash_keyhash(oh, key));
+	if (slot != -1) {
+		void *val = oh->slots[slot].val;
+		if (keyfreefp) keyfreefp(oh->slots[slot].key);
+		ohash_remove_slot(oh, (unsigned int)slot);
+		ohash_shrink(oh);
+		return val;
+	}
+	return NULL;
+}
+
+/**
+ * \return true if the \a key is in \a oh.
+ */
+bool BLI_ohash_haskey(OHash *oh, const void *key)
+{
+	return (ohash_lookup_slot(oh, key, ohash_keyhash(oh, key)) != -1);
+}
+
+/**
+ * Reset \a oh clearing all entries.
+ *
+ * \param keyfreefp  Optional callback to free the key.
+ * \param valfreefp  Optional callback to free the value.
+ * \param nentries_reserve  Optionally reserve the number of members that the hash will hold.
+ */
+void BLI_ohash_clear_ex(OHash *oh, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp,
+                        const unsigned int nentries_reserve)
+{
+	const unsigned int nslots = ohash_nslots_for_entries(nentries_reserve);
+
+	if (keyfreefp || valfreefp)
+		ohash_free_cb(oh, keyfreefp, valfreefp);
+
+	if (nslots != oh->nslots) {
+		MEM_freeN(oh->ctrl);
+		MEM_freeN(oh->slots);
+		ohash_storage_alloc(oh, nslots);
+	}
+	else {
+		memset(oh->ctrl, OHASH_CTRL_EMPTY, sizeof(*oh->ctrl) * oh->nslots);
+		oh->ndeleted = 0;
+	}
+	oh->nentries = 0;
+}
+
+/**
+ * Wraps #BLI_ohash_clear_ex with zero entries reserved.
+ */
+void BLI_ohash_clear(OHash *oh, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp)
+{
+	BLI_ohash_clear_ex(oh, keyfreefp, valfreefp, 0);
+}
+
+/**
+ * \return size of the OHash.
+ */
+unsigned int BLI_ohash_size(OHash *oh)
+{
+	return oh->nentries;
+}
+
+/**
+ * Sets a OHash flag.
+ */
+void BLI_ohash_flag_set(OHash *oh, unsigned int flag)
+{
+	oh->flag |= flag;
+}
+
+/**
+ * Clear a OHash flag.
+ */
+void BLI_ohash_flag_clear(OHash *oh, unsigned int flag)
+{
+	oh->flag &= ~flag;
+}
+
+/** \} */
+
+
+/* -------------------------------------------------------------------- */
+/* OHash Iterator API */
+
+/** \name Iterator API
+ * \{ */
+
+/**
+ * Init an already allocated OHashIterator. The hash table must not
+ * be mutated while the iterator is in use, and the iterator will
+ * step exactly BLI_ohash_size(oh) times before becoming done.
+ *
+ * \param ohi The OHashIterator to initialize.
+ * \param oh The OHash to iterate over.
+ */
+void BLI_ohashIterator_init(OHashIterator *ohi, OHash *oh)
+{
+	ohi->oh = oh;
+	ohi->curr_slot = 0;
+	while (ohi->curr_slot < oh->nslots && !ohash_slot_is_used(oh, ohi->curr_slot)) {
+		ohi->curr_slot++;
+	}
+}
+
+/**
+ * Steps the iterator to the next index.
+ *
+ * \param ohi The iterator.
+ */
+void BLI_ohashIterator_step(OHashIterator *ohi)
+{
+	OHash *oh = ohi->oh;
+	if (ohi->curr_slot < oh->nslots) {
+		ohi->curr_slot++;
+		while (ohi->curr_slot < oh->nslots && !ohash_slot_is_used(oh, ohi->curr_slot)) {
+			ohi->curr_slot++;
+		}
+	}
+}
+
+void *BLI_ohashIterator_getKey(OHashIterator *ohi)
+{
+	return ohi->oh->slots[ohi->curr_slot].key;
+}
+
+void *BLI_ohashIterator_getValue(OHashIterator *ohi)
+{
+	return ohi->oh->slots[ohi->curr_slot].val;
+}
+
+void **BLI_ohashIterator_getValue_p(OHashIterator *ohi)
+{
+	return &ohi->oh->slots[ohi->curr_slot].val;
+}
+
+bool BLI_ohashIterator_done(OHashIterator *ohi)
+{
+	return ohi->curr_slot >= ohi->oh->nslots;
+}
+
+/** \} */
+
+
+/** \name Convenience OHash Creation Functions
+ * \{ */
+
+OHash *BLI_ohash_ptr_new_ex(const char *info, const unsigned int nentries_reserve)
+{
+	return BLI_ohash_new_ex(BLI_ghashutil_ptrhash, BLI_ghashutil_ptrcmp, info, nentries_reserve);
+}
+OHash *BLI_ohash_ptr_new(const char *info)
+{
+	return BLI_ohash_ptr_new_ex(info, 0);
+}
+
+OHash *BLI_ohash_str_new_ex(const char *info, const unsigned int nentries_reserve)
+{
+	return BLI_ohash_new_ex(BLI_ghashutil_strhash_p, BLI_ghashutil_strcmp, info, nentries_reserve);
+}
+OHash *BLI_ohash_str_new(const char *info)
+{
+	return BLI_ohash_str_new_ex(info, 0);
+}
+
+OHash *BLI_ohash_int_new_ex(const char *info, const unsigned int nentries_reserve)
+{
+	return BLI_ohash_new_ex(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, info, nentries_reserve);
+}
+OHash *BLI_ohash_int_new(const char *info)
+{
+	return BLI_ohash_int_new_ex(info, 0);
+}
+
+/** \} */
+
+
+/** \name Debugging & Introspection
+ * \{ */
+
+/**
+ * Measure how well the hash function performs
+ * (1.0 is perfect - every key is found in the first probed group).
+ *
+ * \return the average number of probed groups needed to find an existing key.
+ */
+double BLI_ohash_calc_quality_ex(OHash *oh, double *r_load, int *r_max_probe)
+{
+	unsigned int i;
+	double sum = 0.0;
+	int max_probe = 0;
+
+	if (r_load) {
+		*r_load = (double)oh->nentries / (double)oh->nslots;
+	}
+
+	for (i = 0; i < oh->nslots; i++) {
+		if (ohash_slot_is_used(oh, i)) {
+			const unsigned int hash = ohash_keyhash(oh, oh->slots[i].key);
+			const unsigned int group_dst = i / OHASH_GROUP_SIZE;
+			unsigned int group = ohash_hash_group(oh, hash);
+			int probe = 1;
+			while (group != group_dst) {
+				group = (group + (unsigned int)probe) & oh->group_mask;
+				probe++;
+			}
+			sum += (double)probe;
+			max_probe = MAX2(max_probe, probe);
+		}
+	}
+
+	if (r_max_probe) {
+		*r_max_probe = max_probe;
+	}
+
+	return oh->nentries ? sum / (double)oh->nentries : 1.0;
+}
+
+/** \} */
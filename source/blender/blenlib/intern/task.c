@@ -54,6 +54,13 @@
  */
 #define LOCAL_QUEUE_SIZE 1
 
+/* Initial number of slots in per-worker work-stealing deque.
+ *
+ * Deque grows on demand, this is only to avoid re-allocations for the most
+ * common cases of relatively small task graphs.
+ */
+#define DEQUE_INITIAL_SIZE 256
+
 /* Number of tasks which are allowed to be scheduled in a delayed manner.
  *
  * This allows to use less locks per graph node children schedule. More details
@@ -160,6 +167,38 @@ typedef struct TaskThreadLocalStorage {
 	Task *delayed_queue[DELAYED_QUEUE_SIZE];
 } TaskThreadLocalStorage;
 
+/* Storage of tasks for work-stealing deque.
+ *
+ * Arrays are never freed while deque is in use: when deque grows old array is
+ * put to a retired list, so thieves which are still reading from it don't
+ * access freed memory. All retired arrays are freed together with scheduler.
+ */
+typedef struct TaskDequeArray {
+	struct TaskDequeArray *next_retired;
+	int64_t size;
+	Task *tasks[];
+} TaskDequeArray;
+
+/* Per-worker lock-free work-stealing deque (Chase-Lev).
+ *
+ * Owner thread pushes and pops tasks from the bottom of the deque without any
+ * locks, other threads are stealing tasks from the top of the deque using a
+ * single CAS operation.
+ *
+ * NOTE: top and bottom are only increasing indices, they are stored as unsigned
+ * integers to be usable with atomic primitives, but are to be compared as a
+ * signed values since bottom might become smaller than top for a short period
+ * of time in pop().
+ */
+typedef struct TaskDeque {
+	volatile uint64_t top;
+	/* Make sure thieves and owner are not fighting for the same cache line. */
+	char pad[64 - sizeof(uint64_t)];
+	volatile uint64_t bottom;
+	TaskDequeArray *volatile array;
+	TaskDequeArray *retired;
+} TaskDeque;
+
 struct TaskPool {
 	TaskScheduler *scheduler;
 
@@ -213,6 +252,20 @@ struct TaskScheduler {
 	ThreadMutex queue_mutex;
 	ThreadCondition queue_cond;
 
+	/* Number of tasks in the global queue, allows to skip locking the queue
+	 * when it's known to be empty.
+	 */
+	size_t num_queued;
+	/* Number of worker threads which are about to sleep or are sleeping on the
+	 * queue condition. Used to wake them up when tasks are pushed to a deque.
+	 */
+	size_t num_waiting;
+	/* Work-stealing deques are used for tasks pushed from worker threads.
+	 * Disabled for single background thread case, so tasks from regular pools
+	 * are never executed by that thread.
+	 */
+	bool use_deques;
+
 	volatile bool do_exit;
 
 	/* NOTE: In pthread's TLS we store the whole TaskThread structure. */
@@ -223,6 +276,9 @@ typedef struct TaskThread {
 	TaskScheduler *scheduler;
 	int id;
 	TaskThreadLocalStorage tls;
+	TaskDeque deque;
+	/* State of random generator used to pick victim to steal from. */
+	uint32_t steal_seed;
 } TaskThread;
 
 /* Helper */
@@ -325,6 +381,114 @@ static void task_free(TaskPool *pool, Task *task, const int thread_id)
 	}
 }
 
+/* Work-stealing deque */
+
+static TaskDequeArray *task_deque_array_alloc(int64_t size)
+{
+	TaskDequeArray *array = MEM_mallocN(sizeof(TaskDequeArray) + sizeof(Task *) * size,
+	                                    "TaskDequeArray");
+	array->next_retired = NULL;
+	array->size = size;
+	return array;
+}
+
+static void task_deque_init(TaskDeque *deque)
+{
+	deque->top = 0;
+	deque->bottom = 0;
+	deque->array = task_deque_array_alloc(DEQUE_INITIAL_SIZE);
+	deque->retired = NULL;
+}
+
+static void task_deque_free(TaskDeque *deque)
+{
+	TaskDequeArray *array, *array_next;
+	for (array = deque->retired; array != NULL; array = array_next) {
+		array_next = array->next_retired;
+		MEM_freeN(array);
+	}
+	MEM_freeN(deque->array);
+}
+
+BLI_INLINE int64_t task_deque_size(const TaskDeque *deque)
+{
+	const int64_t size = (int64_t)deque->bottom - (int64_t)deque->top;
+	return (size > 0) ? size : 0;
+}
+
+/* Double the deque storage, only called by the owner. */
+static TaskDequeArray *task_deque_grow(TaskDeque *deque, int64_t top, int64_t bottom)
+{
+	TaskDequeArray *old_array = deque->array;
+	TaskDequeArray *new_array = task_deque_array_alloc(old_array->size * 2);
+	for (int64_t i = top; i < bottom; i++) {
+		new_array->tasks[i & (new_array->size - 1)] = old_array->tasks[i & (old_array->size - 1)];
+	}
+	old_array->next_retired = deque->retired;
+	deque->retired = old_array;
+	/* CAS is used here as a full memory barrier, so thieves never see new
+	 * array before it's filled in.
+	 */
+	atomic_cas_ptr((void **)&deque->array, old_array, new_array);
+	return new_array;
+}
+
+/* Push task to the bottom of the deque, only called by the owner. */
+static void task_deque_push(TaskDeque *deque, Task *task)
+{
+	const int64_t bottom = (int64_t)deque->bottom;
+	const int64_t top = (int64_t)deque->top;
+	TaskDequeArray *array = deque->array;
+	if (bottom - top >= array->size - 1) {
+		array = task_deque_grow(deque, top, bottom);
+	}
+	array->tasks[bottom & (array->size - 1)] = task;
+	/* Publish the task, acts as a full memory barrier. */
+	atomic_add_and_fetch_uint64((uint64_t *)&deque->bottom, 1);
+}
+
+/* Pop task from the bottom of the deque, only called by the owner. */
+static Task *task_deque_pop(TaskDeque *deque)
+{
+	const int64_t bottom = (int64_t)atomic_sub_and_fetch_uint64((uint64_t *)&deque->bottom, 1);
+	TaskDequeArray *array = deque->array;
+	const int64_t top = (int64_t)deque->top;
+	if (bottom < top) {
+		/* Deque was empty, restore its canonical state. */
+		atomic_add_and_fetch_uint64((uint64_t *)&deque->bottom, 1);
+		return NULL;
+	}
+	Task *task = array->tasks[bottom & (array->size - 1)];
+	if (bottom > top) {
+		/* There are more tasks left in the deque, no race with thieves. */
+		return task;
+	}
+	/* Last task in the deque, compete with thieves for it. */
+	if (atomic_cas_uint64((uint64_t *)&deque->top, (uint64_t)top, (uint64_t)(top + 1)) != (uint64_t)top) {
+		task = NULL;
+	}
+	atomic_add_and_fetch_uint64((uint64_t *)&deque->bottom, 1);
+	return task;
+}
+
+/* Steal task from the top of the deque, can be called from any thread. */
+static Task *task_deque_steal(TaskDeque *deque)
+{
+	/* Atomic read of top, makes sure bottom is read after it. */
+	const int64_t top = (int64_t)atomic_fetch_and_add_uint64((uint64_t *)&deque->top, 0);
+	const int64_t bottom = (int64_t)deque->bottom;
+	if (top >= bottom) {
+		return NULL;
+	}
+	TaskDequeArray *array = deque->array;
+	Task *task = array->tasks[top & (array->size - 1)];
+	if (atomic_cas_uint64((uint64_t *)&deque->top, (uint64_t)top, (uint64_t)(top + 1)) != (uint64_t)top) {
+		/* Lost the race with owner or another thief. */
+		return NULL;
+	}
+	return task;
+}
+
 /* Task Scheduler */
 
 static void task_pool_num_decrease(TaskPool *pool, size_t done)
@@ -351,54 +515,188 @@ static void task_pool_num_increase(TaskPool *pool, size_t new)
 	BLI_mutex_unlock(&pool->num_mutex);
 }
 
-static bool task_scheduler_thread_wait_pop(TaskScheduler *scheduler, Task **task)
+/* Find task in the global queue which can be executed by worker threads.
+ * Must be called with queue mutex locked.
+ */
+static Task *task_scheduler_queue_pop(TaskScheduler *scheduler)
 {
-	bool found_task = false;
-	BLI_mutex_lock(&scheduler->queue_mutex);
+	Task *task;
+	for (task = scheduler->queue.first; task != NULL; task = task->next) {
+		TaskPool *pool = task->pool;
+		if (scheduler->background_thread_only && !pool->run_in_background) {
+			continue;
+		}
+		BLI_remlink(&scheduler->queue, task);
+		atomic_sub_and_fetch_z(&scheduler->num_queued, 1);
+		return task;
+	}
+	return NULL;
+}
 
-	while (!scheduler->queue.first && !scheduler->do_exit)
-		BLI_condition_wait(&scheduler->queue_cond, &scheduler->queue_mutex);
+/* Steal a task from a deque of another worker thread.
+ *
+ * Victims are visited starting from a random one, so thieves are not fighting
+ * over the same deque.
+ */
+static Task *task_scheduler_steal(TaskScheduler *scheduler, TaskThread *thread)
+{
+	const int num_threads = scheduler->num_threads;
+	uint32_t seed = thread->steal_seed;
+	int i;
+	if (num_threads < 2) {
+		return NULL;
+	}
+	/* Xorshift, good enough for picking a victim. */
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	thread->steal_seed = seed;
+	for (i = 0; i < num_threads; i++) {
+		TaskThread *victim = &scheduler->task_threads[1 + (seed + i) % num_threads];
+		Task *task;
+		if (victim == thread) {
+			continue;
+		}
+		task = task_deque_steal(&victim->deque);
+		if (task != NULL) {
+			return task;
+		}
+	}
+	return NULL;
+}
 
-	do {
-		Task *current_task;
+/* Steal a task of the given pool, used by the thread which is waiting for the
+ * pool to finish.
+ *
+ * Thieves can only take the top task of a deque, tasks of other pools taken
+ * this way are given to the worker threads via the global queue.
+ */
+static Task *task_scheduler_steal_for_pool(TaskScheduler *scheduler,
+                                           TaskPool *pool,
+                                           TaskThread *thread)
+{
+	int i;
+	for (i = 1; i <= scheduler->num_threads; i++) {
+		TaskThread *victim = &scheduler->task_threads[i];
+		Task *task;
+		if (victim == thread) {
+			continue;
+		}
+		task = task_deque_steal(&victim->deque);
+		if (task == NULL) {
+			continue;
+		}
+		if (task->pool == pool) {
+			return task;
+		}
+		BLI_mutex_lock(&scheduler->queue_mutex);
+		BLI_addhead(&scheduler->queue, task);
+		atomic_add_and_fetch_z(&scheduler->num_queued, 1);
+		BLI_condition_notify_one(&scheduler->queue_cond);
+		BLI_mutex_unlock(&scheduler->queue_mutex);
+	}
+	return NULL;
+}
 
-		/* Assuming we can only have a void queue in 'exit' case here seems logical (we should only be here after
-		 * our worker thread has been woken up from a condition_wait(), which only happens after a new task was
-		 * added to the queue), but it is wrong.
-		 * Waiting on condition may wake up the thread even if condition is not signaled (spurious wake-ups), and some
-		 * race condition may also empty the queue **after** condition has been signaled, but **before** awoken thread
-		 * reaches this point...
-		 * See http://stackoverflow.com/questions/8594591
-		 *
-		 * So we only abort here if do_exit is set.
-		 */
-		if (scheduler->do_exit) {
-			BLI_mutex_unlock(&scheduler->queue_mutex);
-			return false;
+static bool task_scheduler_has_stealable_tasks(TaskScheduler *scheduler)
+{
+	int i;
+	for (i = 1; i <= scheduler->num_threads; i++) {
+		if (task_deque_size(&scheduler->task_threads[i].deque) != 0) {
+			return true;
 		}
+	}
+	return false;
+}
+
+/* Wake up a sleeping worker after a task was pushed to a deque. */
+static void task_scheduler_notify_waiting(TaskScheduler *scheduler)
+{
+	/* NOTE: Waiting thread announces itself before doing final check for
+	 * stealable tasks, and the push is a full memory barrier, so either the
+	 * waiting thread sees the new task or we see the waiting thread here.
+	 */
+	if (atomic_add_and_fetch_z(&scheduler->num_waiting, 0) != 0) {
+		BLI_mutex_lock(&scheduler->queue_mutex);
+		BLI_condition_notify_one(&scheduler->queue_cond);
+		BLI_mutex_unlock(&scheduler->queue_mutex);
+	}
+}
+
+/* Move all tasks from the deque of current thread to the global queue.
+ *
+ * Used when the owner thread is waiting for a specific pool and can not run
+ * tasks of other pools, so those are given away to the other threads.
+ */
+static void task_scheduler_spill_deque(TaskScheduler *scheduler, TaskThread *thread)
+{
+	Task *task;
+	BLI_mutex_lock(&scheduler->queue_mutex);
+	while ((task = task_deque_pop(&thread->deque)) != NULL) {
+		BLI_addhead(&scheduler->queue, task);
+		atomic_add_and_fetch_z(&scheduler->num_queued, 1);
+	}
+	BLI_condition_notify_all(&scheduler->queue_cond);
+	BLI_mutex_unlock(&scheduler->queue_mutex);
+}
 
-		for (current_task = scheduler->queue.first;
-		     current_task != NULL;
-		     current_task = current_task->next)
-		{
-			TaskPool *pool = current_task->pool;
+static bool task_scheduler_thread_wait_pop(TaskScheduler *scheduler,
+                                           TaskThread *thread,
+                                           Task **task)
+{
+	while (!scheduler->do_exit) {
+		/* Own deque is the cheapest source of tasks, and likely has data which
+		 * is hot in the cache.
+		 */
+		if (scheduler->use_deques) {
+			*task = task_deque_pop(&thread->deque);
+			if (*task != NULL) {
+				return true;
+			}
+		}
 
-			if (scheduler->background_thread_only && !pool->run_in_background) {
-				continue;
+		if (atomic_add_and_fetch_z(&scheduler->num_queued, 0) != 0) {
+			BLI_mutex_lock(&scheduler->queue_mutex);
+			*task = task_scheduler_queue_pop(scheduler);
+			BLI_mutex_unlock(&scheduler->queue_mutex);
+			if (*task != NULL) {
+				return true;
 			}
+		}
 
-			*task = current_task;
-			found_task = true;
-			BLI_remlink(&scheduler->queue, *task);
-			break;
+		if (scheduler->use_deques) {
+			*task = task_scheduler_steal(scheduler, thread);
+			if (*task != NULL) {
+				return true;
+			}
 		}
-		if (!found_task)
-			BLI_condition_wait(&scheduler->queue_cond, &scheduler->queue_mutex);
-	} while (!found_task);
 
-	BLI_mutex_unlock(&scheduler->queue_mutex);
+		/* Nothing to do, prepare to sleep.
+		 *
+		 * Waiting on condition may wake up the thread even if condition is not
+		 * signaled (spurious wake-ups), so we simply go over all the sources of
+		 * tasks again after waking up.
+		 * See http://stackoverflow.com/questions/8594591
+		 */
+		BLI_mutex_lock(&scheduler->queue_mutex);
+		atomic_add_and_fetch_z(&scheduler->num_waiting, 1);
+		*task = NULL;
+		if (!scheduler->do_exit) {
+			*task = task_scheduler_queue_pop(scheduler);
+			if (*task == NULL &&
+			    !(scheduler->use_deques && task_scheduler_has_stealable_tasks(scheduler)))
+			{
+				BLI_condition_wait(&scheduler->queue_cond, &scheduler->queue_mutex);
+			}
+		}
+		atomic_sub_and_fetch_z(&scheduler->num_waiting, 1);
+		BLI_mutex_unlock(&scheduler->queue_mutex);
 
-	return true;
+		if (*task != NULL) {
+			return true;
+		}
+	}
+	return false;
 }
 
 BLI_INLINE void handle_local_queue(TaskThreadLocalStorage *tls,
@@ -432,13 +730,18 @@ static void *task_scheduler_thread_run(void *thread_p)
 	pthread_setspecific(scheduler->tls_id_key, thread);
 
 	/* keep popping off tasks */
-	while (task_scheduler_thread_wait_pop(scheduler, &task)) {
+	while (task_scheduler_thread_wait_pop(scheduler, thread, &task)) {
 		TaskPool *pool = task->pool;
 
-		/* run task */
-		BLI_assert(!tls->do_delayed_push);
-		task->run(pool, task->taskdata, thread_id);
-		BLI_assert(!tls->do_delayed_push);
+		/* Tasks of canceled pools which are in deques are not removed by
+		 * task_scheduler_clear(), skip them here.
+		 */
+		if (!pool->do_cancel) {
+			/* run task */
+			BLI_assert(!tls->do_delayed_push);
+			task->run(pool, task->taskdata, thread_id);
+			BLI_assert(!tls->do_delayed_push);
+		}
 
 		/* delete task */
 		task_free(pool, task, thread_id);
@@ -464,6 +767,8 @@ TaskScheduler *BLI_task_scheduler_create(int num_threads)
 	BLI_listbase_clear(&scheduler->queue);
 	BLI_mutex_init(&scheduler->queue_mutex);
 	BLI_condition_init(&scheduler->queue_cond);
+	scheduler->num_queued = 0;
+	scheduler->num_waiting = 0;
 
 	if (num_threads == 0) {
 		/* automatic number of threads will be main thread + num cores */
@@ -482,8 +787,17 @@ TaskScheduler *BLI_task_scheduler_create(int num_threads)
 	scheduler->task_threads = MEM_mallocN(sizeof(TaskThread) * (num_threads + 1),
 	                                      "TaskScheduler task threads");
 
+	/* With a single background thread regular pools must only be handled
+	 * from work_and_wait(), so keep all tasks in the global queue.
+	 */
+	scheduler->use_deques = !scheduler->background_thread_only;
+
 	/* Initialize TLS for main thread. */
+	scheduler->task_threads[0].scheduler = scheduler;
+	scheduler->task_threads[0].id = 0;
+	scheduler->task_threads[0].steal_seed = 1;
 	initialize_task_tls(&scheduler->task_threads[0].tls);
+	task_deque_init(&scheduler->task_threads[0].deque);
 
 	pthread_key_create(&scheduler->tls_id_key, NULL);
 
@@ -494,12 +808,20 @@ TaskScheduler *BLI_task_scheduler_create(int num_threads)
 		scheduler->num_threads = num_threads;
 		scheduler->threads = MEM_callocN(sizeof(pthread_t) * num_threads, "TaskScheduler threads");
 
+		/* All deques are to be initialized before any thread is launched,
+		 * since workers are stealing from each other.
+		 */
 		for (i = 0; i < num_threads; i++) {
 			TaskThread *thread = &scheduler->task_threads[i + 1];
 			thread->scheduler = scheduler;
 			thread->id = i + 1;
+			thread->steal_seed = (uint32_t)(i + 1) * 2654435761u;
 			initialize_task_tls(&thread->tls);
+			task_deque_init(&thread->deque);
+		}
 
+		for (i = 0; i < num_threads; i++) {
+			TaskThread *thread = &scheduler->task_threads[i + 1];
 			if (pthread_create(&scheduler->threads[i], NULL, task_scheduler_thread_run, thread) != 0) {
 				fprintf(stderr, "TaskScheduler failed to launch thread %d/%d\n", i, num_threads);
 			}
@@ -537,6 +859,13 @@ void BLI_task_scheduler_free(TaskScheduler *scheduler)
 	if (scheduler->task_threads) {
 		for (int i = 0; i < scheduler->num_threads + 1; ++i) {
 			TaskThreadLocalStorage *tls = &scheduler->task_threads[i].tls;
+			TaskDeque *deque = &scheduler->task_threads[i].deque;
+			/* Delete leftover tasks from the deque. */
+			while ((task = task_deque_pop(deque)) != NULL) {
+				task_data_free(task, 0);
+				MEM_freeN(task);
+			}
+			task_deque_free(deque);
 			free_task_tls(tls);
 		}
 
@@ -572,6 +901,7 @@ static void task_scheduler_push(TaskScheduler *scheduler, Task *task, TaskPriori
 		BLI_addhead(&scheduler->queue, task);
 	else
 		BLI_addtail(&scheduler->queue, task);
+	atomic_add_and_fetch_z(&scheduler->num_queued, 1);
 
 	BLI_condition_notify_one(&scheduler->queue_cond);
 	BLI_mutex_unlock(&scheduler->queue_mutex);
@@ -593,6 +923,7 @@ static void task_scheduler_push_all(TaskScheduler *scheduler,
 	for (int i = 0; i < num_tasks; i++) {
 		BLI_addhead(&scheduler->queue, tasks[i]);
 	}
+	atomic_add_and_fetch_z(&scheduler->num_queued, (size_t)num_tasks);
 
 	BLI_condition_notify_all(&scheduler->queue_cond);
 	BLI_mutex_unlock(&scheduler->queue_mutex);
@@ -617,6 +948,7 @@ static void task_scheduler_clear(TaskScheduler *scheduler, TaskPool *pool)
 		}
 	}
 
+	atomic_sub_and_fetch_z(&scheduler->num_queued, done);
 	BLI_mutex_unlock(&scheduler->queue_mutex);
 
 	/* notify done */
@@ -770,6 +1102,23 @@ BLI_INLINE bool task_can_use_local_queues(TaskPool *pool, int thread_id)
 	return (thread_id != -1 && (thread_id != pool->thread_id || pool->do_work));
 }
 
+/* Get worker thread which owns the pool, but only if it is the current thread,
+ * so its deque can be accessed from the owner side.
+ */
+static TaskThread *task_pool_deque_owner(TaskPool *pool)
+{
+	TaskScheduler *scheduler = pool->scheduler;
+	TaskThread *thread;
+	if (!scheduler->use_deques || pool->thread_id == 0) {
+		return NULL;
+	}
+	thread = &scheduler->task_threads[pool->thread_id];
+	if (pthread_getspecific(scheduler->tls_id_key) != thread) {
+		return NULL;
+	}
+	return thread;
+}
+
 static void task_pool_push(
         TaskPool *pool, TaskRunFunction run, void *taskdata,
         bool free_taskdata, TaskFreeFunction freedata, TaskPriority priority,
@@ -815,6 +1164,21 @@ static void task_pool_push(
 			return;
 		}
 	}
+	/* Tasks pushed from worker threads go to the worker's own deque, they are
+	 * picked up by this worker next or stolen by other idle workers, without
+	 * any global locks.
+	 *
+	 * NOTE: Deque is LIFO for the owner, so priority is ignored here.
+	 */
+	if (thread_id > 0 && pool->scheduler->use_deques) {
+		TaskScheduler *scheduler = pool->scheduler;
+		ASSERT_THREAD_ID(scheduler, thread_id);
+		/* Count the task before it becomes visible to thieves. */
+		task_pool_num_increase(pool, 1);
+		task_deque_push(&scheduler->task_threads[thread_id].deque, task);
+		task_scheduler_notify_waiting(scheduler);
+		return;
+	}
 	/* Do push to a global execution ppol, slowest possible method,
 	 * causes quite reasonable amount of threading overhead.
 	 */
@@ -851,12 +1215,15 @@ void BLI_task_pool_work_and_wait(TaskPool *pool)
 			BLI_mutex_lock(&scheduler->queue_mutex);
 
 			BLI_movelisttolist(&scheduler->queue, &pool->suspended_queue);
+			atomic_add_and_fetch_z(&scheduler->num_queued, pool->num_suspended);
 
 			BLI_condition_notify_all(&scheduler->queue_cond);
 			BLI_mutex_unlock(&scheduler->queue_mutex);
 		}
 	}
 
+	TaskThread *owner_thread = task_pool_deque_owner(pool);
+
 	pool->do_work = true;
 
 	ASSERT_THREAD_ID(pool->scheduler, pool->thread_id);
@@ -865,35 +1232,56 @@ void BLI_task_pool_work_and_wait(TaskPool *pool)
 
 	while (pool->num != 0) {
 		Task *task, *work_task = NULL;
-		bool found_task = false;
 
 		BLI_mutex_unlock(&pool->num_mutex);
 
-		BLI_mutex_lock(&scheduler->queue_mutex);
+		/* Tasks pushed from this thread are most likely in its own deque. */
+		if (owner_thread != NULL) {
+			work_task = task_deque_pop(&owner_thread->deque);
+			if (work_task != NULL && work_task->pool != pool) {
+				/* Running a task from another pool here can get us into a
+				 * deadlock, so give the whole deque away to other threads.
+				 */
+				task_deque_push(&owner_thread->deque, work_task);
+				task_scheduler_spill_deque(scheduler, owner_thread);
+				work_task = NULL;
+			}
+		}
+
+		if (work_task == NULL && atomic_add_and_fetch_z(&scheduler->num_queued, 0) != 0) {
+			BLI_mutex_lock(&scheduler->queue_mutex);
 
-		/* find task from this pool. if we get a task from another pool,
-		 * we can get into deadlock */
+			/* find task from this pool. if we get a task from another pool,
+			 * we can get into deadlock */
 
-		for (task = scheduler->queue.first; task; task = task->next) {
-			if (task->pool == pool) {
-				work_task = task;
-				found_task = true;
-				BLI_remlink(&scheduler->queue, task);
-				break;
+			for (task = scheduler->queue.first; task; task = task->next) {
+				if (task->pool == pool) {
+					work_task = task;
+					BLI_remlink(&scheduler->queue, task);
+					atomic_sub_and_fetch_z(&scheduler->num_queued, 1);
+					break;
+				}
 			}
+
+			BLI_mutex_unlock(&scheduler->queue_mutex);
 		}
 
-		BLI_mutex_unlock(&scheduler->queue_mutex);
+		/* Tasks of this pool might have been pushed by the workers to their
+		 * own deques, help them instead of waiting.
+		 */
+		if (work_task == NULL && scheduler->use_deques) {
+			work_task = task_scheduler_steal_for_pool(scheduler, pool, owner_thread);
+		}
 
 		/* if found task, do it, otherwise wait until other tasks are done */
-		if (found_task) {
+		if (work_task != NULL) {
 			/* run task */
 			BLI_assert(!tls->do_delayed_push);
 			work_task->run(pool, work_task->taskdata, pool->thread_id);
 			BLI_assert(!tls->do_delayed_push);
 
 			/* delete task */
-			task_free(pool, task, pool->thread_id);
+			task_free(pool, work_task, pool->thread_id);
 
 			/* Handle all tasks from local queue. */
 			handle_local_queue(tls, pool->thread_id);
@@ -906,7 +1294,7 @@ void BLI_task_pool_work_and_wait(TaskPool *pool)
 		if (pool->num == 0)
 			break;
 
-		if (!found_task)
+		if (work_task == NULL)
 			BLI_condition_wait(&pool->num_cond, &pool->num_mutex);
 	}
 
@@ -917,8 +1305,18 @@ void BLI_task_pool_work_and_wait(TaskPool *pool)
 
 void BLI_task_pool_cancel(TaskPool *pool)
 {
+	TaskThread *owner_thread = task_pool_deque_owner(pool);
+
 	pool->do_cancel = true;
 
+	/* Owner thread is not going to pick up tasks from its deque while waiting
+	 * here, move them to the global queue where they are cleared.
+	 * Tasks from deques of other threads are skipped when they are popped.
+	 */
+	if (owner_thread != NULL) {
+		task_scheduler_spill_deque(pool->scheduler, owner_thread);
+	}
+
 	task_scheduler_clear(pool->scheduler, pool);
 
 	/* wait until all entries are cleared */
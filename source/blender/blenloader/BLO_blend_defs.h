@@ -77,4 +77,11 @@ enum {
 
 #define BLEN_THUMB_MEMSIZE_FILE(_x, _y) (sizeof(int) * (size_t)(2 + (_x) * (_y)))
 
+/**
+ * Magic bytes at the start of block compressed files (see #G_FILE_COMPRESS_BLOCKS),
+ * regular files start with "BLENDER", gzip compressed files with the gzip magic.
+ */
+#define BLEN_ZBLOCK_MAGIC "BLENZBLK"
+#define BLEN_ZBLOCK_MAGIC_LEN 8
+
 #endif  /* __BLO_BLEND_DEFS_H__ */
@@ -41,13 +41,24 @@ typedef struct {
 	
 } MemFileChunk;
 
+/* Range of chunks holding a single datablock, so following undo pushes can re-use them. */
+typedef struct MemFileIDChunks {
+	MemFileChunk *first;
+	unsigned int num;
+	/* hash of the datablock struct at the time it was written */
+	unsigned int id_hash;
+} MemFileIDChunks;
+
 typedef struct MemFile {
 	ListBase chunks;
 	unsigned int size;
+	/* ID pointer -> MemFileIDChunks, may be NULL */
+	struct GHash *id_chunks;
 } MemFile;
 
 /* actually only used writefile.c */
 extern void memfile_chunk_add(MemFile *compare, MemFile *current, const char *buf, unsigned int size);
+extern void memfile_chunk_reuse(MemFile *current, const MemFileIDChunks *idc);
 
 /* exports */
 extern void BLO_memfile_free(MemFile *memfile);
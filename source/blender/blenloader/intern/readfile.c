@@ -45,6 +45,7 @@
 #include "BLI_utildefines.h"
 #ifndef WIN32
 #  include <unistd.h> // for read close
+#  include <sys/mman.h> // for mmap
 #else
 #  include <io.h> // for open close read
 #  include "winsock2.h"
@@ -109,6 +110,8 @@
 #include "BLI_math.h"
 #include "BLI_threads.h"
 #include "BLI_mempool.h"
+#include "BLI_task.h"
+#include "PIL_time.h"
 
 #include "BLT_translation.h"
 
@@ -159,6 +162,7 @@
 #include "RE_engine.h"
 
 #include "readfile.h"
+#include "zblock.h"
 
 
 #include <errno.h>
@@ -219,6 +223,15 @@
 /* Use GHash for restoring pointers by name */
 #define USE_GHASH_RESTORE_POINTER
 
+/* Memory-map uncompressed files, block data is read lazily from the mapping.
+ * Not on Windows, where the mmap emulation has no copy-on-write private mappings. */
+#ifndef WIN32
+#  define USE_MMAP_READ
+#endif
+
+/* Read and link direct data of independent ID types in parallel when loading files. */
+#define USE_PARALLEL_DIRECT_LINK
+
 /***/
 
 typedef struct OldNew {
@@ -228,10 +241,21 @@ typedef struct OldNew {
 } OldNew;
 
 typedef struct OldNewMap {
+	/* Entries in insertion order, allows fast iteration and 'lasthit' lookups. */
 	OldNew *entries;
 	int nentries, entriessize;
-	bool sorted;
 	int lasthit;
+
+	/* Open-addressing hash of old addresses, stores indices into the entries
+	 * (-1 for unused slots). Size is always twice the entries size, keeps the
+	 * load factor at most a half. */
+	int *map;
+	unsigned int map_mask;
+
+	/* Statistics, only gathered with G_DEBUG_IO. */
+	bool use_stats;
+	int stats_nlookups, stats_nmisses;
+	double stats_time;
 } OldNewMap;
 
 
@@ -274,31 +298,62 @@ static const char *library_parent_filepath(Library *lib)
 	return lib->parent ? lib->parent->filepath : "<direct>";
 }
 
-static OldNewMap *oldnewmap_new(void) 
+/* Initial number of entries, map is twice as big. */
+#define OLDNEWMAP_SIZE_DEFAULT 1024
+
+BLI_INLINE unsigned int oldnewmap_hash(const OldNewMap *onm, const void *addr)
 {
-	OldNewMap *onm= MEM_callocN(sizeof(*onm), "OldNewMap");
-	
-	onm->entriessize = 1024;
-	onm->entries = MEM_mallocN(sizeof(*onm->entries)*onm->entriessize, "OldNewMap.entries");
-	
-	return onm;
+	/* Addresses are aligned, and written in increasing order most of the time,
+	 * mix bits to avoid clustering (Fibonacci hashing). */
+	uint64_t hash = (uint64_t)(uintptr_t)addr;
+	hash = (hash >> 3) * 0x9E3779B97F4A7C15ull;
+	return (unsigned int)(hash >> 32) & onm->map_mask;
 }
 
-static int verg_oldnewmap(const void *v1, const void *v2)
+static void oldnewmap_map_alloc(OldNewMap *onm)
 {
-	const struct OldNew *x1=v1, *x2=v2;
-	
-	if (x1->old > x2->old) return 1;
-	else if (x1->old < x2->old) return -1;
-	return 0;
+	const unsigned int map_size = (unsigned int)onm->entriessize * 2;
+	onm->map = MEM_mallocN(sizeof(*onm->map) * map_size, "OldNewMap.map");
+	onm->map_mask = map_size - 1;
+	memset(onm->map, 0xff, sizeof(*onm->map) * map_size);
 }
 
+/* Add the entry's address to the map, when the same address was inserted before
+ * the first entry is kept, matching the behavior of a linear search. */
+static void oldnewmap_map_insert(OldNewMap *onm, const int index)
+{
+	const void *addr = onm->entries[index].old;
+	unsigned int slot = oldnewmap_hash(onm, addr);
+	while (onm->map[slot] != -1) {
+		if (onm->entries[onm->map[slot]].old == addr) {
+			return;
+		}
+		slot = (slot + 1) & onm->map_mask;
+	}
+	onm->map[slot] = index;
+}
 
-static void oldnewmap_sort(FileData *fd) 
+static void oldnewmap_map_rebuild(OldNewMap *onm)
 {
-	BLI_assert(fd->libmap->sorted == false);
-	qsort(fd->libmap->entries, fd->libmap->nentries, sizeof(OldNew), verg_oldnewmap);
-	fd->libmap->sorted = 1;
+	int i;
+	MEM_freeN(onm->map);
+	oldnewmap_map_alloc(onm);
+	for (i = 0; i < onm->nentries; i++) {
+		oldnewmap_map_insert(onm, i);
+	}
+}
+
+static OldNewMap *oldnewmap_new(void) 
+{
+	OldNewMap *onm= MEM_callocN(sizeof(*onm), "OldNewMap");
+	
+	onm->entriessize = OLDNEWMAP_SIZE_DEFAULT;
+	onm->entries = MEM_mallocN(sizeof(*onm->entries)*onm->entriessize, "OldNewMap.entries");
+	oldnewmap_map_alloc(onm);
+
+	onm->use_stats = (G.debug & G_DEBUG_IO) != 0;
+	
+	return onm;
 }
 
 /* nr is zero for data, and ID code for libdata */
@@ -311,12 +366,15 @@ static void oldnewmap_insert(OldNewMap *onm, const void *oldaddr, void *newaddr,
 	if (UNLIKELY(onm->nentries == onm->entriessize)) {
 		onm->entriessize *= 2;
 		onm->entries = MEM_reallocN(onm->entries, sizeof(*onm->entries) * onm->entriessize);
+		oldnewmap_map_rebuild(onm);
 	}
 
-	entry = &onm->entries[onm->nentries++];
+	entry = &onm->entries[onm->nentries];
 	entry->old = oldaddr;
 	entry->newp = newaddr;
 	entry->nr = nr;
+
+	oldnewmap_map_insert(onm, onm->nentries++);
 }
 
 void blo_do_versions_oldnewmap_insert(OldNewMap *onm, const void *oldaddr, void *newaddr, int nr)
@@ -327,51 +385,49 @@ void blo_do_versions_oldnewmap_insert(OldNewMap *onm, const void *oldaddr, void
 /**
  * Do a full search (no state).
  *
- * \param lasthit: Use as a reference position to avoid a full search
- * from either end of the array, giving more efficient lookups.
- *
- * \note This would seem an ideal case for hash or btree lookups.
- * However the data is written in-order, using the \a lasthit will normally avoid calling this function.
- * Creating a btree/hash structure adds overhead for the common-case to optimize the corner-case
- * (since most entries will never be retrieved).
- * So just keep full lookups as a fall-back.
+ * \note Data is written in-order, so the 'lasthit' check in the callers
+ * avoids this in the common case, this handles everything else with a hash lookup.
  */
-static int oldnewmap_lookup_entry_full(const OldNewMap *onm, const void *addr, int lasthit)
+static int oldnewmap_lookup_entry_full(const OldNewMap *onm, const void *addr)
 {
-	const int nentries = onm->nentries;
-	const OldNew *entries = onm->entries;
-	int i;
-
-	/* search relative to lasthit where possible */
-	if (lasthit >= 0 && lasthit < nentries) {
+	unsigned int slot = oldnewmap_hash(onm, addr);
+	int index;
 
-		/* search forwards */
-		i = lasthit;
-		while (++i != nentries) {
-			if (entries[i].old == addr) {
-				return i;
-			}
+	while ((index = onm->map[slot]) != -1) {
+		if (onm->entries[index].old == addr) {
+			return index;
 		}
+		slot = (slot + 1) & onm->map_mask;
+	}
 
-		/* search backwards */
-		i = lasthit + 1;
-		while (i--) {
-			if (entries[i].old == addr) {
-				return i;
-			}
-		}
+	return -1;
+}
+
+static int oldnewmap_lookup_entry(OldNewMap *onm, const void *addr)
+{
+	double time_start = 0.0;
+	int i;
+
+	if (UNLIKELY(onm->use_stats)) {
+		time_start = PIL_check_seconds_timer();
+	}
+
+	if (onm->lasthit < onm->nentries - 1 && onm->entries[onm->lasthit + 1].old == addr) {
+		i = onm->lasthit + 1;
 	}
 	else {
-		/* search backwards (full) */
-		i = nentries;
-		while (i--) {
-			if (entries[i].old == addr) {
-				return i;
-			}
+		i = oldnewmap_lookup_entry_full(onm, addr);
+	}
+
+	if (UNLIKELY(onm->use_stats)) {
+		onm->stats_time += PIL_check_seconds_timer() - time_start;
+		onm->stats_nlookups++;
+		if (i == -1) {
+			onm->stats_nmisses++;
 		}
 	}
 
-	return -1;
+	return i;
 }
 
 static void *oldnewmap_lookup_and_inc(OldNewMap *onm, const void *addr, bool increase_users)
@@ -380,17 +436,7 @@ static void *oldnewmap_lookup_and_inc(OldNewMap *onm, const void *addr, bool inc
 	
 	if (addr == NULL) return NULL;
 	
-	if (onm->lasthit < onm->nentries-1) {
-		OldNew *entry = &onm->entries[++onm->lasthit];
-		
-		if (entry->old == addr) {
-			if (increase_users)
-				entry->nr++;
-			return entry->newp;
-		}
-	}
-	
-	i = oldnewmap_lookup_entry_full(onm, addr, onm->lasthit);
+	i = oldnewmap_lookup_entry(onm, addr);
 	if (i != -1) {
 		OldNew *entry = &onm->entries[i];
 		BLI_assert(entry->old == addr);
@@ -406,32 +452,20 @@ static void *oldnewmap_lookup_and_inc(OldNewMap *onm, const void *addr, bool inc
 /* for libdata, nr has ID code, no increment */
 static void *oldnewmap_liblookup(OldNewMap *onm, const void *addr, const void *lib)
 {
+	int i;
+
 	if (addr == NULL) {
 		return NULL;
 	}
 
-	/* lasthit works fine for non-libdata, linking there is done in same sequence as writing */
-	if (onm->sorted) {
-		const OldNew entry_s = {.old = addr};
-		OldNew *entry = bsearch(&entry_s, onm->entries, onm->nentries, sizeof(OldNew), verg_oldnewmap);
-		if (entry) {
-			ID *id = entry->newp;
-
-			if (id && (!lib || id->lib)) {
-				return id;
-			}
-		}
-	}
-	else {
-		/* note, this can be a bottle neck when loading some files */
-		const int i = oldnewmap_lookup_entry_full(onm, addr, -1);
-		if (i != -1) {
-			OldNew *entry = &onm->entries[i];
-			ID *id = entry->newp;
-			BLI_assert(entry->old == addr);
-			if (id && (!lib || id->lib)) {
-				return id;
-			}
+	i = oldnewmap_lookup_entry(onm, addr);
+	if (i != -1) {
+		OldNew *entry = &onm->entries[i];
+		ID *id = entry->newp;
+		BLI_assert(entry->old == addr);
+		onm->lasthit = i;
+		if (id && (!lib || id->lib)) {
+			return id;
 		}
 	}
 
@@ -451,15 +485,52 @@ static void oldnewmap_free_unused(OldNewMap *onm)
 	}
 }
 
+/* Empty the slots used by the entries, without touching the rest of the map.
+ *
+ * Every used slot is in the run of used slots starting at the hash of its
+ * entry, walking each run up to its end clears it in any order of entries. */
+static void oldnewmap_map_clear_entries(OldNewMap *onm)
+{
+	int i;
+	for (i = 0; i < onm->nentries; i++) {
+		unsigned int slot = oldnewmap_hash(onm, onm->entries[i].old);
+		while (onm->map[slot] != -1) {
+			onm->map[slot] = -1;
+			slot = (slot + 1) & onm->map_mask;
+		}
+	}
+}
+
 static void oldnewmap_clear(OldNewMap *onm) 
 {
+	/* Map is cleared for every ID block, don't keep a huge map around
+	 * after a single big ID was read. */
+	if (onm->entriessize > OLDNEWMAP_SIZE_DEFAULT) {
+		onm->entriessize = OLDNEWMAP_SIZE_DEFAULT;
+		onm->entries = MEM_reallocN(onm->entries, sizeof(*onm->entries) * onm->entriessize);
+		MEM_freeN(onm->map);
+		oldnewmap_map_alloc(onm);
+	}
+	else {
+		oldnewmap_map_clear_entries(onm);
+	}
+
 	onm->nentries = 0;
 	onm->lasthit = 0;
 }
 
+static void oldnewmap_print_stats(const OldNewMap *onm, const char *name)
+{
+	if (onm->use_stats && onm->stats_nlookups) {
+		printf("Read blend: %s: %d lookups (%d missed) in %.6f sec\n",
+		       name, onm->stats_nlookups, onm->stats_nmisses, onm->stats_time);
+	}
+}
+
 static void oldnewmap_free(OldNewMap *onm) 
 {
 	MEM_freeN(onm->entries);
+	MEM_freeN(onm->map);
 	MEM_freeN(onm);
 }
 
@@ -787,13 +858,29 @@ static BHeadN *get_bhead(FileData *fd)
 			/* bhead now contains the (converted) bhead structure. Now read
 			 * the associated data and put everything in a BHeadN (creative naming !)
 			 */
-			if (!fd->eof) {
+			if (!fd->eof && fd->filebuf) {
+				/* Data stays in the file buffer, when memory-mapped
+				 * it's only paged in once read_struct() needs it. */
+				if ((size_t)bhead.len <= fd->filebuf_size - fd->filebuf_seek) {
+					new_bhead = MEM_mallocN(sizeof(BHeadN), "new_bhead");
+					new_bhead->next = new_bhead->prev = NULL;
+					new_bhead->data = fd->filebuf + fd->filebuf_seek;
+					new_bhead->bhead = bhead;
+
+					fd->filebuf_seek += (size_t)bhead.len;
+				}
+				else {
+					fd->eof = 1;
+				}
+			}
+			else if (!fd->eof) {
 				new_bhead = MEM_mallocN(sizeof(BHeadN) + bhead.len, "new_bhead");
 				if (new_bhead) {
 					new_bhead->next = new_bhead->prev = NULL;
+					new_bhead->data = new_bhead + 1;
 					new_bhead->bhead = bhead;
 					
-					readsize = fd->read(fd, new_bhead + 1, bhead.len);
+					readsize = fd->read(fd, new_bhead->data, bhead.len);
 					
 					if (readsize != bhead.len) {
 						fd->eof = 1;
@@ -872,10 +959,16 @@ BHead *blo_nextbhead(FileData *fd, BHead *thisblock)
 	return(bhead);
 }
 
+void *blo_bhead_data(BHead *bhead)
+{
+	BHeadN *bheadn = (BHeadN *)POINTER_OFFSET(bhead, -offsetof(BHeadN, bhead));
+	return bheadn->data;
+}
+
 /* Warning! Caller's responsability to ensure given bhead **is** and ID one! */
 const char *bhead_id_name(const FileData *fd, const BHead *bhead)
 {
-	return (const char *)POINTER_OFFSET(bhead, sizeof(*bhead) + fd->id_name_offs);
+	return (const char *)POINTER_OFFSET(blo_bhead_data((BHead *)bhead), fd->id_name_offs);
 }
 
 static void decode_blender_header(FileData *fd)
@@ -929,10 +1022,10 @@ static bool read_file_dna(FileData *fd, const char **r_error_message)
 		if (bhead->code == DNA1) {
 			const bool do_endian_swap = (fd->flags & FD_FLAGS_SWITCH_ENDIAN) != 0;
 			
-			fd->filesdna = DNA_sdna_from_data(&bhead[1], bhead->len, do_endian_swap, true, r_error_message);
+			fd->filesdna = DNA_sdna_from_data(blo_bhead_data(bhead), bhead->len, do_endian_swap, true, r_error_message);
 			if (fd->filesdna) {
 				fd->compflags = DNA_struct_get_compareflags(fd->filesdna, fd->memsdna);
-				/* used to retrieve ID names from (bhead+1) */
+				/* used to retrieve ID names from the bhead data */
 				fd->id_name_offs = DNA_elem_offset(fd->filesdna, "ID", "char", "name[]");
 
 				return true;
@@ -958,7 +1051,7 @@ static int *read_file_thumbnail(FileData *fd)
 	for (bhead = blo_firstbhead(fd); bhead; bhead = blo_nextbhead(fd, bhead)) {
 		if (bhead->code == TEST) {
 			const bool do_endian_swap = (fd->flags & FD_FLAGS_SWITCH_ENDIAN) != 0;
-			int *data = (int *)(bhead + 1);
+			int *data = blo_bhead_data(bhead);
 
 			if (bhead->len < (2 * sizeof(int))) {
 				break;
@@ -1024,6 +1117,26 @@ static int fd_read_from_memory(FileData *filedata, void *buffer, unsigned int si
 	return (readsize);
 }
 
+static int fd_read_from_filebuf(FileData *filedata, void *buffer, unsigned int size)
+{
+	/* don't read more bytes then there are available in the buffer */
+	size_t readsize = MIN2((size_t)size, filedata->filebuf_size - filedata->filebuf_seek);
+
+	memcpy(buffer, filedata->filebuf + filedata->filebuf_seek, readsize);
+	filedata->filebuf_seek += readsize;
+
+	return (int)readsize;
+}
+
+static int fd_read_from_zblock(FileData *filedata, void *buffer, unsigned int size)
+{
+	size_t readsize = blo_zblock_reader_read(filedata->zblock, buffer, filedata->zblock_seek, size);
+
+	filedata->zblock_seek += readsize;
+
+	return (int)readsize;
+}
+
 static int fd_read_from_memfile(FileData *filedata, void *buffer, unsigned int size)
 {
 	static unsigned int seek = (1<<30);	/* the current position */
@@ -1122,11 +1235,106 @@ static FileData *blo_decode_and_check(FileData *fd, ReportList *reports)
 	return fd;
 }
 
+#ifdef USE_MMAP_READ
+/**
+ * Map uncompressed files into memory, so block data is only paged in when it's actually read,
+ * instead of reading the whole file. Mostly useful when only linking a few data-blocks from big files.
+ *
+ * \return NULL for compressed files or when mapping fails, caller falls back to regular reading.
+ */
+static FileData *blo_openblenderfile_mmap(const char *filepath)
+{
+	FileData *fd = NULL;
+	const int file = BLI_open(filepath, O_BINARY | O_RDONLY, 0);
+	char magic[2];
+
+	if (file == -1) {
+		return NULL;
+	}
+
+	if (read(file, magic, sizeof(magic)) == sizeof(magic) && !(magic[0] == 0x1f && magic[1] == (char)0x8b)) {
+		const size_t size = BLI_file_descriptor_size(file);
+
+		if (size != (size_t)-1 && size > SIZEOFBLENDERHEADER) {
+			/* Private mapping, in-place endian switching of the data must never reach the file. */
+			void *buffer = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+
+			if (buffer != MAP_FAILED) {
+				fd = filedata_new();
+				fd->filebuf = buffer;
+				fd->filebuf_size = size;
+				fd->filebuf_is_mmap = true;
+				fd->read = fd_read_from_filebuf;
+			}
+		}
+	}
+
+	/* The mapping stays valid after closing the file. */
+	close(file);
+
+	return fd;
+}
+#endif
+
+/**
+ * Open block compressed files (see #G_FILE_COMPRESS_BLOCKS).
+ *
+ * \param decode_all: Decompress all blocks in parallel up-front,
+ * otherwise blocks are decompressed when reading reaches them.
+ * \return NULL for other files.
+ */
+static FileData *blo_openblenderfile_zblock(const char *filepath, const bool decode_all)
+{
+	ZBlockReader *zr = blo_zblock_reader_open(filepath);
+	FileData *fd;
+
+	if (zr == NULL) {
+		return NULL;
+	}
+
+	fd = filedata_new();
+
+	if (decode_all) {
+		/* Same as memory-mapped files from here, BHead data points into the buffer. */
+		fd->filebuf = blo_zblock_reader_read_all(zr);
+		fd->filebuf_size = blo_zblock_reader_size(zr);
+		fd->read = fd_read_from_filebuf;
+		blo_zblock_reader_close(zr);
+
+		if (fd->filebuf == NULL) {
+			blo_freefiledata(fd);
+			return NULL;
+		}
+	}
+	else {
+		fd->zblock = zr;
+		fd->read = fd_read_from_zblock;
+	}
+
+	return fd;
+}
+
 /* cannot be called with relative paths anymore! */
 /* on each new library added, it now checks for the current FileData and expands relativeness */
 FileData *blo_openblenderfile(const char *filepath, ReportList *reports)
 {
 	gzFile gzfile;
+
+	{
+		FileData *fd = blo_openblenderfile_zblock(filepath, true);
+#ifdef USE_MMAP_READ
+		if (fd == NULL) {
+			fd = blo_openblenderfile_mmap(filepath);
+		}
+#endif
+		if (fd) {
+			/* needed for library_append and read_libraries */
+			BLI_strncpy(fd->relabase, filepath, sizeof(fd->relabase));
+
+			return blo_decode_and_check(fd, reports);
+		}
+	}
+
 	errno = 0;
 	gzfile = BLI_gzopen(filepath, "rb");
 	
@@ -1154,11 +1362,26 @@ FileData *blo_openblenderfile(const char *filepath, ReportList *reports)
 static FileData *blo_openblenderfile_minimal(const char *filepath)
 {
 	gzFile gzfile;
+	FileData *fd;
+
+	/* Only decompress the blocks at the start of the file. */
+	fd = blo_openblenderfile_zblock(filepath, false);
+	if (fd) {
+		decode_blender_header(fd);
+
+		if (fd->flags & FD_FLAGS_FILE_OK) {
+			return fd;
+		}
+
+		blo_freefiledata(fd);
+		return NULL;
+	}
+
 	errno = 0;
 	gzfile = BLI_gzopen(filepath, "rb");
 
 	if (gzfile != (gzFile)Z_NULL) {
-		FileData *fd = filedata_new();
+		fd = filedata_new();
 		fd->gzfiledes = gzfile;
 		fd->read = fd_read_gzip_from_file;
 
@@ -1286,11 +1509,38 @@ void blo_freefiledata(FileData *fd)
 		// Free all BHeadN data blocks
 		BLI_freelistN(&fd->listbase);
 
+		/* Free after the BHeadN's, their data may point into the file buffer. */
+		if (fd->filebuf) {
+#ifdef USE_MMAP_READ
+			if (fd->filebuf_is_mmap) {
+				munmap(fd->filebuf, fd->filebuf_size);
+			}
+			else
+#endif
+			{
+				MEM_freeN(fd->filebuf);
+			}
+			fd->filebuf = NULL;
+		}
+
+		if (fd->zblock) {
+			blo_zblock_reader_close(fd->zblock);
+		}
+
 		if (fd->filesdna)
 			DNA_sdna_free(fd->filesdna);
 		if (fd->compflags)
 			MEM_freeN((void *)fd->compflags);
 		
+		if (G.debug & G_DEBUG_IO) {
+			if (fd->datamap)
+				oldnewmap_print_stats(fd->datamap, "datamap");
+			if (fd->globmap)
+				oldnewmap_print_stats(fd->globmap, "globmap");
+			if (fd->libmap && !(fd->flags & FD_FLAGS_NOT_MY_LIBMAP))
+				oldnewmap_print_stats(fd->libmap, "libmap");
+		}
+
 		if (fd->datamap)
 			oldnewmap_free(fd->datamap);
 		if (fd->globmap)
@@ -1541,9 +1791,6 @@ static void change_idid_adr_fd(FileData *fd, const void *old, void *new)
 {
 	int i;
 	
-	/* use a binary search if we have a sorted libmap, for now it's not needed. */
-	BLI_assert(fd->libmap->sorted == false);
-
 	for (i = 0; i < fd->libmap->nentries; i++) {
 		OldNew *entry = &fd->libmap->entries[i];
 		
@@ -1863,7 +2110,7 @@ static void switch_endian_structs(const struct SDNA *filesdna, BHead *bhead)
 	int blocksize, nblocks;
 	char *data;
 	
-	data = (char *)(bhead+1);
+	data = blo_bhead_data(bhead);
 	blocksize = filesdna->typelens[ filesdna->structs[bhead->SDNAnr][0] ];
 	
 	nblocks = bhead->nr;
@@ -1885,12 +2132,12 @@ static void *read_struct(FileData *fd, BHead *bh, const char *blockname)
 		
 		if (fd->compflags[bh->SDNAnr] != SDNA_CMP_REMOVED) {
 			if (fd->compflags[bh->SDNAnr] == SDNA_CMP_NOT_EQUAL) {
-				temp = DNA_struct_reconstruct(fd->memsdna, fd->filesdna, fd->compflags, bh->SDNAnr, bh->nr, (bh+1));
+				temp = DNA_struct_reconstruct(fd->memsdna, fd->filesdna, fd->compflags, bh->SDNAnr, bh->nr, blo_bhead_data(bh));
 			}
 			else {
 				/* SDNA_CMP_EQUAL */
 				temp = MEM_mallocN(bh->len, blockname);
-				memcpy(temp, (bh+1), bh->len);
+				memcpy(temp, blo_bhead_data(bh), bh->len);
 			}
 		}
 	}
@@ -8106,6 +8353,239 @@ static BHead *read_data_into_oldnewmap(FileData *fd, BHead *bhead, const char *a
 	return bhead;
 }
 
+/* Link the direct data of an ID, returns true when the ID is invalid and has to be freed. */
+static bool direct_link_libblock(FileData *fd, Main *main, ID *id)
+{
+	bool wrong_id = false;
+
+	direct_link_id(fd, id);
+	
+	switch (GS(id->name)) {
+		case ID_WM:
+			direct_link_windowmanager(fd, (wmWindowManager *)id);
+			break;
+		case ID_SCR:
+			wrong_id = direct_link_screen(fd, (bScreen *)id);
+			break;
+		case ID_SCE:
+			direct_link_scene(fd, (Scene *)id);
+			break;
+		case ID_OB:
+			direct_link_object(fd, (Object *)id);
+			break;
+		case ID_ME:
+			direct_link_mesh(fd, (Mesh *)id);
+			break;
+		case ID_CU:
+			direct_link_curve(fd, (Curve *)id);
+			break;
+		case ID_MB:
+			direct_link_mball(fd, (MetaBall *)id);
+			break;
+		case ID_MA:
+			direct_link_material(fd, (Material *)id);
+			break;
+		case ID_TE:
+			direct_link_texture(fd, (Tex *)id);
+			break;
+		case ID_IM:
+			direct_link_image(fd, (Image *)id);
+			break;
+		case ID_LA:
+			direct_link_lamp(fd, (Lamp *)id);
+			break;
+		case ID_VF:
+			direct_link_vfont(fd, (VFont *)id);
+			break;
+		case ID_TXT:
+			direct_link_text(fd, (Text *)id);
+			break;
+		case ID_IP:
+			direct_link_ipo(fd, (Ipo *)id);
+			break;
+		case ID_KE:
+			direct_link_key(fd, (Key *)id);
+			break;
+		case ID_LT:
+			direct_link_latt(fd, (Lattice *)id);
+			break;
+		case ID_WO:
+			direct_link_world(fd, (World *)id);
+			break;
+		case ID_LI:
+			direct_link_library(fd, (Library *)id, main);
+			break;
+		case ID_CA:
+			direct_link_camera(fd, (Camera *)id);
+			break;
+		case ID_SPK:
+			direct_link_speaker(fd, (Speaker *)id);
+			break;
+		case ID_SO:
+			direct_link_sound(fd, (bSound *)id);
+			break;
+		case ID_GR:
+			direct_link_group(fd, (Group *)id);
+			break;
+		case ID_AR:
+			direct_link_armature(fd, (bArmature*)id);
+			break;
+		case ID_AC:
+			direct_link_action(fd, (bAction*)id);
+			break;
+		case ID_NT:
+			direct_link_nodetree(fd, (bNodeTree*)id);
+			break;
+		case ID_BR:
+			direct_link_brush(fd, (Brush*)id);
+			break;
+		case ID_PA:
+			direct_link_particlesettings(fd, (ParticleSettings*)id);
+			break;
+		case ID_GD:
+			direct_link_gpencil(fd, (bGPdata *)id);
+			break;
+		case ID_MC:
+			direct_link_movieclip(fd, (MovieClip *)id);
+			break;
+		case ID_MSK:
+			direct_link_mask(fd, (Mask *)id);
+			break;
+		case ID_LS:
+			direct_link_linestyle(fd, (FreestyleLineStyle *)id);
+			break;
+		case ID_PAL:
+			direct_link_palette(fd, (Palette *)id);
+			break;
+		case ID_PC:
+			direct_link_paint_curve(fd, (PaintCurve *)id);
+			break;
+		case ID_CF:
+			direct_link_cachefile(fd, (CacheFile *)id);
+			break;
+	}
+
+	return wrong_id;
+}
+
+#ifdef USE_PARALLEL_DIRECT_LINK
+
+/* ID whose direct data is read and linked later from a task, see #direct_link_deferred_all. */
+typedef struct DeferredDirectLink {
+	struct DeferredDirectLink *next, *prev;
+	ID *id;
+	/* First DATA block of the ID and number of DATA blocks. */
+	BHead *bhead;
+	int bhead_num;
+
+	/* Statistics of the task's datamap, see G_DEBUG_IO. */
+	int stats_nlookups, stats_nmisses;
+	double stats_time;
+} DeferredDirectLink;
+
+/**
+ * IDs types whose direct linking only touches their own data (no global maps, main database
+ * or reports), so it can run in parallel with other IDs.
+ */
+static bool direct_link_is_threadsafe(const short idcode)
+{
+	return ELEM(idcode, ID_ME, ID_IM, ID_AC);
+}
+
+/* Only index the DATA blocks of the ID, they are read later by #direct_link_deferred_all. */
+static BHead *read_libblock_deferred(FileData *fd, BHead *bhead, ID *id)
+{
+	DeferredDirectLink *ddl = MEM_callocN(sizeof(*ddl), __func__);
+
+	ddl->id = id;
+
+	bhead = blo_nextbhead(fd, bhead);
+	ddl->bhead = bhead;
+	while (bhead && bhead->code == DATA) {
+		ddl->bhead_num++;
+		bhead = blo_nextbhead(fd, bhead);
+	}
+
+	BLI_addtail(&fd->deferred_direct_link, ddl);
+
+	return bhead;
+}
+
+static void direct_link_deferred_task(TaskPool *__restrict pool, void *taskdata, int UNUSED(threadid))
+{
+	FileData *fd = BLI_task_pool_userdata(pool);
+	DeferredDirectLink *ddl = taskdata;
+	const char *allocname = dataname(GS(ddl->id->name));
+	BHead *bhead = ddl->bhead;
+	int bhead_num = ddl->bhead_num;
+
+	/* Local copy of the file data, with its own datamap only containing this ID's data.
+	 * All DATA blocks were already loaded by the main thread, blo_nextbhead() only follows the list. */
+	FileData fd_local = *fd;
+	fd_local.datamap = oldnewmap_new();
+
+	while (bhead_num--) {
+		void *data = read_struct(&fd_local, bhead, allocname);
+		if (data) {
+			oldnewmap_insert(fd_local.datamap, bhead->old, data, 0);
+		}
+		bhead = blo_nextbhead(fd, bhead);
+	}
+
+	if (direct_link_libblock(&fd_local, NULL, ddl->id)) {
+		/* Only happens for screens, which are never deferred. */
+		BLI_assert(0);
+	}
+
+	oldnewmap_free_unused(fd_local.datamap);
+
+	ddl->stats_nlookups = fd_local.datamap->stats_nlookups;
+	ddl->stats_nmisses = fd_local.datamap->stats_nmisses;
+	ddl->stats_time = fd_local.datamap->stats_time;
+
+	oldnewmap_free(fd_local.datamap);
+}
+
+/* Read and link the direct data of all deferred IDs in parallel. */
+static void direct_link_deferred_all(FileData *fd)
+{
+	TaskScheduler *scheduler;
+	TaskPool *pool;
+	DeferredDirectLink *ddl;
+	const double time_start = PIL_check_seconds_timer();
+	int num_ids = 0;
+
+	if (BLI_listbase_is_empty(&fd->deferred_direct_link)) {
+		return;
+	}
+
+	scheduler = BLI_task_scheduler_get();
+	pool = BLI_task_pool_create(scheduler, fd);
+
+	for (ddl = fd->deferred_direct_link.first; ddl; ddl = ddl->next) {
+		BLI_task_pool_push(pool, direct_link_deferred_task, ddl, false, TASK_PRIORITY_LOW);
+	}
+
+	BLI_task_pool_work_and_wait(pool);
+	BLI_task_pool_free(pool);
+
+	for (ddl = fd->deferred_direct_link.first; ddl; ddl = ddl->next) {
+		fd->datamap->stats_nlookups += ddl->stats_nlookups;
+		fd->datamap->stats_nmisses += ddl->stats_nmisses;
+		fd->datamap->stats_time += ddl->stats_time;
+		num_ids++;
+	}
+
+	BLI_freelistN(&fd->deferred_direct_link);
+
+	if (G.debug & G_DEBUG_IO) {
+		printf("Read blend: direct linked %d data-blocks in parallel: %.6f sec\n",
+		       num_ids, PIL_check_seconds_timer() - time_start);
+	}
+}
+
+#endif  /* USE_PARALLEL_DIRECT_LINK */
+
 static BHead *read_libblock(FileData *fd, Main *main, BHead *bhead, const short tag, ID **r_id)
 {
 	/* this routine reads a libblock and its direct data. Use link functions to connect it all
@@ -8223,116 +8703,17 @@ static BHead *read_libblock(FileData *fd, Main *main, BHead *bhead, const short
 	/* need a name for the mallocN, just for debugging and sane prints on leaks */
 	allocname = dataname(GS(id->name));
 	
+#ifdef USE_PARALLEL_DIRECT_LINK
+	if ((fd->flags & FD_FLAGS_DEFER_DIRECT_LINK) && direct_link_is_threadsafe(GS(id->name))) {
+		return read_libblock_deferred(fd, bhead, id);
+	}
+#endif
+
 	/* read all data into fd->datamap */
 	bhead = read_data_into_oldnewmap(fd, bhead, allocname);
 	
 	/* init pointers direct data */
-	direct_link_id(fd, id);
-	
-	switch (GS(id->name)) {
-		case ID_WM:
-			direct_link_windowmanager(fd, (wmWindowManager *)id);
-			break;
-		case ID_SCR:
-			wrong_id = direct_link_screen(fd, (bScreen *)id);
-			break;
-		case ID_SCE:
-			direct_link_scene(fd, (Scene *)id);
-			break;
-		case ID_OB:
-			direct_link_object(fd, (Object *)id);
-			break;
-		case ID_ME:
-			direct_link_mesh(fd, (Mesh *)id);
-			break;
-		case ID_CU:
-			direct_link_curve(fd, (Curve *)id);
-			break;
-		case ID_MB:
-			direct_link_mball(fd, (MetaBall *)id);
-			break;
-		case ID_MA:
-			direct_link_material(fd, (Material *)id);
-			break;
-		case ID_TE:
-			direct_link_texture(fd, (Tex *)id);
-			break;
-		case ID_IM:
-			direct_link_image(fd, (Image *)id);
-			break;
-		case ID_LA:
-			direct_link_lamp(fd, (Lamp *)id);
-			break;
-		case ID_VF:
-			direct_link_vfont(fd, (VFont *)id);
-			break;
-		case ID_TXT:
-			direct_link_text(fd, (Text *)id);
-			break;
-		case ID_IP:
-			direct_link_ipo(fd, (Ipo *)id);
-			break;
-		case ID_KE:
-			direct_link_key(fd, (Key *)id);
-			break;
-		case ID_LT:
-			direct_link_latt(fd, (Lattice *)id);
-			break;
-		case ID_WO:
-			direct_link_world(fd, (World *)id);
-			break;
-		case ID_LI:
-			direct_link_library(fd, (Library *)id, main);
-			break;
-		case ID_CA:
-			direct_link_camera(fd, (Camera *)id);
-			break;
-		case ID_SPK:
-			direct_link_speaker(fd, (Speaker *)id);
-			break;
-		case ID_SO:
-			direct_link_sound(fd, (bSound *)id);
-			break;
-		case ID_GR:
-			direct_link_group(fd, (Group *)id);
-			break;
-		case ID_AR:
-			direct_link_armature(fd, (bArmature*)id);
-			break;
-		case ID_AC:
-			direct_link_action(fd, (bAction*)id);
-			break;
-		case ID_NT:
-			direct_link_nodetree(fd, (bNodeTree*)id);
-			break;
-		case ID_BR:
-			direct_link_brush(fd, (Brush*)id);
-			break;
-		case ID_PA:
-			direct_link_particlesettings(fd, (ParticleSettings*)id);
-			break;
-		case ID_GD:
-			direct_link_gpencil(fd, (bGPdata *)id);
-			break;
-		case ID_MC:
-			direct_link_movieclip(fd, (MovieClip *)id);
-			break;
-		case ID_MSK:
-			direct_link_mask(fd, (Mask *)id);
-			break;
-		case ID_LS:
-			direct_link_linestyle(fd, (FreestyleLineStyle *)id);
-			break;
-		case ID_PAL:
-			direct_link_palette(fd, (Palette *)id);
-			break;
-		case ID_PC:
-			direct_link_paint_curve(fd, (PaintCurve *)id);
-			break;
-		case ID_CF:
-			direct_link_cachefile(fd, (CacheFile *)id);
-			break;
-	}
+	wrong_id = direct_link_libblock(fd, main, id);
 	
 	oldnewmap_free_unused(fd->datamap);
 	oldnewmap_clear(fd->datamap);
@@ -8487,7 +8868,7 @@ static void do_versions_after_linking(Main *main)
 
 static void lib_link_all(FileData *fd, Main *main)
 {
-	oldnewmap_sort(fd);
+	const double time_start = (G.debug & G_DEBUG_IO) ? PIL_check_seconds_timer() : 0.0;
 	
 	/* No load UI for undo memfiles */
 	if (fd->memfile == NULL) {
@@ -8528,6 +8909,11 @@ static void lib_link_all(FileData *fd, Main *main)
 	lib_link_cachefiles(fd, main);
 
 	lib_link_library(fd, main);    /* only init users */
+
+	if (G.debug & G_DEBUG_IO) {
+		printf("Read blend: \"%s\" lib_link_all: %.6f sec\n",
+		       main->name, PIL_check_seconds_timer() - time_start);
+	}
 }
 
 static void direct_link_keymapitem(FileData *fd, wmKeyMapItem *kmi)
@@ -8639,6 +9025,13 @@ BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath)
 		}
 	}
 
+#ifdef USE_PARALLEL_DIRECT_LINK
+	/* Not for undo, which restores some data from the old main while reading. */
+	if (fd->memfile == NULL && BLI_system_thread_count() > 1) {
+		fd->flags |= FD_FLAGS_DEFER_DIRECT_LINK;
+	}
+#endif
+
 	while (bhead) {
 		switch (bhead->code) {
 		case DATA:
@@ -8687,6 +9080,11 @@ BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath)
 		}
 	}
 	
+#ifdef USE_PARALLEL_DIRECT_LINK
+	direct_link_deferred_all(fd);
+	fd->flags &= ~FD_FLAGS_DEFER_DIRECT_LINK;
+#endif
+
 	/* do before read_libraries, but skip undo case */
 	if (fd->memfile == NULL) {
 		do_versions(fd, NULL, bfd->main);
@@ -62,6 +62,16 @@ typedef struct FileData {
 	int filedes;
 	gzFile gzfiledes;
 
+	// variables needed for reading from a buffer holding the whole file,
+	// memory-mapped (see USE_MMAP_READ) or decompressed, BHead data points into it
+	char *filebuf;
+	size_t filebuf_size, filebuf_seek;
+	bool filebuf_is_mmap;
+
+	// variables needed for reading from block compressed file
+	struct ZBlockReader *zblock;
+	size_t zblock_seek;
+
 	// now only in use for library appending
 	char relabase[FILE_MAX];
 	
@@ -96,6 +106,9 @@ typedef struct FileData {
 
 	/* see: USE_GHASH_BHEAD */
 	struct GHash *bhead_idname_hash;
+
+	/* see: USE_PARALLEL_DIRECT_LINK */
+	ListBase deferred_direct_link;
 	
 	ListBase *mainlist;
 	ListBase *old_mainlist;  /* Used for undo. */
@@ -109,6 +122,9 @@ typedef struct FileData {
 
 typedef struct BHeadN {
 	struct BHeadN *next, *prev;
+	/* Block data, directly follows the BHeadN when read into memory,
+	 * or points into the file mapping for memory-mapped files. */
+	void *data;
 	struct BHead bhead;
 } BHeadN;
 
@@ -120,6 +136,7 @@ enum {
 	FD_FLAGS_FILE_OK               = 1 << 3,
 	FD_FLAGS_NOT_MY_BUFFER         = 1 << 4,
 	FD_FLAGS_NOT_MY_LIBMAP         = 1 << 5,  /* XXX Unused in practice (checked once but never set). */
+	FD_FLAGS_DEFER_DIRECT_LINK     = 1 << 6,  /* Direct linking of some IDs is done in parallel after reading. */
 };
 
 #define SIZEOFBLENDERHEADER 12
@@ -152,6 +169,7 @@ BHead *blo_firstbhead(FileData *fd);
 BHead *blo_nextbhead(FileData *fd, BHead *thisblock);
 BHead *blo_prevbhead(FileData *fd, BHead *thisblock);
 
+void *blo_bhead_data(BHead *bhead);
 const char *bhead_id_name(const FileData *fd, const BHead *bhead);
 
 /* do versions stuff */
@@ -40,11 +40,15 @@
 #include "DNA_listBase.h"
 
 #include "BLI_blenlib.h"
+#include "BLI_ghash.h"
 
 #include "BLO_undofile.h"
 
 /* **************** support for memory-write, for undo buffers *************** */
 
+/* chunk of the previous undo step to compare the next written chunk with */
+static MemFileChunk *compchunk = NULL;
+
 /* not memfile itself */
 void BLO_memfile_free(MemFile *memfile)
 {
@@ -56,6 +60,11 @@ void BLO_memfile_free(MemFile *memfile)
 		MEM_freeN(chunk);
 	}
 	memfile->size = 0;
+
+	if (memfile->id_chunks) {
+		BLI_ghash_free(memfile->id_chunks, NULL, MEM_freeN);
+		memfile->id_chunks = NULL;
+	}
 }
 
 /* to keep list of memfiles consistent, 'first' is always first in list */
@@ -63,26 +72,37 @@ void BLO_memfile_free(MemFile *memfile)
 void BLO_memfile_merge(MemFile *first, MemFile *second)
 {
 	MemFileChunk *fc, *sc;
-	
-	fc = first->chunks.first;
-	sc = second->chunks.first;
-	while (fc || sc) {
-		if (fc && sc) {
-			if (sc->ident) {
-				sc->ident = 0;
-				fc->ident = 1;
-			}
+	GSet *owned;
+
+	/* Chunks of 'second' don't necessarily line up with the ones of 'first' (unchanged datablocks re-use
+	 * their chunks wherever they were written), so hand over ownership by buffer instead of position. */
+	owned = BLI_gset_ptr_new(__func__);
+
+	for (fc = first->chunks.first; fc; fc = fc->next) {
+		if (fc->ident == 0) {
+			BLI_gset_add(owned, fc->buf);
 		}
-		if (fc) fc = fc->next;
-		if (sc) sc = sc->next;
 	}
-	
+
+	for (sc = second->chunks.first; sc; sc = sc->next) {
+		if (sc->ident && BLI_gset_remove(owned, sc->buf, NULL)) {
+			sc->ident = 0;
+		}
+	}
+
+	for (fc = first->chunks.first; fc; fc = fc->next) {
+		if (fc->ident == 0 && !BLI_gset_haskey(owned, fc->buf)) {
+			fc->ident = 1;
+		}
+	}
+
+	BLI_gset_free(owned, NULL);
+
 	BLO_memfile_free(first);
 }
 
 void memfile_chunk_add(MemFile *compare, MemFile *current, const char *buf, unsigned int size)
 {
-	static MemFileChunk *compchunk = NULL;
 	MemFileChunk *curchunk;
 	
 	/* this function inits when compare != NULL or when current == NULL  */
@@ -120,3 +140,22 @@ void memfile_chunk_add(MemFile *compare, MemFile *current, const char *buf, unsi
 	}
 }
 
+/**
+ * Add the chunks of an unchanged datablock written in the previous undo step, sharing their buffers.
+ * Comparing continues after them, where the previous step wrote the data following that datablock.
+ */
+void memfile_chunk_reuse(MemFile *current, const MemFileIDChunks *idc)
+{
+	MemFileChunk *chunk = idc->first;
+	unsigned int i;
+
+	for (i = 0; i < idc->num; i++, chunk = chunk->next) {
+		MemFileChunk *curchunk = MEM_mallocN(sizeof(MemFileChunk), "MemFileChunk");
+		curchunk->size = chunk->size;
+		curchunk->buf = chunk->buf;
+		curchunk->ident = 1;
+		BLI_addtail(&current->chunks, curchunk);
+	}
+
+	compchunk = chunk;
+}
@@ -152,6 +152,8 @@
 #include "MEM_guardedalloc.h" // MEM_freeN
 #include "BLI_bitmap.h"
 #include "BLI_blenlib.h"
+#include "BLI_ghash.h"
+#include "BLI_hash_mm2a.h"
 #include "BLI_linklist.h"
 #include "BLI_mempool.h"
 
@@ -184,6 +186,7 @@
 #include "BLO_blend_defs.h"
 
 #include "readfile.h"
+#include "zblock.h"
 
 /* for SDNA_TYPE_FROM_STRUCT() macro */
 #include "dna_type_offsets.h"
@@ -196,6 +199,9 @@
 #define MYWRITE_BUFFER_SIZE (MEM_SIZE_OPTIMAL(1 << 17))  /* 128kb */
 #define MYWRITE_MAX_CHUNK   (MEM_SIZE_OPTIMAL(1 << 15))  /* ~32kb */
 
+/* Undo pushes re-use chunks of datablocks which did not change since previous push. */
+#define USE_MEMFILE_UNDO_SKIP_UNCHANGED
+
 
 /** \name Small API to handle compression.
  * \{ */
@@ -203,6 +209,7 @@
 typedef enum {
 	WW_WRAP_NONE = 1,
 	WW_WRAP_ZLIB,
+	WW_WRAP_ZBLOCK,
 } eWriteWrapType;
 
 typedef struct WriteWrap WriteWrap;
@@ -216,6 +223,7 @@ struct WriteWrap {
 	union {
 		int file_handle;
 		gzFile gz_handle;
+		ZBlockWriter *zblock_handle;
 	} _user_data;
 };
 
@@ -275,6 +283,34 @@ static size_t ww_write_zlib(WriteWrap *ww, const char *buf, size_t buf_len)
 }
 #undef FILE_HANDLE
 
+/* zlib, independently compressed blocks */
+#define FILE_HANDLE(ww) \
+	(ww)->_user_data.zblock_handle
+
+static bool ww_open_zblock(WriteWrap *ww, const char *filepath)
+{
+	ZBlockWriter *file;
+
+	file = blo_zblock_writer_open(filepath);
+
+	if (file != NULL) {
+		FILE_HANDLE(ww) = file;
+		return true;
+	}
+	else {
+		return false;
+	}
+}
+static bool ww_close_zblock(WriteWrap *ww)
+{
+	return blo_zblock_writer_close(FILE_HANDLE(ww));
+}
+static size_t ww_write_zblock(WriteWrap *ww, const char *buf, size_t buf_len)
+{
+	return blo_zblock_writer_write(FILE_HANDLE(ww), buf, buf_len) ? buf_len : 0;
+}
+#undef FILE_HANDLE
+
 /* --- end compression types --- */
 
 static void ww_handle_init(eWriteWrapType ww_type, WriteWrap *r_ww)
@@ -289,6 +325,13 @@ static void ww_handle_init(eWriteWrapType ww_type, WriteWrap *r_ww)
 			r_ww->write = ww_write_zlib;
 			break;
 		}
+		case WW_WRAP_ZBLOCK:
+		{
+			r_ww->open  = ww_open_zblock;
+			r_ww->close = ww_close_zblock;
+			r_ww->write = ww_write_zblock;
+			break;
+		}
 		default:
 		{
 			r_ww->open  = ww_open_none;
@@ -3782,6 +3825,86 @@ static void write_thumb(WriteData *wd, const BlendThumbnail *thumb)
 }
 
 /* if MemFile * there's filesave to memory */
+#ifdef USE_MEMFILE_UNDO_SKIP_UNCHANGED
+
+/** \name Undo: Skip Unchanged Datablocks
+ *
+ * Datablocks not tagged for update since previous undo push (see #LIB_TAG_UNDO_UNCHANGED)
+ * re-use the chunks written for them in that push, instead of being written and compared again.
+ * Only done for types owning much data. The tag is cleared centrally: when the ID is tagged for update,
+ * on any change through RNA, and for the data of the active and selected objects on each undo push,
+ * so direct edits by operators are caught as well.
+ * \{ */
+
+static bool write_undo_id_supported(const ID *id)
+{
+	return ELEM(GS(id->name), ID_ME, ID_CU, ID_LT);
+}
+
+/* Catches changes done without tagging for update (renaming, users, re-allocated arrays...). */
+static unsigned int write_undo_id_hash(const ID *id)
+{
+	const size_t id_size = BKE_libblock_get_alloc_info(GS(id->name), NULL);
+	BLI_HashMurmur2A mm2;
+
+	/* skip runtime tags, including our own one */
+	BLI_hash_mm2a_init(&mm2, 0);
+	BLI_hash_mm2a_add(&mm2, (const unsigned char *)id, offsetof(ID, tag));
+	BLI_hash_mm2a_add(&mm2, (const unsigned char *)&id->us, id_size - offsetof(ID, us));
+	return BLI_hash_mm2a_end(&mm2);
+}
+
+static bool write_undo_id_reuse(WriteData *wd, ID *id, const unsigned int id_hash)
+{
+	MemFileIDChunks *idc;
+
+	if (((id->tag & LIB_TAG_UNDO_UNCHANGED) == 0) ||
+	    (wd->compare == NULL) ||
+	    (wd->compare->id_chunks == NULL))
+	{
+		return false;
+	}
+
+	idc = BLI_ghash_lookup(wd->compare->id_chunks, id);
+	if ((idc == NULL) || (idc->id_hash != id_hash)) {
+		return false;
+	}
+
+	memfile_chunk_reuse(wd->current, idc);
+	return true;
+}
+
+/* Store chunks added after \a chunk_prev as the ones of \a id. */
+static void write_undo_id_store(WriteData *wd, ID *id, MemFileChunk *chunk_prev, const unsigned int id_hash)
+{
+	MemFile *memfile = wd->current;
+	MemFileChunk *chunk = chunk_prev ? chunk_prev->next : memfile->chunks.first;
+	MemFileIDChunks *idc;
+
+	if (chunk == NULL) {
+		return;
+	}
+
+	if (memfile->id_chunks == NULL) {
+		memfile->id_chunks = BLI_ghash_ptr_new(__func__);
+	}
+
+	idc = MEM_mallocN(sizeof(*idc), __func__);
+	idc->first = chunk;
+	idc->num = 0;
+	idc->id_hash = id_hash;
+	for (; chunk; chunk = chunk->next) {
+		idc->num++;
+	}
+
+	BLI_ghash_insert(memfile->id_chunks, id, idc);
+	id->tag |= LIB_TAG_UNDO_UNCHANGED;
+}
+
+/** \} */
+
+#endif  /* USE_MEMFILE_UNDO_SKIP_UNCHANGED */
+
 static bool write_file_handle(
         Main *mainvar,
         WriteWrap *ww,
@@ -3837,6 +3960,24 @@ static bool write_file_handle(
 			/* We should never attempt to write non-regular IDs (i.e. all kind of temp/runtime ones). */
 			BLI_assert((id->tag & (LIB_TAG_NO_MAIN | LIB_TAG_NO_USER_REFCOUNT | LIB_TAG_NOT_ALLOCATED)) == 0);
 
+#ifdef USE_MEMFILE_UNDO_SKIP_UNCHANGED
+			const bool use_undo_skip = (current && write_undo_id_supported(id));
+			MemFileChunk *undo_chunk_prev = NULL;
+			unsigned int undo_id_hash = 0;
+
+			if (use_undo_skip) {
+				/* Keep the datablock in its own chunks. */
+				mywrite_flush(wd);
+				undo_chunk_prev = current->chunks.last;
+				undo_id_hash = write_undo_id_hash(id);
+
+				if (write_undo_id_reuse(wd, id, undo_id_hash)) {
+					write_undo_id_store(wd, id, undo_chunk_prev, undo_id_hash);
+					continue;
+				}
+			}
+#endif
+
 			switch ((ID_Type)GS(id->name)) {
 				case ID_WM:
 					write_windowmanager(wd, (wmWindowManager *)id);
@@ -3946,6 +4087,13 @@ static bool write_file_handle(
 					BLI_assert(0);
 					break;
 			}
+
+#ifdef USE_MEMFILE_UNDO_SKIP_UNCHANGED
+			if (use_undo_skip) {
+				mywrite_flush(wd);
+				write_undo_id_store(wd, id, undo_chunk_prev, undo_id_hash);
+			}
+#endif
 		}
 
 		mywrite_flush(wd);
@@ -4049,7 +4197,7 @@ bool BLO_write_file(
 	BLI_snprintf(tempname, sizeof(tempname), "%s@", filepath);
 
 	if (write_flags & G_FILE_COMPRESS) {
-		ww_type = WW_WRAP_ZLIB;
+		ww_type = (write_flags & G_FILE_COMPRESS_BLOCKS) ? WW_WRAP_ZBLOCK : WW_WRAP_ZLIB;
 	}
 	else {
 		ww_type = WW_WRAP_NONE;
@@ -4098,9 +4246,12 @@ bool BLO_write_file(
 	}
 
 	/* actual file writing */
-	const bool err = write_file_handle(mainvar, &ww, NULL, NULL, write_flags, thumb);
+	bool err = write_file_handle(mainvar, &ww, NULL, NULL, write_flags, thumb);
 
-	ww.close(&ww);
+	/* Compressed data may only be written on close (block table for WW_WRAP_ZBLOCK). */
+	if (ww.close(&ww) == false) {
+		err = true;
+	}
 
 	if (UNLIKELY(path_list_backup)) {
 		BKE_bpath_list_restore(mainvar, path_list_flag, path_list_backup);
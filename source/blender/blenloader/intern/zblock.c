@@ -0,0 +1,585 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/blenloader/intern/zblock.c
+ *  \ingroup blenloader
+ *
+ * Block compressed .blend files, see zblock.h for the file layout.
+ */
+
+#include <string.h>
+#include <fcntl.h>
+
+#ifndef WIN32
+#  include <unistd.h>
+#else
+#  include <io.h>
+#  include "BLI_winstuff.h"
+#endif
+
+#include "zlib.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_utildefines.h"
+#include "BLI_fileops.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+
+#include "BLO_blend_defs.h"
+
+#include "zblock.h"
+
+#define ZBLOCK_VERSION 1
+/* Uncompressed size of all but the last block. */
+#define ZBLOCK_BLOCK_SIZE (1 << 20)
+
+#define ZBLOCK_HEADER_SIZE (BLEN_ZBLOCK_MAGIC_LEN + 8)
+#define ZBLOCK_FOOTER_SIZE (16 + BLEN_ZBLOCK_MAGIC_LEN)
+#define ZBLOCK_ENTRY_SIZE 16
+/* Upper bound of the deflate compression ratio. */
+#define ZBLOCK_MAX_RATIO 1032
+
+typedef struct ZBlockEntry {
+	uint64_t offset;
+	unsigned int compressed_size;
+	unsigned int size;
+} ZBlockEntry;
+
+/* -------------------------------------------------------------------- */
+/** \name Utilities
+ * \{ */
+
+static void zblock_put_uint32(unsigned char *buf, const unsigned int value)
+{
+	buf[0] = (unsigned char)(value);
+	buf[1] = (unsigned char)(value >> 8);
+	buf[2] = (unsigned char)(value >> 16);
+	buf[3] = (unsigned char)(value >> 24);
+}
+
+static void zblock_put_uint64(unsigned char *buf, const uint64_t value)
+{
+	zblock_put_uint32(buf, (unsigned int)value);
+	zblock_put_uint32(buf + 4, (unsigned int)(value >> 32));
+}
+
+static unsigned int zblock_get_uint32(const unsigned char *buf)
+{
+	return ((unsigned int)buf[0]) |
+	       ((unsigned int)buf[1] << 8) |
+	       ((unsigned int)buf[2] << 16) |
+	       ((unsigned int)buf[3] << 24);
+}
+
+static uint64_t zblock_get_uint64(const unsigned char *buf)
+{
+	return (uint64_t)zblock_get_uint32(buf) | ((uint64_t)zblock_get_uint32(buf + 4) << 32);
+}
+
+static bool zblock_write_all(int file, const void *data, size_t data_len)
+{
+	while (data_len) {
+		const int written = (int)write(file, data, (unsigned int)MIN2(data_len, INT_MAX));
+		if (written <= 0) {
+			return false;
+		}
+		data = (const char *)data + written;
+		data_len -= (size_t)written;
+	}
+	return true;
+}
+
+static bool zblock_read_all(int file, void *data, size_t data_len)
+{
+	while (data_len) {
+		const int readsize = (int)read(file, data, (unsigned int)MIN2(data_len, INT_MAX));
+		if (readsize <= 0) {
+			return false;
+		}
+		data = (char *)data + readsize;
+		data_len -= (size_t)readsize;
+	}
+	return true;
+}
+
+/* lseek is the 64 bit _lseeki64 on Windows (see BLI_winstuff.h),
+ * where off_t is only 32 bit, so don't cast offsets to it. */
+static bool zblock_seek(int file, const int64_t offset, const int whence)
+{
+	return lseek(file, offset, whence) != -1;
+}
+
+static int64_t zblock_file_size(int file)
+{
+	return (int64_t)lseek(file, 0, SEEK_END);
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Writing
+ *
+ * Incoming data is split in blocks, once a batch of blocks is filled they are
+ * compressed in parallel and written to the file in order.
+ * \{ */
+
+typedef struct ZBlockCompressTask {
+	unsigned char *data;
+	size_t size;
+	unsigned char *compressed;
+	size_t compressed_size;
+	bool ok;
+} ZBlockCompressTask;
+
+struct ZBlockWriter {
+	int file;
+	bool error;
+
+	/* Current batch, all blocks but the last one are full. */
+	ZBlockCompressTask *batch;
+	int batch_len, batch_size;
+
+	/* Offset in the file for the next block. */
+	uint64_t offset;
+
+	ZBlockEntry *table;
+	int table_len, table_size;
+};
+
+static void zblock_compress_task(TaskPool *__restrict UNUSED(pool), void *taskdata, int UNUSED(threadid))
+{
+	ZBlockCompressTask *task = taskdata;
+	uLongf compressed_size = compressBound((uLong)task->size);
+
+	task->compressed = MEM_mallocN(compressed_size, __func__);
+	/* Same speed/ratio trade-off as the regular gzip compression. */
+	task->ok = (compress2(task->compressed, &compressed_size, task->data, (uLong)task->size, Z_BEST_SPEED) == Z_OK);
+	task->compressed_size = compressed_size;
+}
+
+static void zblock_writer_flush(ZBlockWriter *zw)
+{
+	TaskScheduler *scheduler = BLI_task_scheduler_get();
+	TaskPool *pool;
+	int i;
+
+	if (zw->batch_len == 0) {
+		return;
+	}
+
+	pool = BLI_task_pool_create(scheduler, zw);
+	for (i = 0; i < zw->batch_len; i++) {
+		BLI_task_pool_push(pool, zblock_compress_task, &zw->batch[i], false, TASK_PRIORITY_HIGH);
+	}
+	BLI_task_pool_work_and_wait(pool);
+	BLI_task_pool_free(pool);
+
+	for (i = 0; i < zw->batch_len; i++) {
+		ZBlockCompressTask *task = &zw->batch[i];
+		ZBlockEntry *entry;
+
+		if (!zw->error) {
+			if (task->ok && zblock_write_all(zw->file, task->compressed, task->compressed_size)) {
+				if (zw->table_len == zw->table_size) {
+					zw->table_size *= 2;
+					zw->table = MEM_reallocN(zw->table, sizeof(*zw->table) * (size_t)zw->table_size);
+				}
+				entry = &zw->table[zw->table_len++];
+				entry->offset = zw->offset;
+				entry->compressed_size = (unsigned int)task->compressed_size;
+				entry->size = (unsigned int)task->size;
+				zw->offset += task->compressed_size;
+			}
+			else {
+				zw->error = true;
+			}
+		}
+
+		MEM_freeN(task->compressed);
+		task->compressed = NULL;
+		task->size = 0;
+	}
+
+	zw->batch_len = 0;
+}
+
+ZBlockWriter *blo_zblock_writer_open(const char *filepath)
+{
+	ZBlockWriter *zw;
+	unsigned char header[ZBLOCK_HEADER_SIZE];
+	int i;
+	const int file = BLI_open(filepath, O_BINARY + O_WRONLY + O_CREAT + O_TRUNC, 0666);
+
+	if (file == -1) {
+		return NULL;
+	}
+
+	memcpy(header, BLEN_ZBLOCK_MAGIC, BLEN_ZBLOCK_MAGIC_LEN);
+	zblock_put_uint32(header + BLEN_ZBLOCK_MAGIC_LEN, ZBLOCK_VERSION);
+	zblock_put_uint32(header + BLEN_ZBLOCK_MAGIC_LEN + 4, ZBLOCK_BLOCK_SIZE);
+
+	if (!zblock_write_all(file, header, sizeof(header))) {
+		close(file);
+		return NULL;
+	}
+
+	zw = MEM_callocN(sizeof(*zw), __func__);
+	zw->file = file;
+	zw->offset = sizeof(header);
+
+	/* Batch is compressed at once when full. Having more blocks than threads
+	 * evens out blocks which compress slower than others, so fewer threads are
+	 * idle until the whole batch is done. */
+	zw->batch_size = 2 * BLI_task_scheduler_num_threads(BLI_task_scheduler_get());
+	zw->batch = MEM_callocN(sizeof(*zw->batch) * (size_t)zw->batch_size, __func__);
+	for (i = 0; i < zw->batch_size; i++) {
+		zw->batch[i].data = MEM_mallocN(ZBLOCK_BLOCK_SIZE, __func__);
+	}
+
+	zw->table_size = 64;
+	zw->table = MEM_mallocN(sizeof(*zw->table) * (size_t)zw->table_size, __func__);
+
+	return zw;
+}
+
+bool blo_zblock_writer_write(ZBlockWriter *zw, const void *data, size_t data_len)
+{
+	while (data_len && !zw->error) {
+		ZBlockCompressTask *task = &zw->batch[zw->batch_len];
+		const size_t copy_len = MIN2(data_len, ZBLOCK_BLOCK_SIZE - task->size);
+
+		memcpy(task->data + task->size, data, copy_len);
+		task->size += copy_len;
+		data = (const char *)data + copy_len;
+		data_len -= copy_len;
+
+		if (task->size == ZBLOCK_BLOCK_SIZE) {
+			if (++zw->batch_len == zw->batch_size) {
+				zblock_writer_flush(zw);
+			}
+		}
+	}
+
+	return !zw->error;
+}
+
+/**
+ * Writes remaining data and the block table, then closes the file.
+ *
+ * \return Success.
+ */
+bool blo_zblock_writer_close(ZBlockWriter *zw)
+{
+	bool ok;
+	int i;
+
+	/* Partially filled last block. */
+	if (zw->batch[zw->batch_len].size) {
+		zw->batch_len++;
+	}
+	zblock_writer_flush(zw);
+
+	if (!zw->error) {
+		const size_t table_len = (size_t)zw->table_len * ZBLOCK_ENTRY_SIZE;
+		unsigned char *table = MEM_mallocN(table_len + ZBLOCK_FOOTER_SIZE, __func__);
+		unsigned char *footer = table + table_len;
+
+		for (i = 0; i < zw->table_len; i++) {
+			unsigned char *entry = table + (size_t)i * ZBLOCK_ENTRY_SIZE;
+			zblock_put_uint64(entry, zw->table[i].offset);
+			zblock_put_uint32(entry + 8, zw->table[i].compressed_size);
+			zblock_put_uint32(entry + 12, zw->table[i].size);
+		}
+
+		zblock_put_uint64(footer, zw->offset);
+		zblock_put_uint32(footer + 8, (unsigned int)zw->table_len);
+		zblock_put_uint32(footer + 12, 0);
+		memcpy(footer + 16, BLEN_ZBLOCK_MAGIC, BLEN_ZBLOCK_MAGIC_LEN);
+
+		if (!zblock_write_all(zw->file, table, table_len + ZBLOCK_FOOTER_SIZE)) {
+			zw->error = true;
+		}
+
+		MEM_freeN(table);
+	}
+
+	ok = (close(zw->file) != -1) && !zw->error;
+
+	for (i = 0; i < zw->batch_size; i++) {
+		MEM_freeN(zw->batch[i].data);
+	}
+	MEM_freeN(zw->batch);
+	MEM_freeN(zw->table);
+	MEM_freeN(zw);
+
+	return ok;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Reading
+ *
+ * Blocks can be read in any order, and from multiple threads
+ * (only reading the compressed data from the file is serialized).
+ * \{ */
+
+struct ZBlockReader {
+	int file;
+	ThreadMutex file_lock;
+
+	ZBlockEntry *table;
+	int num_blocks;
+	unsigned int block_size;
+	size_t size;
+
+	/* Last decompressed block, for sequential reading with #blo_zblock_reader_read. */
+	int cache_index;
+	unsigned char *cache;
+};
+
+/**
+ * \return NULL when the file is not a block compressed file (or is corrupt).
+ */
+ZBlockReader *blo_zblock_reader_open(const char *filepath)
+{
+	ZBlockReader *zr;
+	unsigned char header[ZBLOCK_HEADER_SIZE], footer[ZBLOCK_FOOTER_SIZE];
+	unsigned char *table;
+	uint64_t table_offset, table_end, total_size = 0;
+	int64_t file_size;
+	unsigned int block_size;
+	int num_blocks, i;
+	const int file = BLI_open(filepath, O_BINARY | O_RDONLY, 0);
+
+	if (file == -1) {
+		return NULL;
+	}
+
+	if (!zblock_read_all(file, header, sizeof(header)) ||
+	    memcmp(header, BLEN_ZBLOCK_MAGIC, BLEN_ZBLOCK_MAGIC_LEN) != 0 ||
+	    zblock_get_uint32(header + BLEN_ZBLOCK_MAGIC_LEN) != ZBLOCK_VERSION ||
+	    (file_size = zblock_file_size(file)) < ZBLOCK_HEADER_SIZE + ZBLOCK_FOOTER_SIZE ||
+	    !zblock_seek(file, file_size - ZBLOCK_FOOTER_SIZE, SEEK_SET) ||
+	    !zblock_read_all(file, footer, sizeof(footer)) ||
+	    memcmp(footer + 16, BLEN_ZBLOCK_MAGIC, BLEN_ZBLOCK_MAGIC_LEN) != 0)
+	{
+		close(file);
+		return NULL;
+	}
+
+	block_size = zblock_get_uint32(header + BLEN_ZBLOCK_MAGIC_LEN + 4);
+	table_offset = zblock_get_uint64(footer);
+	num_blocks = (int)zblock_get_uint32(footer + 8);
+
+	/* Everything read from the file is checked before use, so corrupt or truncated
+	 * files fail to load instead of causing huge allocations or reads past the end.
+	 * The block table is directly followed by the footer. */
+	table_end = (uint64_t)(file_size - ZBLOCK_FOOTER_SIZE);
+	if (block_size == 0 || num_blocks <= 0 ||
+	    table_offset < ZBLOCK_HEADER_SIZE || table_offset > table_end ||
+	    table_end - table_offset != (uint64_t)num_blocks * ZBLOCK_ENTRY_SIZE ||
+	    !zblock_seek(file, (int64_t)table_offset, SEEK_SET))
+	{
+		close(file);
+		return NULL;
+	}
+
+	table = MEM_mallocN((size_t)num_blocks * ZBLOCK_ENTRY_SIZE, __func__);
+	if (!zblock_read_all(file, table, (size_t)num_blocks * ZBLOCK_ENTRY_SIZE)) {
+		MEM_freeN(table);
+		close(file);
+		return NULL;
+	}
+
+	zr = MEM_callocN(sizeof(*zr), __func__);
+	zr->file = file;
+	zr->num_blocks = num_blocks;
+	zr->block_size = block_size;
+	zr->table = MEM_mallocN(sizeof(*zr->table) * (size_t)num_blocks, __func__);
+	zr->cache_index = -1;
+	BLI_mutex_init(&zr->file_lock);
+
+	for (i = 0; i < num_blocks; i++) {
+		const unsigned char *entry = table + (size_t)i * ZBLOCK_ENTRY_SIZE;
+		zr->table[i].offset = zblock_get_uint64(entry);
+		zr->table[i].compressed_size = zblock_get_uint32(entry + 8);
+		zr->table[i].size = zblock_get_uint32(entry + 12);
+		total_size += zr->table[i].size;
+	}
+	MEM_freeN(table);
+	zr->size = (size_t)total_size;
+
+	for (i = 0; i < num_blocks; i++) {
+		const ZBlockEntry *entry = &zr->table[i];
+		/* Blocks are found by offset, only the last one may be smaller. */
+		if (((i < num_blocks - 1) ? (entry->size != zr->block_size) : (entry->size > zr->block_size)) ||
+		    /* Compressed data has to lie between the header and the block table. */
+		    entry->compressed_size == 0 ||
+		    entry->offset < ZBLOCK_HEADER_SIZE ||
+		    entry->offset > table_offset ||
+		    entry->compressed_size > table_offset - entry->offset ||
+		    /* zlib can't compress better than this, anything else is a corrupt size. */
+		    (uint64_t)entry->size > (uint64_t)entry->compressed_size * ZBLOCK_MAX_RATIO ||
+		    total_size > SIZE_MAX)
+		{
+			blo_zblock_reader_close(zr);
+			return NULL;
+		}
+	}
+
+	return zr;
+}
+
+void blo_zblock_reader_close(ZBlockReader *zr)
+{
+	close(zr->file);
+	BLI_mutex_end(&zr->file_lock);
+	MEM_freeN(zr->table);
+	if (zr->cache) {
+		MEM_freeN(zr->cache);
+	}
+	MEM_freeN(zr);
+}
+
+int blo_zblock_reader_num_blocks(const ZBlockReader *zr)
+{
+	return zr->num_blocks;
+}
+
+size_t blo_zblock_reader_block_size(const ZBlockReader *zr, int index)
+{
+	return zr->table[index].size;
+}
+
+/* Uncompressed size of the file. */
+size_t blo_zblock_reader_size(const ZBlockReader *zr)
+{
+	return zr->size;
+}
+
+/**
+ * Decompress a single block, \a r_data must hold #blo_zblock_reader_block_size bytes.
+ * Can be called from multiple threads at once.
+ */
+bool blo_zblock_reader_read_block(ZBlockReader *zr, int index, void *r_data)
+{
+	const ZBlockEntry *entry = &zr->table[index];
+	unsigned char *compressed = MEM_mallocN(entry->compressed_size, __func__);
+	uLongf size = entry->size;
+	bool ok;
+
+	BLI_mutex_lock(&zr->file_lock);
+	ok = zblock_seek(zr->file, (int64_t)entry->offset, SEEK_SET) &&
+	     zblock_read_all(zr->file, compressed, entry->compressed_size);
+	BLI_mutex_unlock(&zr->file_lock);
+
+	if (ok) {
+		ok = (uncompress(r_data, &size, compressed, entry->compressed_size) == Z_OK) && (size == entry->size);
+	}
+
+	MEM_freeN(compressed);
+
+	return ok;
+}
+
+/**
+ * Read \a data_len bytes at uncompressed \a offset, only decompressing the blocks needed.
+ * Not thread safe, keeps the last block around for sequential reads.
+ *
+ * \return The number of bytes read.
+ */
+size_t blo_zblock_reader_read(ZBlockReader *zr, void *r_data, size_t offset, size_t data_len)
+{
+	size_t readsize = 0;
+
+	while (readsize < data_len && offset < zr->size) {
+		const int index = (int)(offset / zr->block_size);
+		const size_t block_offset = offset - (size_t)index * zr->block_size;
+		const size_t copy_len = MIN2(data_len - readsize, zr->table[index].size - block_offset);
+
+		if (zr->cache_index != index) {
+			if (zr->cache == NULL) {
+				zr->cache = MEM_mallocN(zr->block_size, __func__);
+			}
+			zr->cache_index = -1;
+			if (!blo_zblock_reader_read_block(zr, index, zr->cache)) {
+				break;
+			}
+			zr->cache_index = index;
+		}
+
+		memcpy((char *)r_data + readsize, zr->cache + block_offset, copy_len);
+		readsize += copy_len;
+		offset += copy_len;
+	}
+
+	return readsize;
+}
+
+typedef struct ZBlockReadAllData {
+	ZBlockReader *zr;
+	unsigned char *data;
+	bool error;
+} ZBlockReadAllData;
+
+static void zblock_read_task(TaskPool *__restrict pool, void *taskdata, int UNUSED(threadid))
+{
+	ZBlockReadAllData *data = BLI_task_pool_userdata(pool);
+	const int index = GET_INT_FROM_POINTER(taskdata);
+
+	if (!blo_zblock_reader_read_block(data->zr, index, data->data + (size_t)index * data->zr->block_size)) {
+		data->error = true;
+	}
+}
+
+/**
+ * Decompress all blocks in parallel.
+ *
+ * \return Buffer of #blo_zblock_reader_size bytes owned by the caller, NULL on error.
+ */
+void *blo_zblock_reader_read_all(ZBlockReader *zr)
+{
+	TaskScheduler *scheduler = BLI_task_scheduler_get();
+	TaskPool *pool;
+	ZBlockReadAllData data;
+	int i;
+
+	data.zr = zr;
+	data.data = MEM_mallocN(zr->size, __func__);
+	data.error = false;
+
+	pool = BLI_task_pool_create(scheduler, &data);
+	for (i = 0; i < zr->num_blocks; i++) {
+		BLI_task_pool_push(pool, zblock_read_task, SET_INT_IN_POINTER(i), false, TASK_PRIORITY_HIGH);
+	}
+	BLI_task_pool_work_and_wait(pool);
+	BLI_task_pool_free(pool);
+
+	if (data.error) {
+		MEM_freeN(data.data);
+		return NULL;
+	}
+
+	return data.data;
+}
+
+/** \} */
@@ -0,0 +1,56 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/blenloader/intern/zblock.h
+ *  \ingroup blenloader
+ *  \brief Block compressed .blend files.
+ *
+ * The file is split in fixed size blocks which are compressed independently,
+ * so they can be compressed and decompressed in parallel and read in any order.
+ *
+ * Layout (all numbers little endian):
+ * - Header: #BLEN_ZBLOCK_MAGIC, uint32 version, uint32 uncompressed block size.
+ * - Compressed blocks (zlib streams), back to back.
+ * - Block table: per block uint64 file offset, uint32 compressed size, uint32 uncompressed size.
+ * - Footer: uint64 block table offset, uint32 number of blocks, uint32 unused, #BLEN_ZBLOCK_MAGIC.
+ */
+
+#ifndef __ZBLOCK_H__
+#define __ZBLOCK_H__
+
+typedef struct ZBlockWriter ZBlockWriter;
+typedef struct ZBlockReader ZBlockReader;
+
+/* writing */
+ZBlockWriter *blo_zblock_writer_open(const char *filepath);
+bool          blo_zblock_writer_write(ZBlockWriter *zw, const void *data, size_t data_len);
+bool          blo_zblock_writer_close(ZBlockWriter *zw);
+
+/* reading */
+ZBlockReader *blo_zblock_reader_open(const char *filepath);
+void          blo_zblock_reader_close(ZBlockReader *zr);
+int           blo_zblock_reader_num_blocks(const ZBlockReader *zr);
+size_t        blo_zblock_reader_block_size(const ZBlockReader *zr, int index);
+size_t        blo_zblock_reader_size(const ZBlockReader *zr);
+bool          blo_zblock_reader_read_block(ZBlockReader *zr, int index, void *r_data);
+size_t        blo_zblock_reader_read(ZBlockReader *zr, void *r_data, size_t offset, size_t data_len);
+void         *blo_zblock_reader_read_all(ZBlockReader *zr);
+
+#endif  /* __ZBLOCK_H__ */
@@ -218,16 +218,36 @@ extern "C" {
  * @see MemoryProxy proxy for information about memory image (a image consist out of multiple chunks)
  * @see MemoryBuffer Allocated memory for a single chunk
  *
+ * @section fullframe Full frame
+ * When the full frame option of the node tree is enabled (NTREE_COM_FULL_FRAME) the area of interest is not used.
+ * Every ExecutionGroup is executed once on its whole MemoryProxy, after the ExecutionGroups it depends on
+ * (topological order). The rows of the frame are split in strips, which are all scheduled at once and
+ * calculated in parallel. This avoids the overhead of scheduling chunk dependencies and of recalculating
+ * the borders of neighboring chunks, at the cost of showing the result only when an ExecutionGroup is finished.
+ *
+ * @see ExecutionSystem.executeGroupFullFrame
+ * @see ExecutionGroup.executeFullFrame
+ *
+ * @section resultcache Result cache
+ * The buffers of MemoryProxy's are kept between executions, up to the cache size of the node tree.
+ * When an execution has a buffer with the same key as a previous execution the buffer is copied from the cache
+ * and its ExecutionGroup is marked as executed. Groups which are only needed to calculate this buffer won't
+ * be scheduled anymore, so changing a node only calculates the buffers downstream of it.
+ *
+ * @see ResultCache.determineKey
+ * @see ExecutionSystem.restoreCachedResults
+ *
  * @section workscheduler WorkScheduler
  * the WorkScheduler is implemented as a static class. the responsibility of the WorkScheduler is to balance
  * WorkPackages to the available and free devices.
  * the work-scheduler can work in 2 states. For witching these between the state you need to recompile blender
  *
  * @subsection multithread Multi threaded
- * Default the work-scheduler will place all work as WorkPackage in a queue.
- * For every CPUcore a working thread is created. These working threads will ask the WorkScheduler if there is work
- * for a specific Device.
- * the work-scheduler will find work for the device and the device will be asked to execute the WorkPackage
+ * Default the work-scheduler will place all CPU work as WorkPackage in a task pool of the BLI_task scheduler,
+ * which is shared with the rest of Blender. For every thread of the scheduler a CPUDevice exists, the device
+ * of the thread that runs a task will be asked to execute the WorkPackage.
+ * Chunks near the hotspots of the viewer are pushed with a high priority, so they are executed first.
+ * OpenCL devices have their own threads reading a queue of WorkPackages.
  *
  * @subsection singlethread Single threaded
  * For debugging reasons the multi-threading can be disabled. This is done by changing the COM_CURRENT_THREADING_MODEL
@@ -273,6 +293,11 @@ extern "C" {
  * @section executePixel executing a pixel
  * Finally the last step, the node functionality :)
  *
+ * WriteBufferOperations read non-complex inputs a row at a time, at most COM_ROW_SIZE pixels.
+ * By default a row calls executePixelSampled per pixel, operations that are often used in long chains
+ * (Mix, Gamma, Color Balance, constants and buffer reads) calculate the whole row in one call.
+ * @see SocketReader.executeRow
+ *
  * @page newnode Creating new nodes
  */
 
@@ -329,7 +354,14 @@ void COM_deinitialize(void);
  * @brief Clear all compositor caches. (Compositor system will still remain available). 
  * To deinitialize the compositor use the COM_deinitialize method.
  */
-// void COM_clearCaches(void); // NOT YET WRITTEN
+void COM_clearCaches(void);
+
+/**
+ * @brief Tag the data of an ID as changed.
+ * Cached results of nodes using the ID (render layers) will be calculated again.
+ * Can be called from any thread.
+ */
+void COM_tagChangedID(struct ID *id);
 
 #ifdef __cplusplus
 }
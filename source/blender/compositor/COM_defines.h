@@ -72,7 +72,7 @@ typedef enum CompositorPriority {
 
 // workscheduler threading models
 /**
- * COM_TM_QUEUE is a multithreaded model, which uses the BLI_thread_queue pattern. This is the default option.
+ * COM_TM_QUEUE is a multithreaded model, which uses the BLI_task scheduler for the CPU and BLI_thread_queue for OpenCL. This is the default option.
  */
 #define COM_TM_QUEUE 1
 
@@ -111,4 +111,11 @@ typedef enum OrderOfChunks {
 
 #define COM_BLUR_BOKEH_PIXELS 512
 
+/**
+ * @brief maximum number of pixels calculated by a single SocketReader.readRow call
+ * @note rows are stored with COM_NUM_CHANNELS_COLOR floats per pixel, temporary rows come from RowBuffers
+ * @ingroup Execution
+ */
+#define COM_ROW_SIZE 64
+
 #endif  /* __COM_DEFINES_H__ */
@@ -21,9 +21,72 @@
 
 #include "COM_Debug.h"
 
+#include <typeinfo>
+
+extern "C" {
+#include "BLI_threads.h"
+
+#include "BKE_global.h"
+}
+
+#include "COM_ExecutionSystem.h"
+#include "COM_ExecutionGroup.h"
+
+static SpinLock timing_lock;
+static bool timing_lock_initialized = false;
+
+bool DebugInfo::m_timing_enabled = false;
+DebugInfo::GroupTimingMap DebugInfo::m_group_timings;
+
+void DebugInfo::execute_timing_started()
+{
+	m_timing_enabled = (G.debug & G_DEBUG) != 0;
+	m_group_timings.clear();
+	if (m_timing_enabled && !timing_lock_initialized) {
+		BLI_spin_init(&timing_lock);
+		timing_lock_initialized = true;
+	}
+}
+
+void DebugInfo::execution_group_chunk_executed(const ExecutionGroup *group, double time)
+{
+	if (!m_timing_enabled) {
+		return;
+	}
+	BLI_spin_lock(&timing_lock);
+	GroupTimingMap::iterator it = m_group_timings.find(group);
+	if (it == m_group_timings.end()) {
+		GroupTiming timing = {0, 0.0};
+		it = m_group_timings.insert(std::make_pair(group, timing)).first;
+	}
+	it->second.num_chunks++;
+	it->second.time += time;
+	BLI_spin_unlock(&timing_lock);
+}
+
+void DebugInfo::execute_timing_print(const ExecutionSystem *system)
+{
+	if (!m_timing_enabled) {
+		return;
+	}
+	printf("Compositor execution times:\n");
+	for (unsigned int index = 0; index < system->m_groups.size(); index++) {
+		const ExecutionGroup *group = system->m_groups[index];
+		GroupTimingMap::const_iterator it = m_group_timings.find(group);
+		if (it == m_group_timings.end()) {
+			continue;
+		}
+		std::string name = operation_name(group->getOutputOperation());
+		if (name.empty()) {
+			name = typeid(*group->getOutputOperation()).name();
+		}
+		printf("  group %u (%s): %d chunks, %.4f s\n",
+		       index, name.c_str(), it->second.num_chunks, it->second.time);
+	}
+}
+
 #ifdef COM_DEBUG
 
-#include <typeinfo>
 #include <map>
 #include <vector>
 
@@ -39,8 +102,6 @@ extern "C" {
 }
 
 #include "COM_Node.h"
-#include "COM_ExecutionSystem.h"
-#include "COM_ExecutionGroup.h"
 
 #include "COM_ReadBufferOperation.h"
 #include "COM_ViewerOperation.h"
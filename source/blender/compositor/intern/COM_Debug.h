@@ -43,6 +43,12 @@ public:
 	typedef std::map<const Node *, std::string> NodeNameMap;
 	typedef std::map<const NodeOperation *, std::string> OpNameMap;
 	typedef std::map<const ExecutionGroup *, GroupState> GroupStateMap;
+
+	typedef struct GroupTiming {
+		int num_chunks;
+		double time;
+	} GroupTiming;
+	typedef std::map<const ExecutionGroup *, GroupTiming> GroupTimingMap;
 	
 	static std::string node_name(const Node *node);
 	static std::string operation_name(const NodeOperation *op);
@@ -59,7 +65,17 @@ public:
 	static void execution_group_finished(const ExecutionGroup *group);
 	
 	static void graphviz(const ExecutionSystem *system);
-	
+
+	/* Execution time of the chunks per group, gathered and printed when running with --debug.
+	 * Chunk timing is called from the scheduler threads. */
+	static void execute_timing_started();
+	static void execution_group_chunk_executed(const ExecutionGroup *group, double time);
+	static void execute_timing_print(const ExecutionSystem *system);
+
+private:
+	static bool m_timing_enabled;
+	static GroupTimingMap m_group_timings;
+
 #ifdef COM_DEBUG
 protected:
 	static int graphviz_operation(const ExecutionSystem *system, const NodeOperation *operation, const ExecutionGroup *group, char *str, int maxlen);
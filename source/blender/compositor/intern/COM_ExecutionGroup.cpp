@@ -60,6 +60,8 @@ ExecutionGroup::ExecutionGroup()
 	this->m_initialized = false;
 	this->m_openCL = false;
 	this->m_singleThreaded = false;
+	this->m_fullFrame = false;
+	this->m_fullFrameRows = 0;
 	this->m_chunksFinished = 0;
 	BLI_rcti_init(&this->m_viewerBorder, 0, 0, 0, 0);
 	this->m_executionStartTime = 0;
@@ -168,6 +170,15 @@ void ExecutionGroup::determineNumberOfChunks()
 		this->m_numberOfYChunks = 1;
 		this->m_numberOfChunks = 1;
 	}
+	else if (this->m_fullFrame) {
+		/* Strips of full rows, a few per thread so threads finishing early can pick up more work. */
+		const int border_height = BLI_rcti_size_y(&this->m_viewerBorder);
+		const int numberOfStrips = BLI_system_thread_count() * 4;
+		this->m_fullFrameRows = max_ii((border_height + numberOfStrips - 1) / numberOfStrips, 1);
+		this->m_numberOfXChunks = 1;
+		this->m_numberOfYChunks = (border_height + this->m_fullFrameRows - 1) / this->m_fullFrameRows;
+		this->m_numberOfChunks = this->m_numberOfYChunks;
+	}
 	else {
 		const float chunkSizef = this->m_chunkSize;
 		const int border_width = BLI_rcti_size_x(&this->m_viewerBorder);
@@ -239,7 +250,7 @@ void ExecutionGroup::execute(ExecutionSystem *graph)
 				chunkOrders[index].determineDistance(hotspots, 1);
 			}
 
-			std::sort(&chunkOrders[0], &chunkOrders[this->m_numberOfChunks - 1]);
+			std::sort(&chunkOrders[0], &chunkOrders[this->m_numberOfChunks]);
 			for (index = 0; index < this->m_numberOfChunks; index++) {
 				chunkOrder[index] = chunkOrders[index].getChunkNumber();
 			}
@@ -309,6 +320,13 @@ void ExecutionGroup::execute(ExecutionSystem *graph)
 	unsigned int startIndex = 0;
 	const int maxNumberEvaluated = BLI_system_thread_count() * 2;
 
+	/* Chunks closest to the hotspots of the viewer, and the chunks they depend on,
+	 * are executed before other work of the task scheduler. */
+	unsigned int numberOfHighPriorityChunks = 0;
+	if (chunkorder == COM_TO_CENTER_OUT || chunkorder == COM_TO_RULE_OF_THIRDS) {
+		numberOfHighPriorityChunks = BLI_system_thread_count();
+	}
+
 	while (!finished && !breaked) {
 		bool startEvaluated = false;
 		finished = true;
@@ -320,7 +338,8 @@ void ExecutionGroup::execute(ExecutionSystem *graph)
 			int xChunk = chunkNumber - (yChunk * this->m_numberOfXChunks);
 			const ChunkExecutionState state = this->m_chunkExecutionStates[chunkNumber];
 			if (state == COM_ES_NOT_SCHEDULED) {
-				scheduleChunkWhenPossible(graph, xChunk, yChunk);
+				scheduleChunkWhenPossible(graph, xChunk, yChunk,
+				                          (index < numberOfHighPriorityChunks) ? TASK_PRIORITY_HIGH : TASK_PRIORITY_LOW);
 				finished = false;
 				startEvaluated = true;
 				numberEvaluated++;
@@ -350,6 +369,55 @@ void ExecutionGroup::execute(ExecutionSystem *graph)
 	MEM_freeN(chunkOrder);
 }
 
+void ExecutionGroup::executeFullFrame(ExecutionSystem *graph)
+{
+	const CompositorContext &context = graph->getContext();
+	const bNodeTree *bTree = context.getbNodeTree();
+	if (this->m_width == 0 || this->m_height == 0) {return; } /// @note: break out... no pixels to calculate.
+	if (this->m_numberOfChunks == 0) {return; } /// @note: early break out
+	unsigned int chunkNumber;
+
+	this->m_executionStartTime = PIL_check_seconds_timer();
+
+	this->m_chunksFinished = 0;
+	/* only the groups of the output nodes report progress */
+	this->m_bTree = this->isOutputExecutionGroup() ? bTree : NULL;
+
+	DebugInfo::execution_group_started(this);
+	DebugInfo::graphviz(graph);
+
+	/* All input groups have been executed, no need to check the area of interest of the strips. */
+	for (chunkNumber = 0; chunkNumber < this->m_numberOfChunks; chunkNumber++) {
+		scheduleChunk(chunkNumber, TASK_PRIORITY_LOW);
+	}
+
+	WorkScheduler::finish();
+
+	if (this->m_bTree && bTree->update_draw) {
+		bTree->update_draw(bTree->udh);
+	}
+
+	DebugInfo::execution_group_finished(this);
+	DebugInfo::graphviz(graph);
+}
+
+bool ExecutionGroup::isExecuted() const
+{
+	for (unsigned int index = 0; index < this->m_numberOfChunks; index++) {
+		if (this->m_chunkExecutionStates[index] != COM_ES_EXECUTED) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void ExecutionGroup::setExecuted()
+{
+	for (unsigned int index = 0; index < this->m_numberOfChunks; index++) {
+		this->m_chunkExecutionStates[index] = COM_ES_EXECUTED;
+	}
+}
+
 MemoryBuffer **ExecutionGroup::getInputBuffersOpenCL(int chunkNumber)
 {
 	rcti rect;
@@ -418,6 +486,12 @@ inline void ExecutionGroup::determineChunkRect(rcti *rect, const unsigned int xC
 	if (this->m_singleThreaded) {
 		BLI_rcti_init(rect, this->m_viewerBorder.xmin, border_width, this->m_viewerBorder.ymin, border_height);
 	}
+	else if (this->m_fullFrame) {
+		const unsigned int miny = yChunk * this->m_fullFrameRows + this->m_viewerBorder.ymin;
+		const unsigned int width = min((unsigned int) this->m_viewerBorder.xmax, this->m_width);
+		const unsigned int height = min((unsigned int) this->m_viewerBorder.ymax, this->m_height);
+		BLI_rcti_init(rect, min((unsigned int) this->m_viewerBorder.xmin, this->m_width), width, min(miny, this->m_height), min(miny + this->m_fullFrameRows, height));
+	}
 	else {
 		const unsigned int minx = xChunk * this->m_chunkSize + this->m_viewerBorder.xmin;
 		const unsigned int miny = yChunk * this->m_chunkSize + this->m_viewerBorder.ymin;
@@ -448,10 +522,10 @@ MemoryBuffer *ExecutionGroup::allocateOutputBuffer(int /*chunkNumber*/,
 }
 
 
-bool ExecutionGroup::scheduleAreaWhenPossible(ExecutionSystem *graph, rcti *area)
+bool ExecutionGroup::scheduleAreaWhenPossible(ExecutionSystem *graph, rcti *area, TaskPriority priority)
 {
 	if (this->m_singleThreaded) {
-		return scheduleChunkWhenPossible(graph, 0, 0);
+		return scheduleChunkWhenPossible(graph, 0, 0, priority);
 	}
 	// find all chunks inside the rect
 	// determine minxchunk, minychunk, maxxchunk, maxychunk where x and y are chunknumbers
@@ -473,7 +547,7 @@ bool ExecutionGroup::scheduleAreaWhenPossible(ExecutionSystem *graph, rcti *area
 	bool result = true;
 	for (indexx = minxchunk; indexx < maxxchunk; indexx++) {
 		for (indexy = minychunk; indexy < maxychunk; indexy++) {
-			if (!scheduleChunkWhenPossible(graph, indexx, indexy)) {
+			if (!scheduleChunkWhenPossible(graph, indexx, indexy, priority)) {
 				result = false;
 			}
 		}
@@ -482,17 +556,17 @@ bool ExecutionGroup::scheduleAreaWhenPossible(ExecutionSystem *graph, rcti *area
 	return result;
 }
 
-bool ExecutionGroup::scheduleChunk(unsigned int chunkNumber)
+bool ExecutionGroup::scheduleChunk(unsigned int chunkNumber, TaskPriority priority)
 {
 	if (this->m_chunkExecutionStates[chunkNumber] == COM_ES_NOT_SCHEDULED) {
 		this->m_chunkExecutionStates[chunkNumber] = COM_ES_SCHEDULED;
-		WorkScheduler::schedule(this, chunkNumber);
+		WorkScheduler::schedule(this, chunkNumber, priority);
 		return true;
 	}
 	return false;
 }
 
-bool ExecutionGroup::scheduleChunkWhenPossible(ExecutionSystem *graph, int xChunk, int yChunk)
+bool ExecutionGroup::scheduleChunkWhenPossible(ExecutionSystem *graph, int xChunk, int yChunk, TaskPriority priority)
 {
 	if (xChunk < 0 || xChunk >= (int)this->m_numberOfXChunks) {
 		return true;
@@ -529,7 +603,7 @@ bool ExecutionGroup::scheduleChunkWhenPossible(ExecutionSystem *graph, int xChun
 		ExecutionGroup *group = memoryProxy->getExecutor();
 
 		if (group != NULL) {
-			if (!group->scheduleAreaWhenPossible(graph, &area)) {
+			if (!group->scheduleAreaWhenPossible(graph, &area, priority)) {
 				canBeExecuted = false;
 			}
 		}
@@ -539,7 +613,7 @@ bool ExecutionGroup::scheduleChunkWhenPossible(ExecutionSystem *graph, int xChun
 	}
 
 	if (canBeExecuted) {
-		scheduleChunk(chunkNumber);
+		scheduleChunk(chunkNumber, priority);
 	}
 
 	return false;
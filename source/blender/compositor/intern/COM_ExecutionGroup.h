@@ -27,6 +27,9 @@
 #include "COM_NodeOperation.h"
 #include <vector>
 #include "BLI_rect.h"
+extern "C" {
+#  include "BLI_task.h"
+}
 #include "COM_MemoryProxy.h"
 #include "COM_Device.h"
 #include "COM_CompositorContext.h"
@@ -125,6 +128,18 @@ private:
 	 * @brief Is this Execution group SingleThreaded
 	 */
 	bool m_singleThreaded;
+
+	/**
+	 * @brief Is this ExecutionGroup executed on the whole frame at once
+	 * @note chunks are horizontal strips spanning the full width, see m_fullFrameRows
+	 * @see ExecutionSystem.executeGroupFullFrame
+	 */
+	bool m_fullFrame;
+
+	/**
+	 * @brief number of rows of a single strip when executed on the whole frame
+	 */
+	unsigned int m_fullFrameRows;
 	
 	/**
 	 * @brief what is the maximum number field of all ReadBufferOperation in this ExecutionGroup.
@@ -213,11 +228,12 @@ private:
 	 * @param graph
 	 * @param xChunk
 	 * @param yChunk
+	 * @param priority priority of the chunk and of the chunks it depends on
 	 * @return [true:false]
 	 * true: package(s) are scheduled
 	 * false: scheduling is deferred (depending workpackages are scheduled)
 	 */
-	bool scheduleChunkWhenPossible(ExecutionSystem *graph, int xChunk, int yChunk);
+	bool scheduleChunkWhenPossible(ExecutionSystem *graph, int xChunk, int yChunk, TaskPriority priority);
 
 	/**
 	 * @brief try to schedule a specific area.
@@ -225,17 +241,19 @@ private:
 	 * @note This method is called from other ExecutionGroup's.
 	 * @param graph
 	 * @param rect
+	 * @param priority priority of the chunks in the area
 	 * @return [true:false]
 	 * true: package(s) are scheduled
 	 * false: scheduling is deferred (depending workpackages are scheduled)
 	 */
-	bool scheduleAreaWhenPossible(ExecutionSystem *graph, rcti *rect);
+	bool scheduleAreaWhenPossible(ExecutionSystem *graph, rcti *rect, TaskPriority priority);
 
 	/**
 	 * @brief add a chunk to the WorkScheduler.
 	 * @param chunknumber
+	 * @param priority
 	 */
-	bool scheduleChunk(unsigned int chunkNumber);
+	bool scheduleChunk(unsigned int chunkNumber, TaskPriority priority);
 	
 	/**
 	 * @brief determine the area of interest of a certain input area
@@ -375,6 +393,26 @@ public:
 	 * @param system
 	 */
 	void execute(ExecutionSystem *system);
+
+	/**
+	 * @brief execute this ExecutionGroup on the whole frame
+	 * @note the ExecutionGroups this group depends on must be executed already,
+	 * all strips are scheduled at once and this method returns when they have been calculated.
+	 * @see ExecutionSystem.executeGroupFullFrame
+	 * @param system
+	 */
+	void executeFullFrame(ExecutionSystem *system);
+
+	/**
+	 * @brief have all chunks of this ExecutionGroup been calculated
+	 */
+	bool isExecuted() const;
+
+	/**
+	 * @brief mark all chunks of this ExecutionGroup as calculated
+	 * @note used when the result of the ExecutionGroup is restored from the ResultCache
+	 */
+	void setExecuted();
 	
 	/**
 	 * @brief this method determines the MemoryProxy's where this execution group depends on.
@@ -399,6 +437,12 @@ public:
 
 	void setChunksize(int chunksize) { this->m_chunkSize = chunksize; }
 
+	/**
+	 * @brief execute this ExecutionGroup on the whole frame instead of in chunks
+	 * @note must be set before initExecution
+	 */
+	void setFullFrame(bool fullFrame) { this->m_fullFrame = fullFrame; }
+
 	/**
 	 * @brief get the Render priority of this ExecutionGroup
 	 * @see ExecutionSystem.execute
@@ -36,6 +36,7 @@ extern "C" {
 #include "COM_ExecutionGroup.h"
 #include "COM_WorkScheduler.h"
 #include "COM_ReadBufferOperation.h"
+#include "COM_WriteBufferOperation.h"
 #include "COM_Debug.h"
 
 #ifdef WITH_CXX_GUARDEDALLOC
@@ -171,9 +172,13 @@ void ExecutionSystem::execute()
 	for (index = 0; index < this->m_groups.size(); index++) {
 		ExecutionGroup *executionGroup = this->m_groups[index];
 		executionGroup->setChunksize(this->m_context.getChunksize());
+		executionGroup->setFullFrame(this->m_context.isFullFrame());
 		executionGroup->initExecution();
 	}
 
+	restoreCachedResults();
+
+	DebugInfo::execute_timing_started();
 	WorkScheduler::start(this->m_context);
 
 	executeGroups(COM_PRIORITY_HIGH);
@@ -184,6 +189,9 @@ void ExecutionSystem::execute()
 
 	WorkScheduler::finish();
 	WorkScheduler::stop();
+	DebugInfo::execute_timing_print(this);
+
+	storeCachedResults();
 
 	editingtree->stats_draw(editingtree->sdh, IFACE_("Compositing | De-initializing execution"));
 	for (index = 0; index < this->m_operations.size(); index++) {
@@ -204,7 +212,69 @@ void ExecutionSystem::executeGroups(CompositorPriority priority)
 
 	for (index = 0; index < executionGroups.size(); index++) {
 		ExecutionGroup *group = executionGroups[index];
-		group->execute(this);
+		if (this->m_context.isFullFrame()) {
+			executeGroupFullFrame(group);
+		}
+		else {
+			group->execute(this);
+		}
+	}
+}
+
+void ExecutionSystem::executeGroupFullFrame(ExecutionGroup *group)
+{
+	if (group->isExecuted()) {
+		return;
+	}
+
+	vector<MemoryProxy *> memoryProxies;
+	unsigned int index;
+	group->determineDependingMemoryProxies(&memoryProxies);
+	for (index = 0; index < memoryProxies.size(); index++) {
+		ExecutionGroup *inputGroup = memoryProxies[index]->getExecutor();
+		if (inputGroup != NULL) {
+			executeGroupFullFrame(inputGroup);
+		}
+	}
+
+	const bNodeTree *bTree = this->m_context.getbNodeTree();
+	if (bTree->test_break && bTree->test_break(bTree->tbh)) {
+		return;
+	}
+
+	group->executeFullFrame(this);
+}
+
+void ExecutionSystem::restoreCachedResults()
+{
+	unsigned int index;
+	for (index = 0; index < this->m_groups.size(); index++) {
+		ExecutionGroup *group = this->m_groups[index];
+		NodeOperation *operation = group->getOutputOperation();
+		if (operation->isWriteBufferOperation()) {
+			WriteBufferOperation *writeOperation = (WriteBufferOperation *)operation;
+			ResultCache::Key key = ResultCache::determineKey(this->m_context, writeOperation, this->m_cacheKeys);
+			if (ResultCache::restore(key, writeOperation->getMemoryProxy()->getBuffer())) {
+				group->setExecuted();
+			}
+		}
+	}
+}
+
+void ExecutionSystem::storeCachedResults()
+{
+	unsigned int index;
+	for (index = 0; index < this->m_groups.size(); index++) {
+		ExecutionGroup *group = this->m_groups[index];
+		NodeOperation *operation = group->getOutputOperation();
+		/* groups which are not completely calculated, because of a border or user break, are not stored */
+		if (operation->isWriteBufferOperation() && group->isExecuted()) {
+			WriteBufferOperation *writeOperation = (WriteBufferOperation *)operation;
+			ResultCache::OperationKeys::const_iterator it = this->m_cacheKeys.find(writeOperation);
+			if (it != this->m_cacheKeys.end()) {
+				ResultCache::store(it->second, writeOperation->getMemoryProxy()->getBuffer());
+			}
+		}
 	}
 }
 
@@ -31,6 +31,7 @@ class ExecutionGroup;
 #include "BKE_text.h"
 #include "COM_ExecutionGroup.h"
 #include "COM_NodeOperation.h"
+#include "COM_ResultCache.h"
 
 /**
  * @page execution Execution model
@@ -131,6 +132,11 @@ private:
 	 */
 	Groups m_groups;
 
+	/**
+	 * @brief keys of the operations results in the ResultCache
+	 */
+	ResultCache::OperationKeys m_cacheKeys;
+
 private: //methods
 	/**
 	 * find all execution group with output nodes
@@ -177,6 +183,23 @@ public:
 private:
 	void executeGroups(CompositorPriority priority);
 
+	/**
+	 * @brief execute an ExecutionGroup on the whole frame, after the groups it depends on
+	 * @note groups are executed once, in topological order
+	 */
+	void executeGroupFullFrame(ExecutionGroup *group);
+
+	/**
+	 * @brief copy the results of ExecutionGroups that were calculated before from the ResultCache
+	 * @note these groups are marked as executed and won't be scheduled
+	 */
+	void restoreCachedResults();
+
+	/**
+	 * @brief store the results of the ExecutionGroups that have been calculated in the ResultCache
+	 */
+	void storeCachedResults();
+
 	/* allow the DebugInfo class to look at internals */
 	friend class DebugInfo;
 
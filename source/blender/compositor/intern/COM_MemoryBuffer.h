@@ -129,6 +129,11 @@ public:
 
 	unsigned int get_num_channels() { return this->m_num_channels; }
 
+	/**
+	 * @brief get the type of the values in this MemoryBuffer
+	 */
+	DataType getDataType() const { return this->m_datatype; }
+
 	/**
 	 * @brief get the data of this MemoryBuffer
 	 * @note buffer should already be available in memory
@@ -249,7 +254,34 @@ public:
 		float *buffer = &this->m_buffer[offset];
 		memcpy(result, buffer, sizeof(float) * this->m_num_channels);
 	}
-	
+
+	/**
+	 * @brief read num pixels starting at x, y, like read with COM_MB_CLIP
+	 * @param result array of num * COM_NUM_CHANNELS_COLOR floats, see SocketReader.readRow
+	 */
+	inline void readRow(float *result, int x, int y, int num)
+	{
+		const bool clip_y = (y < m_rect.ymin || y >= m_rect.ymax);
+		if (!clip_y && this->m_num_channels == COM_NUM_CHANNELS_COLOR &&
+		    x >= m_rect.xmin && x + num <= m_rect.xmax)
+		{
+			/* same layout, copy the row at once */
+			memcpy(result, &this->m_buffer[(this->m_width * y + x) * COM_NUM_CHANNELS_COLOR],
+			       sizeof(float) * COM_NUM_CHANNELS_COLOR * num);
+			return;
+		}
+
+		for (int i = 0; i < num; i++, x++, result += COM_NUM_CHANNELS_COLOR) {
+			if (clip_y || x < m_rect.xmin || x >= m_rect.xmax) {
+				memset(result, 0, this->m_num_channels * sizeof(float));
+			}
+			else {
+				memcpy(result, &this->m_buffer[(this->m_width * y + x) * this->m_num_channels],
+				       sizeof(float) * this->m_num_channels);
+			}
+		}
+	}
+
 	void writePixel(int x, int y, const float color[4]);
 	void addPixel(int x, int y, const float color[4]);
 	inline void readBilinear(float *result, float x, float y,
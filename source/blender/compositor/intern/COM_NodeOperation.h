@@ -121,6 +121,18 @@ private:
 	 */
 	const bNodeTree *m_btree;
 
+	/**
+	 * @brief reference to the editor node this operation was converted from, NULL for operations
+	 * added by the NodeOperationBuilder
+	 * @see ResultCache.determineKey
+	 */
+	const bNode *m_bnode;
+
+	/**
+	 * @brief index of this operation among the operations m_bnode was converted to
+	 */
+	int m_bnodeIndex;
+
 	/**
 	 * @brief set to truth when resolution for this operation is set
 	 */
@@ -166,6 +178,10 @@ public:
 	virtual int isSingleThreaded() { return false; }
 
 	void setbNodeTree(const bNodeTree *tree) { this->m_btree = tree; }
+
+	void setbNode(const bNode *node, int index) { this->m_bnode = node; this->m_bnodeIndex = index; }
+	const bNode *getbNode() const { return this->m_bnode; }
+	int getbNodeIndex() const { return this->m_bnodeIndex; }
 	virtual void initExecution();
 	
 	/**
@@ -45,6 +45,7 @@ extern "C" {
 NodeOperationBuilder::NodeOperationBuilder(const CompositorContext *context, bNodeTree *b_nodetree) :
     m_context(context),
     m_current_node(NULL),
+    m_current_node_operations(0),
     m_active_viewer(NULL)
 {
 	m_graph.from_bNodeTree(*context, b_nodetree);
@@ -63,6 +64,7 @@ void NodeOperationBuilder::convertToOperations(ExecutionSystem *system)
 		Node *node = (Node *)m_graph.nodes()[index];
 		
 		m_current_node = node;
+		m_current_node_operations = 0;
 		
 		DebugInfo::node_to_operations(node);
 		node->convertToOperations(converter, *m_context);
@@ -130,6 +132,8 @@ void NodeOperationBuilder::convertToOperations(ExecutionSystem *system)
 
 void NodeOperationBuilder::addOperation(NodeOperation *operation)
 {
+	if (m_current_node)
+		operation->setbNode(m_current_node->getbNode(), m_current_node_operations++);
 	m_operations.push_back(operation);
 }
 
@@ -87,6 +87,8 @@ private:
 	OutputSocketMap m_output_map;
 	
 	Node *m_current_node;
+	/** Number of operations added for the current node, used to identify them for the ResultCache */
+	int m_current_node_operations;
 	
 	/** Operation that will be writing to the viewer image
 	 *  Only one operation can occupy this place at a time,
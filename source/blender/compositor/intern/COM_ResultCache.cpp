@@ -0,0 +1,368 @@
+/*
+ * Copyright 2017, Blender Foundation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <cstring>
+#include <typeinfo>
+
+#include "COM_ResultCache.h"
+#include "COM_ReadBufferOperation.h"
+#include "COM_WriteBufferOperation.h"
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_hash_mm2a.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#include "DNA_color_types.h"
+#include "DNA_node_types.h"
+#include "DNA_scene_types.h"
+
+#include "BKE_node.h"
+}
+
+typedef struct CacheEntry {
+	MemoryBuffer *buffer;
+	size_t size;
+	/* value of g_clock when the entry was last stored or restored */
+	unsigned int lastUsed;
+} CacheEntry;
+
+typedef std::map<ResultCache::Key, CacheEntry> CacheEntries;
+typedef std::map<const ID *, unsigned int> IDGenerations;
+
+static CacheEntries g_entries;
+static size_t g_size = 0;
+static size_t g_maxSize = 0;
+static unsigned int g_clock = 0;
+
+/* Tagging IDs is done from the main thread while the compositor may be executing. */
+static ThreadMutex g_generationsMutex = BLI_MUTEX_INITIALIZER;
+static IDGenerations g_generations;
+
+/* Two 32 bit hashes with different seeds, to make collisions between keys unlikely. */
+class KeyHash {
+private:
+	BLI_HashMurmur2A m_low;
+	BLI_HashMurmur2A m_high;
+
+public:
+	KeyHash()
+	{
+		BLI_hash_mm2a_init(&m_low, 0);
+		BLI_hash_mm2a_init(&m_high, 0x9e3779b9);
+	}
+
+	void add(const void *data, size_t len)
+	{
+		BLI_hash_mm2a_add(&m_low, (const unsigned char *)data, len);
+		BLI_hash_mm2a_add(&m_high, (const unsigned char *)data, len);
+	}
+
+	void addInt(int value)
+	{
+		BLI_hash_mm2a_add_int(&m_low, value);
+		BLI_hash_mm2a_add_int(&m_high, value);
+	}
+
+	void addFloat(float value)
+	{
+		add(&value, sizeof(value));
+	}
+
+	void addString(const char *str)
+	{
+		add(str, strlen(str));
+	}
+
+	ResultCache::Key end()
+	{
+		ResultCache::Key key = ((ResultCache::Key)BLI_hash_mm2a_end(&m_high) << 32) | BLI_hash_mm2a_end(&m_low);
+		return (key == ResultCache::NO_KEY) ? 1 : key;
+	}
+};
+
+/* Only data of IDs which are tagged when they change can be cached. */
+static bool node_is_cacheable(const bNode *node)
+{
+	/* reads the camera of the scene */
+	if (node->type == CMP_NODE_DEFOCUS) {
+		return false;
+	}
+
+	if (node->id == NULL) {
+		return true;
+	}
+
+	/* Images and movie clips are not tagged when they are painted, reloaded or edited outside of a node
+	 * editor, or when the node is in a group, so their pixels are read again on every execution. */
+	switch (GS(node->id->name)) {
+		case ID_SCE:
+			return node->type == CMP_NODE_R_LAYERS;
+		default:
+			return false;
+	}
+}
+
+/* Hash the curves instead of the struct, the points are stored in a separate allocation. */
+static void hash_curvemapping(KeyHash &hash, const CurveMapping *cumap)
+{
+	hash.addInt(cumap->flag & (CUMA_DO_CLIP | CUMA_PREMULLED));
+	hash.addInt(cumap->preset);
+	hash.add(&cumap->clipr, sizeof(cumap->clipr));
+	hash.add(cumap->black, sizeof(cumap->black));
+	hash.add(cumap->white, sizeof(cumap->white));
+
+	for (int index = 0; index < CM_TOT; index++) {
+		const CurveMap *cuma = &cumap->cm[index];
+		hash.addInt(cuma->totpoint);
+		hash.addInt(cuma->flag);
+		hash.add(cuma->ext_in, sizeof(cuma->ext_in));
+		hash.add(cuma->ext_out, sizeof(cuma->ext_out));
+		for (int a = 0; a < cuma->totpoint; a++) {
+			hash.addFloat(cuma->curve[a].x);
+			hash.addFloat(cuma->curve[a].y);
+			hash.addInt(cuma->curve[a].flag & ~CUMA_SELECT);
+		}
+	}
+}
+
+static void hash_node(KeyHash &hash, const bNode *node)
+{
+	hash.addInt(node->type);
+	hash.addInt(node->flag & NODE_MUTED);
+	hash.addInt(node->custom1);
+	hash.addInt(node->custom2);
+	hash.addFloat(node->custom3);
+	hash.addFloat(node->custom4);
+
+	if (node->storage) {
+		if (node->typeinfo && STREQ(node->typeinfo->storagename, "CurveMapping")) {
+			hash_curvemapping(hash, (const CurveMapping *)node->storage);
+		}
+		else {
+			hash.add(node->storage, MEM_allocN_len(node->storage));
+		}
+	}
+
+	for (bNodeSocket *sock = (bNodeSocket *)node->inputs.first; sock; sock = sock->next) {
+		if (sock->default_value) {
+			hash.add(sock->default_value, MEM_allocN_len(sock->default_value));
+		}
+	}
+	for (bNodeSocket *sock = (bNodeSocket *)node->outputs.first; sock; sock = sock->next) {
+		if (sock->storage) {
+			hash.add(sock->storage, MEM_allocN_len(sock->storage));
+		}
+	}
+
+	if (node->id) {
+		hash.add(&node->id, sizeof(node->id));
+		hash.addString(node->id->name);
+
+		BLI_mutex_lock(&g_generationsMutex);
+		IDGenerations::const_iterator it = g_generations.find(node->id);
+		hash.addInt((it != g_generations.end()) ? it->second : 0);
+		BLI_mutex_unlock(&g_generationsMutex);
+	}
+}
+
+static void hash_context(KeyHash &hash, const CompositorContext &context)
+{
+	const RenderData *rd = context.getRenderData();
+
+	hash.addInt(context.getQuality());
+	hash.addInt(context.getFramenumber());
+	hash.addInt(rd->xsch);
+	hash.addInt(rd->ysch);
+	hash.addInt(rd->size);
+	hash.addFloat(rd->xasp);
+	hash.addFloat(rd->yasp);
+	hash.addInt(rd->scemode & (R_FULL_SAMPLE | R_MULTIVIEW));
+	if (context.getViewName()) {
+		hash.addString(context.getViewName());
+	}
+}
+
+ResultCache::Key ResultCache::determineKey(const CompositorContext &context, NodeOperation *operation, OperationKeys &keys)
+{
+	OperationKeys::const_iterator it = keys.find(operation);
+	if (it != keys.end()) {
+		return it->second;
+	}
+
+	/* store first, in case the key is not cacheable */
+	keys[operation] = NO_KEY;
+
+	const bNode *node = operation->getbNode();
+	if (node && !node_is_cacheable(node)) {
+		return NO_KEY;
+	}
+
+	KeyHash hash;
+	hash_context(hash, context);
+
+	hash.addString(typeid(*operation).name());
+	hash.addInt(operation->getWidth());
+	hash.addInt(operation->getHeight());
+	for (unsigned int index = 0; index < operation->getNumberOfOutputSockets(); index++) {
+		hash.addInt(operation->getOutputSocket(index)->getDataType());
+	}
+
+	if (node) {
+		hash_node(hash, node);
+		/* a node can be converted to multiple operations of the same type */
+		hash.addInt(operation->getbNodeIndex());
+	}
+
+	/* values of constants are set by the NodeOperationBuilder, they don't come from a node */
+	if (operation->isSetOperation()) {
+		float value[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+		operation->readSampled(value, 0.0f, 0.0f, COM_PS_NEAREST);
+		hash.add(value, sizeof(value));
+	}
+
+	if (operation->isReadBufferOperation()) {
+		ReadBufferOperation *readOperation = (ReadBufferOperation *)operation;
+		Key inputKey = determineKey(context, readOperation->getMemoryProxy()->getWriteBufferOperation(), keys);
+		if (inputKey == NO_KEY) {
+			return NO_KEY;
+		}
+		hash.add(&inputKey, sizeof(inputKey));
+	}
+
+	for (unsigned int index = 0; index < operation->getNumberOfInputSockets(); index++) {
+		NodeOperationInput *input = operation->getInputSocket(index);
+		hash.addInt(input->getResizeMode());
+
+		NodeOperationOutput *link = input->getLink();
+		if (link) {
+			Key inputKey = determineKey(context, &link->getOperation(), keys);
+			if (inputKey == NO_KEY) {
+				return NO_KEY;
+			}
+			hash.add(&inputKey, sizeof(inputKey));
+		}
+	}
+
+	Key key = hash.end();
+	keys[operation] = key;
+	return key;
+}
+
+static size_t buffer_size(MemoryBuffer *buffer)
+{
+	return sizeof(float) * buffer->getWidth() * buffer->getHeight() * buffer->get_num_channels();
+}
+
+static void free_entry(CacheEntries::iterator it)
+{
+	g_size -= it->second.size;
+	delete it->second.buffer;
+	g_entries.erase(it);
+}
+
+/* Free least recently used entries until size more bytes fit in the budget. */
+static void evict(size_t size)
+{
+	while (!g_entries.empty() && g_size + size > g_maxSize) {
+		CacheEntries::iterator oldest = g_entries.begin();
+		for (CacheEntries::iterator it = g_entries.begin(); it != g_entries.end(); ++it) {
+			if (it->second.lastUsed < oldest->second.lastUsed) {
+				oldest = it;
+			}
+		}
+		free_entry(oldest);
+	}
+}
+
+bool ResultCache::restore(Key key, MemoryBuffer *buffer)
+{
+	if (key == NO_KEY) {
+		return false;
+	}
+
+	CacheEntries::iterator it = g_entries.find(key);
+	if (it == g_entries.end()) {
+		return false;
+	}
+
+	MemoryBuffer *cached = it->second.buffer;
+	if (cached->getWidth() != buffer->getWidth() ||
+	    cached->getHeight() != buffer->getHeight() ||
+	    cached->get_num_channels() != buffer->get_num_channels())
+	{
+		return false;
+	}
+
+	buffer->copyContentFrom(cached);
+	it->second.lastUsed = ++g_clock;
+	return true;
+}
+
+void ResultCache::store(Key key, MemoryBuffer *buffer)
+{
+	if (key == NO_KEY) {
+		return;
+	}
+
+	CacheEntries::iterator it = g_entries.find(key);
+	if (it != g_entries.end()) {
+		it->second.lastUsed = ++g_clock;
+		return;
+	}
+
+	const size_t size = buffer_size(buffer);
+	if (size > g_maxSize) {
+		return;
+	}
+	evict(size);
+
+	CacheEntry entry;
+	entry.buffer = new MemoryBuffer(buffer->getDataType(), buffer->getRect());
+	entry.buffer->copyContentFrom(buffer);
+	entry.size = size;
+	entry.lastUsed = ++g_clock;
+	g_entries[key] = entry;
+	g_size += size;
+}
+
+void ResultCache::setMaxSize(size_t maxSize)
+{
+	g_maxSize = maxSize;
+	evict(0);
+}
+
+void ResultCache::tagID(const ID *id)
+{
+	BLI_mutex_lock(&g_generationsMutex);
+	g_generations[id]++;
+	BLI_mutex_unlock(&g_generationsMutex);
+}
+
+void ResultCache::deinitialize()
+{
+	while (!g_entries.empty()) {
+		free_entry(g_entries.begin());
+	}
+
+	BLI_mutex_lock(&g_generationsMutex);
+	g_generations.clear();
+	BLI_mutex_unlock(&g_generationsMutex);
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2017, Blender Foundation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _COM_ResultCache_h_
+#define _COM_ResultCache_h_
+
+#include <map>
+
+#include "COM_CompositorContext.h"
+#include "COM_MemoryBuffer.h"
+#include "COM_NodeOperation.h"
+
+struct ID;
+
+/**
+ * @brief cache of the MemoryProxy buffers between executions of the compositor
+ *
+ * After an execution the buffers written by WriteBufferOperations are kept, so the next execution
+ * can skip the ExecutionGroups of which nothing changed. Only the operations downstream of a changed
+ * node are executed again.
+ *
+ * A buffer is identified by a key, a hash of the operations that calculate it:
+ *  - the type, resolution and inputs of every operation
+ *  - the settings of the node an operation was converted from
+ *  - the render settings and frame of the context
+ *  - for render layers a counter that is increased when the scene is rendered
+ *
+ * The keys of the inputs are part of the key of an operation, so a change upstream changes the key of all
+ * downstream buffers. Results are evicted least recently used first when the memory budget is exceeded.
+ *
+ * @ingroup Memory
+ */
+class ResultCache {
+public:
+	typedef uint64_t Key;
+	typedef std::map<NodeOperation *, Key> OperationKeys;
+
+	/**
+	 * @brief key of results that can't be cached, e.g. because they depend on data that is not tracked.
+	 * @note operations reading from an uncached operation are not cached either.
+	 */
+	static const Key NO_KEY = 0;
+
+	/**
+	 * @brief determine the key of the result of an operation
+	 * @note must be called after the operations are initialized, constant operations are hashed by value
+	 * @param context the context of the execution
+	 * @param operation the operation to determine the key for
+	 * @param keys keys of the operations that were already determined, the result is added to it
+	 */
+	static Key determineKey(const CompositorContext &context, NodeOperation *operation, OperationKeys &keys);
+
+	/**
+	 * @brief copy a cached result into a buffer
+	 * @return true when a result for the key was found
+	 */
+	static bool restore(Key key, MemoryBuffer *buffer);
+
+	/**
+	 * @brief keep a copy of a buffer
+	 * @note results that don't fit in the memory budget are not stored
+	 */
+	static void store(Key key, MemoryBuffer *buffer);
+
+	/**
+	 * @brief set the memory budget of the cache in bytes, 0 disables the cache
+	 */
+	static void setMaxSize(size_t maxSize);
+
+	/**
+	 * @brief the data of an ID changed, cached results depending on it can't be used anymore
+	 * @note can be called from any thread
+	 */
+	static void tagID(const ID *id);
+
+	/**
+	 * @brief free all cached results
+	 */
+	static void deinitialize();
+};
+
+#endif
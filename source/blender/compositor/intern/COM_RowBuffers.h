@@ -0,0 +1,81 @@
+/*
+ * Copyright 2017, Blender Foundation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _COM_RowBuffers_h_
+#define _COM_RowBuffers_h_
+
+#include <vector>
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#  include "BLI_utildefines.h"
+}
+
+#include "COM_defines.h"
+
+using std::vector;
+
+/**
+ * @brief scratch rows for SocketReader.executeRow
+ *
+ * Operations need rows for the results of their inputs, which in turn need rows for their inputs.
+ * Keeping these on the stack can overflow the stacks of worker threads for long operation chains,
+ * so they are taken from this heap allocated pool instead. One is created per chunk, rows are
+ * allocated the first time a chain reaches a depth and reused for all other rows of the chunk.
+ *
+ * Rows are acquired and released in stack order, every executeRow releases the rows it acquired.
+ */
+class RowBuffers {
+private:
+	vector<float *> m_rows;
+	unsigned int m_used;
+
+public:
+	RowBuffers() : m_used(0) {}
+	~RowBuffers() {
+		for (unsigned int i = 0; i < this->m_rows.size(); i++) {
+			MEM_freeN(this->m_rows[i]);
+		}
+	}
+
+	/**
+	 * @brief get a row of COM_ROW_SIZE * COM_NUM_CHANNELS_COLOR floats
+	 */
+	float *acquire() {
+		if (this->m_used == this->m_rows.size()) {
+			this->m_rows.push_back((float *)MEM_mallocN(sizeof(float) * COM_ROW_SIZE * COM_NUM_CHANNELS_COLOR,
+			                                            "COM_RowBuffers"));
+		}
+		return this->m_rows[this->m_used++];
+	}
+
+	/**
+	 * @brief give back the last num acquired rows
+	 */
+	void release(unsigned int num) {
+		BLI_assert(num <= this->m_used);
+		this->m_used -= num;
+	}
+
+#ifdef WITH_CXX_GUARDEDALLOC
+	MEM_CXX_CLASS_ALLOC_FUNCS("COM:RowBuffers")
+#endif
+};
+
+#endif
@@ -24,6 +24,7 @@
 #define _COM_SocketReader_h
 #include "BLI_rect.h"
 #include "COM_defines.h"
+#include "COM_RowBuffers.h"
 
 #ifdef WITH_CXX_GUARDEDALLOC
 #include "MEM_guardedalloc.h"
@@ -95,6 +96,23 @@ protected:
 	                                  float /*x*/, float /*y*/,
 	                                  float /*dx*/[2], float /*dy*/[2]) {}
 
+	/**
+	 * @brief calculate a row of pixels
+	 * @note this method is called for non-complex, the default implementation calls executePixelSampled
+	 * for every pixel. Operations override it to calculate the row in one go, without a virtual call per pixel.
+	 * @param output array of num * COM_NUM_CHANNELS_COLOR floats to store the result, only the channels of the
+	 * output data type are written
+	 * @param x the x-coordinate of the first pixel of the row in image space
+	 * @param y the y-coordinate of the row in image space
+	 * @param num the number of pixels to calculate, at most COM_ROW_SIZE
+	 * @param rows scratch rows for the results of inputs, released again before returning
+	 */
+	virtual void executeRow(float *output, int x, int y, int num, RowBuffers * /*rows*/) {
+		for (int i = 0; i < num; i++) {
+			executePixelSampled(&output[i * COM_NUM_CHANNELS_COLOR], x + i, y, COM_PS_NEAREST);
+		}
+	}
+
 public:
 	inline void readSampled(float result[4], float x, float y, PixelSampler sampler) {
 		executePixelSampled(result, x, y, sampler);
@@ -102,6 +120,9 @@ public:
 	inline void read(float result[4], int x, int y, void *chunkData) {
 		executePixel(result, x, y, chunkData);
 	}
+	inline void readRow(float *output, int x, int y, int num, RowBuffers *rows) {
+		executeRow(output, x, y, num, rows);
+	}
 	inline void readFiltered(float result[4], float x, float y, float dx[2], float dy[2]) {
 		executePixelFiltered(result, x, y, dx, dy);
 	}
@@ -30,10 +30,12 @@
 #include "COM_OpenCLKernels.cl.h"
 #include "clew.h"
 #include "COM_WriteBufferOperation.h"
+#include "COM_Debug.h"
 
 #include "MEM_guardedalloc.h"
 
 #include "PIL_time.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 
 #include "BKE_global.h"
@@ -49,16 +51,18 @@
 #endif
 
 
-/// @brief list of all CPUDevices. for every hardware thread an instance of CPUDevice is created
+/// @brief list of all CPUDevices. for every thread of the task scheduler an instance of CPUDevice is created
 static vector<CPUDevice*> g_cpudevices;
 static ThreadLocal(CPUDevice *) g_thread_device;
 
 #if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
-/// @brief list of all thread for every CPUDevice in cpudevices a thread exists
-static ListBase g_cputhreads;
+/// @brief task scheduler running the cpu work, shared with the rest of blender unless the number of threads differs
+static TaskScheduler *g_task_scheduler = NULL;
+static bool g_task_scheduler_owned = false;
+static int g_num_cpu_threads = 0;
 static bool g_cpuInitialized = false;
 /// @brief all scheduled work for the cpu
-static ThreadQueue *g_cpuqueue;
+static TaskPool *g_cpupool;
 static ThreadQueue *g_gpuqueue;
 #ifdef COM_OPENCL_ENABLED
 static cl_context g_context;
@@ -76,17 +80,20 @@ static bool g_openclInitialized = false;
 #endif
 
 #if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
-void *WorkScheduler::thread_execute_cpu(void *data)
+void WorkScheduler::thread_execute_cpu(TaskPool *__restrict /*pool*/, void *taskdata, int threadid)
 {
-	CPUDevice *device = (CPUDevice *)data;
-	WorkPackage *work;
+	CPUDevice *device = g_cpudevices[threadid];
+	WorkPackage *work = (WorkPackage *)taskdata;
 	BLI_thread_local_set(g_thread_device, device);
-	while ((work = (WorkPackage *)BLI_thread_queue_pop(g_cpuqueue))) {
-		device->execute(work);
-		delete work;
-	}
-	
-	return NULL;
+
+	const double start_time = PIL_check_seconds_timer();
+	device->execute(work);
+	DebugInfo::execution_group_chunk_executed(work->getExecutionGroup(), PIL_check_seconds_timer() - start_time);
+}
+
+void WorkScheduler::thread_free_work(TaskPool *__restrict /*pool*/, void *taskdata, int /*threadid*/)
+{
+	delete (WorkPackage *)taskdata;
 }
 
 void *WorkScheduler::thread_execute_gpu(void *data)
@@ -105,10 +112,11 @@ void *WorkScheduler::thread_execute_gpu(void *data)
 
 
 
-void WorkScheduler::schedule(ExecutionGroup *group, int chunkNumber)
+void WorkScheduler::schedule(ExecutionGroup *group, int chunkNumber, TaskPriority priority)
 {
 	WorkPackage *package = new WorkPackage(group, chunkNumber);
 #if COM_CURRENT_THREADING_MODEL == COM_TM_NOTHREAD
+	(void)priority;
 	CPUDevice device(0);
 	device.execute(package);
 	delete package;
@@ -118,10 +126,10 @@ void WorkScheduler::schedule(ExecutionGroup *group, int chunkNumber)
 		BLI_thread_queue_push(g_gpuqueue, package);
 	}
 	else {
-		BLI_thread_queue_push(g_cpuqueue, package);
+		BLI_task_pool_push_ex(g_cpupool, thread_execute_cpu, package, true, thread_free_work, priority);
 	}
 #else
-	BLI_thread_queue_push(g_cpuqueue, package);
+	BLI_task_pool_push_ex(g_cpupool, thread_execute_cpu, package, true, thread_free_work, priority);
 #endif
 #endif
 }
@@ -129,15 +137,10 @@ void WorkScheduler::schedule(ExecutionGroup *group, int chunkNumber)
 void WorkScheduler::start(CompositorContext &context)
 {
 #if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
-	unsigned int index;
-	g_cpuqueue = BLI_thread_queue_init();
-	BLI_init_threads(&g_cputhreads, thread_execute_cpu, g_cpudevices.size());
-	for (index = 0; index < g_cpudevices.size(); index++) {
-		Device *device = g_cpudevices[index];
-		BLI_insert_thread(&g_cputhreads, device);
-	}
+	g_cpupool = BLI_task_pool_create(g_task_scheduler, NULL);
 #ifdef COM_OPENCL_ENABLED
 	if (context.getHasActiveOpenCLDevices()) {
+		unsigned int index;
 		g_gpuqueue = BLI_thread_queue_init();
 		BLI_init_threads(&g_gputhreads, thread_execute_gpu, g_gpudevices.size());
 		for (index = 0; index < g_gpudevices.size(); index++) {
@@ -158,23 +161,17 @@ void WorkScheduler::finish()
 #ifdef COM_OPENCL_ENABLED
 	if (g_openclActive) {
 		BLI_thread_queue_wait_finish(g_gpuqueue);
-		BLI_thread_queue_wait_finish(g_cpuqueue);
-	}
-	else {
-		BLI_thread_queue_wait_finish(g_cpuqueue);
 	}
-#else
-	BLI_thread_queue_wait_finish(cpuqueue);
 #endif
+	/* the calling thread works on the cpu chunks as well */
+	BLI_task_pool_work_and_wait(g_cpupool);
 #endif
 }
 void WorkScheduler::stop()
 {
 #if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
-	BLI_thread_queue_nowait(g_cpuqueue);
-	BLI_end_threads(&g_cputhreads);
-	BLI_thread_queue_free(g_cpuqueue);
-	g_cpuqueue = NULL;
+	BLI_task_pool_free(g_cpupool);
+	g_cpupool = NULL;
 #ifdef COM_OPENCL_ENABLED
 	if (g_openclActive) {
 		BLI_thread_queue_nowait(g_gpuqueue);
@@ -212,30 +209,34 @@ static void CL_CALLBACK clContextError(const char *errinfo,
 void WorkScheduler::initialize(bool use_opencl, int num_cpu_threads)
 {
 #if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+	/* the scheduler shared with the rest of blender is used, so the compositor doesn't
+	 * compete for cores with other work. only a fixed number of render threads that
+	 * differs from the system threads needs a separate scheduler. */
 	/* deinitialize if number of threads doesn't match */
-	if (g_cpudevices.size() != num_cpu_threads) {
-		Device *device;
+	if (g_cpuInitialized && g_num_cpu_threads != num_cpu_threads) {
+		deinitialize_cpu();
+	}
 
-		while (g_cpudevices.size() > 0) {
-			device = g_cpudevices.back();
-			g_cpudevices.pop_back();
-			device->deinitialize();
-			delete device;
+	/* initialize CPU devices, one for every thread of the task scheduler */
+	if (!g_cpuInitialized) {
+		TaskScheduler *task_scheduler = BLI_task_scheduler_get();
+		if (BLI_task_scheduler_num_threads(task_scheduler) != num_cpu_threads) {
+			g_task_scheduler = BLI_task_scheduler_create(num_cpu_threads);
+			g_task_scheduler_owned = true;
 		}
-		if (g_cpuInitialized) {
-			BLI_thread_local_delete(g_thread_device);
+		else {
+			g_task_scheduler = task_scheduler;
+			g_task_scheduler_owned = false;
 		}
-		g_cpuInitialized = false;
-	}
 
-	/* initialize CPU threads */
-	if (!g_cpuInitialized) {
-		for (int index = 0; index < num_cpu_threads; index++) {
+		const int num_threads = BLI_task_scheduler_num_threads(g_task_scheduler);
+		for (int index = 0; index < num_threads; index++) {
 			CPUDevice *device = new CPUDevice(index);
 			device->initialize();
 			g_cpudevices.push_back(device);
 		}
 		BLI_thread_local_create(g_thread_device);
+		g_num_cpu_threads = num_cpu_threads;
 		g_cpuInitialized = true;
 	}
 
@@ -309,20 +310,33 @@ void WorkScheduler::initialize(bool use_opencl, int num_cpu_threads)
 #endif
 }
 
+#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+void WorkScheduler::deinitialize_cpu()
+{
+	Device *device;
+	while (g_cpudevices.size() > 0) {
+		device = g_cpudevices.back();
+		g_cpudevices.pop_back();
+		device->deinitialize();
+		delete device;
+	}
+	BLI_thread_local_delete(g_thread_device);
+
+	if (g_task_scheduler_owned) {
+		BLI_task_scheduler_free(g_task_scheduler);
+	}
+	g_task_scheduler = NULL;
+	g_task_scheduler_owned = false;
+	g_cpuInitialized = false;
+}
+#endif
+
 void WorkScheduler::deinitialize()
 {
 #if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
-	/* deinitialize CPU threads */
+	/* deinitialize CPU devices */
 	if (g_cpuInitialized) {
-		Device *device;
-		while (g_cpudevices.size() > 0) {
-			device = g_cpudevices.back();
-			g_cpudevices.pop_back();
-			device->deinitialize();
-			delete device;
-		}
-		BLI_thread_local_delete(g_thread_device);
-		g_cpuInitialized = false;
+		deinitialize_cpu();
 	}
 
 #ifdef COM_OPENCL_ENABLED
@@ -25,6 +25,7 @@
 
 #include "COM_ExecutionGroup.h"
 extern "C" {
+#  include "BLI_task.h"
 #  include "BLI_threads.h"
 }
 #include "COM_WorkPackage.h"
@@ -43,10 +44,20 @@ class WorkScheduler {
 	static bool isStopping();
 
 	/**
-	 * @brief main thread loop for cpudevices
-	 * inside this loop new work is queried and being executed
+	 * @brief task function for cpudevices
+	 * executes a WorkPackage on the CPUDevice of the task scheduler thread
+	 */
+	static void thread_execute_cpu(TaskPool *__restrict pool, void *taskdata, int threadid);
+
+	/**
+	 * @brief free a WorkPackage after its task was executed or canceled
+	 */
+	static void thread_free_work(TaskPool *__restrict pool, void *taskdata, int threadid);
+
+	/**
+	 * @brief free the CPUDevices and the task scheduler if it was created by the WorkScheduler
 	 */
-	static void *thread_execute_cpu(void *data);
+	static void deinitialize_cpu();
 
 	/**
 	 * @brief main thread loop for gpudevices
@@ -63,8 +74,9 @@ public:
 	 * @see ExecutionGroup.execute
 	 * @param group the execution group
 	 * @param chunkNumber the number of the chunk in the group to be executed
+	 * @param priority high priority chunks are executed before other work of the task scheduler
 	 */
-	static void schedule(ExecutionGroup *group, int chunkNumber);
+	static void schedule(ExecutionGroup *group, int chunkNumber, TaskPriority priority);
 
 	/**
 	 * @brief initialize the WorkScheduler
@@ -72,7 +84,7 @@ public:
 	 * during initialization the mutexes are initialized.
 	 * there are two mutexes (for every device type one)
 	 * After mutex initialization the system is queried in order to count the number of CPUDevices and GPUDevices to be created.
-	 * For every hardware thread a CPUDevice and for every OpenCL GPU device a OpenCLDevice is created.
+	 * For every thread of the task scheduler a CPUDevice and for every OpenCL GPU device a OpenCLDevice is created.
 	 * these devices are stored in a separate list (cpudevices & gpudevices)
 	 *
 	 * This function can be called multiple times to lazily initialize OpenCL.
@@ -87,15 +99,15 @@ public:
 
 	/**
 	 * @brief Start the execution
-	 * this methods will start the WorkScheduler. Inside this method all threads are initialized.
-	 * for every device a thread is created.
+	 * this methods will start the WorkScheduler. A task pool is created for the CPUDevices,
+	 * for every OpenCL device a thread is created.
 	 * @see initialize Initialization and query of the number of devices
 	 */
 	static void start(CompositorContext &context);
 
 	/**
 	 * @brief stop the execution
-	 * All created thread by the start method are destroyed.
+	 * The task pool and all threads created by the start method are destroyed.
 	 * @see start
 	 */
 	static void stop();
@@ -33,6 +33,7 @@ extern "C" {
 #include "COM_compositor.h"
 #include "COM_ExecutionSystem.h"
 #include "COM_WorkScheduler.h"
+#include "COM_ResultCache.h"
 #include "clew.h"
 #include "COM_MovieDistortionOperation.h"
 
@@ -84,6 +85,9 @@ void COM_execute(RenderData *rd, Scene *scene, bNodeTree *editingtree, int rende
 	bool use_opencl = (editingtree->flag & NTREE_COM_OPENCL) != 0;
 	WorkScheduler::initialize(use_opencl, BKE_render_num_threads(rd));
 
+	/* cache_size is in megabytes */
+	ResultCache::setMaxSize((size_t)editingtree->cache_size * 1024 * 1024);
+
 	/* set progress bar to 0% and status to init compositing */
 	editingtree->progress(editingtree->prh, 0.0);
 	editingtree->stats_draw(editingtree->sdh, IFACE_("Compositing"));
@@ -115,9 +119,24 @@ void COM_deinitialize()
 {
 	if (is_compositorMutex_init) {
 		BLI_mutex_lock(&s_compositorMutex);
+		ResultCache::deinitialize();
 		WorkScheduler::deinitialize();
 		is_compositorMutex_init = false;
 		BLI_mutex_unlock(&s_compositorMutex);
 		BLI_mutex_end(&s_compositorMutex);
 	}
 }
+
+void COM_clearCaches()
+{
+	if (is_compositorMutex_init) {
+		BLI_mutex_lock(&s_compositorMutex);
+		ResultCache::deinitialize();
+		BLI_mutex_unlock(&s_compositorMutex);
+	}
+}
+
+void COM_tagChangedID(ID *id)
+{
+	ResultCache::tagID(id);
+}
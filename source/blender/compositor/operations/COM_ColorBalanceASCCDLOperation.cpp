@@ -68,6 +68,29 @@ void ColorBalanceASCCDLOperation::executePixelSampled(float output[4], float x,
 
 }
 
+void ColorBalanceASCCDLOperation::executeRow(float *output, int x, int y, int num, RowBuffers *rows)
+{
+	float *inputColor = rows->acquire();
+	float *value = rows->acquire();
+
+	this->m_inputValueOperation->readRow(value, x, y, num, rows);
+	this->m_inputColorOperation->readRow(inputColor, x, y, num, rows);
+
+	for (int i = 0; i < num; i++) {
+		const float *in = &inputColor[i * COM_NUM_CHANNELS_COLOR];
+		float *out = &output[i * COM_NUM_CHANNELS_COLOR];
+		const float fac = min(1.0f, value[i * COM_NUM_CHANNELS_COLOR]);
+		const float mfac = 1.0f - fac;
+
+		out[0] = mfac * in[0] + fac * colorbalance_cdl(in[0], this->m_offset[0], this->m_power[0], this->m_slope[0]);
+		out[1] = mfac * in[1] + fac * colorbalance_cdl(in[1], this->m_offset[1], this->m_power[1], this->m_slope[1]);
+		out[2] = mfac * in[2] + fac * colorbalance_cdl(in[2], this->m_offset[2], this->m_power[2], this->m_slope[2]);
+		out[3] = in[3];
+	}
+
+	rows->release(2);
+}
+
 void ColorBalanceASCCDLOperation::deinitExecution()
 {
 	this->m_inputValueOperation = NULL;
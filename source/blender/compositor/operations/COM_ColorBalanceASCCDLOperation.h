@@ -50,6 +50,7 @@ public:
 	 * the inner loop of this program
 	 */
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void executeRow(float *output, int x, int y, int num, RowBuffers *rows);
 	
 	/**
 	 * Initialize the execution
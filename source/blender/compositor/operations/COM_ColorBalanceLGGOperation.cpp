@@ -73,6 +73,29 @@ void ColorBalanceLGGOperation::executePixelSampled(float output[4], float x, flo
 
 }
 
+void ColorBalanceLGGOperation::executeRow(float *output, int x, int y, int num, RowBuffers *rows)
+{
+	float *inputColor = rows->acquire();
+	float *value = rows->acquire();
+
+	this->m_inputValueOperation->readRow(value, x, y, num, rows);
+	this->m_inputColorOperation->readRow(inputColor, x, y, num, rows);
+
+	for (int i = 0; i < num; i++) {
+		const float *in = &inputColor[i * COM_NUM_CHANNELS_COLOR];
+		float *out = &output[i * COM_NUM_CHANNELS_COLOR];
+		const float fac = min(1.0f, value[i * COM_NUM_CHANNELS_COLOR]);
+		const float mfac = 1.0f - fac;
+
+		out[0] = mfac * in[0] + fac * colorbalance_lgg(in[0], this->m_lift[0], this->m_gamma_inv[0], this->m_gain[0]);
+		out[1] = mfac * in[1] + fac * colorbalance_lgg(in[1], this->m_lift[1], this->m_gamma_inv[1], this->m_gain[1]);
+		out[2] = mfac * in[2] + fac * colorbalance_lgg(in[2], this->m_lift[2], this->m_gamma_inv[2], this->m_gain[2]);
+		out[3] = in[3];
+	}
+
+	rows->release(2);
+}
+
 void ColorBalanceLGGOperation::deinitExecution()
 {
 	this->m_inputValueOperation = NULL;
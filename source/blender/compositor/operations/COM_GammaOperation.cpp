@@ -53,6 +53,28 @@ void GammaOperation::executePixelSampled(float output[4], float x, float y, Pixe
 	output[3] = inputValue[3];
 }
 
+void GammaOperation::executeRow(float *output, int x, int y, int num, RowBuffers *rows)
+{
+	float *inputValue = rows->acquire();
+	float *inputGamma = rows->acquire();
+
+	this->m_inputProgram->readRow(inputValue, x, y, num, rows);
+	this->m_inputGammaProgram->readRow(inputGamma, x, y, num, rows);
+
+	for (int i = 0; i < num; i++) {
+		const float *in = &inputValue[i * COM_NUM_CHANNELS_COLOR];
+		float *out = &output[i * COM_NUM_CHANNELS_COLOR];
+		const float gamma = inputGamma[i * COM_NUM_CHANNELS_COLOR];
+		/* check for negative to avoid nan's */
+		out[0] = in[0] > 0.0f ? powf(in[0], gamma) : in[0];
+		out[1] = in[1] > 0.0f ? powf(in[1], gamma) : in[1];
+		out[2] = in[2] > 0.0f ? powf(in[2], gamma) : in[2];
+		out[3] = in[3];
+	}
+
+	rows->release(2);
+}
+
 void GammaOperation::deinitExecution()
 {
 	this->m_inputProgram = NULL;
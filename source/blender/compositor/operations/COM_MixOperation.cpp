@@ -26,6 +26,17 @@ extern "C" {
 #  include "BLI_math.h"
 }
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+
+/* Mix operations only change the color channels, alpha is taken from the first color. */
+static inline __m128 mix_sse_keep_alpha(__m128 result, __m128 color1)
+{
+	const __m128 mask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+	return _mm_or_ps(_mm_and_ps(mask, result), _mm_andnot_ps(mask, color1));
+}
+#endif
+
 /* ******** Mix Base Operation ******** */
 
 MixBaseOperation::MixBaseOperation() : NodeOperation()
@@ -69,6 +80,24 @@ void MixBaseOperation::executePixelSampled(float output[4], float x, float y, Pi
 	output[3] = inputColor1[3];
 }
 
+void MixBaseOperation::readRowInputs(float *value, float *color1, float *color2, int x, int y, int num,
+                                     RowBuffers *rows)
+{
+	this->m_inputValueOperation->readRow(value, x, y, num, rows);
+	this->m_inputColor1Operation->readRow(color1, x, y, num, rows);
+	this->m_inputColor2Operation->readRow(color2, x, y, num, rows);
+
+	/* pack the factors, the first channel of every pixel */
+	for (int i = 0; i < num; i++) {
+		value[i] = value[i * COM_NUM_CHANNELS_COLOR];
+	}
+	if (this->useValueAlphaMultiply()) {
+		for (int i = 0; i < num; i++) {
+			value[i] *= color2[i * COM_NUM_CHANNELS_COLOR + 3];
+		}
+	}
+}
+
 void MixBaseOperation::determineResolution(unsigned int resolution[2], unsigned int preferredResolution[2])
 {
 	NodeOperationInput *socket;
@@ -129,6 +158,36 @@ void MixAddOperation::executePixelSampled(float output[4], float x, float y, Pix
 	clampIfNeeded(output);
 }
 
+void MixAddOperation::executeRow(float *output, int x, int y, int num, RowBuffers *rows)
+{
+	float *value = rows->acquire();
+	float *color1 = rows->acquire();
+	float *color2 = rows->acquire();
+
+	readRowInputs(value, color1, color2, x, y, num, rows);
+
+	for (int i = 0; i < num; i++) {
+		const int offset = i * COM_NUM_CHANNELS_COLOR;
+#ifdef __SSE2__
+		const __m128 c1 = _mm_loadu_ps(&color1[offset]);
+		const __m128 c2 = _mm_loadu_ps(&color2[offset]);
+		const __m128 v = _mm_set1_ps(value[i]);
+		_mm_storeu_ps(&output[offset], mix_sse_keep_alpha(_mm_add_ps(c1, _mm_mul_ps(v, c2)), c1));
+#else
+		const float *c1 = &color1[offset];
+		const float *c2 = &color2[offset];
+		output[offset + 0] = c1[0] + value[i] * c2[0];
+		output[offset + 1] = c1[1] + value[i] * c2[1];
+		output[offset + 2] = c1[2] + value[i] * c2[2];
+		output[offset + 3] = c1[3];
+#endif
+	}
+
+	rows->release(3);
+
+	clampRowIfNeeded(output, num);
+}
+
 /* ******** Mix Blend Operation ******** */
 
 MixBlendOperation::MixBlendOperation() : MixBaseOperation()
@@ -160,6 +219,38 @@ void MixBlendOperation::executePixelSampled(float output[4], float x, float y, P
 	clampIfNeeded(output);
 }
 
+void MixBlendOperation::executeRow(float *output, int x, int y, int num, RowBuffers *rows)
+{
+	float *value = rows->acquire();
+	float *color1 = rows->acquire();
+	float *color2 = rows->acquire();
+
+	readRowInputs(value, color1, color2, x, y, num, rows);
+
+	for (int i = 0; i < num; i++) {
+		const int offset = i * COM_NUM_CHANNELS_COLOR;
+#ifdef __SSE2__
+		const __m128 c1 = _mm_loadu_ps(&color1[offset]);
+		const __m128 c2 = _mm_loadu_ps(&color2[offset]);
+		const __m128 v = _mm_set1_ps(value[i]);
+		const __m128 vm = _mm_set1_ps(1.0f - value[i]);
+		_mm_storeu_ps(&output[offset], mix_sse_keep_alpha(_mm_add_ps(_mm_mul_ps(vm, c1), _mm_mul_ps(v, c2)), c1));
+#else
+		const float *c1 = &color1[offset];
+		const float *c2 = &color2[offset];
+		const float valuem = 1.0f - value[i];
+		output[offset + 0] = valuem * c1[0] + value[i] * c2[0];
+		output[offset + 1] = valuem * c1[1] + value[i] * c2[1];
+		output[offset + 2] = valuem * c1[2] + value[i] * c2[2];
+		output[offset + 3] = c1[3];
+#endif
+	}
+
+	rows->release(3);
+
+	clampRowIfNeeded(output, num);
+}
+
 /* ******** Mix Burn Operation ******** */
 
 MixBurnOperation::MixBurnOperation() : MixBaseOperation()
@@ -623,6 +714,38 @@ void MixMultiplyOperation::executePixelSampled(float output[4], float x, float y
 	clampIfNeeded(output);
 }
 
+void MixMultiplyOperation::executeRow(float *output, int x, int y, int num, RowBuffers *rows)
+{
+	float *value = rows->acquire();
+	float *color1 = rows->acquire();
+	float *color2 = rows->acquire();
+
+	readRowInputs(value, color1, color2, x, y, num, rows);
+
+	for (int i = 0; i < num; i++) {
+		const int offset = i * COM_NUM_CHANNELS_COLOR;
+#ifdef __SSE2__
+		const __m128 c1 = _mm_loadu_ps(&color1[offset]);
+		const __m128 c2 = _mm_loadu_ps(&color2[offset]);
+		const __m128 v = _mm_set1_ps(value[i]);
+		const __m128 vm = _mm_set1_ps(1.0f - value[i]);
+		_mm_storeu_ps(&output[offset], mix_sse_keep_alpha(_mm_mul_ps(c1, _mm_add_ps(vm, _mm_mul_ps(v, c2))), c1));
+#else
+		const float *c1 = &color1[offset];
+		const float *c2 = &color2[offset];
+		const float valuem = 1.0f - value[i];
+		output[offset + 0] = c1[0] * (valuem + value[i] * c2[0]);
+		output[offset + 1] = c1[1] * (valuem + value[i] * c2[1]);
+		output[offset + 2] = c1[2] * (valuem + value[i] * c2[2]);
+		output[offset + 3] = c1[3];
+#endif
+	}
+
+	rows->release(3);
+
+	clampRowIfNeeded(output, num);
+}
+
 /* ******** Mix Ovelray Operation ******** */
 
 MixOverlayOperation::MixOverlayOperation() : MixBaseOperation()
@@ -806,6 +929,36 @@ void MixSubtractOperation::executePixelSampled(float output[4], float x, float y
 	clampIfNeeded(output);
 }
 
+void MixSubtractOperation::executeRow(float *output, int x, int y, int num, RowBuffers *rows)
+{
+	float *value = rows->acquire();
+	float *color1 = rows->acquire();
+	float *color2 = rows->acquire();
+
+	readRowInputs(value, color1, color2, x, y, num, rows);
+
+	for (int i = 0; i < num; i++) {
+		const int offset = i * COM_NUM_CHANNELS_COLOR;
+#ifdef __SSE2__
+		const __m128 c1 = _mm_loadu_ps(&color1[offset]);
+		const __m128 c2 = _mm_loadu_ps(&color2[offset]);
+		const __m128 v = _mm_set1_ps(value[i]);
+		_mm_storeu_ps(&output[offset], mix_sse_keep_alpha(_mm_sub_ps(c1, _mm_mul_ps(v, c2)), c1));
+#else
+		const float *c1 = &color1[offset];
+		const float *c2 = &color2[offset];
+		output[offset + 0] = c1[0] - value[i] * c2[0];
+		output[offset + 1] = c1[1] - value[i] * c2[1];
+		output[offset + 2] = c1[2] - value[i] * c2[2];
+		output[offset + 3] = c1[3];
+#endif
+	}
+
+	rows->release(3);
+
+	clampRowIfNeeded(output, num);
+}
+
 /* ******** Mix Value Operation ******** */
 
 MixValueOperation::MixValueOperation() : MixBaseOperation()
@@ -50,6 +50,23 @@ protected:
 			CLAMP(color[3], 0.0f, 1.0f);
 		}
 	}
+
+	inline void clampRowIfNeeded(float *output, int num)
+	{
+		if (m_useClamp) {
+			for (int i = 0; i < num; i++) {
+				clampIfNeeded(&output[i * COM_NUM_CHANNELS_COLOR]);
+			}
+		}
+	}
+
+	/**
+	 * @brief read the inputs of a row for executeRow
+	 * @param value receives one factor per pixel, multiplied by the alpha of color2 when enabled
+	 * @param color1 receives num * COM_NUM_CHANNELS_COLOR floats
+	 * @param color2 receives num * COM_NUM_CHANNELS_COLOR floats
+	 */
+	void readRowInputs(float *value, float *color1, float *color2, int x, int y, int num, RowBuffers *rows);
 	
 public:
 	/**
@@ -84,12 +101,14 @@ class MixAddOperation : public MixBaseOperation {
 public:
 	MixAddOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void executeRow(float *output, int x, int y, int num, RowBuffers *rows);
 };
 
 class MixBlendOperation : public MixBaseOperation {
 public:
 	MixBlendOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void executeRow(float *output, int x, int y, int num, RowBuffers *rows);
 };
 
 class MixBurnOperation : public MixBaseOperation {
@@ -156,6 +175,7 @@ class MixMultiplyOperation : public MixBaseOperation {
 public:
 	MixMultiplyOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void executeRow(float *output, int x, int y, int num, RowBuffers *rows);
 };
 
 class MixOverlayOperation : public MixBaseOperation {
@@ -186,6 +206,7 @@ class MixSubtractOperation : public MixBaseOperation {
 public:
 	MixSubtractOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void executeRow(float *output, int x, int y, int num, RowBuffers *rows);
 };
 
 class MixValueOperation : public MixBaseOperation {
@@ -102,6 +102,19 @@ void ReadBufferOperation::executePixelFiltered(float output[4], float x, float y
 	}
 }
 
+void ReadBufferOperation::executeRow(float *output, int x, int y, int num, RowBuffers * /*rows*/)
+{
+	if (m_single_value) {
+		/* write buffer has a single value stored at (0,0) */
+		for (int i = 0; i < num; i++) {
+			m_buffer->read(&output[i * COM_NUM_CHANNELS_COLOR], 0, 0);
+		}
+	}
+	else {
+		m_buffer->readRow(output, x, y, num);
+	}
+}
+
 bool ReadBufferOperation::determineDependingAreaOfInterest(rcti *input, ReadBufferOperation *readOperation, rcti *output)
 {
 	if (this == readOperation) {
@@ -44,6 +44,7 @@ public:
 	void executePixelExtend(float output[4], float x, float y, PixelSampler sampler,
 	                        MemoryBufferExtend extend_x, MemoryBufferExtend extend_y);
 	void executePixelFiltered(float output[4], float x, float y, float dx[2], float dy[2]);
+	void executeRow(float *output, int x, int y, int num, RowBuffers *rows);
 	const bool isReadBufferOperation() const { return true; }
 	void setOffset(unsigned int offset) { this->m_offset = offset; }
 	unsigned int getOffset() const { return this->m_offset; }
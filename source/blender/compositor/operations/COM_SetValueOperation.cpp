@@ -34,6 +34,13 @@ void SetValueOperation::executePixelSampled(float output[4],
 	output[0] = this->m_value;
 }
 
+void SetValueOperation::executeRow(float *output, int /*x*/, int /*y*/, int num, RowBuffers * /*rows*/)
+{
+	for (int i = 0; i < num; i++) {
+		output[i * COM_NUM_CHANNELS_COLOR] = this->m_value;
+	}
+}
+
 void SetValueOperation::determineResolution(unsigned int resolution[2], unsigned int preferredResolution[2])
 {
 	resolution[0] = preferredResolution[0];
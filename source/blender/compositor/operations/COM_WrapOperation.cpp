@@ -74,6 +74,13 @@ void WrapOperation::executePixelSampled(float output[4], float x, float y, Pixel
 	executePixelExtend(output, nx, ny, sampler, extend_x, extend_y);
 }
 
+void WrapOperation::executeRow(float *output, int x, int y, int num, RowBuffers * /*rows*/)
+{
+	for (int i = 0; i < num; i++) {
+		executePixelSampled(&output[i * COM_NUM_CHANNELS_COLOR], x + i, y, COM_PS_NEAREST);
+	}
+}
+
 bool WrapOperation::determineDependingAreaOfInterest(rcti *input, ReadBufferOperation *readOperation, rcti *output)
 {
 	rcti newInput;
@@ -32,6 +32,8 @@ public:
 	WrapOperation(DataType datetype);
 	bool determineDependingAreaOfInterest(rcti *input, ReadBufferOperation *readOperation, rcti *output);
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	/* wrapping is done per pixel, not with the direct buffer read of ReadBufferOperation */
+	void executeRow(float *output, int x, int y, int num, RowBuffers *rows);
 
 	void setWrapping(int wrapping_type);
 	float getWrappedOriginalXPos(float x);
@@ -96,11 +96,25 @@ void WriteBufferOperation::executeRegion(rcti *rect, unsigned int /*tileNumber*/
 		int x;
 		int y;
 		bool breaked = false;
+		/* scratch rows of the whole chain of operations, allocated once per chunk */
+		RowBuffers rows;
+		float *row = rows.acquire();
 		for (y = y1; y < y2 && (!breaked); y++) {
 			int offset4 = (y * memoryBuffer->getWidth() + x1) * num_channels;
-			for (x = x1; x < x2; x++) {
-				this->m_input->readSampled(&(buffer[offset4]), x, y, COM_PS_NEAREST);
-				offset4 += num_channels;
+			for (x = x1; x < x2; x += COM_ROW_SIZE) {
+				const int num = min_ii(x2 - x, COM_ROW_SIZE);
+				if (num_channels == COM_NUM_CHANNELS_COLOR) {
+					/* rows have the same layout as the buffer */
+					this->m_input->readRow(&(buffer[offset4]), x, y, num, &rows);
+				}
+				else {
+					this->m_input->readRow(row, x, y, num, &rows);
+					for (int i = 0; i < num; i++) {
+						memcpy(&(buffer[offset4 + i * num_channels]), &row[i * COM_NUM_CHANNELS_COLOR],
+						       sizeof(float) * num_channels);
+					}
+				}
+				offset4 += num * num_channels;
 			}
 			if (isBreaked()) {
 				breaked = true;
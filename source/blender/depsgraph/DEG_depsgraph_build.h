@@ -66,6 +66,11 @@ void DEG_graph_tag_relations_update(struct Depsgraph *graph);
 /* Tag all relations in the database for update.*/
 void DEG_relations_tag_update(struct Main *bmain);
 
+/* Tag relations of the given ID for update. Unlike the functions above only
+ * this ID gets its relations rebuilt, when that is possible.
+ */
+void DEG_id_relations_tag_update(struct Main *bmain, struct ID *id);
+
 /* Create new graph if didn't exist yet,
  * or update relations if graph was tagged for update.
  */
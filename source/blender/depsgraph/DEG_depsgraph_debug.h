@@ -53,6 +53,19 @@ void DEG_stats_simple(const struct Depsgraph *graph,
 
 void DEG_debug_graphviz(const struct Depsgraph *graph, FILE *stream, const char *label, bool show_eval);
 
+/* ************************************************ */
+/* Evaluation Profiling */
+
+/* Write timing of the last evaluation done with G_DEBUG_DEPSGRAPH_PROFILE set
+ * in Chrome trace event format, for chrome://tracing.
+ * Returns false when no evaluation was profiled yet.
+ */
+bool DEG_debug_profile_trace(const struct Depsgraph *graph, FILE *stream);
+/* Write critical path and timing per thread of the last profiled evaluation.
+ * Returns false when no evaluation was profiled yet.
+ */
+bool DEG_debug_profile_report(const struct Depsgraph *graph, FILE *stream);
+
 /* ************************************************ */
 
 /* Compare two dependency graphs. */
@@ -63,6 +76,10 @@ bool DEG_debug_compare(const struct Depsgraph *graph1,
 bool DEG_debug_scene_relations_validate(struct Main *bmain,
                                         struct Scene *scene);
 
+/* Check that incrementally updated relations match a full rebuild. */
+bool DEG_debug_incremental_update_validate(struct Main *bmain,
+                                           struct Scene *scene);
+
 
 /* Perform consistency check on the graph. */
 bool DEG_debug_consistency_check(struct Depsgraph *graph);
@@ -37,6 +37,9 @@
 #include "BLI_utildefines.h"
 #include "BLI_ghash.h"
 #include "BLI_stack.h"
+#include "BLI_task.h"
+
+#include "BKE_global.h"
 
 #include "intern/depsgraph.h"
 #include "intern/depsgraph_types.h"
@@ -46,7 +49,9 @@
 
 #include "util/deg_util_foreach.h"
 
+#include <algorithm>
 #include <cstdio>
+#include <cstring>
 
 namespace DEG {
 
@@ -117,6 +122,68 @@ void deg_graph_build_flush_layers(Depsgraph *graph)
 	BLI_stack_free(stack);
 }
 
+void deg_graph_build_flush_customdata_mask(Depsgraph *graph)
+{
+	foreach (OperationDepsNode *node, graph->operations) {
+		IDDepsNode *id_node = node->owner->owner;
+		ID *id = id_node->id;
+		if (GS(id->name) == ID_OB) {
+			Object *object = (Object *)id;
+			object->customdata_mask |= node->customdata_mask;
+		}
+	}
+}
+
+/* Nodes store their index in the operations list in the done field while
+ * the relations are sorted, the time source goes first.
+ */
+static bool relation_from_less(const DepsRelation *a, const DepsRelation *b)
+{
+	if (a->from->done != b->from->done) {
+		return a->from->done < b->from->done;
+	}
+	return strcmp(a->name, b->name) < 0;
+}
+
+static bool relation_to_less(const DepsRelation *a, const DepsRelation *b)
+{
+	if (a->to->done != b->to->done) {
+		return a->to->done < b->to->done;
+	}
+	return strcmp(a->name, b->name) < 0;
+}
+
+static void sort_relations_func(void *data_v, int i)
+{
+	Depsgraph *graph = (Depsgraph *)data_v;
+	OperationDepsNode *node = graph->operations[i];
+	std::sort(node->inlinks.begin(), node->inlinks.end(), relation_from_less);
+	std::sort(node->outlinks.begin(), node->outlinks.end(), relation_to_less);
+}
+
+void deg_graph_sort_relations(Depsgraph *graph)
+{
+	const int num_operations = graph->operations.size();
+	for (int i = 0; i < num_operations; ++i) {
+		graph->operations[i]->done = i;
+	}
+	if (graph->time_source != NULL) {
+		graph->time_source->done = -1;
+	}
+	const bool do_threads = (num_operations > 256) &&
+	                        (G.debug & G_DEBUG_DEPSGRAPH_NO_THREADS) == 0;
+	BLI_task_parallel_range(0,
+	                        num_operations,
+	                        graph,
+	                        sort_relations_func,
+	                        do_threads);
+	if (graph->time_source != NULL) {
+		std::sort(graph->time_source->outlinks.begin(),
+		          graph->time_source->outlinks.end(),
+		          relation_to_less);
+	}
+}
+
 void deg_graph_build_finalize(Depsgraph *graph)
 {
 	/* STEP 1: Make sure new invisible dependencies are ready for use.
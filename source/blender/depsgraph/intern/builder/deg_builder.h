@@ -39,6 +39,13 @@ namespace DEG {
 struct Depsgraph;
 
 void deg_graph_build_finalize(struct Depsgraph *graph);
+/* Give relations of every node an order which does not depend on the order
+ * they were added in, which is not deterministic when relations are built
+ * from multiple threads.
+ */
+void deg_graph_sort_relations(struct Depsgraph *graph);
 void deg_graph_build_flush_layers(struct Depsgraph *graph);
+/* Make objects request custom data layers needed by their operations. */
+void deg_graph_build_flush_customdata_mask(struct Depsgraph *graph);
 
 }  // namespace DEG
@@ -0,0 +1,336 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2017 Blender Foundation.
+ * All rights reserved.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/depsgraph/intern/builder/deg_builder_incremental.cc
+ *  \ingroup depsgraph
+ *
+ * Update of the graph relations for a few IDs, without full rebuild.
+ *
+ * Every relation knows which ID was being built when it was added (its
+ * owner). When an object changes its relations, its own nodes are rebuilt,
+ * and so are the relations of all objects which owned relations to them.
+ * Everything else in the graph stays as it is.
+ */
+
+#include "intern/builder/deg_builder_incremental.h"
+
+#include <stdio.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_utildefines.h"
+#include "BLI_ghash.h"
+#include "BLI_listbase.h"
+
+#include "PIL_time.h"
+
+extern "C" {
+#include "DNA_modifier_types.h"
+#include "DNA_object_force.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "BKE_global.h"
+#include "BKE_scene.h"
+}  /* extern "C" */
+
+#include "intern/builder/deg_builder.h"
+#include "intern/builder/deg_builder_cycle.h"
+#include "intern/builder/deg_builder_nodes.h"
+#include "intern/builder/deg_builder_relations.h"
+#include "intern/builder/deg_builder_transitive.h"
+
+#include "intern/nodes/deg_node.h"
+#include "intern/nodes/deg_node_component.h"
+#include "intern/nodes/deg_node_operation.h"
+
+#include "intern/depsgraph.h"
+#include "intern/depsgraph_types.h"
+
+#include "util/deg_util_foreach.h"
+
+namespace DEG {
+
+namespace {
+
+/* Relations between such objects and the rest of the scene are found by
+ * iterating over the whole scene (effectors, collisions, rigid body world,
+ * metaballs) or go both ways (proxies), so other objects might need to
+ * change their relations as well.
+ */
+bool object_supports_incremental_update(Object *ob)
+{
+	if (ob->rigidbody_object != NULL || ob->rigidbody_constraint != NULL) {
+		return false;
+	}
+	if (ob->proxy != NULL || ob->proxy_from != NULL || ob->proxy_group != NULL) {
+		return false;
+	}
+	if (ob->type == OB_MBALL) {
+		return false;
+	}
+	if (ob->particlesystem.first != NULL) {
+		return false;
+	}
+	if (ob->pd != NULL && ob->pd->forcefield != 0) {
+		return false;
+	}
+	LINKLIST_FOREACH (ModifierData *, md, &ob->modifiers) {
+		if (ELEM(md->type,
+		         eModifierType_Collision,
+		         eModifierType_Surface,
+		         eModifierType_Smoke,
+		         eModifierType_DynamicPaint))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/* Scene the object was built for. Sets are built first, so it is the
+ * deepest set which has a base of the object. Objects which are only
+ * used by other objects get the scene of whoever used them first, which
+ * is not known here.
+ */
+Scene *object_build_scene(Scene *scene, Object *ob)
+{
+	Scene *build_scene = NULL;
+	for (Scene *sce = scene; sce != NULL; sce = sce->set) {
+		if (BKE_scene_base_find(sce, ob) != NULL) {
+			build_scene = sce;
+		}
+	}
+	return build_scene;
+}
+
+ID *node_id(DepsNode *node)
+{
+	if (node->type == DEG_NODE_TYPE_OPERATION) {
+		return ((OperationDepsNode *)node)->owner->owner->id;
+	}
+	return NULL;
+}
+
+}  /* namespace */
+
+bool deg_graph_build_incremental(Depsgraph *graph, Main *bmain, Scene *scene)
+{
+	const double start_time = PIL_check_seconds_timer();
+
+	/* Objects which get their nodes rebuilt. */
+	GSet *rebuild_ids = BLI_gset_ptr_new("DEG rebuild ids");
+	vector<Object *> rebuild_objects;
+	/* Objects which get their relations rebuilt, includes the ones above. */
+	GSet *relation_ids = BLI_gset_ptr_new("DEG relation ids");
+	vector<Object *> relation_objects;
+
+	/* STEP 1: Check whether update is possible, nothing is modified until
+	 * it's known for sure.
+	 */
+	bool supported = true;
+	GSET_FOREACH_BEGIN(ID *, id, graph->id_relations_updates)
+	{
+		if (GS(id->name) != ID_OB || graph->find_id_node(id) == NULL) {
+			supported = false;
+			break;
+		}
+		Object *ob = (Object *)id;
+		if (!object_supports_incremental_update(ob) ||
+		    object_build_scene(scene, ob) == NULL)
+		{
+			supported = false;
+			break;
+		}
+		BLI_gset_add(rebuild_ids, id);
+		rebuild_objects.push_back(ob);
+		BLI_gset_add(relation_ids, id);
+		relation_objects.push_back(ob);
+	}
+	GSET_FOREACH_END();
+
+	if (supported) {
+		foreach (Object *ob, rebuild_objects) {
+			IDDepsNode *id_node = graph->find_id_node(&ob->id);
+			GHASH_FOREACH_BEGIN(ComponentDepsNode *, comp_node, id_node->components)
+			{
+				foreach (OperationDepsNode *op_node, comp_node->operations) {
+					foreach (DepsRelation *rel, op_node->inlinks) {
+						BLI_gset_add(relation_ids, rel->owner);
+					}
+					foreach (DepsRelation *rel, op_node->outlinks) {
+						BLI_gset_add(relation_ids, rel->owner);
+					}
+				}
+			}
+			GHASH_FOREACH_END();
+		}
+		/* Relations to the rebuilt nodes might only be re-created by
+		 * building the objects which owned them.
+		 */
+		GSET_FOREACH_BEGIN(ID *, id, relation_ids)
+		{
+			if (id == NULL || GS(id->name) != ID_OB) {
+				supported = false;
+				break;
+			}
+			Object *ob = (Object *)id;
+			if (BLI_gset_haskey(rebuild_ids, id)) {
+				continue;
+			}
+			if (graph->find_id_node(id) == NULL ||
+			    !object_supports_incremental_update(ob) ||
+			    object_build_scene(scene, ob) == NULL)
+			{
+				supported = false;
+				break;
+			}
+			relation_objects.push_back(ob);
+		}
+		GSET_FOREACH_END();
+	}
+
+	if (!supported) {
+		BLI_gset_free(rebuild_ids, NULL);
+		BLI_gset_free(relation_ids, NULL);
+		return false;
+	}
+
+	/* STEP 2: Remove relations which will be rebuilt, and everything
+	 * connected to the rebuilt nodes.
+	 */
+	vector<DepsRelation *> removed_relations;
+	foreach (OperationDepsNode *op_node, graph->operations) {
+		foreach (DepsRelation *rel, op_node->inlinks) {
+			ID *from_id = node_id(rel->from);
+			if (BLI_gset_haskey(relation_ids, rel->owner) ||
+			    BLI_gset_haskey(rebuild_ids, op_node->owner->owner->id) ||
+			    (from_id != NULL && BLI_gset_haskey(rebuild_ids, from_id)))
+			{
+				removed_relations.push_back(rel);
+			}
+		}
+	}
+	foreach (DepsRelation *rel, removed_relations) {
+		rel->unlink();
+		OBJECT_GUARDED_DELETE(rel, DepsRelation);
+	}
+
+	/* STEP 3: Remove nodes of the rebuilt objects. Layers are kept, the
+	 * node builder only knows them for the bases it is iterating over.
+	 */
+	vector<unsigned int> rebuild_layers;
+	foreach (Object *ob, rebuild_objects) {
+		rebuild_layers.push_back(graph->find_id_node(&ob->id)->layers);
+	}
+	Depsgraph::OperationNodes operations;
+	operations.reserve(graph->operations.size());
+	foreach (OperationDepsNode *op_node, graph->operations) {
+		if (BLI_gset_haskey(rebuild_ids, op_node->owner->owner->id)) {
+			BLI_gset_remove(graph->entry_tags, op_node, NULL);
+		}
+		else {
+			operations.push_back(op_node);
+		}
+	}
+	graph->operations.swap(operations);
+	foreach (Object *ob, rebuild_objects) {
+		graph->remove_id_node(&ob->id);
+	}
+
+	/* STEP 4: Rebuild nodes of the objects. Everything which is still in
+	 * the graph is considered built already.
+	 */
+	GSet *graph_ids = BLI_gset_ptr_new("DEG graph ids");
+	GHASH_FOREACH_BEGIN(IDDepsNode *, id_node, graph->id_hash)
+	{
+		GHASH_FOREACH_BEGIN(ComponentDepsNode *, comp_node, id_node->components)
+		{
+			comp_node->begin_update();
+		}
+		GHASH_FOREACH_END();
+		BLI_gset_add(graph_ids, id_node->id);
+	}
+	GHASH_FOREACH_END();
+
+	DepsgraphNodeBuilder node_builder(bmain, graph);
+	node_builder.begin_build(bmain);
+	GSET_FOREACH_BEGIN(ID *, id, graph_ids)
+	{
+		id->tag |= LIB_TAG_DOIT;
+	}
+	GSET_FOREACH_END();
+	for (int i = 0; i < (int)rebuild_objects.size(); ++i) {
+		Object *ob = rebuild_objects[i];
+		node_builder.build_object(object_build_scene(scene, ob), NULL, ob);
+		graph->find_id_node(&ob->id)->layers |= rebuild_layers[i];
+	}
+
+	/* STEP 5: Rebuild relations. IDs which were added by the node builder
+	 * are not in the graph_ids, so their relations are built as well.
+	 */
+	DepsgraphRelationBuilder relation_builder(graph);
+	relation_builder.begin_build(bmain);
+	GSET_FOREACH_BEGIN(ID *, id, graph_ids)
+	{
+		if (!BLI_gset_haskey(relation_ids, id)) {
+			id->tag |= LIB_TAG_DOIT;
+		}
+	}
+	GSET_FOREACH_END();
+	foreach (Object *ob, relation_objects) {
+		relation_builder.build_object(bmain, object_build_scene(scene, ob), ob);
+	}
+	deg_graph_build_flush_customdata_mask(graph);
+
+	/* STEP 6: Same as the end of full build. Cycles are detected again
+	 * from scratch, the removed relations might have been breaking them.
+	 */
+	foreach (OperationDepsNode *op_node, graph->operations) {
+		foreach (DepsRelation *rel, op_node->inlinks) {
+			rel->flag &= ~DEPSREL_FLAG_CYCLIC;
+		}
+	}
+	deg_graph_sort_relations(graph);
+	deg_graph_detect_cycles(graph);
+	if (G.debug_value == 799) {
+		deg_graph_transitive_reduction(graph);
+	}
+	deg_graph_build_finalize(graph);
+
+	if (G.debug & G_DEBUG_DEPSGRAPH) {
+		printf("Depsgraph updated in %.3f ms: %d objects rebuilt, "
+		       "relations of %d objects rebuilt, %d relations removed\n",
+		       (PIL_check_seconds_timer() - start_time) * 1000.0,
+		       (int)rebuild_objects.size(),
+		       (int)relation_objects.size(),
+		       (int)removed_relations.size());
+	}
+
+	BLI_gset_free(graph_ids, NULL);
+	BLI_gset_free(rebuild_ids, NULL);
+	BLI_gset_free(relation_ids, NULL);
+	return true;
+}
+
+}  // namespace DEG
@@ -40,6 +40,7 @@
 
 #include "BLI_utildefines.h"
 #include "BLI_blenlib.h"
+#include "BLI_threads.h"
 
 extern "C" {
 #include "DNA_action_types.h"
@@ -96,6 +97,8 @@ extern "C" {
 #include "RNA_types.h"
 } /* extern "C" */
 
+#include "atomic_ops.h"
+
 #include "DEG_depsgraph.h"
 #include "DEG_depsgraph_build.h"
 
@@ -193,8 +196,28 @@ RNAPathKey::RNAPathKey(ID *id, const char *path) :
 	}
 }
 
-DepsgraphRelationBuilder::DepsgraphRelationBuilder(Depsgraph *graph) :
-    m_graph(graph)
+/* BKE_mball_basis_find() iterates duplis of the whole scene, which modifies
+ * the objects temporarily.
+ */
+static ThreadMutex mball_basis_lock = BLI_MUTEX_INITIALIZER;
+
+/* Objects are built from multiple threads, so checking whether an ID was
+ * already handled and tagging it has to be done at once.
+ * Returns true when the ID was tagged before.
+ */
+static bool id_tag_test_and_set(ID *id)
+{
+	const uint32_t tag = atomic_fetch_and_or_uint32((uint32_t *)&id->tag,
+	                                                LIB_TAG_DOIT);
+	return (tag & LIB_TAG_DOIT) != 0;
+}
+
+DepsgraphRelationBuilder::DepsgraphRelationBuilder(
+        Depsgraph *graph,
+        PendingRelations *pending_relations) :
+    m_graph(graph),
+    m_pending_relations(pending_relations),
+    m_owner(NULL)
 {
 }
 
@@ -275,7 +298,14 @@ void DepsgraphRelationBuilder::add_time_relation(TimeSourceDepsNode *timesrc,
                                                  const char *description)
 {
 	if (timesrc && node_to) {
-		m_graph->add_new_relation(timesrc, node_to, description);
+		if (m_pending_relations != NULL) {
+			PendingRelation relation = {timesrc, node_to, description, m_owner, false};
+			m_pending_relations->push_back(relation);
+		}
+		else {
+			DepsRelation *rel = m_graph->add_new_relation(timesrc, node_to, description);
+			rel->owner = m_owner;
+		}
 	}
 	else {
 		DEG_DEBUG_PRINTF("add_time_relation(%p = %s, %p = %s, %s) Failed\n",
@@ -291,7 +321,14 @@ void DepsgraphRelationBuilder::add_operation_relation(
         const char *description)
 {
 	if (node_from && node_to) {
-		m_graph->add_new_relation(node_from, node_to, description);
+		if (m_pending_relations != NULL) {
+			PendingRelation relation = {node_from, node_to, description, m_owner, true};
+			m_pending_relations->push_back(relation);
+		}
+		else {
+			DepsRelation *rel = m_graph->add_new_relation(node_from, node_to, description);
+			rel->owner = m_owner;
+		}
 	}
 	else {
 		DEG_DEBUG_PRINTF("add_operation_relation(%p = %s, %p = %s, %s) Failed\n",
@@ -301,6 +338,21 @@ void DepsgraphRelationBuilder::add_operation_relation(
 	}
 }
 
+void DepsgraphRelationBuilder::add_customdata_mask(OperationDepsNode *node,
+                                                   uint64_t mask)
+{
+	uint64_t old_mask = node->customdata_mask;
+	while ((old_mask & mask) != mask) {
+		const uint64_t prev_mask = atomic_cas_uint64(&node->customdata_mask,
+		                                             old_mask,
+		                                             old_mask | mask);
+		if (prev_mask == old_mask) {
+			break;
+		}
+		old_mask = prev_mask;
+	}
+}
+
 void DepsgraphRelationBuilder::add_collision_relations(const OperationKey &key, Scene *scene, Object *ob, Group *group, int layer, bool dupli, const char *name)
 {
 	unsigned int numcollobj;
@@ -387,6 +439,19 @@ void DepsgraphRelationBuilder::begin_build(Main *bmain)
 		}
 	}
 	FOREACH_NODETREE_END;
+	/* Entry and exit operations of components are resolved lazily, do it
+	 * now so lookups are read-only once objects are built from threads.
+	 */
+	GHASH_FOREACH_BEGIN(IDDepsNode *, id_node, m_graph->id_hash)
+	{
+		GHASH_FOREACH_BEGIN(ComponentDepsNode *, comp_node, id_node->components)
+		{
+			comp_node->get_entry_operation();
+			comp_node->get_exit_operation();
+		}
+		GHASH_FOREACH_END();
+	}
+	GHASH_FOREACH_END();
 }
 
 void DepsgraphRelationBuilder::build_group(Main *bmain,
@@ -395,7 +460,7 @@ void DepsgraphRelationBuilder::build_group(Main *bmain,
                                            Group *group)
 {
 	ID *group_id = &group->id;
-	bool group_done = (group_id->tag & LIB_TAG_DOIT) != 0;
+	bool group_done = id_tag_test_and_set(group_id);
 	OperationKey object_local_transform_key(&object->id,
 	                                        DEG_NODE_TYPE_TRANSFORM,
 	                                        DEG_OPCODE_TRANSFORM_LOCAL);
@@ -406,15 +471,15 @@ void DepsgraphRelationBuilder::build_group(Main *bmain,
 		ComponentKey dupli_transform_key(&go->ob->id, DEG_NODE_TYPE_TRANSFORM);
 		add_relation(dupli_transform_key, object_local_transform_key, "Dupligroup");
 	}
-	group_id->tag |= LIB_TAG_DOIT;
 }
 
 void DepsgraphRelationBuilder::build_object(Main *bmain, Scene *scene, Object *ob)
 {
-	if (ob->id.tag & LIB_TAG_DOIT) {
+	if (id_tag_test_and_set(&ob->id)) {
 		return;
 	}
-	ob->id.tag |= LIB_TAG_DOIT;
+	ID *prev_owner = m_owner;
+	m_owner = &ob->id;
 
 	/* Object Transforms */
 	eDepsOperation_Code base_op = (ob->parent) ? DEG_OPCODE_TRANSFORM_PARENT : DEG_OPCODE_TRANSFORM_LOCAL;
@@ -569,6 +634,8 @@ void DepsgraphRelationBuilder::build_object(Main *bmain, Scene *scene, Object *o
 	if (ob->dup_group != NULL) {
 		build_group(bmain, scene, ob, ob->dup_group);
 	}
+
+	m_owner = prev_owner;
 }
 
 void DepsgraphRelationBuilder::build_object_parent(Object *ob)
@@ -599,7 +666,7 @@ void DepsgraphRelationBuilder::build_object_parent(Object *ob)
 			/* XXX not sure what this is for or how you could be done properly - lukas */
 			OperationDepsNode *parent_node = find_operation_node(parent_key);
 			if (parent_node != NULL) {
-				parent_node->customdata_mask |= CD_MASK_ORIGINDEX;
+				add_customdata_mask(parent_node, CD_MASK_ORIGINDEX);
 			}
 
 			ComponentKey transform_key(&ob->parent->id, DEG_NODE_TYPE_TRANSFORM);
@@ -809,7 +876,7 @@ void DepsgraphRelationBuilder::build_constraints(Scene *scene, ID *id,
 					if (ct->tar->type == OB_MESH) {
 						OperationDepsNode *node2 = find_operation_node(target_key);
 						if (node2 != NULL) {
-							node2->customdata_mask |= CD_MASK_MDEFORMVERT;
+							add_customdata_mask(node2, CD_MASK_MDEFORMVERT);
 						}
 					}
 				}
@@ -1211,10 +1278,11 @@ void DepsgraphRelationBuilder::build_driver(ID *id, FCurve *fcu)
 void DepsgraphRelationBuilder::build_world(World *world)
 {
 	ID *world_id = &world->id;
-	if (world_id->tag & LIB_TAG_DOIT) {
+	if (id_tag_test_and_set(world_id)) {
 		return;
 	}
-	world_id->tag |= LIB_TAG_DOIT;
+	ID *prev_owner = m_owner;
+	m_owner = world_id;
 
 	build_animdata(world_id);
 
@@ -1230,6 +1298,7 @@ void DepsgraphRelationBuilder::build_world(World *world)
 		ComponentKey world_key(world_id, DEG_NODE_TYPE_PARAMETERS);
 		add_relation(ntree_key, world_key, "NTree->World Parameters");
 	}
+	m_owner = prev_owner;
 }
 
 void DepsgraphRelationBuilder::build_rigidbody(Scene *scene)
@@ -1551,10 +1620,11 @@ void DepsgraphRelationBuilder::build_obdata_geom(Main *bmain, Scene *scene, Obje
 		add_relation(geom_init_key, obdata_ubereval_key, "Object Geometry UberEval");
 	}
 
-	if (obdata->tag & LIB_TAG_DOIT) {
+	if (id_tag_test_and_set(obdata)) {
 		return;
 	}
-	obdata->tag |= LIB_TAG_DOIT;
+	ID *prev_owner = m_owner;
+	m_owner = obdata;
 
 	/* Link object data evaluation node to exit operation. */
 	OperationKey obdata_geom_eval_key(obdata, DEG_NODE_TYPE_GEOMETRY, DEG_OPCODE_PLACEHOLDER, "Geometry Eval");
@@ -1581,7 +1651,9 @@ void DepsgraphRelationBuilder::build_obdata_geom(Main *bmain, Scene *scene, Obje
 
 		case OB_MBALL:
 		{
+			BLI_mutex_lock(&mball_basis_lock);
 			Object *mom = BKE_mball_basis_find(scene, ob);
+			BLI_mutex_unlock(&mball_basis_lock);
 
 			/* motherball - mom depends on children! */
 			if (mom != ob) {
@@ -1647,6 +1719,7 @@ void DepsgraphRelationBuilder::build_obdata_geom(Main *bmain, Scene *scene, Obje
 		 */
 		add_relation(animation_key, obdata_geom_eval_key, "Animation");
 	}
+	m_owner = prev_owner;
 }
 
 /* Cameras */
@@ -1655,10 +1728,11 @@ void DepsgraphRelationBuilder::build_camera(Object *ob)
 {
 	Camera *cam = (Camera *)ob->data;
 	ID *camera_id = &cam->id;
-	if (camera_id->tag & LIB_TAG_DOIT) {
+	if (id_tag_test_and_set(camera_id)) {
 		return;
 	}
-	camera_id->tag |= LIB_TAG_DOIT;
+	ID *prev_owner = m_owner;
+	m_owner = camera_id;
 
 	ComponentKey parameters_key(camera_id, DEG_NODE_TYPE_PARAMETERS);
 
@@ -1673,6 +1747,7 @@ void DepsgraphRelationBuilder::build_camera(Object *ob)
 		ComponentKey dof_ob_key(&cam->dof_ob->id, DEG_NODE_TYPE_TRANSFORM);
 		add_relation(dof_ob_key, ob_param_key, "Camera DOF");
 	}
+	m_owner = prev_owner;
 }
 
 /* Lamps */
@@ -1680,10 +1755,11 @@ void DepsgraphRelationBuilder::build_lamp(Object *ob)
 {
 	Lamp *la = (Lamp *)ob->data;
 	ID *lamp_id = &la->id;
-	if (lamp_id->tag & LIB_TAG_DOIT) {
+	if (id_tag_test_and_set(lamp_id)) {
 		return;
 	}
-	lamp_id->tag |= LIB_TAG_DOIT;
+	ID *prev_owner = m_owner;
+	m_owner = lamp_id;
 
 	ComponentKey parameters_key(lamp_id, DEG_NODE_TYPE_PARAMETERS);
 
@@ -1701,6 +1777,7 @@ void DepsgraphRelationBuilder::build_lamp(Object *ob)
 
 	/* textures */
 	build_texture_stack(la->mtex);
+	m_owner = prev_owner;
 }
 
 void DepsgraphRelationBuilder::build_nodetree(bNodeTree *ntree)
@@ -1727,9 +1804,11 @@ void DepsgraphRelationBuilder::build_nodetree(bNodeTree *ntree)
 			}
 			else if (bnode->type == NODE_GROUP) {
 				bNodeTree *group_ntree = (bNodeTree *)bnode->id;
-				if ((group_ntree->id.tag & LIB_TAG_DOIT) == 0) {
+				if (!id_tag_test_and_set(&group_ntree->id)) {
+					ID *prev_owner = m_owner;
+					m_owner = &group_ntree->id;
 					build_nodetree(group_ntree);
-					group_ntree->id.tag |= LIB_TAG_DOIT;
+					m_owner = prev_owner;
 				}
 				OperationKey group_parameters_key(&group_ntree->id,
 				                                  DEG_NODE_TYPE_PARAMETERS,
@@ -1749,10 +1828,11 @@ void DepsgraphRelationBuilder::build_nodetree(bNodeTree *ntree)
 void DepsgraphRelationBuilder::build_material(Material *ma)
 {
 	ID *ma_id = &ma->id;
-	if (ma_id->tag & LIB_TAG_DOIT) {
+	if (id_tag_test_and_set(ma_id)) {
 		return;
 	}
-	ma_id->tag |= LIB_TAG_DOIT;
+	ID *prev_owner = m_owner;
+	m_owner = ma_id;
 
 	/* animation */
 	build_animdata(ma_id);
@@ -1772,22 +1852,25 @@ void DepsgraphRelationBuilder::build_material(Material *ma)
 		                          "Material Update");
 		add_relation(ntree_key, material_key, "Material's NTree");
 	}
+	m_owner = prev_owner;
 }
 
 /* Recursively build graph for texture */
 void DepsgraphRelationBuilder::build_texture(Tex *tex)
 {
 	ID *tex_id = &tex->id;
-	if (tex_id->tag & LIB_TAG_DOIT) {
+	if (id_tag_test_and_set(tex_id)) {
 		return;
 	}
-	tex_id->tag |= LIB_TAG_DOIT;
+	ID *prev_owner = m_owner;
+	m_owner = tex_id;
 
 	/* texture itself */
 	build_animdata(tex_id);
 
 	/* texture's nodetree */
 	build_nodetree(tex->nodetree);
+	m_owner = prev_owner;
 }
 
 /* Texture-stack attached to some shading datablock */
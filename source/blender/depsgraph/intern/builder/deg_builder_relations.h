@@ -165,7 +165,25 @@ struct RNAPathKey
 
 struct DepsgraphRelationBuilder
 {
-	DepsgraphRelationBuilder(Depsgraph *graph);
+	/* Relation which is only added to the graph after all objects of the
+	 * scene are built, see build_scene_objects().
+	 */
+	struct PendingRelation {
+		DepsNode *from;
+		DepsNode *to;
+		const char *description;
+		ID *owner;
+		/* Both nodes are operations, otherwise from is the time source. */
+		bool is_operation;
+	};
+	typedef vector<PendingRelation> PendingRelations;
+
+	/* When pending_relations is given relations are collected there instead
+	 * of being added to the graph, which allows multiple builders to work on
+	 * the same graph from different threads.
+	 */
+	DepsgraphRelationBuilder(Depsgraph *graph,
+	                         PendingRelations *pending_relations = NULL);
 
 	void begin_build(Main *bmain);
 
@@ -185,6 +203,7 @@ struct DepsgraphRelationBuilder
 	                              const char *description);
 
 	void build_scene(Main *bmain, Scene *scene);
+	void build_scene_objects(Main *bmain, Scene *scene);
 	void build_group(Main *bmain, Scene *scene, Object *object, Group *group);
 	void build_object(Main *bmain, Scene *scene, Object *ob);
 	void build_object_parent(Object *ob);
@@ -251,8 +270,16 @@ protected:
 
 	bool needs_animdata_node(ID *id);
 
+	/* Operation nodes are shared between the threads building objects. */
+	static void add_customdata_mask(OperationDepsNode *node, uint64_t mask);
+
 private:
 	Depsgraph *m_graph;
+	PendingRelations *m_pending_relations;
+	/* ID which is being built, or the scene for relations which don't
+	 * belong to a single ID. Stored in the relations as their owner.
+	 */
+	ID *m_owner;
 };
 
 struct DepsNodeHandle
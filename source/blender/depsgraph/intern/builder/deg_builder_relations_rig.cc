@@ -130,7 +130,7 @@ void DepsgraphRelationBuilder::build_ik_pose(Object *ob,
 			if (data->tar->type == OB_MESH) {
 				OperationDepsNode *node2 = find_operation_node(target_key);
 				if (node2 != NULL) {
-					node2->customdata_mask |= CD_MASK_MDEFORMVERT;
+					add_customdata_mask(node2, CD_MASK_MDEFORMVERT);
 				}
 			}
 		}
@@ -165,7 +165,7 @@ void DepsgraphRelationBuilder::build_ik_pose(Object *ob,
 			if (data->poletar->type == OB_MESH) {
 				OperationDepsNode *node2 = find_operation_node(target_key);
 				if (node2 != NULL) {
-					node2->customdata_mask |= CD_MASK_MDEFORMVERT;
+					add_customdata_mask(node2, CD_MASK_MDEFORMVERT);
 				}
 			}
 		}
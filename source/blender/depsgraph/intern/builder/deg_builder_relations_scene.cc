@@ -40,12 +40,14 @@
 
 #include "BLI_utildefines.h"
 #include "BLI_blenlib.h"
+#include "BLI_task.h"
 
 extern "C" {
 #include "DNA_node_types.h"
 #include "DNA_object_types.h"
 #include "DNA_scene_types.h"
 
+#include "BKE_global.h"
 #include "BKE_main.h"
 #include "BKE_node.h"
 } /* extern "C" */
@@ -67,17 +69,85 @@ extern "C" {
 
 namespace DEG {
 
+namespace {
+
+typedef DepsgraphRelationBuilder::PendingRelations PendingRelations;
+
+struct BuildObjectsData {
+	Depsgraph *graph;
+	Main *bmain;
+	Scene *scene;
+	vector<Object *> objects;
+	/* Relations of every object, same order as objects. */
+	vector<PendingRelations> relations;
+};
+
+void build_object_func(void *data_v, int i)
+{
+	BuildObjectsData *data = (BuildObjectsData *)data_v;
+	DepsgraphRelationBuilder builder(data->graph, &data->relations[i]);
+	builder.build_object(data->bmain, data->scene, data->objects[i]);
+}
+
+}  /* namespace */
+
+/* Relations of the objects are built from multiple threads. Nodes are not
+ * modified at this point, all the nodes already exist and lookups are
+ * read-only, so the only thing which needs care is adding the relations
+ * themselves. Every object collects them into its own list, and they are
+ * added to the graph once all objects are done.
+ *
+ * IDs shared between objects are still built only once, whichever object
+ * gets to them first claims them. This makes the order of relations in the
+ * graph depend on threading, see deg_graph_sort_relations().
+ */
+void DepsgraphRelationBuilder::build_scene_objects(Main *bmain, Scene *scene)
+{
+	BuildObjectsData data;
+	data.graph = m_graph;
+	data.bmain = bmain;
+	data.scene = scene;
+	LINKLIST_FOREACH (Base *, base, &scene->base) {
+		data.objects.push_back(base->object);
+	}
+	const int num_objects = data.objects.size();
+	data.relations.resize(num_objects);
+
+	const bool do_threads = (num_objects > 16) &&
+	                        (G.debug & G_DEBUG_DEPSGRAPH_NO_THREADS) == 0;
+	BLI_task_parallel_range(0,
+	                        num_objects,
+	                        &data,
+	                        build_object_func,
+	                        do_threads);
+
+	foreach (const PendingRelations &relations, data.relations) {
+		foreach (const PendingRelation &relation, relations) {
+			DepsRelation *rel;
+			if (relation.is_operation) {
+				rel = m_graph->add_new_relation((OperationDepsNode *)relation.from,
+				                                (OperationDepsNode *)relation.to,
+				                                relation.description);
+			}
+			else {
+				rel = m_graph->add_new_relation(relation.from,
+				                                relation.to,
+				                                relation.description);
+			}
+			rel->owner = relation.owner;
+		}
+	}
+}
+
 void DepsgraphRelationBuilder::build_scene(Main *bmain, Scene *scene)
 {
 	if (scene->set) {
 		build_scene(bmain, scene->set);
 	}
+	m_owner = &scene->id;
 
 	/* scene objects */
-	LINKLIST_FOREACH (Base *, base, &scene->base) {
-		Object *ob = base->object;
-		build_object(bmain, scene, ob);
-	}
+	build_scene_objects(bmain, scene);
 
 	/* rigidbody */
 	if (scene->rigidbody_world) {
@@ -114,18 +184,7 @@ void DepsgraphRelationBuilder::build_scene(Main *bmain, Scene *scene)
 		build_movieclip(clip);
 	}
 
-	for (Depsgraph::OperationNodes::const_iterator it_op = m_graph->operations.begin();
-	     it_op != m_graph->operations.end();
-	     ++it_op)
-	{
-		OperationDepsNode *node = *it_op;
-		IDDepsNode *id_node = node->owner->owner;
-		ID *id = id_node->id;
-		if (GS(id->name) == ID_OB) {
-			Object *object = (Object *)id;
-			object->customdata_mask |= node->customdata_mask;
-		}
-	}
+	deg_graph_build_flush_customdata_mask(m_graph);
 }
 
 }  // namespace DEG
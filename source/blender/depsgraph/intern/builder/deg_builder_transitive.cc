@@ -32,6 +32,13 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "BLI_utildefines.h"
+#include "BLI_task.h"
+
+extern "C" {
+#include "BKE_global.h"
+}
+
 #include "intern/nodes/deg_node.h"
 #include "intern/nodes/deg_node_component.h"
 #include "intern/nodes/deg_node_operation.h"
@@ -44,74 +51,134 @@ namespace DEG {
 
 /* -------------------------------------------------- */
 
-/* Performs a transitive reduction to remove redundant relations.
- * https://en.wikipedia.org/wiki/Transitive_reduction
- *
- * XXX The current implementation is somewhat naive and has O(V*E) worst case
- * runtime.
- * A more optimized algorithm can be implemented later, e.g.
- *
- *   http://www.sciencedirect.com/science/article/pii/0304397588900321/pdf?md5=3391e309b708b6f9cdedcd08f84f4afc&pid=1-s2.0-0304397588900321-main.pdf
- *
- * Care has to be taken to make sure the algorithm can handle the cyclic case
- * too! (unless we can to prevent this case early on).
+namespace {
+
+/* Visited and reachable marks of a single thread. Instead of clearing them
+ * for every target node they store the index of the target they were set
+ * for.
  */
+struct ThreadState {
+	vector<int> visited;
+	vector<int> reachable;
+	vector<OperationDepsNode *> stack;
+};
 
-enum {
-	OP_VISITED = 1,
-	OP_REACHABLE = 2,
+struct TransitiveReductionData {
+	Depsgraph *graph;
+	vector<ThreadState> threads;
+	/* Redundant relations of every target node. */
+	vector<vector<DepsRelation *> > redundant;
 };
 
-static void deg_graph_tag_paths_recursive(DepsNode *node)
+bool relation_is_reducible(const DepsRelation *rel)
 {
-	if (node->done & OP_VISITED) {
-		return;
-	}
-	node->done |= OP_VISITED;
-	foreach (DepsRelation *rel, node->inlinks) {
-		deg_graph_tag_paths_recursive(rel->from);
-		/* Do this only in inlinks loop, so the target node does not get
-		 * flagged.
-		 */
-		rel->from->done |= OP_REACHABLE;
+	/* HACK: time source nodes don't get an index. */
+	/* TODO: there will be other types in future, so this check needs
+	 * modifying.
+	 */
+	if (rel->from->type == DEG_NODE_TYPE_TIMESOURCE) {
+		return false;
 	}
+	/* Relations which were removed to break cycles are not followed, the rest
+	 * of the graph is acyclic which makes the reduction independent of the
+	 * order relations are removed in.
+	 */
+	return (rel->flag & DEPSREL_FLAG_CYCLIC) == 0;
 }
 
-void deg_graph_transitive_reduction(Depsgraph *graph)
+void transitive_reduction_func(void *data_v,
+                               void * /*userdata_chunk*/,
+                               int target_index,
+                               int thread_id)
 {
-	foreach (OperationDepsNode *target, graph->operations) {
-		/* Clear tags. */
-		foreach (OperationDepsNode *node, graph->operations) {
-			node->done = 0;
+	TransitiveReductionData *data = (TransitiveReductionData *)data_v;
+	ThreadState &state = data->threads[thread_id];
+	OperationDepsNode *target = data->graph->operations[target_index];
+	const int tag = target_index + 1;
+
+	/* Mark nodes from which we can reach the target, start with children,
+	 * so the target node and direct children are not flagged.
+	 */
+	state.visited[target_index] = tag;
+	foreach (DepsRelation *rel, target->inlinks) {
+		if (relation_is_reducible(rel)) {
+			state.stack.push_back((OperationDepsNode *)rel->from);
 		}
-
-		/* mark nodes from which we can reach the target
-		 * start with children, so the target node and direct children are not
-		 * flagged.
-		 */
-		target->done |= OP_VISITED;
-		foreach (DepsRelation *rel, target->inlinks) {
-			deg_graph_tag_paths_recursive(rel->from);
+	}
+	while (!state.stack.empty()) {
+		OperationDepsNode *node = state.stack.back();
+		state.stack.pop_back();
+		if (state.visited[node->done] == tag) {
+			continue;
 		}
-
-		/* Remove redundant paths to the target. */
-		for (DepsNode::Relations::const_iterator it_rel = target->inlinks.begin();
-		     it_rel != target->inlinks.end();
-		     )
-		{
-			DepsRelation *rel = *it_rel;
-			/* Increment in advance, so we can safely remove the relation. */
-			++it_rel;
-
-			if (rel->from->type == DEG_NODE_TYPE_TIMESOURCE) {
-				/* HACK: time source nodes don't get "done" flag set/cleared. */
-				/* TODO: there will be other types in future, so iterators above
-				 * need modifying.
+		state.visited[node->done] = tag;
+		foreach (DepsRelation *rel, node->inlinks) {
+			if (relation_is_reducible(rel)) {
+				/* Do this only in inlinks loop, so the target node does not
+				 * get flagged.
 				 */
+				state.reachable[rel->from->done] = tag;
+				state.stack.push_back((OperationDepsNode *)rel->from);
 			}
-			else if (rel->from->done & OP_REACHABLE) {
-				OBJECT_GUARDED_DELETE(rel, DepsRelation);
-			}
+		}
+	}
+
+	/* Collect redundant paths to the target. */
+	foreach (DepsRelation *rel, target->inlinks) {
+		if (relation_is_reducible(rel) &&
+		    state.reachable[rel->from->done] == tag)
+		{
+			data->redundant[target_index].push_back(rel);
+		}
+	}
+}
+
+}  /* namespace */
+
+/* Performs a transitive reduction to remove redundant relations.
+ * https://en.wikipedia.org/wiki/Transitive_reduction
+ *
+ * Every target node is handled independently, which allows to do them in
+ * parallel. Relations are only removed once all of them are handled.
+ *
+ * XXX The current implementation is somewhat naive and has O(V*E) worst case
+ * runtime.
+ * A more optimized algorithm can be implemented later, e.g.
+ *
+ *   http://www.sciencedirect.com/science/article/pii/0304397588900321/pdf?md5=3391e309b708b6f9cdedcd08f84f4afc&pid=1-s2.0-0304397588900321-main.pdf
+ */
+void deg_graph_transitive_reduction(Depsgraph *graph)
+{
+	const int num_operations = graph->operations.size();
+	/* Node index is used to address the marks. */
+	for (int i = 0; i < num_operations; ++i) {
+		graph->operations[i]->done = i;
+	}
+
+	TaskScheduler *task_scheduler = BLI_task_scheduler_get();
+	const int num_threads = BLI_task_scheduler_num_threads(task_scheduler);
+	TransitiveReductionData data;
+	data.graph = graph;
+	data.threads.resize(num_threads);
+	foreach (ThreadState &state, data.threads) {
+		state.visited.resize(num_operations, 0);
+		state.reachable.resize(num_operations, 0);
+	}
+	data.redundant.resize(num_operations);
+
+	const bool do_threads = (num_operations > 256) &&
+	                        (G.debug & G_DEBUG_DEPSGRAPH_NO_THREADS) == 0;
+	BLI_task_parallel_range_ex(0, num_operations,
+	                           &data,
+	                           NULL, 0,
+	                           transitive_reduction_func,
+	                           do_threads,
+	                           true);
+
+	foreach (const vector<DepsRelation *> &relations, data.redundant) {
+		foreach (DepsRelation *rel, relations) {
+			rel->unlink();
+			OBJECT_GUARDED_DELETE(rel, DepsRelation);
 		}
 	}
 }
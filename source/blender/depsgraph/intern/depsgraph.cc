@@ -51,6 +51,7 @@ extern "C" {
 #include "RNA_access.h"
 }
 
+#include <algorithm>
 #include <cstring>
 
 #include "DEG_depsgraph.h"
@@ -58,6 +59,7 @@ extern "C" {
 #include "intern/nodes/deg_node.h"
 #include "intern/nodes/deg_node_component.h"
 #include "intern/nodes/deg_node_operation.h"
+#include "intern/eval/deg_eval_profile.h"
 
 #include "intern/depsgraph_intern.h"
 #include "util/deg_util_foreach.h"
@@ -71,11 +73,13 @@ static DEG_EditorUpdateScenePreCb deg_editor_update_scene_pre_cb = NULL;
 Depsgraph::Depsgraph()
   : time_source(NULL),
     need_update(false),
-    layers(0)
+    layers(0),
+    profile(NULL)
 {
 	BLI_spin_init(&lock);
 	id_hash = BLI_ghash_ptr_new("Depsgraph id hash");
 	entry_tags = BLI_gset_ptr_new("Depsgraph entry_tags");
+	id_relations_updates = BLI_gset_ptr_new("Depsgraph id_relations_updates");
 }
 
 Depsgraph::~Depsgraph()
@@ -83,9 +87,13 @@ Depsgraph::~Depsgraph()
 	clear_id_nodes();
 	BLI_ghash_free(id_hash, NULL, NULL);
 	BLI_gset_free(entry_tags, NULL);
+	BLI_gset_free(id_relations_updates, NULL);
 	if (time_source != NULL) {
 		OBJECT_GUARDED_DELETE(time_source, TimeSourceDepsNode);
 	}
+	if (profile != NULL) {
+		OBJECT_GUARDED_DELETE(profile, DepsgraphProfile);
+	}
 	BLI_spin_end(&lock);
 }
 
@@ -291,6 +299,11 @@ IDDepsNode *Depsgraph::add_id_node(ID *id, const char *name)
 	return id_node;
 }
 
+void Depsgraph::remove_id_node(const ID *id)
+{
+	BLI_ghash_remove(id_hash, id, NULL, id_node_deleter);
+}
+
 void Depsgraph::clear_id_nodes()
 {
 	BLI_ghash_clear(id_hash, NULL, id_node_deleter);
@@ -338,7 +351,8 @@ DepsRelation::DepsRelation(DepsNode *from,
   : from(from),
     to(to),
     name(description),
-    flag(0)
+    flag(0),
+    owner(NULL)
 {
 #ifndef NDEBUG
 /*
@@ -382,6 +396,16 @@ DepsRelation::~DepsRelation()
 	BLI_assert(this->from && this->to);
 }
 
+void DepsRelation::unlink()
+{
+	from->outlinks.erase(std::find(from->outlinks.begin(),
+	                               from->outlinks.end(),
+	                               this));
+	to->inlinks.erase(std::find(to->inlinks.begin(),
+	                            to->inlinks.end(),
+	                            this));
+}
+
 /* Low level tagging -------------------------------------- */
 
 /* Tag a specific node as needing updates. */
@@ -53,6 +53,7 @@ struct TimeSourceDepsNode;
 struct IDDepsNode;
 struct ComponentDepsNode;
 struct OperationDepsNode;
+struct DepsgraphProfile;
 
 /* *************************** */
 /* Relationships Between Nodes */
@@ -79,11 +80,19 @@ struct DepsRelation {
 
 	int flag;                     /* (eDepsRelation_Flag) */
 
+	/* ID which was being built when the relation was added, relations are
+	 * rebuilt per owner when the graph is updated incrementally.
+	 */
+	ID *owner;
+
 	DepsRelation(DepsNode *from,
 	             DepsNode *to,
 	             const char *description);
 
 	~DepsRelation();
+
+	/* Remove relation from the nodes it connects. */
+	void unlink();
 };
 
 /* ********* */
@@ -112,6 +121,8 @@ struct Depsgraph {
 
 	IDDepsNode *find_id_node(const ID *id) const;
 	IDDepsNode *add_id_node(ID *id, const char *name = "");
+	/* Relations of the node's operations must be removed already. */
+	void remove_id_node(const ID *id);
 	void clear_id_nodes();
 
 	/* Add new relationship between two nodes. */
@@ -141,6 +152,11 @@ struct Depsgraph {
 	/* Indicates whether relations needs to be updated. */
 	bool need_update;
 
+	/* IDs whose relations need to be updated, this is done without rebuilding
+	 * the whole graph. Not used when need_update is set.
+	 */
+	GSet *id_relations_updates;
+
 	/* Quick-Access Temp Data ............. */
 
 	/* Nodes which have been tagged as "directly modified". */
@@ -162,6 +178,11 @@ struct Depsgraph {
 	/* Visible layers bitfield, used for skipping invisible objects updates. */
 	unsigned int layers;
 
+	/* Profiling ......................... */
+
+	/* Timing of the last evaluation done with profiling enabled. */
+	DepsgraphProfile *profile;
+
 	// XXX: additional stuff like eval contexts, mempools for allocating nodes from, etc.
 };
 
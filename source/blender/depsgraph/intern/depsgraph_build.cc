@@ -37,8 +37,8 @@
 #include "BLI_utildefines.h"
 #include "BLI_ghash.h"
 
+#include "PIL_time.h"
 #ifdef DEBUG_TIME
-#  include "PIL_time.h"
 #  include "PIL_time_utildefines.h"
 #endif
 
@@ -54,12 +54,15 @@ extern "C" {
 #include "BKE_modifier.h"
 } /* extern "C" */
 
+#include "atomic_ops.h"
+
 #include "DEG_depsgraph.h"
 #include "DEG_depsgraph_debug.h"
 #include "DEG_depsgraph_build.h"
 
 #include "builder/deg_builder.h"
 #include "builder/deg_builder_cycle.h"
+#include "builder/deg_builder_incremental.h"
 #include "builder/deg_builder_nodes.h"
 #include "builder/deg_builder_relations.h"
 #include "builder/deg_builder_transitive.h"
@@ -185,7 +188,8 @@ void DEG_add_special_eval_flag(Depsgraph *graph, ID *id, short flag)
 		BLI_assert(!"ID should always be valid");
 		return;
 	}
-	id_node->eval_flags |= flag;
+	/* Modifiers add their relations from multiple threads. */
+	atomic_fetch_and_or_uint32((uint32_t *)&id_node->eval_flags, flag);
 }
 
 /* ******************** */
@@ -197,6 +201,16 @@ void DEG_add_special_eval_flag(Depsgraph *graph, ID *id, short flag)
 /* XXX: assume that this is called from outside, given the current scene as
  * the "main" scene.
  */
+static int deg_graph_num_relations(DEG::Depsgraph *graph)
+{
+	/* Every relation ends in an operation. */
+	int num_relations = 0;
+	foreach (DEG::OperationDepsNode *node, graph->operations) {
+		num_relations += node->inlinks.size();
+	}
+	return num_relations;
+}
+
 void DEG_graph_build_from_scene(Depsgraph *graph, Main *bmain, Scene *scene)
 {
 #ifdef DEBUG_TIME
@@ -204,11 +218,15 @@ void DEG_graph_build_from_scene(Depsgraph *graph, Main *bmain, Scene *scene)
 #endif
 
 	DEG::Depsgraph *deg_graph = reinterpret_cast<DEG::Depsgraph *>(graph);
+	const bool do_stats = (G.debug & G_DEBUG_DEPSGRAPH) != 0;
+	const double start_time = PIL_check_seconds_timer();
+	double node_time, relation_time, cycle_time, reduction_time;
 
 	/* 1) Generate all the nodes in the graph first */
 	DEG::DepsgraphNodeBuilder node_builder(bmain, deg_graph);
 	node_builder.begin_build(bmain);
 	node_builder.build_scene(bmain, scene);
+	node_time = PIL_check_seconds_timer();
 
 	/* 2) Hook up relationships between operations - to determine evaluation
 	 *    order.
@@ -216,22 +234,47 @@ void DEG_graph_build_from_scene(Depsgraph *graph, Main *bmain, Scene *scene)
 	DEG::DepsgraphRelationBuilder relation_builder(deg_graph);
 	relation_builder.begin_build(bmain);
 	relation_builder.build_scene(bmain, scene);
+	/* Objects are built in parallel, make the result not depend on that. */
+	DEG::deg_graph_sort_relations(deg_graph);
+	relation_time = PIL_check_seconds_timer();
 
 	/* Detect and solve cycles. */
 	DEG::deg_graph_detect_cycles(deg_graph);
+	cycle_time = PIL_check_seconds_timer();
 
 	/* 3) Simplify the graph by removing redundant relations (to optimize
 	 *    traversal later). */
 	/* TODO: it would be useful to have an option to disable this in cases where
 	 *       it is causing trouble.
 	 */
+	const int num_relations = do_stats ? deg_graph_num_relations(deg_graph) : 0;
 	if (G.debug_value == 799) {
 		DEG::deg_graph_transitive_reduction(deg_graph);
 	}
+	reduction_time = PIL_check_seconds_timer();
 
 	/* 4) Flush visibility layer and re-schedule nodes for update. */
 	DEG::deg_graph_build_finalize(deg_graph);
 
+	if (do_stats) {
+		const double end_time = PIL_check_seconds_timer();
+		const int num_reduced = num_relations - deg_graph_num_relations(deg_graph);
+		printf("Depsgraph built in %.3f ms: %d IDs, %d operations, "
+		       "%d relations (%d removed as redundant)\n",
+		       (end_time - start_time) * 1000.0,
+		       (int)BLI_ghash_size(deg_graph->id_hash),
+		       (int)deg_graph->operations.size(),
+		       num_relations - num_reduced,
+		       num_reduced);
+		printf("  nodes %.3f ms, relations %.3f ms, cycles %.3f ms, "
+		       "reduction %.3f ms, finalize %.3f ms\n",
+		       (node_time - start_time) * 1000.0,
+		       (relation_time - node_time) * 1000.0,
+		       (cycle_time - relation_time) * 1000.0,
+		       (reduction_time - cycle_time) * 1000.0,
+		       (end_time - reduction_time) * 1000.0);
+	}
+
 #if 0
 	if (!DEG_debug_consistency_check(deg_graph)) {
 		printf("Consistency validation failed, ABORTING!\n");
@@ -264,6 +307,28 @@ void DEG_relations_tag_update(Main *bmain)
 	}
 }
 
+/* Tag relations of the ID for update in all graphs which use it. */
+void DEG_id_relations_tag_update(Main *bmain, ID *id)
+{
+	for (Scene *scene = (Scene *)bmain->scene.first;
+	     scene != NULL;
+	     scene = (Scene *)scene->id.next)
+	{
+		if (scene->depsgraph == NULL) {
+			continue;
+		}
+		DEG::Depsgraph *graph =
+		        reinterpret_cast<DEG::Depsgraph *>(scene->depsgraph);
+		if (graph->need_update) {
+			/* Whole graph will be rebuilt anyway. */
+			continue;
+		}
+		if (graph->find_id_node(id) != NULL) {
+			BLI_gset_add(graph->id_relations_updates, id);
+		}
+	}
+}
+
 /* Create new graph if didn't exist yet,
  * or update relations if graph was tagged for update.
  */
@@ -278,9 +343,30 @@ void DEG_scene_relations_update(Main *bmain, Scene *scene)
 
 	DEG::Depsgraph *graph = reinterpret_cast<DEG::Depsgraph *>(scene->depsgraph);
 	if (!graph->need_update) {
-		/* Graph is up to date, nothing to do. */
-		return;
+		if (BLI_gset_size(graph->id_relations_updates) == 0) {
+			/* Graph is up to date, nothing to do. */
+			return;
+		}
+		const bool updated = DEG::deg_graph_build_incremental(graph,
+		                                                      bmain,
+		                                                      scene);
+		BLI_gset_clear(graph->id_relations_updates, NULL);
+		if (updated) {
+			/* Make sure the graph matches what full rebuild would give,
+			 * this builds a whole second graph so only done on request.
+			 */
+			if (G.debug_value == 798) {
+				DEG_debug_consistency_check(scene->depsgraph);
+				DEG_debug_incremental_update_validate(bmain, scene);
+				/* Validation builds another graph, which resets custom
+				 * data masks of objects.
+				 */
+				DEG::deg_graph_build_flush_customdata_mask(graph);
+			}
+			return;
+		}
 	}
+	BLI_gset_clear(graph->id_relations_updates, NULL);
 
 	/* Clear all previous nodes and operations. */
 	graph->clear_all_nodes();
@@ -41,9 +41,97 @@ extern "C" {
 #include "DEG_depsgraph_debug.h"
 #include "DEG_depsgraph_build.h"
 
+#include "intern/eval/deg_eval_profile.h"
 #include "intern/depsgraph_intern.h"
 #include "util/deg_util_foreach.h"
 
+#include <algorithm>
+#include <iterator>
+
+namespace DEG {
+
+namespace {
+
+bool deg_debug_node_in_graph(const DepsNode *node,
+                             const Depsgraph *graph)
+{
+	if (graph == NULL || node->type != DEG_NODE_TYPE_OPERATION) {
+		return true;
+	}
+	const OperationDepsNode *op_node = (const OperationDepsNode *)node;
+	return graph->find_id_node(op_node->owner->owner->id) != NULL;
+}
+
+string deg_debug_node_name(const DepsNode *node)
+{
+	if (node->type == DEG_NODE_TYPE_OPERATION) {
+		return ((const OperationDepsNode *)node)->full_identifier();
+	}
+	return node->identifier();
+}
+
+/* Operations and relations of the graph as strings, sorted so graphs which
+ * were built in different order can be compared. When filter is given only
+ * nodes of IDs which are in there are listed.
+ */
+void deg_debug_graph_lines(const Depsgraph *graph,
+                           const Depsgraph *filter,
+                           vector<string> *r_lines)
+{
+	foreach (OperationDepsNode *node, graph->operations) {
+		if (!deg_debug_node_in_graph(node, filter)) {
+			continue;
+		}
+		const string name = node->full_identifier();
+		r_lines->push_back(name);
+		foreach (DepsRelation *rel, node->inlinks) {
+			if (!deg_debug_node_in_graph(rel->from, filter)) {
+				continue;
+			}
+			r_lines->push_back(deg_debug_node_name(rel->from) + " -> " +
+			                   name + " (" + rel->name + ")");
+		}
+	}
+	std::sort(r_lines->begin(), r_lines->end());
+}
+
+/* Flags and custom data masks are not compared, only what the graph
+ * consists of.
+ *
+ * Graphs which were updated incrementally keep IDs which are not used
+ * anymore until the next full rebuild, ignore_unused_ids skips nodes of
+ * graph2 which are not in graph1.
+ */
+bool deg_debug_compare(const Depsgraph *graph1,
+                       const Depsgraph *graph2,
+                       bool ignore_unused_ids)
+{
+	vector<string> lines1, lines2;
+	deg_debug_graph_lines(graph1, NULL, &lines1);
+	deg_debug_graph_lines(graph2, ignore_unused_ids ? graph1 : NULL, &lines2);
+	if (lines1 == lines2) {
+		return true;
+	}
+	vector<string> missing, extra;
+	std::set_difference(lines1.begin(), lines1.end(),
+	                    lines2.begin(), lines2.end(),
+	                    std::back_inserter(missing));
+	std::set_difference(lines2.begin(), lines2.end(),
+	                    lines1.begin(), lines1.end(),
+	                    std::back_inserter(extra));
+	if (!missing.empty()) {
+		fprintf(stderr, "Only in the first graph: %s\n", missing[0].c_str());
+	}
+	if (!extra.empty()) {
+		fprintf(stderr, "Only in the second graph: %s\n", extra[0].c_str());
+	}
+	return false;
+}
+
+}  /* namespace */
+
+}  // namespace DEG
+
 bool DEG_debug_compare(const struct Depsgraph *graph1,
                        const struct Depsgraph *graph2)
 {
@@ -51,32 +139,42 @@ bool DEG_debug_compare(const struct Depsgraph *graph1,
 	BLI_assert(graph2 != NULL);
 	const DEG::Depsgraph *deg_graph1 = reinterpret_cast<const DEG::Depsgraph *>(graph1);
 	const DEG::Depsgraph *deg_graph2 = reinterpret_cast<const DEG::Depsgraph *>(graph2);
-	if (deg_graph1->operations.size() != deg_graph2->operations.size()) {
-		return false;
-	}
-	/* TODO(sergey): Currently we only do real stupid check,
-	 * which is fast but which isn't 100% reliable.
-	 *
-	 * Would be cool to make it more robust, but it's good enough
-	 * for now. Also, proper graph check is actually NP-complex
-	 * problem..
-	 */
-	return true;
+	return DEG::deg_debug_compare(deg_graph1, deg_graph2, false);
 }
 
-bool DEG_debug_scene_relations_validate(Main *bmain,
-                                        Scene *scene)
+/* Compare graph of the scene against one built from scratch. */
+static bool deg_debug_scene_relations_match(Main *bmain, Scene *scene)
 {
 	Depsgraph *depsgraph = DEG_graph_new();
-	bool valid = true;
 	DEG_graph_build_from_scene(depsgraph, bmain, scene);
-	if (!DEG_debug_compare(depsgraph, scene->depsgraph)) {
+	const bool match =
+	        DEG::deg_debug_compare(reinterpret_cast<DEG::Depsgraph *>(depsgraph),
+	                               reinterpret_cast<DEG::Depsgraph *>(scene->depsgraph),
+	                               true);
+	DEG_graph_free(depsgraph);
+	return match;
+}
+
+bool DEG_debug_scene_relations_validate(Main *bmain,
+                                        Scene *scene)
+{
+	if (!deg_debug_scene_relations_match(bmain, scene)) {
 		fprintf(stderr, "ERROR! Depsgraph wasn't tagged for update when it should have!\n");
 		BLI_assert(!"This should not happen!");
-		valid = false;
+		return false;
 	}
-	DEG_graph_free(depsgraph);
-	return valid;
+	return true;
+}
+
+bool DEG_debug_incremental_update_validate(Main *bmain,
+                                           Scene *scene)
+{
+	if (!deg_debug_scene_relations_match(bmain, scene)) {
+		fprintf(stderr, "ERROR! Incremental relations update diverged from full rebuild!\n");
+		BLI_assert(!"Incremental depsgraph update diverged from full rebuild!");
+		return false;
+	}
+	return true;
 }
 
 bool DEG_debug_consistency_check(Depsgraph *graph)
@@ -220,3 +318,23 @@ void DEG_stats_simple(const Depsgraph *graph, size_t *r_outer,
 		if (r_outer)     *r_outer     = tot_outer;
 	}
 }
+
+bool DEG_debug_profile_trace(const Depsgraph *graph, FILE *stream)
+{
+	const DEG::Depsgraph *deg_graph = reinterpret_cast<const DEG::Depsgraph *>(graph);
+	if (deg_graph->profile == NULL) {
+		return false;
+	}
+	deg_graph->profile->write_trace(stream);
+	return true;
+}
+
+bool DEG_debug_profile_report(const Depsgraph *graph, FILE *stream)
+{
+	const DEG::Depsgraph *deg_graph = reinterpret_cast<const DEG::Depsgraph *>(graph);
+	if (deg_graph->profile == NULL) {
+		return false;
+	}
+	deg_graph->profile->write_report(stream, true);
+	return true;
+}
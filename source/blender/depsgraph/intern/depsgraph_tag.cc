@@ -210,6 +210,11 @@ void DEG_id_tag_update_ex(Main *bmain, ID *id, short flag)
 		return;
 	}
 	DEG_DEBUG_PRINTF("%s: id=%s flag=%d\n", __func__, id->name, flag);
+	/* Data is about to change, memfile undo can't re-use what it wrote before. */
+	id->tag &= ~LIB_TAG_UNDO_UNCHANGED;
+	if (GS(id->name) == ID_OB && ((Object *)id)->data != NULL) {
+		((ID *)((Object *)id)->data)->tag &= ~LIB_TAG_UNDO_UNCHANGED;
+	}
 	lib_id_recalc_tag_flag(bmain, id, flag);
 	for (Scene *scene = (Scene *)bmain->scene.first;
 	     scene != NULL;
@@ -32,6 +32,10 @@
 
 #include "intern/eval/deg_eval.h"
 
+#include <algorithm>
+
+#include "MEM_guardedalloc.h"
+
 #include "PIL_time.h"
 
 #include "BLI_utildefines.h"
@@ -48,6 +52,7 @@ extern "C" {
 #include "atomic_ops.h"
 
 #include "intern/eval/deg_eval_flush.h"
+#include "intern/eval/deg_eval_profile.h"
 #include "intern/nodes/deg_node.h"
 #include "intern/nodes/deg_node_component.h"
 #include "intern/nodes/deg_node_operation.h"
@@ -55,32 +60,62 @@ extern "C" {
 #include "intern/depsgraph_intern.h"
 #include "util/deg_util_foreach.h"
 
-/* Unfinished and unused, and takes quite some pre-processing time. */
-#undef USE_EVAL_PRIORITY
-
-/* Use integrated debugger to keep track how much each of the nodes was
- * evaluating.
+/* Weight of the last measured evaluation time in the average cost of an
+ * operation. Smooths out single slow evaluations, while still following
+ * changes like a modifier being enabled within a few frames.
  */
-#undef USE_DEBUGGER
+#define EVAL_COST_FACTOR 0.25f
 
 namespace DEG {
 
 /* ********************** */
 /* Evaluation Entrypoints */
 
-/* Forward declarations. */
-static void schedule_children(TaskPool *pool,
-                              Depsgraph *graph,
-                              OperationDepsNode *node,
-                              const unsigned int layers,
-                              const int thread_id);
-
 struct DepsgraphEvalState {
 	EvaluationContext *eval_ctx;
 	Depsgraph *graph;
 	unsigned int layers;
+	/* Keeps track how much each of the nodes was evaluating,
+	 * NULL unless profiling is enabled.
+	 */
+	DepsgraphProfiler *profiler;
+	/* Operations in the order they were finished, including NOOPs.
+	 * This is a topological order of the evaluated part of the graph.
+	 */
+	OperationDepsNode **finished;
+	uint32_t num_finished;
 };
 
+/* Operations which became ready to be evaluated. */
+typedef vector<OperationDepsNode *> ReadyNodes;
+
+/* Forward declarations. */
+static void schedule_children(DepsgraphEvalState *state,
+                              OperationDepsNode *node,
+                              ReadyNodes *r_ready);
+static void push_ready_nodes(TaskPool *pool,
+                             ReadyNodes& ready,
+                             const bool from_task,
+                             const int thread_id);
+
+static void node_finished(DepsgraphEvalState *state, OperationDepsNode *node)
+{
+	const uint32_t index = atomic_fetch_and_add_uint32(&state->num_finished, 1);
+	state->finished[index] = node;
+	node->done = 1;
+}
+
+/* Moving average of the time it took to evaluate the operation. */
+static void update_eval_cost(OperationDepsNode *node, const float time)
+{
+	if (node->eval_cost == 0.0f) {
+		node->eval_cost = time;
+	}
+	else {
+		node->eval_cost += EVAL_COST_FACTOR * (time - node->eval_cost);
+	}
+}
+
 static void deg_task_run_func(TaskPool *pool,
                               void *taskdata,
                               int thread_id)
@@ -107,26 +142,26 @@ static void deg_task_run_func(TaskPool *pool,
 	 * but that's all fine, we'll just scheduler it's children.
 	 */
 	if (node->evaluate) {
-			/* Take note of current time. */
-#ifdef USE_DEBUGGER
-		double start_time = PIL_check_seconds_timer();
-		DepsgraphDebug::task_started(state->graph, node);
-#endif
-
-		/* Perform operation. */
+		/* Perform operation, and note how long this took. */
+		const double start_time = PIL_check_seconds_timer();
 		node->evaluate(state->eval_ctx);
-
-			/* Note how long this took. */
-#ifdef USE_DEBUGGER
-		double end_time = PIL_check_seconds_timer();
-		DepsgraphDebug::task_completed(state->graph,
-		                               node,
-		                               end_time - start_time);
-#endif
+		const double end_time = PIL_check_seconds_timer();
+
+		update_eval_cost(node, (float)(end_time - start_time));
+		if (state->profiler != NULL) {
+			state->profiler->operation_evaluated(thread_id,
+			                                     node,
+			                                     start_time,
+			                                     end_time);
+		}
 	}
+	node_finished(state, node);
+
+	ReadyNodes ready;
+	schedule_children(state, node, &ready);
 
 	BLI_task_pool_delayed_push_begin(pool, thread_id);
-	schedule_children(pool, state->graph, node, state->layers, thread_id);
+	push_ready_nodes(pool, ready, true, thread_id);
 	BLI_task_pool_delayed_push_end(pool, thread_id);
 }
 
@@ -180,45 +215,83 @@ static void calculate_pending_parents(Depsgraph *graph, unsigned int layers)
 	                        do_threads);
 }
 
-#ifdef USE_EVAL_PRIORITY
-static void calculate_eval_priority(OperationDepsNode *node)
+/* Priority of an operation is the length of the longest chain of evaluation
+ * time which depends on it, including the operation itself. Operations on
+ * the critical path of the graph get the highest priority, so they are
+ * started first and other operations fill up the remaining threads.
+ *
+ * Costs are only known after evaluating, so the priorities are updated at
+ * the end of an evaluation and used by the next one. During playback the
+ * same operations are evaluated every frame, so they match well.
+ */
+static void update_eval_priorities(DepsgraphEvalState *state)
 {
-	if (node->done) {
-		return;
+	/* In reverse order of finishing, all children of an operation which
+	 * were evaluated are handled before the operation itself.
+	 */
+	for (int i = (int)state->num_finished - 1; i >= 0; i--) {
+		OperationDepsNode *node = state->finished[i];
+		float children_priority = 0.0f;
+		foreach (DepsRelation *rel, node->outlinks) {
+			OperationDepsNode *child = (OperationDepsNode *)rel->to;
+			BLI_assert(child->type == DEG_NODE_TYPE_OPERATION);
+			if ((rel->flag & DEPSREL_FLAG_CYCLIC) == 0 && child->done) {
+				children_priority = std::max(children_priority, child->eval_priority);
+			}
+		}
+		/* NOOP nodes have no cost. */
+		node->eval_priority = node->eval_cost + children_priority;
 	}
-	node->done = 1;
+}
 
-	if (node->flag & DEPSOP_FLAG_NEEDS_UPDATE) {
-		/* XXX standard cost of a node, could be estimated somewhat later on */
-		const float cost = 1.0f;
-		/* NOOP nodes have no cost */
-		node->eval_priority = node->is_noop() ? cost : 0.0f;
+static bool node_priority_less(const OperationDepsNode *a,
+                               const OperationDepsNode *b)
+{
+	return a->eval_priority < b->eval_priority;
+}
 
-		foreach (DepsRelation *rel, node->outlinks) {
-			OperationDepsNode *to = (OperationDepsNode *)rel->to;
-			BLI_assert(to->type == DEG_NODE_TYPE_OPERATION);
-			calculate_eval_priority(to);
-			node->eval_priority += to->eval_priority;
+/* Push operations which are ready to the task pool, in order of priority.
+ *
+ * The first task pushed from a running task is picked up by the same thread
+ * right after the current task, so the most critical operation is pushed
+ * first. Other tasks are put in front of the scheduler queue, so they are
+ * picked up in reverse order of pushing, and are pushed from the lowest to
+ * the highest priority.
+ */
+static void push_ready_nodes(TaskPool *pool,
+                             ReadyNodes& ready,
+                             const bool from_task,
+                             const int thread_id)
+{
+	if (ready.size() > 1) {
+		std::sort(ready.begin(), ready.end(), node_priority_less);
+		if (from_task) {
+			std::rotate(ready.begin(), ready.end() - 1, ready.end());
 		}
 	}
-	else {
-		node->eval_priority = 0.0f;
+	foreach (OperationDepsNode *node, ready) {
+		BLI_task_pool_push_from_thread(pool,
+		                               deg_task_run_func,
+		                               node,
+		                               false,
+		                               TASK_PRIORITY_HIGH,
+		                               thread_id);
 	}
 }
-#endif
 
 /* Schedule a node if it needs evaluation.
  *   dec_parents: Decrement pending parents count, true when child nodes are
  *                scheduled after a task has been completed.
  */
-static void schedule_node(TaskPool *pool, Depsgraph *graph, unsigned int layers,
-                          OperationDepsNode *node, bool dec_parents,
-                          const int thread_id)
+static void schedule_node(DepsgraphEvalState *state,
+                          OperationDepsNode *node,
+                          bool dec_parents,
+                          ReadyNodes *r_ready)
 {
 	unsigned int id_layers = node->owner->owner->layers;
 
 	if ((node->flag & DEPSOP_FLAG_NEEDS_UPDATE) != 0 &&
-	    (id_layers & layers) != 0)
+	    (id_layers & state->layers) != 0)
 	{
 		if (dec_parents) {
 			BLI_assert(node->num_links_pending > 0);
@@ -231,16 +304,12 @@ static void schedule_node(TaskPool *pool, Depsgraph *graph, unsigned int layers,
 			if (!is_scheduled) {
 				if (node->is_noop()) {
 					/* skip NOOP node, schedule children right away */
-					schedule_children(pool, graph, node, layers, thread_id);
+					node_finished(state, node);
+					schedule_children(state, node, r_ready);
 				}
 				else {
 					/* children are scheduled once this task is completed */
-					BLI_task_pool_push_from_thread(pool,
-					                               deg_task_run_func,
-					                               node,
-					                               false,
-					                               TASK_PRIORITY_HIGH,
-					                               thread_id);
+					r_ready->push_back(node);
 				}
 			}
 		}
@@ -248,19 +317,18 @@ static void schedule_node(TaskPool *pool, Depsgraph *graph, unsigned int layers,
 }
 
 static void schedule_graph(TaskPool *pool,
-                           Depsgraph *graph,
-                           const unsigned int layers)
+                           DepsgraphEvalState *state)
 {
-	foreach (OperationDepsNode *node, graph->operations) {
-		schedule_node(pool, graph, layers, node, false, 0);
+	ReadyNodes ready;
+	foreach (OperationDepsNode *node, state->graph->operations) {
+		schedule_node(state, node, false, &ready);
 	}
+	push_ready_nodes(pool, ready, false, 0);
 }
 
-static void schedule_children(TaskPool *pool,
-                              Depsgraph *graph,
+static void schedule_children(DepsgraphEvalState *state,
                               OperationDepsNode *node,
-                              const unsigned int layers,
-                              const int thread_id)
+                              ReadyNodes *r_ready)
 {
 	foreach (DepsRelation *rel, node->outlinks) {
 		OperationDepsNode *child = (OperationDepsNode *)rel->to;
@@ -269,12 +337,10 @@ static void schedule_children(TaskPool *pool,
 			/* Happens when having cyclic dependencies. */
 			continue;
 		}
-		schedule_node(pool,
-		              graph,
-		              layers,
+		schedule_node(state,
 		              child,
 		              (rel->flag & DEPSREL_FLAG_CYCLIC) == 0,
-		              thread_id);
+		              r_ready);
 	}
 }
 
@@ -324,6 +390,15 @@ void deg_evaluate_on_refresh(EvaluationContext *eval_ctx,
 		need_free_scheduler = false;
 	}
 
+	state.finished = (OperationDepsNode **)MEM_mallocN(
+	        sizeof(OperationDepsNode *) * graph->operations.size(), __func__);
+	state.num_finished = 0;
+	state.profiler = NULL;
+	if (G.debug & G_DEBUG_DEPSGRAPH_PROFILE) {
+		state.profiler = OBJECT_GUARDED_NEW(DepsgraphProfiler,
+		                                    BLI_task_scheduler_num_threads(task_scheduler));
+	}
+
 	TaskPool *task_pool = BLI_task_pool_create_suspended(task_scheduler, &state);
 
 	calculate_pending_parents(graph, layers);
@@ -333,18 +408,24 @@ void deg_evaluate_on_refresh(EvaluationContext *eval_ctx,
 		node->done = 0;
 	}
 
-	/* Calculate priority for operation nodes. */
-#ifdef USE_EVAL_PRIORITY
-	foreach (OperationDepsNode *node, graph->operations) {
-		calculate_eval_priority(node);
-	}
-#endif
-
-	schedule_graph(task_pool, graph, layers);
+	schedule_graph(task_pool, &state);
 
 	BLI_task_pool_work_and_wait(task_pool);
 	BLI_task_pool_free(task_pool);
 
+	update_eval_priorities(&state);
+	MEM_freeN(state.finished);
+
+	/* Resolve timing while the update tags are still set. */
+	if (state.profiler != NULL) {
+		if (graph->profile != NULL) {
+			OBJECT_GUARDED_DELETE(graph->profile, DepsgraphProfile);
+		}
+		graph->profile = state.profiler->finish(graph, layers);
+		graph->profile->write_report(stdout, false);
+		OBJECT_GUARDED_DELETE(state.profiler, DepsgraphProfiler);
+	}
+
 	/* Clear any uncleared tags - just in case. */
 	deg_graph_clear_tags(graph);
 
@@ -0,0 +1,357 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2017 Blender Foundation.
+ * All rights reserved.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/depsgraph/intern/eval/deg_eval_profile.cc
+ *  \ingroup depsgraph
+ *
+ * Timing of operations during graph evaluation.
+ */
+
+#include "intern/eval/deg_eval_profile.h"
+
+#include <algorithm>
+#include <deque>
+
+#include "MEM_guardedalloc.h"
+
+#include "PIL_time.h"
+
+#include "BLI_utildefines.h"
+#include "BLI_ghash.h"
+
+#include "intern/nodes/deg_node.h"
+#include "intern/nodes/deg_node_component.h"
+#include "intern/nodes/deg_node_operation.h"
+#include "intern/depsgraph.h"
+#include "util/deg_util_foreach.h"
+
+namespace DEG {
+
+/* Number of operations listed in the short report. */
+#define PROFILE_REPORT_SHORT_NUM 10
+
+namespace {
+
+/* Per operation state used to resolve the critical path. */
+struct ProfileNode {
+	OperationDepsNode *node;
+	/* Index in the profile records, -1 for operations which weren't
+	 * evaluated (NOOPs).
+	 */
+	int record;
+	int num_pending;
+	double ready_time;
+	/* Longest chain of evaluation time leading to and including this
+	 * operation, and the operation before it on that chain.
+	 */
+	double path_time;
+	int path_prev;
+};
+
+bool record_start_less(const DepsgraphProfileRecord& a,
+                       const DepsgraphProfileRecord& b)
+{
+	return a.start_time < b.start_time;
+}
+
+bool record_duration_greater(const DepsgraphProfileRecord *a,
+                             const DepsgraphProfileRecord *b)
+{
+	return a->duration() > b->duration();
+}
+
+bool node_needs_evaluation(OperationDepsNode *node, const unsigned int layers)
+{
+	return (node->flag & DEPSOP_FLAG_NEEDS_UPDATE) != 0 &&
+	       (node->owner->owner->layers & layers) != 0;
+}
+
+void write_json_string(FILE *stream, const string& str)
+{
+	fputc('"', stream);
+	for (size_t i = 0; i < str.size(); i++) {
+		const unsigned char c = str[i];
+		if (c == '"' || c == '\\') {
+			fprintf(stream, "\\%c", c);
+		}
+		else if (c < 0x20) {
+			fprintf(stream, "\\u%04x", c);
+		}
+		else {
+			fputc(c, stream);
+		}
+	}
+	fputc('"', stream);
+}
+
+}  /* namespace */
+
+DepsgraphProfiler::DepsgraphProfiler(int num_threads)
+  : m_threads(num_threads),
+    m_start_time(PIL_check_seconds_timer())
+{
+}
+
+void DepsgraphProfiler::operation_evaluated(int thread_id,
+                                            OperationDepsNode *node,
+                                            double start_time,
+                                            double end_time)
+{
+	BLI_assert(thread_id >= 0 && thread_id < (int)m_threads.size());
+	Event event;
+	event.node = node;
+	event.start_time = start_time;
+	event.end_time = end_time;
+	m_threads[thread_id].events.push_back(event);
+}
+
+DepsgraphProfile *DepsgraphProfiler::finish(Depsgraph *graph,
+                                            const unsigned int layers)
+{
+	const double end_time = PIL_check_seconds_timer();
+	DepsgraphProfile *profile = OBJECT_GUARDED_NEW(DepsgraphProfile);
+	profile->num_threads = m_threads.size();
+	profile->total_time = end_time - m_start_time;
+	profile->critical_time = 0.0;
+
+	/* Merge the per-thread buffers. */
+	for (int thread_id = 0; thread_id < (int)m_threads.size(); thread_id++) {
+		foreach (const Event& event, m_threads[thread_id].events) {
+			DepsgraphProfileRecord record;
+			record.name = event.node->full_identifier();
+			record.id_name = event.node->owner->owner->name;
+			record.thread_id = thread_id;
+			record.ready_time = event.start_time;
+			record.start_time = event.start_time;
+			record.end_time = event.end_time;
+			record.critical = false;
+			profile->records.push_back(record);
+		}
+	}
+	/* Stable, so events of a thread keep their order. */
+	std::stable_sort(profile->records.begin(),
+	                 profile->records.end(),
+	                 record_start_less);
+
+	/* Records are sorted now, map the evaluated nodes to them. */
+	GHash *record_hash = BLI_ghash_ptr_new("Depsgraph profile records");
+	{
+		vector<int> thread_offset(m_threads.size(), 0);
+		for (int i = 0; i < (int)profile->records.size(); i++) {
+			const DepsgraphProfileRecord& record = profile->records[i];
+			const Event& event =
+			        m_threads[record.thread_id].events[thread_offset[record.thread_id]++];
+			BLI_ghash_insert(record_hash, event.node, SET_INT_IN_POINTER(i + 1));
+		}
+	}
+
+	/* Operations which were part of this evaluation, including NOOPs. */
+	vector<ProfileNode> nodes;
+	GHash *node_hash = BLI_ghash_ptr_new("Depsgraph profile nodes");
+	foreach (OperationDepsNode *node, graph->operations) {
+		if (!node_needs_evaluation(node, layers)) {
+			continue;
+		}
+		ProfileNode profile_node;
+		profile_node.node = node;
+		profile_node.record = GET_INT_FROM_POINTER(BLI_ghash_lookup(record_hash, node)) - 1;
+		profile_node.num_pending = 0;
+		profile_node.ready_time = m_start_time;
+		profile_node.path_time = 0.0;
+		profile_node.path_prev = -1;
+		BLI_ghash_insert(node_hash, node, SET_INT_IN_POINTER(nodes.size() + 1));
+		nodes.push_back(profile_node);
+	}
+	foreach (ProfileNode& profile_node, nodes) {
+		foreach (DepsRelation *rel, profile_node.node->outlinks) {
+			if ((rel->flag & DEPSREL_FLAG_CYCLIC) == 0 &&
+			    BLI_ghash_haskey(node_hash, rel->to))
+			{
+				int child = GET_INT_FROM_POINTER(BLI_ghash_lookup(node_hash, rel->to)) - 1;
+				nodes[child].num_pending++;
+			}
+		}
+	}
+
+	/* Visit the operations in dependency order. An operation becomes ready
+	 * when the last one it depends on is finished, NOOPs finish right away.
+	 */
+	std::deque<int> queue;
+	for (int i = 0; i < (int)nodes.size(); i++) {
+		if (nodes[i].num_pending == 0) {
+			queue.push_back(i);
+		}
+	}
+	int critical_end = -1;
+	while (!queue.empty()) {
+		const int index = queue.front();
+		queue.pop_front();
+		ProfileNode& profile_node = nodes[index];
+
+		double finish_time = profile_node.ready_time;
+		if (profile_node.record != -1) {
+			DepsgraphProfileRecord& record = profile->records[profile_node.record];
+			record.ready_time = std::min(profile_node.ready_time, record.start_time);
+			finish_time = record.end_time;
+			profile_node.path_time += record.duration();
+		}
+		if (critical_end == -1 || profile_node.path_time > nodes[critical_end].path_time) {
+			critical_end = index;
+		}
+
+		foreach (DepsRelation *rel, profile_node.node->outlinks) {
+			if ((rel->flag & DEPSREL_FLAG_CYCLIC) != 0 ||
+			    !BLI_ghash_haskey(node_hash, rel->to))
+			{
+				continue;
+			}
+			const int child_index = GET_INT_FROM_POINTER(BLI_ghash_lookup(node_hash, rel->to)) - 1;
+			ProfileNode& child = nodes[child_index];
+			child.ready_time = std::max(child.ready_time, finish_time);
+			if (child.path_prev == -1 || profile_node.path_time > child.path_time) {
+				child.path_time = profile_node.path_time;
+				child.path_prev = index;
+			}
+			if (--child.num_pending == 0) {
+				queue.push_back(child_index);
+			}
+		}
+	}
+
+	/* Walk the critical path back from its last operation. */
+	for (int index = critical_end; index != -1; index = nodes[index].path_prev) {
+		const int record = nodes[index].record;
+		if (record != -1) {
+			profile->records[record].critical = true;
+			profile->critical_path.push_back(record);
+			profile->critical_time += profile->records[record].duration();
+		}
+	}
+	std::reverse(profile->critical_path.begin(), profile->critical_path.end());
+
+	/* Make all times relative to the start of the evaluation. */
+	foreach (DepsgraphProfileRecord& record, profile->records) {
+		record.ready_time -= m_start_time;
+		record.start_time -= m_start_time;
+		record.end_time -= m_start_time;
+	}
+
+	BLI_ghash_free(record_hash, NULL, NULL);
+	BLI_ghash_free(node_hash, NULL, NULL);
+	return profile;
+}
+
+void DepsgraphProfile::write_trace(FILE *stream) const
+{
+	fprintf(stream, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+	for (int thread_id = 0; thread_id < num_threads; thread_id++) {
+		fprintf(stream,
+		        "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": %d, "
+		        "\"args\": {\"name\": \"%s %d\"}},\n",
+		        thread_id,
+		        (thread_id == 0) ? "Main" : "Worker",
+		        thread_id);
+	}
+	for (size_t i = 0; i < records.size(); i++) {
+		const DepsgraphProfileRecord& record = records[i];
+		fprintf(stream, "{\"name\": ");
+		write_json_string(stream, record.name);
+		fprintf(stream, ", \"cat\": ");
+		write_json_string(stream, record.id_name);
+		/* Trace timestamps are in microseconds. */
+		fprintf(stream,
+		        ", \"ph\": \"X\", \"pid\": 0, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f, "
+		        "\"args\": {\"wait_ms\": %.3f, \"critical\": %s}}%s\n",
+		        record.thread_id,
+		        record.start_time * 1e6,
+		        record.duration() * 1e6,
+		        record.wait_time() * 1e3,
+		        record.critical ? "true" : "false",
+		        (i + 1 < records.size()) ? "," : "");
+	}
+	fprintf(stream, "]}\n");
+}
+
+void DepsgraphProfile::write_report(FILE *stream, bool full) const
+{
+	double operations_time = 0.0;
+	foreach (const DepsgraphProfileRecord& record, records) {
+		operations_time += record.duration();
+	}
+
+	fprintf(stream,
+	        "Depsgraph evaluation: %d operations on %d threads in %.3f ms\n",
+	        (int)records.size(),
+	        num_threads,
+	        total_time * 1e3);
+	if (records.empty()) {
+		return;
+	}
+	fprintf(stream,
+	        "  Operations: %.3f ms, parallelism %.2f\n",
+	        operations_time * 1e3,
+	        (total_time > 0.0) ? operations_time / total_time : 0.0);
+	fprintf(stream,
+	        "  Critical path: %d operations, %.3f ms (%.1f%% of evaluation)\n",
+	        (int)critical_path.size(),
+	        critical_time * 1e3,
+	        (total_time > 0.0) ? critical_time / total_time * 100.0 : 0.0);
+
+	vector<const DepsgraphProfileRecord *> listed;
+	foreach (int index, critical_path) {
+		listed.push_back(&records[index]);
+	}
+	if (!full) {
+		/* Only the operations which serialize the evaluation the most. */
+		std::sort(listed.begin(), listed.end(), record_duration_greater);
+		if (listed.size() > PROFILE_REPORT_SHORT_NUM) {
+			listed.resize(PROFILE_REPORT_SHORT_NUM);
+		}
+	}
+	foreach (const DepsgraphProfileRecord *record, listed) {
+		fprintf(stream,
+		        "    %9.3f ms  wait %8.3f ms  thread %2d  %s\n",
+		        record->duration() * 1e3,
+		        record->wait_time() * 1e3,
+		        record->thread_id,
+		        record->name.c_str());
+	}
+
+	if (full) {
+		vector<double> busy_time(num_threads, 0.0);
+		vector<int> num_operations(num_threads, 0);
+		foreach (const DepsgraphProfileRecord& record, records) {
+			busy_time[record.thread_id] += record.duration();
+			num_operations[record.thread_id]++;
+		}
+		for (int thread_id = 0; thread_id < num_threads; thread_id++) {
+			fprintf(stream,
+			        "  Thread %2d: %d operations, %.3f ms busy\n",
+			        thread_id,
+			        num_operations[thread_id],
+			        busy_time[thread_id] * 1e3);
+		}
+	}
+}
+
+}  // namespace DEG
@@ -0,0 +1,125 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2017 Blender Foundation.
+ * All rights reserved.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/depsgraph/intern/eval/deg_eval_profile.h
+ *  \ingroup depsgraph
+ *
+ * Timing of operations during graph evaluation.
+ */
+
+#pragma once
+
+#include <stdio.h>
+
+#include "intern/depsgraph_types.h"
+
+namespace DEG {
+
+struct Depsgraph;
+struct OperationDepsNode;
+
+/* Timing of a single evaluated operation. All times are in seconds,
+ * relative to the start of the evaluation.
+ */
+struct DepsgraphProfileRecord {
+	/* Full identifier of the operation, nodes might be freed after the
+	 * evaluation so no pointer is kept.
+	 */
+	string name;
+	/* Name of the ID the operation belongs to. */
+	string id_name;
+	int thread_id;
+	/* All operations this one depends on were evaluated. */
+	double ready_time;
+	double start_time;
+	double end_time;
+	/* Operation is on the critical path of the evaluation. */
+	bool critical;
+
+	double duration() const { return end_time - start_time; }
+	double wait_time() const { return start_time - ready_time; }
+};
+
+/* Result of a profiled evaluation, kept in the graph until the next one. */
+struct DepsgraphProfile {
+	/* Evaluated operations, in order of their start time. */
+	vector<DepsgraphProfileRecord> records;
+	/* Indices in records of the critical path, in evaluation order. */
+	vector<int> critical_path;
+	int num_threads;
+	/* Wall time of the whole evaluation. */
+	double total_time;
+	/* Sum of the evaluation time of the operations on the critical path.
+	 * No matter how many threads are used, the evaluation can't be faster.
+	 */
+	double critical_time;
+
+	/* Chrome trace event format, can be loaded in chrome://tracing. */
+	void write_trace(FILE *stream) const;
+	/* Human readable summary. When full is false only the slowest operations
+	 * of the critical path are listed.
+	 */
+	void write_report(FILE *stream, bool full) const;
+};
+
+/* Collects the timing of operations while the graph is evaluated.
+ *
+ * Every thread of the task scheduler appends to its own buffer, so no
+ * locking is needed while evaluating.
+ */
+class DepsgraphProfiler {
+public:
+	DepsgraphProfiler(int num_threads);
+
+	/* Called by the thread which evaluated the operation, times are taken
+	 * with PIL_check_seconds_timer().
+	 */
+	void operation_evaluated(int thread_id,
+	                         OperationDepsNode *node,
+	                         double start_time,
+	                         double end_time);
+
+	/* Resolve the dependencies between the evaluated operations and find
+	 * the critical path. Must be called before the update tags of the
+	 * graph are cleared.
+	 */
+	DepsgraphProfile *finish(Depsgraph *graph, const unsigned int layers);
+
+protected:
+	struct Event {
+		OperationDepsNode *node;
+		double start_time;
+		double end_time;
+	};
+
+	struct ThreadEvents {
+		vector<Event> events;
+		/* Avoid false sharing between threads appending events. */
+		char pad[64];
+	};
+
+	vector<ThreadEvents> m_threads;
+	double m_start_time;
+};
+
+}  // namespace DEG
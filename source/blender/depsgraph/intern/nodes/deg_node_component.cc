@@ -225,6 +225,7 @@ OperationDepsNode *ComponentDepsNode::add_operation(const DepsEvalOperationCb& o
 	op_node->evaluate = op;
 	op_node->opcode = opcode;
 	op_node->name = name;
+	op_node->name_tag = name_tag;
 
 	return op_node;
 }
@@ -333,6 +334,22 @@ void ComponentDepsNode::finalize_build()
 	operations_map = NULL;
 }
 
+void ComponentDepsNode::begin_update()
+{
+	BLI_assert(operations_map == NULL);
+	operations_map = BLI_ghash_new(comp_node_hash_key,
+	                               comp_node_hash_key_cmp,
+	                               "Depsgraph id hash");
+	foreach (OperationDepsNode *op_node, operations) {
+		OperationIDKey *key = OBJECT_GUARDED_NEW(OperationIDKey,
+		                                         op_node->opcode,
+		                                         op_node->name,
+		                                         op_node->name_tag);
+		BLI_ghash_insert(operations_map, key, op_node);
+	}
+	operations.clear();
+}
+
 /* Parameter Component Defines ============================ */
 
 DEG_DEPSNODE_DEFINE(ParametersComponentDepsNode, DEG_NODE_TYPE_PARAMETERS, "Parameters Component");
@@ -132,6 +132,10 @@ struct ComponentDepsNode : public DepsNode {
 	OperationDepsNode *get_exit_operation();
 
 	void finalize_build();
+	/* Reverse of finalize_build(), allows to look up and add operations
+	 * again when the graph is updated.
+	 */
+	void begin_update();
 
 	IDDepsNode *owner;
 
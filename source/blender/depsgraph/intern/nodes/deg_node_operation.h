@@ -74,11 +74,20 @@ struct OperationDepsNode : public DepsNode {
 
 	/* How many inlinks are we still waiting on before we can be evaluated. */
 	uint32_t num_links_pending;
+	/* Length of the longest chain of evaluation time starting at this
+	 * operation, as measured by the last evaluation.
+	 */
 	float eval_priority;
+	/* Moving average of the evaluation time of this operation in seconds,
+	 * zero until it was evaluated once.
+	 */
+	float eval_cost;
 	bool scheduled;
 
 	/* Identifier for the operation being performed. */
 	eDepsOperation_Code opcode;
+	/* Tag which was used together with the name to add the operation. */
+	int name_tag;
 
 	/* (eDepsOperation_Flag) extra settings affecting evaluation. */
 	int flag;
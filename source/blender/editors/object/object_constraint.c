@@ -1221,7 +1221,7 @@ void ED_object_constraint_dependency_update(Main *bmain, Object *ob)
 	if (ob->pose) {
 		object_pose_tag_update(bmain, ob);
 	}
-	DAG_relations_tag_update(bmain);
+	DAG_id_relations_tag_update(bmain, &ob->id);
 }
 
 void ED_object_constraint_tag_update(Object *ob, bConstraint *con)
@@ -1245,7 +1245,7 @@ void ED_object_constraint_dependency_tag_update(Main *bmain, Object *ob, bConstr
 	if (ob->pose) {
 		object_pose_tag_update(bmain, ob);
 	}
-	DAG_relations_tag_update(bmain);
+	DAG_id_relations_tag_update(bmain, &ob->id);
 }
 
 static int constraint_poll(bContext *C)
@@ -1269,7 +1269,7 @@ static int constraint_delete_exec(bContext *C, wmOperator *UNUSED(op))
 		ED_object_constraint_update(ob); /* needed to set the flags on posebones correctly */
 
 		/* relatiols */
-		DAG_relations_tag_update(CTX_data_main(C));
+		DAG_id_relations_tag_update(CTX_data_main(C), &ob->id);
 
 		/* notifiers */
 		WM_event_add_notifier(C, NC_OBJECT | ND_CONSTRAINT | NA_REMOVED, ob);
@@ -82,6 +82,20 @@ void ED_undo_push(bContext *C, const char *str)
 	if (G.debug & G_DEBUG)
 		printf("%s: %s\n", __func__, str);
 
+	/* Edit and paint modes, and operators in general, may modify object data in place without
+	 * tagging it for update. They work on the active and selected objects, make sure the memfile
+	 * undo push doesn't re-use the old state of their data. */
+	if (obact && obact->data) {
+		((ID *)obact->data)->tag &= ~LIB_TAG_UNDO_UNCHANGED;
+	}
+	CTX_DATA_BEGIN(C, Object *, ob, selected_objects)
+	{
+		if (ob->data) {
+			((ID *)ob->data)->tag &= ~LIB_TAG_UNDO_UNCHANGED;
+		}
+	}
+	CTX_DATA_END;
+
 	if (obedit) {
 		if (U.undosteps == 0) return;
 		
@@ -356,6 +356,10 @@ enum {
 	/* Datablock was not allocated by standard system (BKE_libblock_alloc), do not free its memory
 	 * (usual type-specific freeing is called though). */
 	LIB_TAG_NOT_ALLOCATED     = 1 << 18,
+
+	/* RESET_AFTER_USE set by memfile undo on the datablocks it wrote, cleared as soon as they get tagged for update.
+	 * Next undo push can re-use the previously written data of datablocks still having it. */
+	LIB_TAG_UNDO_UNCHANGED    = 1 << 19,
 };
 
 /* To filter ID types (filter_id) */
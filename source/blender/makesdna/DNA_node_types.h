@@ -378,7 +378,7 @@ typedef struct bNodeTree {
 	 * in case multiple different editors are used and make context ambiguous.
 	 */
 	bNodeInstanceKey active_viewer_key;
-	int pad;
+	int cache_size;					/* memory used for keeping compositor results between executions, in MB */
 	
 	/* execution data */
 	/* XXX It would be preferable to completely move this data out of the underlying node tree,
@@ -417,6 +417,7 @@ typedef struct bNodeTree {
 #define NTREE_COM_GROUPNODE_BUFFER	8	/* use groupnode buffers */
 #define NTREE_VIEWER_BORDER			16	/* use a border for viewer nodes */
 #define NTREE_IS_LOCALIZED			32	/* tree is localized copy, free when deleting node groups */
+#define NTREE_COM_FULL_FRAME		64	/* execute operations on the whole frame instead of in chunks */
 
 /* XXX not nice, but needed as a temporary flags
  * for group updates after library linking.
@@ -1882,11 +1882,22 @@ bool RNA_property_path_from_ID_check(PointerRNA *ptr, PropertyRNA *prop)
 }
 
 
+/* Memfile undo re-uses the previous state of IDs still tagged unchanged. Any change
+ * through RNA clears the tag, whether or not an update is called or tags the ID. */
+static void rna_id_tag_undo_changed(PointerRNA *ptr)
+{
+	if (ptr->id.data) {
+		((ID *)ptr->id.data)->tag &= ~LIB_TAG_UNDO_UNCHANGED;
+	}
+}
+
 static void rna_property_update(bContext *C, Main *bmain, Scene *scene, PointerRNA *ptr, PropertyRNA *prop)
 {
 	const bool is_rna = (prop->magic == RNA_MAGIC);
 	prop = rna_ensure_property(prop);
 
+	rna_id_tag_undo_changed(ptr);
+
 	if (is_rna) {
 		if (prop->update) {
 			/* ideally no context would be needed for update, but there's some
@@ -2084,6 +2095,8 @@ void RNA_property_boolean_set(PointerRNA *ptr, PropertyRNA *prop, int value)
 	BLI_assert(RNA_property_array_check(prop) == false);
 	BLI_assert(ELEM(value, false, true));
 
+	rna_id_tag_undo_changed(ptr);
+
 	/* just in case other values are passed */
 	if (value) value = 1;
 
@@ -2172,6 +2185,8 @@ void RNA_property_boolean_set_array(PointerRNA *ptr, PropertyRNA *prop, const in
 	BLI_assert(RNA_property_type(prop) == PROP_BOOLEAN);
 	BLI_assert(RNA_property_array_check(prop) != false);
 
+	rna_id_tag_undo_changed(ptr);
+
 	if ((idprop = rna_idproperty_check(&prop, ptr))) {
 		if (prop->arraydimension == 0)
 			IDP_Int(idprop) = values[0];
@@ -2213,6 +2228,8 @@ void RNA_property_boolean_set_index(PointerRNA *ptr, PropertyRNA *prop, int inde
 	BLI_assert(index < len);
 	BLI_assert(ELEM(value, false, true));
 
+	rna_id_tag_undo_changed(ptr);
+
 	if (len <= RNA_MAX_ARRAY_LENGTH) {
 		RNA_property_boolean_get_array(ptr, prop, tmp);
 		tmp[index] = value;
@@ -2306,6 +2323,8 @@ void RNA_property_int_set(PointerRNA *ptr, PropertyRNA *prop, int value)
 
 	BLI_assert(RNA_property_type(prop) == PROP_INT);
 	BLI_assert(RNA_property_array_check(prop) == false);
+
+	rna_id_tag_undo_changed(ptr);
 	/* useful to check on bad values but set function should clamp */
 	/* BLI_assert(RNA_property_int_clamp(ptr, prop, &value) == 0); */
 
@@ -2430,6 +2449,8 @@ void RNA_property_int_set_array(PointerRNA *ptr, PropertyRNA *prop, const int *v
 	BLI_assert(RNA_property_type(prop) == PROP_INT);
 	BLI_assert(RNA_property_array_check(prop) != false);
 
+	rna_id_tag_undo_changed(ptr);
+
 	if ((idprop = rna_idproperty_check(&prop, ptr))) {
 		BLI_assert(idprop->len == RNA_property_array_length(ptr, prop) || (prop->flag & PROP_IDPROPERTY));
 		if (prop->arraydimension == 0)
@@ -2473,6 +2494,8 @@ void RNA_property_int_set_index(PointerRNA *ptr, PropertyRNA *prop, int index, i
 	BLI_assert(index >= 0);
 	BLI_assert(index < len);
 
+	rna_id_tag_undo_changed(ptr);
+
 	if (len <= RNA_MAX_ARRAY_LENGTH) {
 		RNA_property_int_get_array(ptr, prop, tmp);
 		tmp[index] = value;
@@ -2565,6 +2588,8 @@ void RNA_property_float_set(PointerRNA *ptr, PropertyRNA *prop, float value)
 
 	BLI_assert(RNA_property_type(prop) == PROP_FLOAT);
 	BLI_assert(RNA_property_array_check(prop) == false);
+
+	rna_id_tag_undo_changed(ptr);
 	/* useful to check on bad values but set function should clamp */
 	/* BLI_assert(RNA_property_float_clamp(ptr, prop, &value) == 0); */
 
@@ -2702,6 +2727,8 @@ void RNA_property_float_set_array(PointerRNA *ptr, PropertyRNA *prop, const floa
 	BLI_assert(RNA_property_type(prop) == PROP_FLOAT);
 	BLI_assert(RNA_property_array_check(prop) != false);
 
+	rna_id_tag_undo_changed(ptr);
+
 	if ((idprop = rna_idproperty_check(&prop, ptr))) {
 		BLI_assert(idprop->len == RNA_property_array_length(ptr, prop) || (prop->flag & PROP_IDPROPERTY));
 		if (prop->arraydimension == 0) {
@@ -2756,6 +2783,8 @@ void RNA_property_float_set_index(PointerRNA *ptr, PropertyRNA *prop, int index,
 	BLI_assert(index >= 0);
 	BLI_assert(index < len);
 
+	rna_id_tag_undo_changed(ptr);
+
 	if (len <= RNA_MAX_ARRAY_LENGTH) {
 		RNA_property_float_get_array(ptr, prop, tmp);
 		tmp[index] = value;
@@ -2920,6 +2949,8 @@ void RNA_property_string_set(PointerRNA *ptr, PropertyRNA *prop, const char *val
 
 	BLI_assert(RNA_property_type(prop) == PROP_STRING);
 
+	rna_id_tag_undo_changed(ptr);
+
 	if ((idprop = rna_idproperty_check(&prop, ptr))) {
 		/* both IDP_STRING_SUB_BYTE / IDP_STRING_SUB_UTF8 */
 		IDP_AssignString(idprop, value, RNA_property_string_maxlength(prop) - 1);
@@ -3000,6 +3031,8 @@ void RNA_property_enum_set(PointerRNA *ptr, PropertyRNA *prop, int value)
 
 	BLI_assert(RNA_property_type(prop) == PROP_ENUM);
 
+	rna_id_tag_undo_changed(ptr);
+
 	if ((idprop = rna_idproperty_check(&prop, ptr))) {
 		IDP_Int(idprop) = value;
 		rna_idproperty_touch(idprop);
@@ -3118,6 +3151,8 @@ void RNA_property_pointer_set(PointerRNA *ptr, PropertyRNA *prop, PointerRNA ptr
 	PointerPropertyRNA *pprop = (PointerPropertyRNA *)prop;
 	BLI_assert(RNA_property_type(prop) == PROP_POINTER);
 
+	rna_id_tag_undo_changed(ptr);
+
 	/* Check types */
 	if (ptr_value.type != NULL && !RNA_struct_is_a(ptr_value.type, pprop->type)) {
 		printf("%s: expected %s type, not %s.\n", __func__, pprop->type->identifier, ptr_value.type->identifier);
@@ -3688,6 +3723,11 @@ static int rna_raw_access(ReportList *reports, PointerRNA *ptr, PropertyRNA *pro
 	in.len = inlen;
 	in.stride = 0;
 
+	/* raw arrays are written directly, not through the set functions */
+	if (set) {
+		rna_id_tag_undo_changed(ptr);
+	}
+
 	ptype = RNA_property_pointer_type(ptr, prop);
 
 	/* try to get item property pointer */
@@ -6370,6 +6410,8 @@ void RNA_parameter_dynamic_length_set_data(ParameterList *UNUSED(parms), Propert
 int RNA_function_call(bContext *C, ReportList *reports, PointerRNA *ptr, FunctionRNA *func, ParameterList *parms)
 {
 	if (func->call) {
+		/* functions like mesh.vertices.add() change data without tagging it */
+		rna_id_tag_undo_changed(ptr);
 		func->call(C, reports, ptr, parms);
 
 		return 0;
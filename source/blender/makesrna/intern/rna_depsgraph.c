@@ -42,6 +42,8 @@
 
 #ifdef RNA_RUNTIME
 
+#include "BKE_report.h"
+
 #include "DEG_depsgraph_build.h"
 #include "DEG_depsgraph_debug.h"
 
@@ -55,6 +57,32 @@ static void rna_Depsgraph_debug_graphviz(Depsgraph *graph, const char *filename)
 	fclose(f);
 }
 
+static void rna_Depsgraph_debug_profile_trace(Depsgraph *graph, ReportList *reports, const char *filename)
+{
+	FILE *f = fopen(filename, "w");
+	if (f == NULL) {
+		BKE_reportf(reports, RPT_ERROR, "Cannot open file '%s' for writing", filename);
+		return;
+	}
+	if (!DEG_debug_profile_trace(graph, f)) {
+		BKE_report(reports, RPT_ERROR, "No evaluation was profiled, enable bpy.app.debug_depsgraph_profile");
+	}
+	fclose(f);
+}
+
+static void rna_Depsgraph_debug_profile_report(Depsgraph *graph, ReportList *reports, const char *filename)
+{
+	FILE *f = fopen(filename, "w");
+	if (f == NULL) {
+		BKE_reportf(reports, RPT_ERROR, "Cannot open file '%s' for writing", filename);
+		return;
+	}
+	if (!DEG_debug_profile_report(graph, f)) {
+		BKE_report(reports, RPT_ERROR, "No evaluation was profiled, enable bpy.app.debug_depsgraph_profile");
+	}
+	fclose(f);
+}
+
 static void rna_Depsgraph_debug_tag_update(Depsgraph *graph)
 {
 	DEG_graph_tag_relations_update(graph);
@@ -85,6 +113,20 @@ static void rna_def_depsgraph(BlenderRNA *brna)
 	                                "File in which to store graphviz debug output");
 	RNA_def_parameter_flags(parm, 0, PARM_REQUIRED);
 
+	func = RNA_def_function(srna, "debug_profile_trace", "rna_Depsgraph_debug_profile_trace");
+	RNA_def_function_ui_description(func, "Store the timing of the last profiled evaluation in Chrome trace format");
+	RNA_def_function_flag(func, FUNC_USE_REPORTS);
+	parm = RNA_def_string_file_path(func, "filename", NULL, FILE_MAX, "File Name",
+	                                "File in which to store the trace, can be opened in chrome://tracing");
+	RNA_def_parameter_flags(parm, 0, PARM_REQUIRED);
+
+	func = RNA_def_function(srna, "debug_profile_report", "rna_Depsgraph_debug_profile_report");
+	RNA_def_function_ui_description(func, "Store the critical path of the last profiled evaluation");
+	RNA_def_function_flag(func, FUNC_USE_REPORTS);
+	parm = RNA_def_string_file_path(func, "filename", NULL, FILE_MAX, "File Name",
+	                                "File in which to store the report");
+	RNA_def_parameter_flags(parm, 0, PARM_REQUIRED);
+
 	func = RNA_def_function(srna, "debug_tag_update", "rna_Depsgraph_debug_tag_update");
 
 	func = RNA_def_function(srna, "debug_stats", "rna_Depsgraph_debug_stats");
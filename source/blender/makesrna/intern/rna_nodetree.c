@@ -8297,6 +8297,13 @@ static void rna_def_composite_nodetree(BlenderRNA *brna)
 	RNA_def_property_ui_text(prop, "Chunksize", "Max size of a tile (smaller values gives better distribution "
 	                                            "of multiple threads, but more overhead)");
 
+	prop = RNA_def_property(srna, "cache_size", PROP_INT, PROP_NONE);
+	RNA_def_property_int_sdna(prop, NULL, "cache_size");
+	RNA_def_property_range(prop, 0, INT_MAX);
+	RNA_def_property_ui_range(prop, 0, 16384, 128, -1);
+	RNA_def_property_ui_text(prop, "Cache Size", "Memory used to keep results of nodes between updates, "
+	                                             "so only nodes after a changed node are calculated again (in MB, 0 to disable)");
+
 	prop = RNA_def_property(srna, "use_opencl", PROP_BOOLEAN, PROP_NONE);
 	RNA_def_property_boolean_sdna(prop, NULL, "flag", NTREE_COM_OPENCL);
 	RNA_def_property_ui_text(prop, "OpenCL", "Enable GPU calculations");
@@ -8314,6 +8321,11 @@ static void rna_def_composite_nodetree(BlenderRNA *brna)
 	RNA_def_property_boolean_sdna(prop, NULL, "flag", NTREE_VIEWER_BORDER);
 	RNA_def_property_ui_text(prop, "Viewer Border", "Use boundaries for viewer nodes and composite backdrop");
 	RNA_def_property_update(prop, NC_NODE | ND_DISPLAY, "rna_NodeTree_update");
+
+	prop = RNA_def_property(srna, "use_full_frame", PROP_BOOLEAN, PROP_NONE);
+	RNA_def_property_boolean_sdna(prop, NULL, "flag", NTREE_COM_FULL_FRAME);
+	RNA_def_property_ui_text(prop, "Full Frame", "Calculate each node on the whole frame at once instead of in chunks, "
+	                                             "faster for large trees but results are only shown when finished");
 }
 
 static void rna_def_shader_nodetree(BlenderRNA *brna)
@@ -185,6 +185,12 @@ static void update(bNodeTree *ntree)
 	}
 }
 
+static void init(bNodeTree *ntree)
+{
+	/* memory budget for keeping results between executions, in MB */
+	ntree->cache_size = 1024;
+}
+
 static void composite_node_add_init(bNodeTree *UNUSED(bnodetree), bNode *bnode)
 {
 	/* Composite node will only show previews for input classes 
@@ -213,6 +219,7 @@ void register_node_tree_type_cmp(void)
 	tt->localize = localize;
 	tt->local_sync = local_sync;
 	tt->local_merge = local_merge;
+	tt->init = init;
 	tt->update = update;
 	tt->get_from_context = composite_get_from_context;
 	tt->node_add_init = composite_node_add_init;
@@ -280,6 +287,11 @@ void ntreeCompositTagRender(Scene *curscene)
 {
 	Scene *sce;
 
+#ifdef WITH_COMPOSITOR
+	/* render results of the scene changed, cached results of render layer nodes can't be used */
+	COM_tagChangedID(&curscene->id);
+#endif
+
 	for (sce = G.main->scene.first; sce; sce = sce->id.next) {
 		if (sce->nodetree) {
 			bNode *node;
@@ -1979,8 +1979,11 @@ static void render_scene(Render *re, Scene *sce, int cfra)
 	resc->sdh = re->sdh;
 	resc->current_scene_update = re->current_scene_update;
 	resc->suh = re->suh;
-	
+
 	do_render_fields_blur_3d(resc);
+
+	/* new render result, cached compositor results of its render layer nodes are stale */
+	ntreeCompositTagRender(sce);
 }
 
 /* helper call to detect if this scene needs a render, or if there's a any render layer to render */
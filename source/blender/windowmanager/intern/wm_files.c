@@ -87,6 +87,7 @@
 #include "BKE_scene.h"
 #include "BKE_screen.h"
 
+#include "BLO_blend_defs.h"
 #include "BLO_readfile.h"
 #include "BLO_writefile.h"
 
@@ -119,6 +120,10 @@
 #include "BPY_extern.h"
 #endif
 
+#ifdef WITH_COMPOSITOR
+#include "COM_compositor.h"
+#endif
+
 #include "WM_api.h"
 #include "WM_types.h"
 #include "wm.h"
@@ -361,7 +366,7 @@ static int wm_read_exotic(const char *name)
 {
 	int len;
 	gzFile gzfile;
-	char header[7];
+	char header[BLEN_ZBLOCK_MAGIC_LEN];
 	int retval;
 
 	/* make sure we're not trying to read a directory.... */
@@ -378,7 +383,9 @@ static int wm_read_exotic(const char *name)
 		else {
 			len = gzread(gzfile, header, sizeof(header));
 			gzclose(gzfile);
-			if (len == sizeof(header) && STREQLEN(header, "BLENDER", 7)) {
+			if (len == sizeof(header) &&
+			    (STREQLEN(header, "BLENDER", 7) || STREQLEN(header, BLEN_ZBLOCK_MAGIC, BLEN_ZBLOCK_MAGIC_LEN)))
+			{
 				retval = BKE_READ_EXOTIC_OK_BLEND;
 			}
 			else {
@@ -464,6 +471,11 @@ static void wm_file_read_post(bContext *C, const bool is_startup_file, const boo
 	ED_editors_init(C);
 	DAG_on_visible_update(CTX_data_main(C), true);
 
+#ifdef WITH_COMPOSITOR
+	/* cached results refer to data of the previous file */
+	COM_clearCaches();
+#endif
+
 #ifdef WITH_PYTHON
 	if (is_startup_file) {
 		/* possible python hasn't been initialized */
@@ -1168,6 +1180,7 @@ static int wm_file_write(bContext *C, const char *filepath, int fileflags, Repor
 		}
 
 		BKE_BIT_TEST_SET(G.fileflags, fileflags & G_FILE_COMPRESS, G_FILE_COMPRESS);
+		BKE_BIT_TEST_SET(G.fileflags, fileflags & G_FILE_COMPRESS_BLOCKS, G_FILE_COMPRESS_BLOCKS);
 		BKE_BIT_TEST_SET(G.fileflags, fileflags & G_FILE_AUTOPLAY, G_FILE_AUTOPLAY);
 
 		/* prevent background mode scripts from clobbering history */
@@ -1985,6 +1998,12 @@ static void save_set_compress(wmOperator *op)
 			RNA_property_boolean_set(op->ptr, prop, (U.flag & USER_FILECOMPRESS) != 0);
 		}
 	}
+
+	prop = RNA_struct_find_property(op->ptr, "compress_blocks");
+	if (!RNA_property_is_set(op->ptr, prop)) {
+		/* keep flag for existing file */
+		RNA_property_boolean_set(op->ptr, prop, G.save_over && (G.fileflags & G_FILE_COMPRESS_BLOCKS) != 0);
+	}
 }
 
 static void save_set_filepath(wmOperator *op)
@@ -2040,6 +2059,8 @@ static int wm_save_as_mainfile_exec(bContext *C, wmOperator *op)
 	/* set compression flag */
 	BKE_BIT_TEST_SET(fileflags, RNA_boolean_get(op->ptr, "compress"),
 	                 G_FILE_COMPRESS);
+	BKE_BIT_TEST_SET(fileflags, RNA_boolean_get(op->ptr, "compress_blocks"),
+	                 G_FILE_COMPRESS_BLOCKS);
 	BKE_BIT_TEST_SET(fileflags, RNA_boolean_get(op->ptr, "relative_remap"),
 	                 G_FILE_RELATIVE_REMAP);
 	BKE_BIT_TEST_SET(fileflags,
@@ -2096,6 +2117,9 @@ void WM_OT_save_as_mainfile(wmOperatorType *ot)
 	        ot, FILE_TYPE_FOLDER | FILE_TYPE_BLENDER, FILE_BLENDER, FILE_SAVE,
 	        WM_FILESEL_FILEPATH, FILE_DEFAULTDISPLAY, FILE_SORT_ALPHA);
 	RNA_def_boolean(ot->srna, "compress", false, "Compress", "Write compressed .blend file");
+	RNA_def_boolean(ot->srna, "compress_blocks", false, "Multithreaded Compression",
+	                "Compress in independent blocks, faster to save and load, "
+	                "but can't be opened by older Blender versions");
 	RNA_def_boolean(ot->srna, "relative_remap", true, "Remap Relative",
 	                "Remap relative paths when saving in a different directory");
 	prop = RNA_def_boolean(ot->srna, "copy", false, "Save Copy",
@@ -2162,6 +2186,9 @@ void WM_OT_save_mainfile(wmOperatorType *ot)
 	        ot, FILE_TYPE_FOLDER | FILE_TYPE_BLENDER, FILE_BLENDER, FILE_SAVE,
 	        WM_FILESEL_FILEPATH, FILE_DEFAULTDISPLAY, FILE_SORT_ALPHA);
 	RNA_def_boolean(ot->srna, "compress", false, "Compress", "Write compressed .blend file");
+	RNA_def_boolean(ot->srna, "compress_blocks", false, "Multithreaded Compression",
+	                "Compress in independent blocks, faster to save and load, "
+	                "but can't be opened by older Blender versions");
 	RNA_def_boolean(ot->srna, "relative_remap", false, "Remap Relative",
 	                "Remap relative paths when saving in a different directory");
 }
@@ -4,11 +4,13 @@
 #include "BLI_ressource_strings.h"
 
 #define GHASH_INTERNAL_API
+#define OHASH_INTERNAL_API
 
 extern "C" {
 #include "MEM_guardedalloc.h"
 #include "BLI_utildefines.h"
 #include "BLI_ghash.h"
+#include "BLI_ohash.h"
 #include "BLI_rand.h"
 #include "BLI_string.h"
 #include "PIL_time_utildefines.h"
@@ -38,6 +40,17 @@ extern "C" {
 	       BLI_ghash_size(_gh), q, var, lf, pempty * 100.0, poverloaded * 100.0, bigb); \
 } void (0)
 
+#define PRINTF_OHASH_STATS(_oh) \
+{ \
+	double q, lf; \
+	int maxp; \
+	q = BLI_ohash_calc_quality_ex((_oh), &lf, &maxp); \
+	printf("OHash stats (%u entries):\n\t" \
+	       "Average probed groups (the lower the better): %f\n\tLoad: %f\n\t" \
+	       "Longest probe sequence: %d\n", \
+	       BLI_ohash_size(_oh), q, lf, maxp); \
+} void (0)
+
 /* Str: whole text, lines and words from a 'corpus' text. */
 
 static void str_ghash_tests(GHash *ghash, const char *id)
@@ -534,3 +547,286 @@ TEST(ghash, MultiRandIntMurmur2a200000)
 
 	multi_small_ghash_tests(ghash, "MultiSmall RandIntGHash - Murmur2a - 200000", 200000);
 }
+
+
+/* OHash: same cases as above for the open-addressing hash, to compare against GHash. */
+
+static void str_ohash_tests(OHash *ohash, const char *id)
+{
+	printf("\n========== STARTING %s ==========\n", id);
+
+	char *data = BLI_strdup(words10k);
+	char *data_w = BLI_strdup(data);
+	char *data_bis = BLI_strdup(data);
+
+	{
+		char *w, *c_w;
+
+		TIMEIT_START(string_insert);
+
+		for (w = c_w = data_w; *c_w; c_w++) {
+			if (ELEM(*c_w, '.', ' ')) {
+				*c_w = '\0';
+				if (!BLI_ohash_haskey(ohash, w)) {
+					BLI_ohash_insert(ohash, w, SET_INT_IN_POINTER(w[0]));
+				}
+				w = c_w + 1;
+			}
+		}
+
+		TIMEIT_END(string_insert);
+	}
+
+	PRINTF_OHASH_STATS(ohash);
+
+	{
+		char *w, *c;
+
+		TIMEIT_START(string_lookup);
+
+		for (w = c = data_bis; *c; c++) {
+			if (ELEM(*c, '.', ' ')) {
+				*c = '\0';
+				void *v = BLI_ohash_lookup(ohash, w);
+				EXPECT_EQ(GET_INT_FROM_POINTER(v), w[0]);
+				w = c + 1;
+			}
+		}
+
+		TIMEIT_END(string_lookup);
+	}
+
+	BLI_ohash_free(ohash, NULL, NULL);
+	MEM_freeN(data);
+	MEM_freeN(data_w);
+	MEM_freeN(data_bis);
+
+	printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(ohash, TextOHash)
+{
+	OHash *ohash = BLI_ohash_new(BLI_ghashutil_strhash_p, BLI_ghashutil_strcmp, __func__);
+
+	str_ohash_tests(ohash, "StrOHash - OHash");
+}
+
+static void int_ohash_tests(OHash *ohash, const char *id, const unsigned int nbr)
+{
+	printf("\n========== STARTING %s ==========\n", id);
+
+	{
+		unsigned int i = nbr;
+
+		TIMEIT_START(int_insert);
+
+		while (i--) {
+			BLI_ohash_insert(ohash, SET_UINT_IN_POINTER(i), SET_UINT_IN_POINTER(i));
+		}
+
+		TIMEIT_END(int_insert);
+	}
+
+	PRINTF_OHASH_STATS(ohash);
+
+	{
+		unsigned int i = nbr;
+
+		TIMEIT_START(int_lookup);
+
+		while (i--) {
+			void *v = BLI_ohash_lookup(ohash, SET_UINT_IN_POINTER(i));
+			EXPECT_EQ(GET_UINT_FROM_POINTER(v), i);
+		}
+
+		TIMEIT_END(int_lookup);
+	}
+
+	{
+		unsigned int i = nbr;
+
+		TIMEIT_START(int_remove);
+
+		while (i--) {
+			void *v = BLI_ohash_popkey(ohash, SET_UINT_IN_POINTER(i), NULL);
+			EXPECT_EQ(GET_UINT_FROM_POINTER(v), i);
+		}
+
+		TIMEIT_END(int_remove);
+	}
+	EXPECT_EQ(BLI_ohash_size(ohash), 0);
+
+	BLI_ohash_free(ohash, NULL, NULL);
+
+	printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(ohash, IntOHash12000)
+{
+	OHash *ohash = BLI_ohash_new(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__);
+
+	int_ohash_tests(ohash, "IntOHash - OHash - 12000", 12000);
+}
+
+#ifdef GHASH_RUN_BIG
+TEST(ohash, IntOHash100000000)
+{
+	OHash *ohash = BLI_ohash_new(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__);
+
+	int_ohash_tests(ohash, "IntOHash - OHash - 100000000", 100000000);
+}
+#endif
+
+static void randint_ohash_tests(OHash *ohash, const char *id, const unsigned int nbr)
+{
+	printf("\n========== STARTING %s ==========\n", id);
+
+	unsigned int *data = (unsigned int *)MEM_mallocN(sizeof(*data) * (size_t)nbr, __func__);
+	unsigned int *dt;
+	unsigned int i;
+
+	{
+		RNG *rng = BLI_rng_new(0);
+		for (i = nbr, dt = data; i--; dt++) {
+			*dt = BLI_rng_get_uint(rng);
+		}
+		BLI_rng_free(rng);
+	}
+
+	{
+		TIMEIT_START(int_insert);
+
+		for (i = nbr, dt = data; i--; dt++) {
+			BLI_ohash_reinsert(ohash, SET_UINT_IN_POINTER(*dt), SET_UINT_IN_POINTER(*dt), NULL, NULL);
+		}
+
+		TIMEIT_END(int_insert);
+	}
+
+	PRINTF_OHASH_STATS(ohash);
+
+	{
+		TIMEIT_START(int_lookup);
+
+		for (i = nbr, dt = data; i--; dt++) {
+			void *v = BLI_ohash_lookup(ohash, SET_UINT_IN_POINTER(*dt));
+			EXPECT_EQ(GET_UINT_FROM_POINTER(v), *dt);
+		}
+
+		TIMEIT_END(int_lookup);
+	}
+
+	BLI_ohash_free(ohash, NULL, NULL);
+	MEM_freeN(data);
+
+	printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(ohash, IntRandOHash12000)
+{
+	OHash *ohash = BLI_ohash_new(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__);
+
+	randint_ohash_tests(ohash, "RandIntOHash - OHash - 12000", 12000);
+}
+
+TEST(ohash, Int4NoHash12000)
+{
+	OHash *ohash = BLI_ohash_new(ghashutil_tests_nohash_p, ghashutil_tests_cmp_p, __func__);
+
+	randint_ohash_tests(ohash, "RandIntOHash - No Hash - 12000", 12000);
+}
+
+#ifdef GHASH_RUN_BIG
+TEST(ohash, IntRandOHash50000000)
+{
+	OHash *ohash = BLI_ohash_new(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__);
+
+	randint_ohash_tests(ohash, "RandIntOHash - OHash - 50000000", 50000000);
+}
+#endif
+
+/* GHash vs. OHash on the same set of random pointer-like keys,
+ * closest to how hashes are used when reading files or in bmesh operators. */
+
+#define TESTCASE_SIZE_COMPARE 2000000
+#define TESTCASE_STRIDE_COMPARE 1000003  /* Prime, co-prime with size. */
+
+TEST(ohash, ComparePtrGHashOHash)
+{
+	printf("\n========== STARTING GHash vs. OHash - %d ==========\n", TESTCASE_SIZE_COMPARE);
+
+	const unsigned int nbr = TESTCASE_SIZE_COMPARE;
+	uintptr_t *data = (uintptr_t *)MEM_mallocN(sizeof(*data) * (size_t)nbr, __func__);
+	unsigned int i;
+
+	{
+		RNG *rng = BLI_rng_new(0);
+		for (i = 0; i < nbr; i++) {
+			/* Simulate aligned heap addresses, high bits are dropped on 32-bit. */
+			data[i] = ((uintptr_t)BLI_rng_get_uint(rng) << 4) | (uintptr_t)((uint64_t)i << 36);
+		}
+		BLI_rng_free(rng);
+	}
+
+	{
+		GHash *ghash = BLI_ghash_ptr_new(__func__);
+
+		TIMEIT_START(ghash_ptr_insert);
+		for (i = 0; i < nbr; i++) {
+			BLI_ghash_insert(ghash, (void *)data[i], SET_UINT_IN_POINTER(i));
+		}
+		TIMEIT_END(ghash_ptr_insert);
+
+		PRINTF_GHASH_STATS(ghash);
+
+		TIMEIT_START(ghash_ptr_lookup);
+		for (i = 0; i < nbr; i++) {
+			/* Don't follow insertion order, it's unrealistically cache friendly. */
+			const unsigned int j = (unsigned int)(((uint64_t)i * TESTCASE_STRIDE_COMPARE) % nbr);
+			void *v = BLI_ghash_lookup(ghash, (void *)data[j]);
+			EXPECT_EQ(GET_UINT_FROM_POINTER(v), j);
+		}
+		TIMEIT_END(ghash_ptr_lookup);
+
+		TIMEIT_START(ghash_ptr_lookup_miss);
+		for (i = 0; i < nbr; i++) {
+			EXPECT_FALSE(BLI_ghash_haskey(ghash, (void *)(data[i] + 1)));
+		}
+		TIMEIT_END(ghash_ptr_lookup_miss);
+
+		BLI_ghash_free(ghash, NULL, NULL);
+	}
+
+	{
+		OHash *ohash = BLI_ohash_ptr_new(__func__);
+
+		TIMEIT_START(ohash_ptr_insert);
+		for (i = 0; i < nbr; i++) {
+			BLI_ohash_insert(ohash, (void *)data[i], SET_UINT_IN_POINTER(i));
+		}
+		TIMEIT_END(ohash_ptr_insert);
+
+		PRINTF_OHASH_STATS(ohash);
+
+		TIMEIT_START(ohash_ptr_lookup);
+		for (i = 0; i < nbr; i++) {
+			/* Don't follow insertion order, it's unrealistically cache friendly. */
+			const unsigned int j = (unsigned int)(((uint64_t)i * TESTCASE_STRIDE_COMPARE) % nbr);
+			void *v = BLI_ohash_lookup(ohash, (void *)data[j]);
+			EXPECT_EQ(GET_UINT_FROM_POINTER(v), j);
+		}
+		TIMEIT_END(ohash_ptr_lookup);
+
+		TIMEIT_START(ohash_ptr_lookup_miss);
+		for (i = 0; i < nbr; i++) {
+			EXPECT_FALSE(BLI_ohash_haskey(ohash, (void *)(data[i] + 1)));
+		}
+		TIMEIT_END(ohash_ptr_lookup_miss);
+
+		BLI_ohash_free(ohash, NULL, NULL);
+	}
+
+	MEM_freeN(data);
+
+	printf("========== ENDED GHash vs. OHash - %d ==========\n\n", TESTCASE_SIZE_COMPARE);
+}
@@ -0,0 +1,153 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "atomic_ops.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_mempool.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+}
+
+#define NUM_TASKS 64
+#define ELEMS_PER_TASK 1000
+
+typedef struct TestElem {
+	uint32_t value;
+	int task;
+} TestElem;
+
+static void mempool_count_check(BLI_mempool *pool, const uint32_t value_expected, const int count_expected)
+{
+	BLI_mempool_iter iter;
+	TestElem *elem;
+	int count = 0;
+
+	BLI_mempool_iternew(pool, &iter);
+	while ((elem = (TestElem *)BLI_mempool_iterstep(&iter))) {
+		EXPECT_EQ(value_expected, elem->value);
+		count++;
+	}
+	EXPECT_EQ(count_expected, count);
+	EXPECT_EQ(count_expected, BLI_mempool_count(pool));
+}
+
+TEST(mempool, AllocFree)
+{
+	BLI_mempool *pool = BLI_mempool_create(sizeof(TestElem), 0, 32, BLI_MEMPOOL_ALLOW_ITER);
+	TestElem *elems[100];
+
+	for (int i = 0; i < 100; i++) {
+		elems[i] = (TestElem *)BLI_mempool_alloc(pool);
+		elems[i]->value = 1u;
+	}
+	mempool_count_check(pool, 1u, 100);
+
+	for (int i = 0; i < 100; i += 2) {
+		BLI_mempool_free(pool, elems[i]);
+	}
+	mempool_count_check(pool, 1u, 50);
+
+	BLI_mempool_destroy(pool);
+}
+
+/* Thread caches. */
+
+static void task_threadcache_run(TaskPool *__restrict task_pool, void *taskdata, int /*threadid*/)
+{
+	BLI_mempool *pool = (BLI_mempool *)BLI_task_pool_userdata(task_pool);
+	BLI_mempool_threadcache *cache = BLI_mempool_threadcache_create(pool);
+	TestElem *elems[ELEMS_PER_TASK];
+	const int task = (int)(intptr_t)taskdata;
+
+	for (int i = 0; i < ELEMS_PER_TASK; i++) {
+		elems[i] = (TestElem *)BLI_mempool_threadcache_calloc(cache);
+		elems[i]->value = 1u;
+		elems[i]->task = task;
+	}
+	/* Free half of the elements, some get back to the pool. */
+	for (int i = 0; i < ELEMS_PER_TASK; i += 2) {
+		EXPECT_EQ(task, elems[i]->task);
+		BLI_mempool_threadcache_free(cache, elems[i]);
+	}
+
+	BLI_mempool_threadcache_destroy(cache);
+}
+
+TEST(mempool, ThreadCache)
+{
+	BLI_threadapi_init();
+	TaskScheduler *scheduler = BLI_task_scheduler_create(4);
+	BLI_mempool *pool = BLI_mempool_create(sizeof(TestElem), 0, 64, BLI_MEMPOOL_ALLOW_ITER);
+	TaskPool *task_pool = BLI_task_pool_create(scheduler, pool);
+
+	for (int i = 0; i < NUM_TASKS; i++) {
+		BLI_task_pool_push(task_pool, task_threadcache_run, (void *)(intptr_t)i, false, TASK_PRIORITY_HIGH);
+	}
+	BLI_task_pool_work_and_wait(task_pool);
+
+	mempool_count_check(pool, 1u, NUM_TASKS * ELEMS_PER_TASK / 2);
+
+	BLI_task_pool_free(task_pool);
+	BLI_mempool_destroy(pool);
+	BLI_task_scheduler_free(scheduler);
+}
+
+/* Threaded iteration. */
+
+typedef struct IterTestData {
+	BLI_mempool_iter *iter_arr;
+	size_t num_visited;
+} IterTestData;
+
+static void task_iter_run(TaskPool *__restrict task_pool, void *taskdata, int /*threadid*/)
+{
+	IterTestData *data = (IterTestData *)BLI_task_pool_userdata(task_pool);
+	BLI_mempool_iter *iter = &data->iter_arr[(intptr_t)taskdata];
+	TestElem *elem;
+
+	while ((elem = (TestElem *)BLI_mempool_iterstep(iter))) {
+		/* Every element must be visited exactly once. */
+		EXPECT_EQ(2u, atomic_add_and_fetch_uint32(&elem->value, 1));
+		atomic_add_and_fetch_z(&data->num_visited, 1);
+	}
+}
+
+TEST(mempool, IterThreadsafe)
+{
+	BLI_threadapi_init();
+	TaskScheduler *scheduler = BLI_task_scheduler_create(4);
+	BLI_mempool *pool = BLI_mempool_create(sizeof(TestElem), 0, 16, BLI_MEMPOOL_ALLOW_ITER);
+	const int num_elems = 1000;
+	const size_t num_iter = 8;
+
+	/* Leave holes in the pool, they must be skipped. */
+	for (int i = 0; i < num_elems * 2; i++) {
+		TestElem *elem = (TestElem *)BLI_mempool_alloc(pool);
+		elem->value = 1u;
+		if (i % 2) {
+			BLI_mempool_free(pool, elem);
+		}
+	}
+
+	IterTestData data;
+	data.iter_arr = BLI_mempool_iter_threadsafe_create(pool, num_iter);
+	data.num_visited = 0;
+
+	TaskPool *task_pool = BLI_task_pool_create(scheduler, &data);
+	for (size_t i = 0; i < num_iter; i++) {
+		BLI_task_pool_push(task_pool, task_iter_run, (void *)(intptr_t)i, false, TASK_PRIORITY_HIGH);
+	}
+	BLI_task_pool_work_and_wait(task_pool);
+	BLI_task_pool_free(task_pool);
+
+	EXPECT_EQ((size_t)num_elems, data.num_visited);
+	mempool_count_check(pool, 2u, num_elems);
+
+	BLI_mempool_iter_threadsafe_free(data.iter_arr);
+	BLI_mempool_destroy(pool);
+	BLI_task_scheduler_free(scheduler);
+}
@@ -0,0 +1,175 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "BLI_utildefines.h"
+#include "BLI_ghash.h"
+#include "BLI_ohash.h"
+}
+
+#define TESTCASE_SIZE 10000
+
+/* Unique 'random' keys, multiplication by an odd number is a bijection. */
+static void init_keys(unsigned int keys[TESTCASE_SIZE], const unsigned int seed)
+{
+	for (unsigned int i = 0; i < TESTCASE_SIZE; i++) {
+		keys[i] = (i + seed) * 2654435761u;
+	}
+}
+
+/* Here we simply insert and then lookup all keys, ensuring we do get back the expected stored 'data'. */
+TEST(ohash, InsertLookup)
+{
+	OHash *ohash = BLI_ohash_int_new(__func__);
+	unsigned int keys[TESTCASE_SIZE], *k;
+	int i;
+
+	init_keys(keys, 0);
+
+	for (i = TESTCASE_SIZE, k = keys; i--; k++) {
+		BLI_ohash_insert(ohash, SET_UINT_IN_POINTER(*k), SET_UINT_IN_POINTER(*k));
+	}
+
+	EXPECT_EQ(BLI_ohash_size(ohash), TESTCASE_SIZE);
+
+	for (i = TESTCASE_SIZE, k = keys; i--; k++) {
+		void *v = BLI_ohash_lookup(ohash, SET_UINT_IN_POINTER(*k));
+		EXPECT_EQ(GET_UINT_FROM_POINTER(v), *k);
+	}
+
+	/* Keys which were never inserted. */
+	init_keys(keys, TESTCASE_SIZE);
+	for (i = TESTCASE_SIZE, k = keys; i--; k++) {
+		EXPECT_FALSE(BLI_ohash_haskey(ohash, SET_UINT_IN_POINTER(*k)));
+	}
+
+	BLI_ohash_free(ohash, NULL, NULL);
+}
+
+/* Remove every other key, then re-insert them, deleted slots have to be re-used and probing must stay valid. */
+TEST(ohash, InsertRemoveReinsert)
+{
+	OHash *ohash = BLI_ohash_int_new(__func__);
+	unsigned int keys[TESTCASE_SIZE], *k;
+	int i;
+
+	init_keys(keys, 0);
+
+	for (i = TESTCASE_SIZE, k = keys; i--; k++) {
+		BLI_ohash_insert(ohash, SET_UINT_IN_POINTER(*k), SET_UINT_IN_POINTER(*k));
+	}
+
+	for (i = 0; i < TESTCASE_SIZE; i += 2) {
+		void *v = BLI_ohash_popkey(ohash, SET_UINT_IN_POINTER(keys[i]), NULL);
+		EXPECT_EQ(GET_UINT_FROM_POINTER(v), keys[i]);
+	}
+
+	EXPECT_EQ(BLI_ohash_size(ohash), TESTCASE_SIZE / 2);
+
+	for (i = 0; i < TESTCASE_SIZE; i++) {
+		EXPECT_EQ(BLI_ohash_haskey(ohash, SET_UINT_IN_POINTER(keys[i])), (i % 2) == 1);
+	}
+
+	for (i = 0; i < TESTCASE_SIZE; i++) {
+		const bool is_new = BLI_ohash_reinsert(
+		        ohash, SET_UINT_IN_POINTER(keys[i]), SET_UINT_IN_POINTER(keys[i] + 1), NULL, NULL);
+		EXPECT_EQ(is_new, (i % 2) == 0);
+	}
+
+	EXPECT_EQ(BLI_ohash_size(ohash), TESTCASE_SIZE);
+
+	for (i = 0; i < TESTCASE_SIZE; i++) {
+		void *v = BLI_ohash_lookup(ohash, SET_UINT_IN_POINTER(keys[i]));
+		EXPECT_EQ(GET_UINT_FROM_POINTER(v), keys[i] + 1);
+	}
+
+	BLI_ohash_free(ohash, NULL, NULL);
+}
+
+/* Same as above, but with shrinking allowed we should end up with an empty and small hash. */
+TEST(ohash, InsertRemoveShrink)
+{
+	OHash *ohash = BLI_ohash_int_new(__func__);
+	unsigned int keys[TESTCASE_SIZE], *k;
+	int i;
+
+	BLI_ohash_flag_set(ohash, OHASH_FLAG_ALLOW_SHRINK);
+	init_keys(keys, 0);
+
+	for (i = TESTCASE_SIZE, k = keys; i--; k++) {
+		BLI_ohash_insert(ohash, SET_UINT_IN_POINTER(*k), SET_UINT_IN_POINTER(*k));
+	}
+
+	for (i = TESTCASE_SIZE, k = keys; i--; k++) {
+		EXPECT_TRUE(BLI_ohash_remove(ohash, SET_UINT_IN_POINTER(*k), NULL, NULL));
+		/* Remaining keys are still reachable after shrinking. */
+		if (i > 0) {
+			EXPECT_TRUE(BLI_ohash_haskey(ohash, SET_UINT_IN_POINTER(*(k + 1))));
+		}
+	}
+
+	EXPECT_EQ(BLI_ohash_size(ohash), 0);
+
+	BLI_ohash_free(ohash, NULL, NULL);
+}
+
+/* Values pointers returned by ensure_p are stable until next insertion. */
+TEST(ohash, EnsureP)
+{
+	OHash *ohash = BLI_ohash_int_new(__func__);
+	unsigned int keys[TESTCASE_SIZE];
+	int i;
+
+	init_keys(keys, 0);
+
+	for (i = 0; i < TESTCASE_SIZE; i++) {
+		void **val_p;
+		EXPECT_FALSE(BLI_ohash_ensure_p(ohash, SET_UINT_IN_POINTER(keys[i]), &val_p));
+		*val_p = SET_UINT_IN_POINTER(i);
+	}
+
+	for (i = 0; i < TESTCASE_SIZE; i++) {
+		void **val_p;
+		EXPECT_TRUE(BLI_ohash_ensure_p(ohash, SET_UINT_IN_POINTER(keys[i]), &val_p));
+		EXPECT_EQ(GET_UINT_FROM_POINTER(*val_p), i);
+	}
+
+	BLI_ohash_free(ohash, NULL, NULL);
+}
+
+/* Iteration visits every entry exactly once. */
+TEST(ohash, Iterator)
+{
+	OHash *ohash = BLI_ohash_int_new(__func__);
+	unsigned int keys[TESTCASE_SIZE];
+	OHashIterator ohi;
+	unsigned int sum_expected = 0, sum = 0;
+	int i, count = 0;
+
+	init_keys(keys, 0);
+
+	for (i = 0; i < TESTCASE_SIZE; i++) {
+		BLI_ohash_insert(ohash, SET_UINT_IN_POINTER(keys[i]), SET_UINT_IN_POINTER(i));
+		sum_expected += (unsigned int)i;
+	}
+
+	OHASH_ITER (ohi, ohash) {
+		const unsigned int key = GET_UINT_FROM_POINTER(BLI_ohashIterator_getKey(&ohi));
+		const unsigned int val = GET_UINT_FROM_POINTER(BLI_ohashIterator_getValue(&ohi));
+		EXPECT_EQ(keys[val], key);
+		sum += val;
+		count++;
+	}
+
+	EXPECT_EQ(count, TESTCASE_SIZE);
+	EXPECT_EQ(sum, sum_expected);
+
+	BLI_ohash_clear(ohash, NULL, NULL);
+	EXPECT_EQ(BLI_ohash_size(ohash), 0);
+
+	BLI_ohashIterator_init(&ohi, ohash);
+	EXPECT_TRUE(BLI_ohashIterator_done(&ohi));
+
+	BLI_ohash_free(ohash, NULL, NULL);
+}
@@ -0,0 +1,124 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "atomic_ops.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_math_base.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "PIL_time.h"
+}
+
+/* Number of tasks pushed from main thread in flat tests. */
+#define NUM_TASKS_FLAT 1000000
+
+/* Depth of the binary tree of tasks spawned from worker threads. */
+#define RECURSION_DEPTH 20
+
+/* Amount of dummy work done by every task, to get some sort of real-world
+ * timing (tasks which are doing nothing at all are only measuring overhead). */
+#define TASK_WORK_ITERATIONS 64
+
+typedef struct TaskTestData {
+	size_t num_done;
+	int work_iterations;
+} TaskTestData;
+
+static void task_do_work(TaskTestData *data)
+{
+	volatile float f = 1.0f;
+	for (int i = 0; i < data->work_iterations; i++) {
+		f = f * 1.0001f + 0.0001f;
+	}
+	atomic_add_and_fetch_z(&data->num_done, 1);
+}
+
+static void task_flat_run(TaskPool *__restrict pool, void * /*taskdata*/, int /*threadid*/)
+{
+	TaskTestData *data = (TaskTestData *)BLI_task_pool_userdata(pool);
+	task_do_work(data);
+}
+
+static void task_recursive_run(TaskPool *__restrict pool, void *taskdata, int threadid)
+{
+	TaskTestData *data = (TaskTestData *)BLI_task_pool_userdata(pool);
+	const int depth = GET_INT_FROM_POINTER(taskdata);
+	task_do_work(data);
+	if (depth > 0) {
+		BLI_task_pool_push_from_thread(pool, task_recursive_run, SET_INT_IN_POINTER(depth - 1),
+		                               false, TASK_PRIORITY_HIGH, threadid);
+		BLI_task_pool_push_from_thread(pool, task_recursive_run, SET_INT_IN_POINTER(depth - 1),
+		                               false, TASK_PRIORITY_HIGH, threadid);
+	}
+}
+
+static void task_flat_test(TaskScheduler *scheduler, const int num_threads, const int work_iterations)
+{
+	TaskTestData data = {0, work_iterations};
+	TaskPool *pool = BLI_task_pool_create(scheduler, &data);
+
+	const double time_start = PIL_check_seconds_timer();
+	for (int i = 0; i < NUM_TASKS_FLAT; i++) {
+		BLI_task_pool_push(pool, task_flat_run, NULL, false, TASK_PRIORITY_LOW);
+	}
+	BLI_task_pool_work_and_wait(pool);
+	const double time_total = PIL_check_seconds_timer() - time_start;
+
+	BLI_task_pool_free(pool);
+
+	EXPECT_EQ((size_t)NUM_TASKS_FLAT, data.num_done);
+	printf("  flat       %2d threads: %.4f sec, %.2f Mtasks/sec\n",
+	       num_threads, time_total, (double)data.num_done / time_total * 1e-6);
+}
+
+static void task_recursive_test(TaskScheduler *scheduler, const int num_threads, const int work_iterations)
+{
+	TaskTestData data = {0, work_iterations};
+	TaskPool *pool = BLI_task_pool_create(scheduler, &data);
+
+	const double time_start = PIL_check_seconds_timer();
+	BLI_task_pool_push(pool, task_recursive_run, SET_INT_IN_POINTER(RECURSION_DEPTH),
+	                   false, TASK_PRIORITY_HIGH);
+	BLI_task_pool_work_and_wait(pool);
+	const double time_total = PIL_check_seconds_timer() - time_start;
+
+	BLI_task_pool_free(pool);
+
+	EXPECT_EQ((size_t)(1 << (RECURSION_DEPTH + 1)) - 1, data.num_done);
+	printf("  recursive  %2d threads: %.4f sec, %.2f Mtasks/sec\n",
+	       num_threads, time_total, (double)data.num_done / time_total * 1e-6);
+}
+
+static void task_scaling_tests(const char *id, const int work_iterations)
+{
+	const int max_threads = BLI_system_thread_count();
+
+	printf("\n========== STARTING %s ==========\n", id);
+
+	BLI_threadapi_init();
+	for (int num_threads = 1; ; num_threads = min_ii(num_threads * 2, max_threads)) {
+		TaskScheduler *scheduler = BLI_task_scheduler_create(num_threads);
+		task_flat_test(scheduler, num_threads, work_iterations);
+		task_recursive_test(scheduler, num_threads, work_iterations);
+		BLI_task_scheduler_free(scheduler);
+		if (num_threads == max_threads) {
+			break;
+		}
+	}
+
+	printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(task, PushPopOverhead)
+{
+	task_scaling_tests("Task push/pop overhead", 0);
+}
+
+TEST(task, PushPopWork)
+{
+	task_scaling_tests("Task push/pop with work", TASK_WORK_ITERATIONS);
+}
@@ -0,0 +1,109 @@
+# ##### BEGIN GPL LICENSE BLOCK #####
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software Foundation,
+#  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+# ##### END GPL LICENSE BLOCK #####
+
+# <pep8 compliant>
+
+# Measure global (memfile) undo push latency on a large generated scene.
+#
+# ./blender.bin --background -noaudio --factory-startup \
+#     --python tests/python/bl_undo_push_benchmark.py -- --objects 200 --grid 100 --repeat 10
+#
+# Run with '--debug-wm' to get the timing and new data size of each push printed by Blender itself.
+
+import bpy
+import bmesh
+
+import sys
+import time
+
+
+def scene_create(num_objects, grid_size):
+    scene = bpy.context.scene
+
+    for ob in list(scene.objects):
+        scene.objects.unlink(ob)
+
+    for i in range(num_objects):
+        me = bpy.data.meshes.new("BenchMesh.%d" % i)
+        bm = bmesh.new()
+        bmesh.ops.create_grid(bm, x_segments=grid_size, y_segments=grid_size, size=1.0)
+        bm.to_mesh(me)
+        bm.free()
+
+        ob = bpy.data.objects.new("BenchObject.%d" % i, me)
+        ob.location.x = (i % 32) * 2.5
+        ob.location.y = (i // 32) * 2.5
+        scene.objects.link(ob)
+
+    scene.update()
+    return scene
+
+
+def undo_push_time(message):
+    time_start = time.time()
+    bpy.ops.ed.undo_push(message=message)
+    return (time.time() - time_start) * 1000.0
+
+
+def report(name, timings):
+    timings = sorted(timings)
+    print("%-24s min %9.3f ms, median %9.3f ms, max %9.3f ms" %
+          (name, timings[0], timings[len(timings) // 2], timings[-1]))
+
+
+def main():
+    import argparse
+
+    argv = sys.argv[sys.argv.index("--") + 1:] if "--" in sys.argv else []
+
+    parser = argparse.ArgumentParser(description="Global undo push benchmark")
+    parser.add_argument("--objects", type=int, default=200, help="Number of mesh objects")
+    parser.add_argument("--grid", type=int, default=100, help="Grid resolution of each mesh")
+    parser.add_argument("--repeat", type=int, default=10, help="Number of pushes per case")
+    args = parser.parse_args(argv)
+
+    scene = scene_create(args.objects, args.grid)
+    objects = [ob for ob in scene.objects if ob.type == 'MESH']
+
+    print("Undo push benchmark: %d objects, %d vertices each" %
+          (len(objects), len(objects[0].data.vertices)))
+
+    # First push writes everything, following ones compare against it.
+    report("initial", [undo_push_time("Initial")])
+
+    report("no change", [undo_push_time("No Change") for _ in range(args.repeat)])
+
+    timings = []
+    for i in range(args.repeat):
+        objects[i % len(objects)].location.z += 0.1
+        scene.update()
+        timings.append(undo_push_time("Move Object"))
+    report("move one object", timings)
+
+    timings = []
+    for i in range(args.repeat):
+        me = objects[i % len(objects)].data
+        me.vertices[0].co.z += 0.1
+        me.update()
+        scene.update()
+        timings.append(undo_push_time("Edit Mesh"))
+    report("edit one mesh", timings)
+
+
+if __name__ == "__main__":
+    main()